@@ -0,0 +1,272 @@
+/*
+ Copyright (c) 2025 Mateusz Stadnik
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "editor.h"
+#include "terminal.h"
+
+// keys go through the same editor_process_key and editor_redraw_screen calls
+// as the main loop, drawn on a virtual terminal of the default curses size
+#define SCREEN_WIDTH 80
+#define SCREEN_HEIGHT 24
+#define NUMBER_OF_ROWS 100000
+#define INPUT_FILE "build/replay_bench_input.c"
+
+#define KEY_ESCAPE 27
+
+typedef struct Keys {
+  int* keys;
+  int count;
+  int capacity;
+} Keys;
+
+typedef struct Scenario {
+  const char* name;
+  // setup keys are processed before measuring, keys are measured one by one
+  void (*generate)(Keys* setup, Keys* keys);
+} Scenario;
+
+static double now(void) {
+  struct timespec time;
+  clock_gettime(CLOCK_MONOTONIC, &time);
+  return time.tv_sec + time.tv_nsec / 1e9;
+}
+
+static void keys_push(Keys* keys, int key) {
+  if (keys->count == keys->capacity) {
+    keys->capacity = keys->capacity > 0 ? keys->capacity * 2 : 1024;
+    keys->keys = realloc(keys->keys, sizeof(int) * keys->capacity);
+    if (keys->keys == NULL) {
+      fprintf(stderr, "Out of memory\n");
+      exit(1);
+    }
+  }
+  keys->keys[keys->count++] = key;
+}
+
+static void keys_push_text(Keys* keys, const char* text) {
+  for (; *text != '\0'; ++text) {
+    keys_push(keys, (unsigned char)*text);
+  }
+}
+
+// a C file with the usual mix of braces, comments, strings and identifiers
+static void write_input_file(void) {
+  FILE* file = fopen(INPUT_FILE, "w");
+  if (file == NULL) {
+    fprintf(stderr, "Can't write %s\n", INPUT_FILE);
+    exit(1);
+  }
+  for (int i = 0; i < NUMBER_OF_ROWS / 10; ++i) {
+    fprintf(file,
+            "// computes value %d from the previous ones\n"
+            "static int compute_%d(const int* values, int count) {\n"
+            "  int sum = 0;\n"
+            "  for (int i = 0; i < count; ++i) {\n"
+            "    sum += values[i] * %d;\n"
+            "  }\n"
+            "  if (sum > %d) {\n"
+            "    printf(\"overflow in %%s\\n\", \"compute_%d\");\n"
+            "  }\n"
+            "  return sum;\n",
+            i, i, i % 17, i * 3, i);
+  }
+  fclose(file);
+}
+
+static void generate_typing(Keys* setup, Keys* keys) {
+  keys_push_text(setup, ":50000\n");
+  // a function typed line by line, with typos fixed and the cursor moved down
+  // between lines
+  for (int i = 0; i < 100; ++i) {
+    keys_push_text(keys, "i  if (valeu");
+    for (int j = 0; j < 3; ++j) {
+      keys_push(keys, TERMINAL_KEY_BACKSPACE);
+    }
+    keys_push_text(keys, "lue_count > limit) {\n    return -1;\n  }\n");
+    keys_push(keys, KEY_ESCAPE);
+    keys_push_text(keys, "jj");
+  }
+}
+
+static void generate_holding_j(Keys* setup, Keys* keys) {
+  (void)setup;
+  for (int i = 0; i < NUMBER_OF_ROWS; ++i) {
+    keys_push(keys, 'j');
+  }
+}
+
+static void generate_dd_bursts(Keys* setup, Keys* keys) {
+  keys_push_text(setup, ":20000\n");
+  for (int burst = 0; burst < 100; ++burst) {
+    for (int i = 0; i < 20; ++i) {
+      keys_push_text(keys, "dd");
+    }
+    keys_push_text(keys, ":+500\n");
+  }
+}
+
+// a terminal paste arrives as insert mode keys without pauses
+static void generate_pasting(Keys* setup, Keys* keys) {
+  keys_push_text(setup, ":30000\n");
+  keys_push(keys, 'i');
+  for (int i = 0; i < 200; ++i) {
+    keys_push_text(keys,
+                   "static int pasted(const int* values, int count) {\n"
+                   "  int sum = 0; // \"total\" of the values\n"
+                   "  for (int i = 0; i < count; ++i) sum += values[i];\n"
+                   "  return sum;\n"
+                   "}\n");
+  }
+  keys_push(keys, KEY_ESCAPE);
+}
+
+static int compare_doubles(const void* a, const void* b) {
+  const double left = *(const double*)a;
+  const double right = *(const double*)b;
+  return left < right ? -1 : left > right;
+}
+
+static int compare_sizes(const void* a, const void* b) {
+  const size_t left = *(const size_t*)a;
+  const size_t right = *(const size_t*)b;
+  return left < right ? -1 : left > right;
+}
+
+static void run(const char* name, const char* filename, Keys* setup, Keys* keys) {
+  Editor editor = {
+    .state = EditorState_Running,
+    .cursor = {2, 0},
+    .number_of_line_digits = 3,
+    .tab_size = 2,
+  };
+  VirtualTerminal terminal;
+  terminal_virtual_setup(&terminal, SCREEN_WIDTH, SCREEN_HEIGHT);
+  editor.terminal = &terminal.terminal;
+  if (!editor_init(&editor)) {
+    fprintf(stderr, "Can't initialize the terminal\n");
+    return;
+  }
+  editor_load_file(&editor, filename);
+  for (int i = 0; i < setup->count; ++i) {
+    editor_process_key(&editor, setup->keys[i]);
+  }
+  editor_redraw_screen(&editor);
+  terminal_virtual_push_keys(&terminal, keys->keys, keys->count);
+
+  double* latencies = malloc(sizeof(double) * (keys->count + 1));
+  size_t* frame_bytes = malloc(sizeof(size_t) * (keys->count + 1));
+  if (latencies == NULL || frame_bytes == NULL) {
+    fprintf(stderr, "Out of memory\n");
+    exit(1);
+  }
+  int frames = 0;
+  size_t total_bytes = 0;
+  const double start = now();
+  while (!editor_should_exit(&editor)) {
+    const double key_start = now();
+    const int key = editor_read_key(&editor);
+    if (key == TERMINAL_NO_KEY) {
+      break;
+    }
+    const size_t bytes = terminal.terminal.statistics.bytes;
+    editor_process_key(&editor, key);
+    editor_redraw_screen(&editor);
+    latencies[frames] = (now() - key_start) * 1e6;
+    frame_bytes[frames] = terminal.terminal.statistics.bytes - bytes;
+    total_bytes += frame_bytes[frames];
+    ++frames;
+  }
+  const double elapsed = now() - start;
+  editor_deinit(&editor);
+
+  if (frames == 0) {
+    printf("%-12s no keys\n", name);
+  } else {
+    qsort(latencies, frames, sizeof(double), compare_doubles);
+    qsort(frame_bytes, frames, sizeof(size_t), compare_sizes);
+    printf("%-12s %7d keys %7.3f s  us/key p50 %7.1f p90 %7.1f p99 %7.1f max %9.1f"
+           "  bytes/frame avg %6.0f p50 %5zu max %6zu\n",
+           name, frames, elapsed, latencies[frames / 2], latencies[frames * 9 / 10],
+           latencies[frames * 99 / 100], latencies[frames - 1],
+           (double)total_bytes / frames, frame_bytes[frames / 2],
+           frame_bytes[frames - 1]);
+  }
+  free(latencies);
+  free(frame_bytes);
+}
+
+static void replay(const char* keys_filename, const char* filename) {
+  FILE* file = fopen(keys_filename, "rb");
+  if (file == NULL) {
+    fprintf(stderr, "Can't open %s\n", keys_filename);
+    exit(1);
+  }
+  Keys setup = {0};
+  Keys keys = {0};
+  int c;
+  while ((c = fgetc(file)) != EOF) {
+    keys_push(&keys, c);
+  }
+  fclose(file);
+  run(keys_filename, filename, &setup, &keys);
+  free(keys.keys);
+}
+
+// without arguments the generated scenarios run on a generated file, given a
+// file of recorded keys, as for vi -e -k, those are replayed on the file given
+// after it or on the generated one
+int main(int argc, char* argv[]) {
+  if (argc > 3) {
+    fprintf(stderr, "usage: %s [keys [file]]\n", argv[0]);
+    return 2;
+  }
+  if (argc == 3) {
+    replay(argv[1], argv[2]);
+    return 0;
+  }
+  write_input_file();
+  if (argc == 2) {
+    replay(argv[1], INPUT_FILE);
+    remove(INPUT_FILE);
+    return 0;
+  }
+  static const Scenario scenarios[] = {
+    {"typing", generate_typing},
+    {"holding j", generate_holding_j},
+    {"dd bursts", generate_dd_bursts},
+    {"pasting", generate_pasting},
+  };
+  printf("replay keys on %d rows, %dx%d screen\n", NUMBER_OF_ROWS, SCREEN_WIDTH,
+         SCREEN_HEIGHT);
+  for (size_t i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); ++i) {
+    Keys setup = {0};
+    Keys keys = {0};
+    scenarios[i].generate(&setup, &keys);
+    run(scenarios[i].name, INPUT_FILE, &setup, &keys);
+    free(setup.keys);
+    free(keys.keys);
+  }
+  remove(INPUT_FILE);
+  return 0;
+}
@@ -0,0 +1,91 @@
+/*
+ Copyright (c) 2025 Mateusz Stadnik
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "buffer.h"
+#include "substitute.h"
+#include "worker_pool.h"
+
+#define NUMBER_OF_ROWS 1000000
+
+static double now(void) {
+  struct timespec time;
+  clock_gettime(CLOCK_MONOTONIC, &time);
+  return time.tv_sec + time.tv_nsec / 1e9;
+}
+
+static Buffer* create_buffer(void) {
+  Buffer* buffer = buffer_alloc();
+  char line[96];
+  for (int i = 0; i < NUMBER_OF_ROWS; ++i) {
+    snprintf(line, sizeof(line), "  int value_%d = compute(value_%d, %d); // value", i,
+             i / 2, i % 97);
+    buffer_append_line(buffer, line);
+  }
+  return buffer;
+}
+
+// :%s/val\(ue\)/value/g keeps the text the same so every run does equal work
+static double run(Buffer* buffer, int number_of_threads, int* substitutions) {
+  Substitution substitution;
+  const char* error = NULL;
+  if (!substitution_init(&substitution, "val\\(ue\\)", "value", "g", &error)) {
+    fprintf(stderr, "Invalid substitution: %s\n", error);
+    exit(1);
+  }
+  SubstituteResult result;
+  const double start = now();
+  if (number_of_threads == 1) {
+    substitute_rows(&substitution, buffer->head, NUMBER_OF_ROWS, &result);
+  } else {
+    WorkerPool pool;
+    if (!worker_pool_init(&pool, number_of_threads)) {
+      fprintf(stderr, "Failed to start %d threads\n", number_of_threads);
+      exit(1);
+    }
+    substitute_rows_parallel(&substitution, &pool, buffer->head, NUMBER_OF_ROWS, NULL,
+                             NULL, &result);
+    worker_pool_deinit(&pool);
+  }
+  const double elapsed = now() - start;
+  substitution_deinit(&substitution);
+  *substitutions = result.substitutions;
+  return elapsed;
+}
+
+int main(void) {
+  Buffer* buffer = create_buffer();
+  const int threads[] = {1, 2, 4, 8};
+  double single_thread = 0;
+  printf("substitute %d rows\n", NUMBER_OF_ROWS);
+  for (size_t i = 0; i < sizeof(threads) / sizeof(threads[0]); ++i) {
+    int substitutions = 0;
+    const double elapsed = run(buffer, threads[i], &substitutions);
+    if (threads[i] == 1) {
+      single_thread = elapsed;
+    }
+    printf("  %d threads: %8.3f s  %5.2fx  (%d substitutions)\n", threads[i], elapsed,
+           single_thread / elapsed, substitutions);
+  }
+  buffer_free(buffer);
+  return 0;
+}
@@ -15,18 +15,307 @@
  along with this program. If not, see <https://www.gnu.org/licenses/>.
  */
 
+#define _GNU_SOURCE
 #include "buffer.h"
 
-#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include "line_splitter.h"
+
+// rows removed at once above this count rebuild the tree on the next query
+#define BUFFER_TREE_REBUILD_ROWS 1024
+
+static int buffer_tree_size(const BufferRow* node) {
+  return node != NULL ? node->tree_size : 0;
+}
+
+static unsigned int buffer_tree_random(Buffer* buffer) {
+  // xorshift, the seed must not be 0
+  unsigned int x = buffer->tree_seed != 0 ? buffer->tree_seed : 2463534242u;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  buffer->tree_seed = x;
+  return x;
+}
+
+static void buffer_tree_invalidate(Buffer* buffer) {
+  buffer->tree_valid = false;
+  buffer->tree_root = NULL;
+}
+
+// builds a balanced tree of the next count rows of the list, priorities
+// fall with the depth so later random ones keep it a treap
+static BufferRow* buffer_tree_build(BufferRow** row, int count, int depth) {
+  if (count == 0) {
+    return NULL;
+  }
+  const int left_count = count / 2;
+  BufferRow* left = buffer_tree_build(row, left_count, depth + 1);
+  BufferRow* node = *row;
+  *row = node->next;
+  BufferRow* right = buffer_tree_build(row, count - left_count - 1, depth + 1);
+  node->tree_left = left;
+  node->tree_right = right;
+  node->tree_size = count;
+  node->tree_priority = 0xffffffffu - (unsigned int)depth * (0xffffffffu / 64);
+  if (left != NULL) {
+    left->tree_parent = node;
+  }
+  if (right != NULL) {
+    right->tree_parent = node;
+  }
+  return node;
+}
+
+static void buffer_tree_rebuild(Buffer* buffer) {
+  BufferRow* row = buffer->head;
+  buffer->tree_root = buffer_tree_build(&row, buffer->number_of_rows, 0);
+  if (buffer->tree_root != NULL) {
+    buffer->tree_root->tree_parent = NULL;
+  }
+  buffer->tree_valid = true;
+}
+
+static void buffer_tree_rotate_up(Buffer* buffer, BufferRow* node) {
+  BufferRow* parent = node->tree_parent;
+  BufferRow* grandparent = parent->tree_parent;
+  if (parent->tree_left == node) {
+    parent->tree_left = node->tree_right;
+    if (node->tree_right != NULL) {
+      node->tree_right->tree_parent = parent;
+    }
+    node->tree_right = parent;
+  } else {
+    parent->tree_right = node->tree_left;
+    if (node->tree_left != NULL) {
+      node->tree_left->tree_parent = parent;
+    }
+    node->tree_left = parent;
+  }
+  parent->tree_parent = node;
+  node->tree_parent = grandparent;
+  if (grandparent == NULL) {
+    buffer->tree_root = node;
+  } else if (grandparent->tree_left == parent) {
+    grandparent->tree_left = node;
+  } else {
+    grandparent->tree_right = node;
+  }
+  node->tree_size = parent->tree_size;
+  parent->tree_size =
+    1 + buffer_tree_size(parent->tree_left) + buffer_tree_size(parent->tree_right);
+}
+
+// row has to be linked after the given one already
+static void buffer_tree_insert_after(Buffer* buffer, BufferRow* after, BufferRow* row) {
+  if (!buffer->tree_valid) {
+    return;
+  }
+  row->tree_left = NULL;
+  row->tree_right = NULL;
+  row->tree_size = 1;
+  row->tree_priority = buffer_tree_random(buffer);
+  // the new row becomes the leftmost node after the previous one
+  BufferRow* parent = after;
+  if (after == NULL || after->tree_right != NULL) {
+    parent = after == NULL ? buffer->tree_root : after->tree_right;
+    while (parent != NULL && parent->tree_left != NULL) {
+      parent = parent->tree_left;
+    }
+  }
+  row->tree_parent = parent;
+  if (parent == NULL) {
+    buffer->tree_root = row;
+  } else if (parent == after) {
+    parent->tree_right = row;
+  } else {
+    parent->tree_left = row;
+  }
+  for (; parent != NULL; parent = parent->tree_parent) {
+    ++parent->tree_size;
+  }
+  while (row->tree_parent != NULL &&
+         row->tree_parent->tree_priority < row->tree_priority) {
+    buffer_tree_rotate_up(buffer, row);
+  }
+}
+
+static void buffer_tree_remove(Buffer* buffer, BufferRow* row) {
+  if (!buffer->tree_valid) {
+    return;
+  }
+  // rotated down until it is a leaf
+  while (row->tree_left != NULL || row->tree_right != NULL) {
+    BufferRow* child = row->tree_left;
+    if (child == NULL || (row->tree_right != NULL &&
+                          row->tree_right->tree_priority > child->tree_priority)) {
+      child = row->tree_right;
+    }
+    buffer_tree_rotate_up(buffer, child);
+  }
+  BufferRow* parent = row->tree_parent;
+  if (parent == NULL) {
+    buffer->tree_root = NULL;
+  } else if (parent->tree_left == row) {
+    parent->tree_left = NULL;
+  } else {
+    parent->tree_right = NULL;
+  }
+  for (; parent != NULL; parent = parent->tree_parent) {
+    --parent->tree_size;
+  }
+}
+
+int buffer_get_row_index(Buffer* buffer, const BufferRow* row) {
+  if (buffer == NULL || row == NULL) {
+    return -1;
+  }
+  if (!buffer->tree_valid) {
+    buffer_tree_rebuild(buffer);
+  }
+  int index = buffer_tree_size(row->tree_left);
+  for (const BufferRow* node = row; node->tree_parent != NULL;
+       node = node->tree_parent) {
+    if (node->tree_parent->tree_right == node) {
+      index += buffer_tree_size(node->tree_parent->tree_left) + 1;
+    }
+  }
+  return index;
+}
+
+static void buffer_reference_row(BufferMark* mark, BufferRow* row, int column) {
+  if (mark->row != NULL) {
+    --mark->row->references;
+  }
+  mark->row = row;
+  mark->column = column;
+  if (row != NULL) {
+    ++row->references;
+  }
+}
+
+// jumps to the row or, with a NULL row, to any row of the buffer
+static void buffer_forget_jumps(BufferJumplist* list,
+                                const Buffer* buffer,
+                                const BufferRow* row) {
+  if (list == NULL) {
+    return;
+  }
+  int kept = 0;
+  for (int i = 0; i < list->number_of_jumps; ++i) {
+    const BufferJump* jump = &list->jumps[i];
+    if (row != NULL ? jump->mark.row != row : jump->buffer != buffer) {
+      list->jumps[kept++] = *jump;
+    } else if (i < list->jump_position) {
+      --list->jump_position;
+    }
+  }
+  list->number_of_jumps = kept;
+  if (list->jump_position > kept) {
+    list->jump_position = kept;
+  }
+}
+
+// marks and jumps of a row going away
+static void buffer_forget_row(Buffer* buffer, const BufferRow* row) {
+  for (int i = 0; i < BUFFER_NUMBER_OF_MARKS; ++i) {
+    if (buffer->marks[i].row == row) {
+      buffer->marks[i].row = NULL;
+    }
+  }
+  buffer_forget_jumps(buffer->jumplist, NULL, row);
+}
+
+static void buffer_drop_row(Buffer* buffer, BufferRow* row) {
+  if (row->references > 0) {
+    buffer_forget_row(buffer, row);
+  }
+  // a fold goes away with its first or last row
+  if (row->fold_first != NULL || row->fold_last != NULL) {
+    fold_tree_forget_row(&buffer->folds, row);
+  }
+  buffer_row_free(row);
+}
+
+void buffer_set_mark(Buffer* buffer, int mark, BufferRow* row, int column) {
+  if (buffer == NULL || mark < 0 || mark >= BUFFER_NUMBER_OF_MARKS) {
+    return;
+  }
+  buffer_reference_row(&buffer->marks[mark], row, column);
+}
+
+const BufferMark* buffer_get_mark(const Buffer* buffer, int mark) {
+  if (buffer == NULL || mark < 0 || mark >= BUFFER_NUMBER_OF_MARKS ||
+      buffer->marks[mark].row == NULL) {
+    return NULL;
+  }
+  return &buffer->marks[mark];
+}
+
+static void buffer_append_jump(Buffer* buffer, BufferRow* row, int column) {
+  BufferJumplist* list = buffer->jumplist;
+  if (list->number_of_jumps == BUFFER_JUMPLIST_SIZE) {
+    // the oldest jump goes
+    buffer_reference_row(&list->jumps[0].mark, NULL, 0);
+    memmove(&list->jumps[0], &list->jumps[1],
+            sizeof(BufferJump) * (BUFFER_JUMPLIST_SIZE - 1));
+    --list->number_of_jumps;
+  }
+  BufferJump* jump = &list->jumps[list->number_of_jumps++];
+  jump->buffer = buffer;
+  jump->mark.row = NULL;
+  buffer_reference_row(&jump->mark, row, column);
+}
+
+void buffer_push_jump(Buffer* buffer, BufferRow* row, int column) {
+  if (buffer == NULL || buffer->jumplist == NULL || row == NULL) {
+    return;
+  }
+  BufferJumplist* list = buffer->jumplist;
+  while (list->number_of_jumps > list->jump_position) {
+    buffer_reference_row(&list->jumps[--list->number_of_jumps].mark, NULL, 0);
+  }
+  buffer_append_jump(buffer, row, column);
+  list->jump_position = list->number_of_jumps;
+}
+
+bool buffer_jump_back(Buffer* buffer,
+                      BufferRow* row,
+                      int column,
+                      BufferJump* target) {
+  if (buffer == NULL || buffer->jumplist == NULL ||
+      buffer->jumplist->jump_position == 0) {
+    return false;
+  }
+  BufferJumplist* list = buffer->jumplist;
+  if (list->jump_position == list->number_of_jumps) {
+    // Ctrl-I comes back here
+    buffer_append_jump(buffer, row, column);
+    list->jump_position = list->number_of_jumps - 1;
+  }
+  *target = list->jumps[--list->jump_position];
+  return true;
+}
+
+bool buffer_jump_forward(Buffer* buffer, BufferJump* target) {
+  if (buffer == NULL || buffer->jumplist == NULL ||
+      buffer->jumplist->jump_position + 1 >= buffer->jumplist->number_of_jumps) {
+    return false;
+  }
+  *target = buffer->jumplist->jumps[++buffer->jumplist->jump_position];
+  return true;
+}
+
 static bool buffer_append_list_row(Buffer* buffer, BufferRow* new_row) {
   if (buffer == NULL || new_row == NULL) {
     return false;
   }
 
+  // appends come in bulk from loading, the tree is rebuilt when needed
+  buffer_tree_invalidate(buffer);
   // list is empty
   if (buffer->tail == NULL) {
     buffer->head = new_row;
@@ -50,7 +339,7 @@ static bool buffer_append_list_row(Buffer* buffer, BufferRow* new_row) {
 }
 
 static void buffer_insert_below_current(Buffer* buffer) {
-  BufferRow* new_row = (BufferRow*)malloc(sizeof(BufferRow));
+  BufferRow* new_row = (BufferRow*)calloc(1, sizeof(BufferRow));
   if (new_row == NULL) {
     return;  // Memory allocation failed
   }
@@ -84,10 +373,11 @@ static void buffer_insert_below_current(Buffer* buffer) {
   }
   current->next = new_row;
   buffer->number_of_rows++;
+  buffer_tree_insert_after(buffer, current, new_row);
 }
 
 Buffer* buffer_alloc() {
-  Buffer* buffer = (Buffer*)malloc(sizeof(Buffer));
+  Buffer* buffer = (Buffer*)calloc(1, sizeof(Buffer));
   if (buffer) {
     buffer->head = NULL;
     buffer->tail = NULL;
@@ -100,12 +390,12 @@ Buffer* buffer_alloc() {
 
 void buffer_free(Buffer* buffer) {
   if (buffer) {
+    buffer_forget_jumps(buffer->jumplist, buffer, NULL);
+    fold_tree_clear(&buffer->folds);
     BufferRow* current = buffer->head;
     while (current) {
       BufferRow* next = current->next;
-      free(current->data);
-      free(current->highlight_data);
-      free(current);
+      buffer_row_free(current);
       current = next;
     }
     if (buffer->filename) {
@@ -121,7 +411,7 @@ bool buffer_append_line(Buffer* buffer, const char* line) {
     return false;
   }
 
-  BufferRow* new_row = (BufferRow*)malloc(sizeof(BufferRow));
+  BufferRow* new_row = (BufferRow*)calloc(1, sizeof(BufferRow));
   if (new_row == NULL) {
     return false;  // Memory allocation failed
   }
@@ -170,16 +460,26 @@ BufferRow* buffer_get_first_row(const Buffer* buffer) {
   return buffer->head;
 }
 
-BufferRow* buffer_get_row(const Buffer* buffer, int index) {
+BufferRow* buffer_get_row(Buffer* buffer, int index) {
   if (buffer == NULL || index < 0 || index >= buffer->number_of_rows) {
     return NULL;
   }
-
-  BufferRow* current = buffer->head;
-  for (int i = 0; i < index && current != NULL; i++) {
-    current = current->next;
+  if (!buffer->tree_valid) {
+    buffer_tree_rebuild(buffer);
   }
-  return current;
+  BufferRow* node = buffer->tree_root;
+  while (node != NULL) {
+    const int left_size = buffer_tree_size(node->tree_left);
+    if (index < left_size) {
+      node = node->tree_left;
+    } else if (index == left_size) {
+      return node;
+    } else {
+      index -= left_size + 1;
+      node = node->tree_right;
+    }
+  }
+  return NULL;
 }
 
 BufferRow* buffer_get_current_line(const Buffer* buffer) {
@@ -194,35 +494,22 @@ void buffer_load_from_file(Buffer* buffer, const char* filename) {
     return;
   }
 
-  FILE* file = fopen(filename, "r");
   buffer->filename = strdup(filename);
-  if (file == NULL) {
-    buffer_append_line(buffer, "\n");
-    return;
+  LineSplitter splitter;
+  line_splitter_init(&splitter);
+  // a file which can not be read opens as an empty buffer
+  line_splitter_read_file(&splitter, filename);
+  BufferRow* head = NULL;
+  BufferRow* tail = NULL;
+  int number_of_rows = 0;
+  line_splitter_take_rows(&splitter, &head, &tail, &number_of_rows);
+  line_splitter_deinit(&splitter);
+  // ensures at least one empty line
+  buffer_replace_rows(buffer, NULL, 0, head, tail, number_of_rows);
+  // the identifier index wants every row of an opened file
+  for (int i = 0; i < number_of_rows; ++i, head = head->next) {
+    buffer_row_highlight_line(head);
   }
-
-  char* line = NULL;
-  size_t len = 0;
-  int lines = 0;
-
-  while (getline(&line, &len, file) != EOF) {
-    if (line != NULL) {
-      buffer_append_line(buffer, line);
-      free(line);
-      line = NULL;
-      lines++;
-    }
-  }
-  if (line) {
-    free(line);
-    line = NULL;
-  }
-
-  if (lines == 0) {
-    buffer_append_line(buffer, "\n");  // Ensure at least one empty line
-  }
-
-  fclose(file);
 }
 
 void buffer_remove_row(Buffer* buffer, BufferRow* row) {
@@ -242,11 +529,209 @@ void buffer_remove_row(Buffer* buffer, BufferRow* row) {
     buffer->tail = row->prev;  // Remove tail
   }
 
-  free(row->data);
-  free(row);
+  buffer_tree_remove(buffer, row);
+  buffer_drop_row(buffer, row);
   buffer->number_of_rows--;
 }
 
+int buffer_remove_current_rows(Buffer* buffer, int count) {
+  if (buffer == NULL || buffer->current_row == NULL || count <= 0) {
+    return 0;  // Invalid buffer or current row
+  }
+
+  BufferRow* first = buffer->current_row;
+  BufferRow* before = first->prev;
+  BufferRow* row = first;
+  int removed = 0;
+  if (count > BUFFER_TREE_REBUILD_ROWS) {
+    buffer_tree_invalidate(buffer);
+  }
+  // unlink the whole range at once, neighbours are fixed up only once
+  while (row != NULL && removed < count) {
+    BufferRow* next = row->next;
+    buffer_tree_remove(buffer, row);
+    buffer_drop_row(buffer, row);
+    row = next;
+    ++removed;
+  }
+
+  if (before != NULL) {
+    before->next = row;
+  } else {
+    buffer->head = row;
+  }
+  if (row != NULL) {
+    row->prev = before;
+    buffer->current_row = row;
+  } else {
+    buffer->tail = before;
+    buffer->current_row = before;
+  }
+  buffer->number_of_rows -= removed;
+
+  if (buffer->number_of_rows == 0) {
+    buffer_append_line(buffer, "");
+  } else if (buffer->current_row != NULL) {
+    // comment or string state may have changed for the rows below
+    buffer_row_highlight_line(buffer->current_row);
+  }
+  return removed;
+}
+
+// keeps row after the previously kept one, gaps collects rows following removed
+// ones for highlighting
+static void buffer_link_kept_row(Buffer* buffer,
+                                 BufferRow* kept,
+                                 BufferRow* row,
+                                 bool after_removed,
+                                 BufferRow*** gaps,
+                                 int* number_of_gaps,
+                                 int* gaps_capacity) {
+  row->prev = kept;
+  if (kept != NULL) {
+    kept->next = row;
+  } else {
+    buffer->head = row;
+  }
+  if (!after_removed) {
+    return;
+  }
+  if (*number_of_gaps == *gaps_capacity) {
+    const int capacity = *gaps_capacity ? *gaps_capacity * 2 : 16;
+    BufferRow** resized = realloc(*gaps, sizeof(BufferRow*) * capacity);
+    if (resized == NULL) {
+      return;  // only the highlighting of this row is skipped
+    }
+    *gaps = resized;
+    *gaps_capacity = capacity;
+  }
+  (*gaps)[(*number_of_gaps)++] = row;
+}
+
+int buffer_remove_marked_rows(Buffer* buffer,
+                              BufferRow* first,
+                              int count,
+                              const bool* marks) {
+  if (buffer == NULL || first == NULL || count <= 0) {
+    return 0;
+  }
+  BufferRow** gaps = NULL;
+  int number_of_gaps = 0;
+  int gaps_capacity = 0;
+
+  BufferRow* kept = first->prev;
+  BufferRow* row = first;
+  bool after_removed = false;
+  bool current_removed = false;
+  int removed = 0;
+  buffer_tree_invalidate(buffer);
+  for (int i = 0; i < count && row != NULL; ++i) {
+    BufferRow* next = row->next;
+    if (marks[i]) {
+      current_removed = current_removed || row == buffer->current_row;
+      buffer_drop_row(buffer, row);
+      after_removed = true;
+      ++removed;
+    } else {
+      buffer_link_kept_row(buffer, kept, row, after_removed, &gaps, &number_of_gaps,
+                           &gaps_capacity);
+      if (current_removed) {
+        buffer->current_row = row;
+        current_removed = false;
+      }
+      after_removed = false;
+      kept = row;
+    }
+    row = next;
+  }
+
+  // row is the first one after the range
+  if (row != NULL) {
+    buffer_link_kept_row(buffer, kept, row, after_removed, &gaps, &number_of_gaps,
+                         &gaps_capacity);
+    if (current_removed) {
+      buffer->current_row = row;
+    }
+  } else {
+    if (kept != NULL) {
+      kept->next = NULL;
+    } else {
+      buffer->head = NULL;
+    }
+    buffer->tail = kept;
+    if (current_removed) {
+      buffer->current_row = kept;
+    }
+  }
+  buffer->number_of_rows -= removed;
+
+  if (buffer->number_of_rows == 0) {
+    buffer->current_row = NULL;
+    buffer_append_line(buffer, "");
+  }
+  for (int i = 0; i < number_of_gaps; ++i) {
+    buffer_row_highlight_line(gaps[i]);
+  }
+  free(gaps);
+  return removed;
+}
+
+void buffer_replace_rows(Buffer* buffer,
+                         BufferRow* first,
+                         int count,
+                         BufferRow* head,
+                         BufferRow* tail,
+                         int number_of_rows) {
+  if (buffer == NULL) {
+    return;
+  }
+  BufferRow* before = first != NULL ? first->prev : buffer->tail;
+  BufferRow* row = first;
+  bool current_removed = false;
+  buffer_tree_invalidate(buffer);
+  for (int i = 0; i < count && row != NULL; ++i) {
+    BufferRow* next = row->next;
+    current_removed = current_removed || row == buffer->current_row;
+    buffer_drop_row(buffer, row);
+    --buffer->number_of_rows;
+    row = next;
+  }
+
+  // row is the first one after the replaced ones
+  if (head != NULL) {
+    head->prev = before;
+    tail->next = row;
+  } else {
+    head = row;
+    tail = before;
+  }
+  if (before != NULL) {
+    before->next = head;
+  } else {
+    buffer->head = head;
+  }
+  if (row != NULL) {
+    row->prev = tail;
+  } else {
+    buffer->tail = tail;
+  }
+  buffer->number_of_rows += number_of_rows;
+  if (current_removed || buffer->current_row == NULL) {
+    buffer->current_row = head != NULL ? head : before;
+  }
+
+  if (buffer->number_of_rows == 0) {
+    buffer->current_row = NULL;
+    buffer_append_line(buffer, "");
+    return;
+  }
+  // a comment may be opened or closed above it now, after new rows it is
+  // highlighted again with them
+  if (row != NULL && count > 0 && number_of_rows == 0) {
+    buffer_row_highlight_line(row);
+  }
+}
+
 int buffer_remove_current_row(Buffer* buffer) {
   if (buffer == NULL || buffer->current_row == NULL) {
     return 0;  // Invalid buffer or current row
@@ -268,28 +753,30 @@ int buffer_remove_current_row(Buffer* buffer) {
   return row_offset;
 }
 
-void buffer_scroll_rows(Buffer* buffer, int lines) {
-  if (buffer == NULL) {
-    return;  // Invalid buffer
+void buffer_set_current_row(Buffer* buffer, BufferRow* row) {
+  buffer->current_row = row;
+}
+
+int buffer_scroll_rows(Buffer* buffer, int lines) {
+  if (buffer == NULL || buffer->current_row == NULL) {
+    return 0;  // Invalid buffer
   }
 
+  BufferRow* row = buffer->current_row;
+  int scrolled = 0;
   if (lines > 0) {
-    for (int i = 0; i < lines && buffer->current_row != NULL; i++) {
-      if (buffer->current_row->next != NULL) {
-        buffer->current_row = buffer->current_row->next;
-      } else {
-        return;
-      }
+    while (scrolled < lines && row->next != NULL) {
+      row = row->next;
+      ++scrolled;
     }
   } else if (lines < 0) {
-    for (int i = 0; i < -lines && buffer->current_row != NULL; i++) {
-      if (buffer->current_row->prev != NULL) {
-        buffer->current_row = buffer->current_row->prev;
-      } else {
-        return;
-      }
+    while (scrolled > lines && row->prev != NULL) {
+      row = row->prev;
+      --scrolled;
     }
   }
+  buffer->current_row = row;
+  return scrolled;
 }
 
 void buffer_scroll_to_top(Buffer* buffer) {
@@ -340,16 +827,257 @@ int buffer_join_current_line_with_previous(Buffer* buffer) {
   if (current == buffer->head) {
     return number_of_chars;
   }
+  BufferRow* previous = current->prev;
   number_of_chars = current->len;
-  buffer_row_append_str(current->prev, current->data, current->len);
+  buffer_row_append_str(previous, current->data, current->len);
   buffer_remove_current_row(buffer);
-  buffer->current_row = current->prev;
+  buffer->current_row = previous;
   return number_of_chars + 1;
 }
 
+// stops where depth unmatched brackets of type are left, opening ones going
+// forward and closing ones going backward
+static int buffer_scan_brackets(const BufferRow* row,
+                                int column,
+                                int type,
+                                bool backward,
+                                int* depth) {
+  const int step = backward ? -1 : 1;
+  const int same = backward ? -type : type;
+  for (int i = column; i >= 0 && i < row->len; i += step) {
+    const int bracket = buffer_row_get_bracket(row, i);
+    if (bracket == same) {
+      ++*depth;
+    } else if (bracket == -same && --*depth == 0) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+// rows which cannot hold the match are skipped with their bracket summary
+static bool buffer_find_unmatched_bracket(BufferRow* row,
+                                          int line,
+                                          int column,
+                                          int type,
+                                          bool backward,
+                                          BufferPosition* result) {
+  int depth = 1;
+  int position = buffer_scan_brackets(row, column, type, backward, &depth);
+  while (position < 0) {
+    row = backward ? row->prev : row->next;
+    if (row == NULL) {
+      return false;
+    }
+    line += backward ? -1 : 1;
+    buffer_row_highlight_pending(row);
+    const int balance = row->bracket_balance[type - 1];
+    const int lowest = row->bracket_lowest[type - 1];
+    // backward the highest sum from the row end is balance - lowest
+    if (backward ? balance - lowest < depth : depth + lowest > 0) {
+      depth += backward ? -balance : balance;
+      continue;
+    }
+    position = buffer_scan_brackets(row, backward ? row->len - 1 : 0, type,
+                                    backward, &depth);
+  }
+  result->row = row;
+  result->line = line;
+  result->column = position;
+  result->length = 1;
+  result->wrapped = false;
+  return true;
+}
+
+bool buffer_find_matching_bracket(BufferRow* row,
+                                  int line,
+                                  int column,
+                                  BufferPosition* result) {
+  if (row == NULL || result == NULL) {
+    return false;
+  }
+  // e.g. a row read with :r is only highlighted once it is needed
+  buffer_row_highlight_pending(row);
+  const int bracket = buffer_row_get_bracket(row, column);
+  if (bracket > 0) {
+    return buffer_find_unmatched_bracket(row, line, column + 1, bracket, false,
+                                         result);
+  } else if (bracket < 0) {
+    return buffer_find_unmatched_bracket(row, line, column - 1, -bracket, true,
+                                         result);
+  }
+  return false;
+}
+
+bool buffer_find_enclosing_brackets(BufferRow* row,
+                                    int line,
+                                    int column,
+                                    int type,
+                                    BufferPosition* start,
+                                    BufferPosition* end) {
+  if (row == NULL || start == NULL || end == NULL || type <= 0 ||
+      type > BUFFER_ROW_BRACKET_TYPES) {
+    return false;
+  }
+  buffer_row_highlight_pending(row);
+  const int bracket = buffer_row_get_bracket(row, column);
+  bool found = true;
+  if (bracket == type) {
+    start->row = row;
+    start->line = line;
+    start->column = column;
+    start->length = 1;
+    start->wrapped = false;
+  } else if (bracket == -type) {
+    found = buffer_find_matching_bracket(row, line, column, start);
+  } else {
+    found = buffer_find_unmatched_bracket(row, line, column - 1, type, true, start);
+  }
+  return found &&
+         buffer_find_matching_bracket(start->row, start->line, start->column, end);
+}
+
 const char* buffer_get_filename(const Buffer* buffer) {
   if (buffer == NULL) {
     return NULL;  // Invalid buffer
   }
   return buffer->filename;
 }
+
+static void buffer_prefetch_row(const BufferRow* row) {
+#if defined(__GNUC__) && !defined(__TINYC__)
+  // rows are scattered on the heap, fetch the next payload while this is scanned
+  if (row != NULL) {
+    __builtin_prefetch(row->data);
+  }
+#else
+  (void)row;
+#endif
+}
+
+static bool buffer_find_forward(const Buffer* buffer,
+                                const SearchPattern* pattern,
+                                BufferRow* start_row,
+                                int line,
+                                int column,
+                                BufferPosition* result) {
+  SearchMatch match;
+  if (search_find_forward(pattern, start_row->data, start_row->len, column + 1,
+                          &match)) {
+    result->row = start_row;
+    result->line = line;
+    result->column = match.start;
+    result->length = match.length;
+    return true;
+  }
+
+  BufferRow* row = start_row->next;
+  ++line;
+  if (row == NULL) {
+    row = buffer->head;
+    line = 0;
+    result->wrapped = true;
+  }
+
+  while (row != start_row) {
+    buffer_prefetch_row(row->next);
+    if (search_find_forward(pattern, row->data, row->len, 0, &match)) {
+      result->row = row;
+      result->line = line;
+      result->column = match.start;
+      result->length = match.length;
+      return true;
+    }
+    row = row->next;
+    ++line;
+    if (row == NULL) {
+      row = buffer->head;
+      line = 0;
+      result->wrapped = true;
+    }
+  }
+
+  // wrapped back to the start row, the part before the cursor is left
+  if (search_find_forward(pattern, start_row->data, start_row->len, 0, &match) &&
+      match.start <= column) {
+    result->row = start_row;
+    result->line = line;
+    result->column = match.start;
+    result->length = match.length;
+    return true;
+  }
+  return false;
+}
+
+static bool buffer_find_backward(const Buffer* buffer,
+                                 const SearchPattern* pattern,
+                                 BufferRow* start_row,
+                                 int line,
+                                 int column,
+                                 BufferPosition* result) {
+  SearchMatch match;
+  if (search_find_backward(pattern, start_row->data, start_row->len, column,
+                           &match)) {
+    result->row = start_row;
+    result->line = line;
+    result->column = match.start;
+    result->length = match.length;
+    return true;
+  }
+
+  BufferRow* row = start_row->prev;
+  --line;
+  if (row == NULL) {
+    row = buffer->tail;
+    line = buffer->number_of_rows - 1;
+    result->wrapped = true;
+  }
+
+  while (row != start_row) {
+    buffer_prefetch_row(row->prev);
+    if (search_find_backward(pattern, row->data, row->len, row->len, &match)) {
+      result->row = row;
+      result->line = line;
+      result->column = match.start;
+      result->length = match.length;
+      return true;
+    }
+    row = row->prev;
+    --line;
+    if (row == NULL) {
+      row = buffer->tail;
+      line = buffer->number_of_rows - 1;
+      result->wrapped = true;
+    }
+  }
+
+  if (search_find_backward(pattern, start_row->data, start_row->len,
+                           start_row->len, &match) &&
+      match.start >= column) {
+    result->row = start_row;
+    result->line = line;
+    result->column = match.start;
+    result->length = match.length;
+    return true;
+  }
+  return false;
+}
+
+bool buffer_find(const Buffer* buffer,
+                 const SearchPattern* pattern,
+                 BufferRow* row,
+                 int line,
+                 int column,
+                 bool backward,
+                 BufferPosition* result) {
+  if (buffer == NULL || pattern == NULL || row == NULL || result == NULL ||
+      search_pattern_is_empty(pattern)) {
+    return false;
+  }
+
+  result->wrapped = false;
+  if (backward) {
+    return buffer_find_backward(buffer, pattern, row, line, column, result);
+  }
+  return buffer_find_forward(buffer, pattern, row, line, column, result);
+}
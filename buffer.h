@@ -21,6 +21,34 @@
 #include <stddef.h>
 
 #include "buffer_row.h"
+#include "fold.h"
+#include "search.h"
+
+#define BUFFER_NUMBER_OF_MARKS 26
+#define BUFFER_JUMPLIST_SIZE 100
+
+// position anchored to a row, it moves with the row and is dropped with it
+typedef struct BufferMark {
+  // NULL when not set
+  BufferRow* row;
+  int column;
+} BufferMark;
+
+struct Buffer;
+
+typedef struct BufferJump {
+  struct Buffer* buffer;
+  BufferMark mark;
+} BufferJump;
+
+// Ctrl-O and Ctrl-I, shared by the buffers of an editor so jumps to a tag or
+// a :grep match in another file can be followed back
+typedef struct BufferJumplist {
+  BufferJump jumps[BUFFER_JUMPLIST_SIZE];
+  int number_of_jumps;
+  // number_of_jumps when not moving through the list
+  int jump_position;
+} BufferJumplist;
 
 typedef struct Buffer {
   BufferRow* head;
@@ -28,20 +56,61 @@ typedef struct Buffer {
   BufferRow* current_row;
   int number_of_rows;
   char* filename;
+  // rebuilt on the next index query after bulk changes
+  BufferRow* tree_root;
+  bool tree_valid;
+  unsigned int tree_seed;
+  BufferMark marks[BUFFER_NUMBER_OF_MARKS];
+  // jumps to rows of the buffer are dropped with the rows, NULL when the
+  // buffer is not in a jumplist
+  BufferJumplist* jumplist;
+  FoldTree folds;
 } Buffer;
 
+typedef struct BufferPosition {
+  BufferRow* row;
+  int line;
+  int column;
+  int length;
+  // search continued from the other end of the buffer
+  bool wrapped;
+} BufferPosition;
+
 Buffer* buffer_alloc();
 void buffer_free(Buffer* buffer);
 
 // buffer getter functions
 BufferRow* buffer_get_first_row(const Buffer* buffer);
-BufferRow* buffer_get_row(const Buffer* buffer, int index);
+// found in the row tree, rebuilt first after bulk changes
+BufferRow* buffer_get_row(Buffer* buffer, int index);
 BufferRow* buffer_get_current_line(const Buffer* buffer);
 
 void buffer_load_from_file(Buffer* buffer, const char* filename);
 bool buffer_append_line(Buffer* buffer, const char* line);
 
 void buffer_remove_row(Buffer* buffer, BufferRow* row);
+// removes up to count rows starting from the current one, returns the number of
+// removed rows, the buffer always keeps at least one (empty) row
+int buffer_remove_current_rows(Buffer* buffer, int count);
+
+// removes the rows of [first, first + count) with marks[i] set in a single
+// pass, rows after removed ones are highlighted once all links are fixed,
+// returns the number of removed rows
+int buffer_remove_marked_rows(Buffer* buffer,
+                              BufferRow* first,
+                              int count,
+                              const bool* marks);
+
+// replaces count rows from first with the rows linked from head to tail in a
+// single splice, NULL first inserts them at the end. Highlighting of the new
+// rows is left pending and the current row moves to the first of them when it
+// was replaced.
+void buffer_replace_rows(Buffer* buffer,
+                         BufferRow* first,
+                         int count,
+                         BufferRow* head,
+                         BufferRow* tail,
+                         int number_of_rows);
 
 // result:
 // +1 - next row is now current
@@ -50,8 +119,10 @@ void buffer_remove_row(Buffer* buffer, BufferRow* row);
 int buffer_remove_current_row(Buffer* buffer);
 
 // buffer scroll functions
-// +/- lines from the current row
-void buffer_scroll_rows(Buffer* buffer, int lines);
+// row must belong to the buffer, e.g. one remembered by an index
+void buffer_set_current_row(Buffer* buffer, BufferRow* row);
+// +/- lines from the current row, returns the number of rows actually scrolled
+int buffer_scroll_rows(Buffer* buffer, int lines);
 void buffer_scroll_to_top(Buffer* buffer);
 
 bool buffer_current_is_first_row(const Buffer* buffer);
@@ -61,3 +132,47 @@ void buffer_break_current_line(Buffer* buffer, int index);
 int buffer_join_current_line_with_previous(Buffer* buffer);
 
 const char* buffer_get_filename(const Buffer* buffer);
+
+// index of the row in the buffer in O(log n)
+int buffer_get_row_index(Buffer* buffer, const BufferRow* row);
+
+// mark is 0 for 'a'
+void buffer_set_mark(Buffer* buffer, int mark, BufferRow* row, int column);
+// NULL when the mark is not set or its row was removed
+const BufferMark* buffer_get_mark(const Buffer* buffer, int mark);
+// position in the buffer left by a jump, entries after the current one in the
+// list are dropped
+void buffer_push_jump(Buffer* buffer, BufferRow* row, int column);
+// Ctrl-O, row and column of the buffer are remembered when leaving the end of
+// the list
+bool buffer_jump_back(Buffer* buffer,
+                      BufferRow* row,
+                      int column,
+                      BufferJump* target);
+// Ctrl-I
+bool buffer_jump_forward(Buffer* buffer, BufferJump* target);
+
+// searches for the pattern starting next to (line, column) of row, wraps around
+// at the buffer boundaries
+bool buffer_find(const Buffer* buffer,
+                 const SearchPattern* pattern,
+                 BufferRow* row,
+                 int line,
+                 int column,
+                 bool backward,
+                 BufferPosition* result);
+
+// bracket matching the one at (line, column) of row, brackets in strings and
+// comments are ignored
+bool buffer_find_matching_bracket(BufferRow* row,
+                                  int line,
+                                  int column,
+                                  BufferPosition* result);
+// innermost pair of brackets of type (see buffer_row_get_bracket) around
+// (line, column), a bracket at the position belongs to the pair
+bool buffer_find_enclosing_brackets(BufferRow* row,
+                                    int line,
+                                    int column,
+                                    int type,
+                                    BufferPosition* start,
+                                    BufferPosition* end);
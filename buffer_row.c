@@ -23,6 +23,8 @@
 
 #include <stdio.h>
 
+#include "profile.h"
+
 const char whitespace[] = " \f\n\r\t\v";
 
 bool is_digit(char c) {
@@ -44,12 +46,12 @@ static const char* types[] = {"int",      "char",   "float",  "double",
                               "unsigned", "signed", "size_t", NULL};
 
 static const char* keywords_2[] = {
-  "false", "true", "NULL", "FALSE", "TRUE",
+  "false", "true", "NULL", "FALSE", "TRUE", NULL,
 };
 
 static bool is_token(const char** array, const char* word, int n) {
   for (const char** kw = array; *kw != NULL; ++kw) {
-    if (strlen(*kw) != n) {
+    if ((int)strlen(*kw) != n) {
       continue;
     }
     if (strncmp(*kw, word, n) == 0) {
@@ -59,7 +61,45 @@ static bool is_token(const char** array, const char* word, int n) {
   return false;
 }
 
+// shared by all buffers, see buffer_row_set_identifier_index
+static IdentifierIndex* buffer_row_identifier_index = NULL;
+
+void buffer_row_set_identifier_index(IdentifierIndex* index) {
+  buffer_row_identifier_index = index;
+}
+
+static void buffer_row_release_identifiers(BufferRow* row) {
+  if (buffer_row_identifier_index == NULL) {
+    return;
+  }
+  for (int i = 0; i < row->number_of_identifiers; ++i) {
+    identifier_index_release(buffer_row_identifier_index, row->identifiers[i]);
+  }
+  row->number_of_identifiers = 0;
+}
+
+static void buffer_row_add_identifier(BufferRow* row, int start, int end) {
+  if (buffer_row_identifier_index == NULL) {
+    return;
+  }
+  if (row->number_of_identifiers == row->identifiers_capacity) {
+    const int capacity = row->identifiers_capacity ? row->identifiers_capacity * 2 : 4;
+    int* identifiers = realloc(row->identifiers, sizeof(int) * capacity);
+    if (identifiers == NULL) {
+      return;
+    }
+    row->identifiers = identifiers;
+    row->identifiers_capacity = capacity;
+  }
+  const int id =
+    identifier_index_add(buffer_row_identifier_index, &row->data[start], end - start);
+  if (id >= 0) {
+    row->identifiers[row->number_of_identifiers++] = id;
+  }
+}
+
 static bool highlight_token(BufferRow* row, int token_start, int i) {
+  buffer_row_add_identifier(row, token_start, i);
   if (is_token(keywords_1, &row->data[token_start], i - token_start)) {
     for (int j = token_start; j < i; ++j) {
       row->highlight_data[j] = (char)EHighlightToken_Keyword;
@@ -84,13 +124,62 @@ static bool highlight_token(BufferRow* row, int token_start, int i) {
   return false;
 }
 
+static int buffer_row_get_bracket_type(char c) {
+  switch (c) {
+    case '(':
+      return 1;
+    case ')':
+      return -1;
+    case '[':
+      return 2;
+    case ']':
+      return -2;
+    case '{':
+      return 3;
+    case '}':
+      return -3;
+    default:
+      return 0;
+  }
+}
+
+int buffer_row_get_bracket(const BufferRow* row, int index) {
+  if (row == NULL || index < 0 || index >= row->len) {
+    return 0;
+  }
+  const EHighlightToken token = (EHighlightToken)row->highlight_data[index];
+  if (token == EHighlightToken_String || token == EHighlightToken_Comment ||
+      token == EHighlightToken_Digit) {
+    return 0;
+  }
+  return buffer_row_get_bracket_type(row->data[index]);
+}
+
+static void buffer_row_update_brackets(BufferRow* row) {
+  for (int type = 0; type < BUFFER_ROW_BRACKET_TYPES; ++type) {
+    row->bracket_balance[type] = 0;
+    row->bracket_lowest[type] = 0;
+  }
+  for (int i = 0; i < row->len; ++i) {
+    const int bracket = buffer_row_get_bracket(row, i);
+    if (bracket > 0) {
+      ++row->bracket_balance[bracket - 1];
+    } else if (bracket < 0) {
+      const int type = -bracket - 1;
+      if (--row->bracket_balance[type] < row->bracket_lowest[type]) {
+        row->bracket_lowest[type] = row->bracket_balance[type];
+      }
+    }
+  }
+}
+
 void buffer_row_highlight_line(BufferRow* row) {
   if (row == NULL) {
     return;  // Invalid row
   }
+  PROFILE_BEGIN(ProfileTimer_Highlight);
   int preprocessor_started = 0;
   int include_started = 0;
-  int string_chars_in_row = 0;
   int string_started = 0;
   int escape_sequence_started = 0;
   bool process_next_row = true;
@@ -101,8 +190,11 @@ void buffer_row_highlight_line(BufferRow* row) {
     }
 
     int comment_started = 0;
+    PROFILE_COUNT(ProfileCounter_RowsHighlighted, 1);
     row->dirty = true;
+    row->highlight_pending = false;
     process_next_row = false;
+    buffer_row_release_identifiers(row);
     if (row->prev) {
       if (row->prev->highlight_string_open && !row->highlight_comment_open) {
         string_started = row->prev->highlight_string_open;
@@ -232,9 +324,28 @@ void buffer_row_highlight_line(BufferRow* row) {
     if (token_start != -1) {
       highlight_token(row, token_start, row->len);
     }
+    buffer_row_update_brackets(row);
 
     row = row->next;
   }
+  PROFILE_END(ProfileTimer_Highlight);
+}
+
+void buffer_row_highlight_pending(BufferRow* row) {
+  if (row == NULL || !row->highlight_pending) {
+    return;
+  }
+  BufferRow* first = row;
+  while (first->prev != NULL && first->prev->highlight_pending) {
+    first = first->prev;
+  }
+  for (; first != row->next; first = first->next) {
+    buffer_row_highlight_line(first);
+  }
+  // highlighted before the rows above it were
+  if (row->next != NULL && !row->next->highlight_pending) {
+    buffer_row_highlight_line(row->next);
+  }
 }
 
 int buffer_row_get_offset_to_first_char(const BufferRow* row, int start_index) {
@@ -245,11 +356,15 @@ int buffer_row_get_offset_to_first_char(const BufferRow* row, int start_index) {
   return strspn(&row->data[start_index], whitespace);
 }
 
+static bool buffer_row_is_whitespace(char c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v';
+}
+
 bool buffer_row_has_whitespace_at_position(const BufferRow* row, int position) {
   if (row == NULL || position < 0 || position >= row->len) {
     return false;  // Invalid row or position
   }
-  return strchr(whitespace, row->data[position]) != NULL;
+  return buffer_row_is_whitespace(row->data[position]);
 }
 
 int buffer_row_get_length(const BufferRow* row) {
@@ -259,70 +374,230 @@ int buffer_row_get_length(const BufferRow* row) {
   return row->len;  // Return the length of the row
 }
 
-int buffer_row_get_offset_to_next_word(const BufferRow* row, int start_index) {
-  if (row == NULL || start_index < 0 || start_index >= row->len) {
-    return 0;  // Invalid row or start index
+#if defined(__GNUC__) && !defined(__TINYC__)
+static int buffer_row_count_bits(uint64_t bits) {
+  return __builtin_popcountll(bits);
+}
+
+static int buffer_row_lowest_bit(uint64_t bits) {
+  return __builtin_ctzll(bits);
+}
+
+static int buffer_row_highest_bit(uint64_t bits) {
+  return 63 - __builtin_clzll(bits);
+}
+#else
+static int buffer_row_count_bits(uint64_t bits) {
+  int count = 0;
+  for (; bits != 0; bits &= bits - 1) {
+    ++count;
   }
-  int stripped = 0;
-  bool first_char = false;
+  return count;
+}
 
-  int offset = 0;
-  for (offset = start_index + offset; offset < row->len; ++offset) {
-    if (!first_char) {
-      if (!buffer_row_has_whitespace_at_position(row, offset)) {
-        first_char = true;  // Found the first non-whitespace character
-      } else {
-        ++stripped;
-        continue;
+static int buffer_row_lowest_bit(uint64_t bits) {
+  int bit = 0;
+  for (; (bits & 1) == 0; bits >>= 1) {
+    ++bit;
+  }
+  return bit;
+}
+
+static int buffer_row_highest_bit(uint64_t bits) {
+  int bit = 0;
+  for (; bits > 1; bits >>= 1) {
+    ++bit;
+  }
+  return bit;
+}
+#endif
+
+// the cache is not a part of the row text, so it is filled through const rows
+static bool buffer_row_update_word_bits(const BufferRow* const_row) {
+  BufferRow* row = (BufferRow*)const_row;
+  if (row->word_bits_valid) {
+    return true;
+  }
+  const int number_of_words = (row->len + 63) / 64;
+  if (2 * number_of_words > row->word_bits_size) {
+    uint64_t* bits =
+      (uint64_t*)realloc(row->word_bits, 2 * number_of_words * sizeof(uint64_t));
+    if (bits == NULL) {
+      return false;
+    }
+    row->word_bits = bits;
+    row->word_bits_size = 2 * number_of_words;
+  }
+  uint64_t* starts = row->word_bits;
+  uint64_t* ends = row->word_bits + number_of_words;
+  // non whitespace characters first, then starts and ends from their edges
+  for (int k = 0; k < number_of_words; ++k) {
+    const char* data = &row->data[k * 64];
+    const int length = row->len - k * 64 < 64 ? row->len - k * 64 : 64;
+    uint64_t word = 0;
+    for (int i = 0; i < length; ++i) {
+      if (!buffer_row_is_whitespace(data[i])) {
+        word |= (uint64_t)1 << i;
       }
     }
-    if (stripped > 0) {
-      offset = stripped;
-      break;
+    ends[k] = word;
+  }
+  uint64_t previous = 0;
+  for (int k = 0; k < number_of_words; ++k) {
+    const uint64_t word = ends[k];
+    const uint64_t next = k + 1 < number_of_words ? ends[k + 1] : 0;
+    starts[k] = word & ~((word << 1) | (previous >> 63));
+    ends[k] = word & ~((word >> 1) | (next << 63));
+    previous = word;
+  }
+  row->word_bits_valid = true;
+  return true;
+}
+
+// whole 64 bit words are skipped by counting their bits
+static int buffer_row_scan_forward(const uint64_t* bits,
+                                   int number_of_words,
+                                   int from,
+                                   int* count) {
+  if (from < 0) {
+    from = 0;
+  }
+  int k = from / 64;
+  if (k >= number_of_words || *count <= 0) {
+    return -1;
+  }
+  uint64_t word = bits[k] & (~(uint64_t)0 << (from % 64));
+  while (true) {
+    const int found = buffer_row_count_bits(word);
+    if (found >= *count) {
+      for (int i = 1; i < *count; ++i) {
+        word &= word - 1;
+      }
+      *count = 0;
+      return k * 64 + buffer_row_lowest_bit(word);
     }
-    if (first_char && buffer_row_has_whitespace_at_position(row, offset)) {
-      break;
+    *count -= found;
+    if (++k >= number_of_words) {
+      return -1;
     }
+    word = bits[k];
   }
+}
 
-  // strip leading whitespace
-  for (; offset < row->len; ++offset) {
-    if (!buffer_row_has_whitespace_at_position(row, offset)) {
-      return offset - start_index;
+static int buffer_row_scan_backward(const uint64_t* bits,
+                                    int number_of_words,
+                                    int to,
+                                    int* count) {
+  if (to >= number_of_words * 64) {
+    to = number_of_words * 64 - 1;
+  }
+  if (to < 0 || *count <= 0) {
+    return -1;
+  }
+  int k = to / 64;
+  uint64_t word = bits[k];
+  if (to % 64 != 63) {
+    word &= ((uint64_t)1 << (to % 64 + 1)) - 1;
+  }
+  while (true) {
+    const int found = buffer_row_count_bits(word);
+    if (found >= *count) {
+      for (int i = 1; i < *count; ++i) {
+        word &= ~((uint64_t)1 << buffer_row_highest_bit(word));
+      }
+      *count = 0;
+      return k * 64 + buffer_row_highest_bit(word);
     }
+    *count -= found;
+    if (--k < 0) {
+      return -1;
+    }
+    word = bits[k];
   }
+}
 
-  if (first_char) {
-    return row->len - start_index;  // Return the offset to the end of the line
+int buffer_row_find_next_word_start(const BufferRow* row, int index, int* count) {
+  if (row == NULL || !buffer_row_update_word_bits(row)) {
+    return -1;
   }
-  return 0;
+  return buffer_row_scan_forward(row->word_bits, (row->len + 63) / 64, index + 1,
+                                 count);
+}
+
+int buffer_row_find_prev_word_start(const BufferRow* row, int index, int* count) {
+  if (row == NULL || !buffer_row_update_word_bits(row)) {
+    return -1;
+  }
+  return buffer_row_scan_backward(row->word_bits, (row->len + 63) / 64, index - 1,
+                                  count);
+}
+
+int buffer_row_find_next_word_end(const BufferRow* row, int index, int* count) {
+  if (row == NULL || !buffer_row_update_word_bits(row)) {
+    return -1;
+  }
+  const int number_of_words = (row->len + 63) / 64;
+  return buffer_row_scan_forward(row->word_bits + number_of_words, number_of_words,
+                                 index + 1, count);
+}
+
+int buffer_row_get_offset_to_next_word(const BufferRow* row, int start_index) {
+  if (row == NULL || start_index < 0 || start_index >= row->len) {
+    return 0;  // Invalid row or start index
+  }
+  int count = 1;
+  const int position = buffer_row_find_next_word_start(row, start_index, &count);
+  if (position >= 0) {
+    return position - start_index;
+  }
+  // the last word ends the line, trailing whitespace has no word to move to
+  if (buffer_row_is_whitespace(row->data[start_index])) {
+    return 0;
+  }
+  return row->len - start_index;
 }
 
 int buffer_row_get_offset_to_prev_word(const BufferRow* row, int start_index) {
   if (row == NULL || start_index < 0 || start_index > row->len) {
     return 0;  // Invalid row or start index
   }
-  bool first_char = false;
+  int count = 1;
+  const int position = buffer_row_find_prev_word_start(row, start_index, &count);
+  if (position >= 0) {
+    return position - start_index;
+  }
+  return 0;
+}
 
-  for (int i = start_index - 1; i > 0; i--) {
-    if (!first_char) {
-      if (!buffer_row_has_whitespace_at_position(row, i)) {
-        first_char = true;  // Found the first non-whitespace character
-      } else {
-        continue;
-      }
-    }
+void buffer_row_free(BufferRow* row) {
+  buffer_row_release_identifiers(row);
+  free(row->identifiers);
+  free(row->data);
+  free(row->highlight_data);
+  free(row->word_bits);
+  free(row);
+}
 
-    if (first_char && buffer_row_has_whitespace_at_position(row, i)) {
-      return i - start_index + 1;  // Return the offset to the next word
-    }
+BufferRow* buffer_row_alloc(const char* text, int length) {
+  BufferRow* row = calloc(1, sizeof(BufferRow));
+  if (row == NULL) {
+    return NULL;
   }
-
-  if (first_char) {
-    return -start_index;  // Return the offset to the start of the line
+  row->allocated_size = length + 1;
+  row->data = malloc(row->allocated_size);
+  row->highlight_data = calloc(row->allocated_size, 1);
+  if (row->data == NULL || row->highlight_data == NULL) {
+    free(row->data);
+    free(row->highlight_data);
+    free(row);
+    return NULL;
   }
-
-  return 0;
+  memcpy(row->data, text, length);
+  row->data[length] = '\0';
+  row->len = length;
+  row->dirty = true;
+  row->highlight_pending = true;
+  return row;
 }
 
 void buffer_row_replace_line(BufferRow* row, const char* new_line) {
@@ -339,9 +614,29 @@ void buffer_row_replace_line(BufferRow* row, const char* new_line) {
     row->data[row->len] = '\0';  // Null-terminate the string
   }
   row->dirty = true;
+  row->word_bits_valid = false;
   buffer_row_highlight_line(row);
 }
 
+void buffer_row_set_data(BufferRow* row, char* data, int len, int allocated_size) {
+  if (row == NULL || data == NULL) {
+    return;  // Invalid row or data
+  }
+
+  char* highlight_data = realloc(row->highlight_data, allocated_size);
+  if (highlight_data == NULL) {
+    free(data);
+    return;  // Memory allocation failed
+  }
+  free(row->data);
+  row->data = data;
+  row->highlight_data = highlight_data;
+  row->len = len;
+  row->allocated_size = allocated_size;
+  row->dirty = true;
+  row->word_bits_valid = false;
+}
+
 int buffer_row_remove_chars(BufferRow* row, int index, int number) {
   if (row == NULL || index < 0 || index >= row->len) {
     return 0;
@@ -354,6 +649,7 @@ int buffer_row_remove_chars(BufferRow* row, int index, int number) {
   row->len -= number;
   row->data[row->len] = '\0';
   row->dirty = true;
+  row->word_bits_valid = false;
   buffer_row_highlight_line(row);
   return number;
 }
@@ -386,6 +682,7 @@ void buffer_row_insert_chars(BufferRow* row,
   memcpy(&row->data[index], str, number);
   row->len += number;
   row->dirty = true;
+  row->word_bits_valid = false;
   buffer_row_highlight_line(row);
 }
 
@@ -415,6 +712,7 @@ void buffer_row_trim(BufferRow* row, int start_index) {
   row->len = start_index;
   row->data[row->len] = '\0';  // Null-terminate the string
   row->dirty = true;
+  row->word_bits_valid = false;
   buffer_row_highlight_line(row);
 }
 
@@ -19,8 +19,15 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 
 #include "highlight.h"
+#include "identifier_index.h"
+
+// (), [] and {}
+#define BUFFER_ROW_BRACKET_TYPES 3
+
+struct Fold;
 
 typedef struct BufferRow {
   char* data;
@@ -30,18 +37,65 @@ typedef struct BufferRow {
   struct BufferRow* next;
   struct BufferRow* prev;
   bool dirty;
+  // rows inserted in bulk are highlighted when first needed, e.g. drawn
+  bool highlight_pending;
   int highlight_comment_open;
   int highlight_string_open;
+  // word start bits followed by word end bits, one bit per character,
+  // computed on first use after an edit
+  uint64_t* word_bits;
+  int word_bits_size;
+  bool word_bits_valid;
+  // per bracket type, opening ones count 1 and closing ones -1: the sum over
+  // the row and the lowest running sum from its start (never above 0),
+  // updated by the highlighter
+  int bracket_balance[BUFFER_ROW_BRACKET_TYPES];
+  int bracket_lowest[BUFFER_ROW_BRACKET_TYPES];
+  // node of the buffer's treap in row order, gives the row index in O(log n)
+  struct BufferRow* tree_parent;
+  struct BufferRow* tree_left;
+  struct BufferRow* tree_right;
+  int tree_size;
+  unsigned int tree_priority;
+  // marks and jumps pointing to the row
+  int references;
+  // outermost folds starting and ending at the row
+  struct Fold* fold_first;
+  struct Fold* fold_last;
+  // ids of the identifiers counted in the identifier index by the last
+  // highlighting of the row
+  int* identifiers;
+  int number_of_identifiers;
+  int identifiers_capacity;
 } BufferRow;
 
+// unlinked row holding a copy of length bytes of text, its highlighting is
+// pending
+BufferRow* buffer_row_alloc(const char* text, int length);
+// frees the row together with its data
+void buffer_row_free(BufferRow* row);
+// identifiers of rows highlighted from now on are counted in index, it is
+// shared by all buffers, NULL stops the counting
+void buffer_row_set_identifier_index(IdentifierIndex* index);
+
 bool buffer_row_has_whitespace_at_position(const BufferRow* row, int position);
 int buffer_row_get_length(const BufferRow* row);
 
 int buffer_row_get_offset_to_first_char(const BufferRow* row, int start_index);
 int buffer_row_get_offset_to_next_word(const BufferRow* row, int start_index);
 int buffer_row_get_offset_to_prev_word(const BufferRow* row, int start_index);
+// position of the count-th word start (or end) after index, or before index
+// for the previous start. Returns -1 when the row has fewer of them and
+// decreases count by the number found, so the search can go on in the
+// next row.
+int buffer_row_find_next_word_start(const BufferRow* row, int index, int* count);
+int buffer_row_find_prev_word_start(const BufferRow* row, int index, int* count);
+int buffer_row_find_next_word_end(const BufferRow* row, int index, int* count);
 
 void buffer_row_replace_line(BufferRow* row, const char* new_line);
+// takes ownership of malloc'ed, null terminated data, highlighting is left to
+// the caller so bulk edits can do it once
+void buffer_row_set_data(BufferRow* row, char* data, int len, int allocated_size);
 bool buffer_row_remove_char(BufferRow* row, int index);
 int buffer_row_remove_chars(BufferRow* row, int index, int number);
 void buffer_row_insert_char(BufferRow* row, int index, char c);
@@ -61,3 +115,9 @@ void buffer_row_set_highlight(BufferRow* row,
                               int column_end,
                               EHighlightToken token);
 void buffer_row_highlight_line(BufferRow* row);
+// highlights the row if pending, together with the pending rows above it whose
+// state it continues
+void buffer_row_highlight_pending(BufferRow* row);
+// bracket at index outside strings and comments: 1, 2 or 3 for '(', '[' and
+// '{', the negated type for the closing ones and 0 for anything else
+int buffer_row_get_bracket(const BufferRow* row, int index);
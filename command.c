@@ -17,6 +17,7 @@
 
 #include "command.h"
 
+#include <ctype.h>
 #include <string.h>
 
 #define COMMAND_BUFFER_DEFAULT_SIZE 64
@@ -55,4 +56,239 @@ void command_error(Command* command, const char* message) {
          command->cursor_position);
   memcpy(command->buffer, message, error_length);
   command->buffer[command->cursor_position + error_length] = '\0';
-}
\ No newline at end of file
+}
+
+// sorted by name, the first command accepting an abbreviation wins
+static const CommandDefinition command_definitions[] = {
+  {"cnext", 2, ExCommandId_Cnext, 0},
+  {"cprevious", 2, ExCommandId_Cprevious, 0},
+  {"delete", 1, ExCommandId_Delete, COMMAND_FLAG_RANGE},
+  {"find", 3, ExCommandId_Find, COMMAND_FLAG_BANG},
+  {"fold", 2, ExCommandId_Fold, COMMAND_FLAG_RANGE},
+  {"global", 1, ExCommandId_Global,
+   COMMAND_FLAG_RANGE | COMMAND_FLAG_WHOLE_BUFFER | COMMAND_FLAG_BANG},
+  {"grep", 2, ExCommandId_Grep, COMMAND_FLAG_BANG},
+  {"quit", 1, ExCommandId_Quit, COMMAND_FLAG_BANG},
+  {"read", 1, ExCommandId_Read, COMMAND_FLAG_RANGE},
+  {"set", 2, ExCommandId_Set, 0},
+  {"stats", 5, ExCommandId_Stats, 0},
+  {"substitute", 1, ExCommandId_Substitute, COMMAND_FLAG_RANGE},
+  {"tag", 2, ExCommandId_Tag, 0},
+  {"vglobal", 1, ExCommandId_Vglobal, COMMAND_FLAG_RANGE | COMMAND_FLAG_WHOLE_BUFFER},
+  {"vimgrep", 3, ExCommandId_Grep, COMMAND_FLAG_BANG},
+  {"wq", 2, ExCommandId_WriteQuit, COMMAND_FLAG_BANG},
+  {"write", 1, ExCommandId_Write, COMMAND_FLAG_BANG},
+};
+
+static const CommandDefinition command_goto = {"", 0, ExCommandId_Goto,
+                                               COMMAND_FLAG_RANGE};
+static const CommandDefinition command_shell = {"!", 1, ExCommandId_Shell,
+                                                COMMAND_FLAG_RANGE};
+
+#define COMMAND_NUMBER_OF_DEFINITIONS \
+  (int)(sizeof(command_definitions) / sizeof(command_definitions[0]))
+
+const CommandDefinition* command_find_definition(const char* name, int length) {
+  // first definition not sorting before the name
+  int low = 0;
+  int high = COMMAND_NUMBER_OF_DEFINITIONS;
+  while (low < high) {
+    const int middle = low + (high - low) / 2;
+    if (strncmp(command_definitions[middle].name, name, length) < 0) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+  for (int i = low; i < COMMAND_NUMBER_OF_DEFINITIONS &&
+                    strncmp(command_definitions[i].name, name, length) == 0;
+       ++i) {
+    if (length >= command_definitions[i].minimum_length &&
+        length <= (int)strlen(command_definitions[i].name)) {
+      return &command_definitions[i];
+    }
+  }
+  return NULL;
+}
+
+char* command_split_delimited(const char** cursor, char delimiter) {
+  const char* p = *cursor;
+  char* result = malloc(strlen(p) + 1);
+  if (result == NULL) {
+    return NULL;
+  }
+  int length = 0;
+  while (*p != '\0' && *p != delimiter) {
+    if (*p == '\\' && p[1] != '\0') {
+      if (p[1] != delimiter) {
+        result[length++] = *p;
+      }
+      ++p;
+    }
+    result[length++] = *p++;
+  }
+  result[length] = '\0';
+  if (*p == delimiter) {
+    ++p;
+  }
+  *cursor = p;
+  return result;
+}
+
+static const char* command_skip_blanks(const char* p) {
+  while (*p == ' ' || *p == '\t') {
+    ++p;
+  }
+  return p;
+}
+
+// returns false when there is no address at p
+static bool command_parse_address(const char** cursor,
+                                  CommandAddress* address,
+                                  const char** error) {
+  const char* p = *cursor;
+  address->offset = 0;
+  address->pattern = NULL;
+  if (isdigit((unsigned char)*p)) {
+    address->type = CommandAddressType_Line;
+    address->line = (int)strtol(p, (char**)&p, 10) - 1;
+  } else if (*p == '.') {
+    address->type = CommandAddressType_Current;
+    ++p;
+  } else if (*p == '$') {
+    address->type = CommandAddressType_Last;
+    ++p;
+  } else if (*p == '\'') {
+    if (!islower((unsigned char)p[1])) {
+      *error = "Invalid mark";
+      return false;
+    }
+    address->type = CommandAddressType_Mark;
+    address->mark = p[1];
+    p += 2;
+  } else if (*p == '/' || *p == '?') {
+    const char delimiter = *p++;
+    address->type = delimiter == '/' ? CommandAddressType_SearchForward
+                                     : CommandAddressType_SearchBackward;
+    address->pattern = command_split_delimited(&p, delimiter);
+    if (address->pattern == NULL) {
+      *error = "Out of memory";
+      return false;
+    }
+    if (address->pattern[0] == '\0') {
+      free(address->pattern);
+      address->pattern = NULL;
+    }
+  } else if (*p == '+' || *p == '-') {
+    address->type = CommandAddressType_Current;
+  } else {
+    return false;
+  }
+
+  while (*p == '+' || *p == '-') {
+    const int sign = *p == '+' ? 1 : -1;
+    ++p;
+    const int offset = isdigit((unsigned char)*p) ? (int)strtol(p, (char**)&p, 10) : 1;
+    address->offset += sign * offset;
+  }
+  *cursor = p;
+  return true;
+}
+
+static bool command_parse_range(const char** cursor,
+                                ExCommand* command,
+                                const char** error) {
+  const char* p = command_skip_blanks(*cursor);
+  if (*p == '%') {
+    command->addresses[0].type = CommandAddressType_Line;
+    command->addresses[0].line = 0;
+    command->addresses[0].offset = 0;
+    command->addresses[1].type = CommandAddressType_Last;
+    command->addresses[1].offset = 0;
+    command->number_of_addresses = 2;
+    *cursor = p + 1;
+    return true;
+  }
+  while (command->number_of_addresses < 2) {
+    CommandAddress* address = &command->addresses[command->number_of_addresses];
+    if (command_parse_address(&p, address, error)) {
+      ++command->number_of_addresses;
+    } else if (*error != NULL) {
+      return false;
+    } else if (*p == ',' || *p == ';') {
+      // missing address before the separator is the current line
+      address->type = CommandAddressType_Current;
+      address->offset = 0;
+      address->pattern = NULL;
+      ++command->number_of_addresses;
+    } else {
+      break;
+    }
+    if (*p != ',' && *p != ';') {
+      break;
+    }
+    ++p;
+    if (command->number_of_addresses == 2) {
+      *error = "Invalid range";
+      return false;
+    }
+  }
+  *cursor = p;
+  return true;
+}
+
+bool command_parse(const char* text, ExCommand* command, const char** error) {
+  memset(command, 0, sizeof(ExCommand));
+  *error = NULL;
+  const char* p = command_skip_blanks(text);
+  if (!command_parse_range(&p, command, error)) {
+    command_parsed_deinit(command);
+    return false;
+  }
+  p = command_skip_blanks(p);
+
+  const char* name = p;
+  while (isalpha((unsigned char)*p)) {
+    ++p;
+  }
+  if (p == name && *p == '!') {
+    command->definition = &command_shell;
+    ++p;
+  } else if (p == name) {
+    if (*p != '\0') {
+      *error = "Not an editor command";
+      command_parsed_deinit(command);
+      return false;
+    }
+    command->definition = &command_goto;
+  } else {
+    command->definition = command_find_definition(name, (int)(p - name));
+    if (command->definition == NULL) {
+      *error = "Not an editor command";
+      command_parsed_deinit(command);
+      return false;
+    }
+  }
+
+  const int flags = command->definition->flags;
+  if (*p == '!' && (flags & COMMAND_FLAG_BANG)) {
+    command->bang = true;
+    ++p;
+  }
+  if (command->number_of_addresses > 0 && !(flags & COMMAND_FLAG_RANGE)) {
+    *error = "No range allowed";
+    command_parsed_deinit(command);
+    return false;
+  }
+  // :s/a/b/ and :g/a/d take their arguments right after the name
+  command->arguments = command_skip_blanks(p);
+  return true;
+}
+
+void command_parsed_deinit(ExCommand* command) {
+  for (int i = 0; i < 2; ++i) {
+    free(command->addresses[i].pattern);
+    command->addresses[i].pattern = NULL;
+  }
+  command->number_of_addresses = 0;
+}
@@ -17,6 +17,7 @@
 
 #pragma once
 
+#include <stdbool.h>
 #include <stdlib.h>
 
 typedef struct {
@@ -28,4 +29,82 @@ typedef struct {
 void command_init(Command* command);
 void command_append(Command* command, char ch);
 void command_deinit(Command* command);
-void command_error(Command* command, const char* message);
\ No newline at end of file
+void command_error(Command* command, const char* message);
+
+typedef enum {
+  CommandAddressType_Line,
+  CommandAddressType_Current,
+  CommandAddressType_Last,
+  CommandAddressType_Mark,
+  CommandAddressType_SearchForward,
+  CommandAddressType_SearchBackward,
+} CommandAddressType;
+
+typedef struct CommandAddress {
+  CommandAddressType type;
+  // 0 based line for CommandAddressType_Line
+  int line;
+  char mark;
+  // search pattern, NULL reuses the last one
+  char* pattern;
+  // sum of the +N and -N suffixes
+  int offset;
+} CommandAddress;
+
+typedef enum {
+  // bare range, e.g. :42
+  ExCommandId_Goto,
+  ExCommandId_Cnext,
+  ExCommandId_Cprevious,
+  ExCommandId_Delete,
+  ExCommandId_Find,
+  ExCommandId_Fold,
+  ExCommandId_Global,
+  ExCommandId_Grep,
+  ExCommandId_Quit,
+  ExCommandId_Read,
+  ExCommandId_Set,
+  // :{range}!command filters the rows through command
+  ExCommandId_Shell,
+  // frame timings kept with YASVI_PROFILE
+  ExCommandId_Stats,
+  ExCommandId_Substitute,
+  ExCommandId_Tag,
+  ExCommandId_Vglobal,
+  ExCommandId_Write,
+  ExCommandId_WriteQuit,
+  ExCommandId_Count,
+} ExCommandId;
+
+// command accepts a range
+#define COMMAND_FLAG_RANGE 0x1
+// without a range the command works on the whole buffer
+#define COMMAND_FLAG_WHOLE_BUFFER 0x2
+#define COMMAND_FLAG_BANG 0x4
+
+typedef struct CommandDefinition {
+  const char* name;
+  // shortest accepted abbreviation
+  int minimum_length;
+  ExCommandId id;
+  int flags;
+} CommandDefinition;
+
+typedef struct ExCommand {
+  const CommandDefinition* definition;
+  int number_of_addresses;
+  CommandAddress addresses[2];
+  bool bang;
+  // rest of the line, points into the parsed text
+  const char* arguments;
+} ExCommand;
+
+// parses "[range]name[!] [arguments]", error tells what is wrong otherwise
+bool command_parse(const char* text, ExCommand* command, const char** error);
+void command_parsed_deinit(ExCommand* command);
+// finds the command by its name or an abbreviation of it
+const CommandDefinition* command_find_definition(const char* name, int length);
+
+// copies text up to the unescaped delimiter, escaped delimiters lose the
+// backslash, other escapes are kept for the pattern compiler
+char* command_split_delimited(const char** cursor, char delimiter);
@@ -18,18 +18,31 @@
 #include "editor.h"
 
 #include <ctype.h>
+#include <limits.h>
 #include <stdio.h>
 #include <string.h>
 
-#include <ncurses.h>
-
 #include "command.h"
+#include "grep.h"
 #include "highlight.h"
+#include "path_index.h"
+#include "profile.h"
+#include "shell.h"
+#include "substitute.h"
+#include "tags.h"
 
 #define EDITOR_TOP_BAR_HEIGHT 1
 // 1 is for command line
 // 2 is for status bar
 #define EDITOR_BOTTOM_BAR_HEIGHT 2
+// looked up by Ctrl-] and :tag, relative to the working directory
+#define EDITOR_TAGS_FILE "tags"
+// rows scanned by the match index on each idle tick
+#define EDITOR_IDLE_SCAN_ROWS 4096
+// macros replaying themselves stop at this depth
+#define EDITOR_MAX_REPLAY_DEPTH 100
+// replayed keys between checks for ESC
+#define EDITOR_REPLAY_POLL_KEYS 4096
 
 typedef enum {
   CommandResult_Success = 0,
@@ -42,10 +55,24 @@ static void editor_move_cursor_x(Editor* editor, int x, bool insert_mode);
 static void editor_move_cursor_y(Editor* editor, int y);
 static bool editor_process_key_sequence(Editor* editor, int key);
 static void editor_set_error_message(Editor* editor, const char* message);
+static void editor_set_message(Editor* editor, const char* message);
+static void editor_show_match_number(Editor* editor, int line, int column);
 static void editor_home_cursor_x(Editor* editor);
 static void editor_home_cursor_y(Editor* editor);
 static void editor_home_cursor_xy(Editor* editor);
 static void editor_fix_cursor_position(Editor* editor);
+static CommandResult editor_process_search_command(Editor* editor);
+static CommandResult editor_execute_command(Editor* editor, const ExCommand* command);
+static CommandResult editor_process_filter_command(Editor* editor);
+static void editor_update_incremental_search(Editor* editor);
+static void editor_end_incremental_search(Editor* editor);
+static void editor_update_finder(Editor* editor);
+static void editor_hide_finder(Editor* editor);
+static void editor_filter_sync(Editor* editor);
+static void editor_fold_sync(Editor* editor);
+static void editor_stop_recording(Editor* editor);
+static bool editor_append_buffer(Editor* editor, Buffer* buffer);
+void editor_insert_char(Editor* editor, int key);
 
 #ifdef __GNUC__
 char* itoa(int n, char* s, int base) {
@@ -81,9 +108,39 @@ static void editor_home_cursor_x(Editor* editor) {
   editor->start_column = 0;
 }
 
+static int editor_get_number_of_visible_lines(const Editor* editor) {
+  return editor->window.height - EDITOR_TOP_BAR_HEIGHT - EDITOR_BOTTOM_BAR_HEIGHT;
+}
+
+static bool editor_is_fold_view(const Editor* editor) {
+  return editor->fold_view && !editor->filtering;
+}
+
+// row shown below the given one, a closed fold is skipped as a whole
+static BufferRow* editor_get_next_shown_row(BufferRow* row) {
+  const Fold* fold = fold_get_closed_at_first(row);
+  return fold != NULL ? fold->last->next : row->next;
+}
+
 static void editor_mark_dirty_whole_screen(Editor* editor) {
-  const int number_of_lines =
-    editor->window.height - EDITOR_TOP_BAR_HEIGHT - EDITOR_BOTTOM_BAR_HEIGHT;
+  const int number_of_lines = editor_get_number_of_visible_lines(editor);
+  if (editor->filtering) {
+    const MatchIndex* index = &editor->filter_index;
+    const int number_of_matches = match_index_get_number_of_matches(index);
+    for (int i = editor->filter_top;
+         i < number_of_matches && i < editor->filter_top + number_of_lines; ++i) {
+      buffer_row_mark_dirty(match_index_get(index, i)->row);
+    }
+    return;
+  }
+  if (editor_is_fold_view(editor)) {
+    BufferRow* row = buffer_get_row(editor->current_buffer, editor->fold_top);
+    for (int y = 0; y < number_of_lines && row != NULL; ++y) {
+      buffer_row_mark_dirty(row);
+      row = editor_get_next_shown_row(row);
+    }
+    return;
+  }
   BufferRow* row = buffer_get_row(editor->current_buffer, editor->start_line);
   if (row == NULL) {
     return;  // No rows in the buffer
@@ -99,6 +156,10 @@ static void editor_mark_dirty_whole_screen(Editor* editor) {
 }
 
 static void editor_mark_dirty_from_cursor(Editor* editor) {
+  if (editor->filtering || editor_is_fold_view(editor)) {
+    editor_mark_dirty_whole_screen(editor);
+    return;
+  }
   BufferRow* row = buffer_get_row(editor->current_buffer, editor->start_line);
   if (row == NULL) {
     return;  // No rows in the buffer
@@ -126,55 +187,56 @@ static void editor_home_cursor_xy(Editor* editor) {
 
 // true if editor loop should continue
 static bool editor_collect_command(Editor* editor, int key) {
+  const bool searching = editor->command_prompt == '/' || editor->command_prompt == '?';
   if (key == '\n') {
+    if (searching) {
+      editor_end_incremental_search(editor);
+    }
+    editor_hide_finder(editor);
     editor->state = EditorState_ProcessingCommand;
     return true;
   } else if (key == 27) {
     // cancel command
+    if (searching) {
+      editor_end_incremental_search(editor);
+    }
+    editor_hide_finder(editor);
     command_deinit(&editor->command);
     editor->state = EditorState_Running;
     return true;
-  } else if (key == KEY_BACKSPACE || key == 127) {
-    editor->command.cursor_position--;
-    editor->command.buffer[editor->command.cursor_position] = '\0';
-    return false;
+  } else if (key == TERMINAL_KEY_BACKSPACE || key == 127) {
+    if (editor->command.cursor_position > 0) {
+      editor->command.cursor_position--;
+      editor->command.buffer[editor->command.cursor_position] = '\0';
+    }
+  } else {
+    command_append(&editor->command, (char)key);
+  }
+  if (searching) {
+    editor_update_incremental_search(editor);
+  } else if (editor->command_prompt == ':') {
+    editor_update_finder(editor);
   }
-  command_append(&editor->command, (char)key);
   return false;
 }
 
 static void editor_clear_error_message(Editor* editor) {
   if (editor->error_message) {
     for (size_t i = 0; i < strlen(editor->error_message); ++i) {
-      mvaddch(editor->window.height - 1, 1 + i, ' ');
+      terminal_draw_char(editor->terminal, editor->window.height - 1, 1 + i, ' ');
     }
     free(editor->error_message);
     editor->error_message = NULL;
   }
+  editor->match_number_shown = false;
 }
 
-static CommandResult editor_process_save_command(Editor* editor) {
-  int command_length = strlen(editor->command.buffer);
-  const char* filename = buffer_get_filename(editor->current_buffer);
-  bool should_exit = false;
-  if (command_length > 1) {
-    // additional arguments for the command
-    if (editor->command.buffer[1] == ' ') {
-      // save to a different file
-      filename = &editor->command.buffer[2];
-      while (isspace(*filename)) {
-        filename++;  // Skip leading spaces
-      }
-      if (strlen(filename) == 0) {
-        filename = buffer_get_filename(editor->current_buffer);
-      }
-    } else if (editor->command.buffer[1] == 'q') {
-      // force save
-      should_exit = true;
-    } else {
-      editor_set_error_message(editor, "Invalid command syntax");
-      return CommandResult_CommandNotFound;
-    }
+// filename may be empty to use the one of the buffer
+static CommandResult editor_process_save_command(Editor* editor,
+                                                 const char* filename,
+                                                 bool should_exit) {
+  if (filename[0] == '\0') {
+    filename = buffer_get_filename(editor->current_buffer);
   }
 
   if (filename == NULL || strlen(filename) == 0) {
@@ -196,7 +258,7 @@ static CommandResult editor_process_save_command(Editor* editor) {
   }
 
   fclose(file);
-  editor_set_error_message(editor, "File saved successfully");
+  editor_set_message(editor, "File saved successfully");
   return should_exit ? CommandResult_ShouldExit : CommandResult_Success;
 }
 
@@ -205,18 +267,26 @@ static CommandResult editor_process_command(Editor* editor) {
   if (command->buffer == NULL) {
     return CommandResult_CommandNotFound;
   }
-  if (strcmp(command->buffer, "q") == 0) {
-    return CommandResult_ShouldExit;
+  if (editor->command_prompt == '/' || editor->command_prompt == '?') {
+    return editor_process_search_command(editor);
   }
-
-  if (command->buffer[0] == 'w') {
-    return editor_process_save_command(editor);
+  if (editor->command_prompt == '&') {
+    return editor_process_filter_command(editor);
   }
 
-  return CommandResult_CommandNotFound;
+  ExCommand ex_command;
+  const char* error = NULL;
+  if (!command_parse(command->buffer, &ex_command, &error)) {
+    editor_set_error_message(editor, error);
+    return CommandResult_Success;
+  }
+  const CommandResult result = editor_execute_command(editor, &ex_command);
+  command_parsed_deinit(&ex_command);
+  return result;
 }
 
-static void editor_set_error_message(Editor* editor, const char* message) {
+// shows a message in the status line, e.g. the result of a command
+static void editor_set_message(Editor* editor, const char* message) {
   int error_length = strlen(message);
   int message_offset = 0;
   editor_clear_error_message(editor);
@@ -237,11 +307,20 @@ static void editor_set_error_message(Editor* editor, const char* message) {
     memcpy(editor->error_message, message, error_length);
     editor->error_message[error_length] = '\0';
   }
+  if (editor->headless && !editor->silent && editor->error_message != NULL) {
+    fprintf(stderr, "%s\n", editor->error_message);
+  }
   editor_redraw_screen(editor);
 }
 
+// the message of a failed command, they are counted for the exit status of -e
+static void editor_set_error_message(Editor* editor, const char* message) {
+  ++editor->number_of_errors;
+  editor_set_message(editor, message);
+}
+
 static void editor_restore_cursor_position(const Editor* editor) {
-  move(editor->cursor.y, editor->cursor.x);
+  terminal_move(editor->terminal, editor->cursor.y, editor->cursor.x);
 }
 
 static void editor_move_cursor_to_start(Editor* editor) {
@@ -259,145 +338,2038 @@ static void editor_move_to_top(Editor* editor) {
   editor_home_cursor_xy(editor);
 }
 
-static void editor_move_to_bottom(Editor* editor) {
+static int editor_get_current_line_index(const Editor* editor) {
+  return editor->start_line + editor->cursor.y - EDITOR_TOP_BAR_HEIGHT;
+}
+
+// moves the cursor to the given line in a single buffer scroll
+static void editor_move_to_line(Editor* editor, int line) {
   const int number_of_lines = buffer_get_number_of_lines(editor->current_buffer);
-  const int lines_to_the_end = number_of_lines - editor->start_line - 1;
+  if (line >= number_of_lines) {
+    line = number_of_lines - 1;
+  }
+  if (line < 0) {
+    line = 0;
+  }
+  const int scrolled = buffer_scroll_rows(editor->current_buffer,
+                                          line - editor_get_current_line_index(editor));
+  editor_move_cursor_y(editor, scrolled);
+  editor_fix_cursor_position(editor);
+}
+
+static void editor_move_to_bottom(Editor* editor) {
   if (buffer_current_is_last_row(editor->current_buffer)) {
     return;  // Already at the last row
   }
-  editor_move_cursor_y(editor, lines_to_the_end);
-  buffer_scroll_rows(editor->current_buffer, lines_to_the_end);
+  editor_move_to_line(editor, buffer_get_number_of_lines(editor->current_buffer) - 1);
+}
+
+// moves the cursor by count rows, count is signed
+static void editor_move_rows(Editor* editor, int count) {
+  const int scrolled = buffer_scroll_rows(editor->current_buffer, count);
+  if (scrolled == 0) {
+    return;
+  }
+  editor_move_cursor_y(editor, scrolled);
   editor_fix_cursor_position(editor);
 }
 
-static void editor_fix_cursor_position(Editor* editor) {
-  const BufferRow* current_row = buffer_get_current_line(editor->current_buffer);
-  int line_length = buffer_row_get_length(current_row);
+static void editor_move_to_position(Editor* editor, int line, int column) {
+  const int previous_start_column = editor->start_column;
+  editor->end_line_mode = false;
+  editor_move_to_line(editor, line);
+  editor_home_cursor_x(editor);
+  editor_move_cursor_x(editor, column, false);
+  if (editor->start_column != previous_start_column) {
+    editor_mark_dirty_whole_screen(editor);
+  }
+}
 
-  if (line_length <= editor_get_cursor_x(editor)) {
-    editor_home_cursor_x(editor);
-    editor_move_cursor_x(editor, line_length, false);
+// G, gg, searches, % and marks remember where they started for Ctrl-O
+static void editor_push_jump(Editor* editor) {
+  buffer_push_jump(editor->current_buffer,
+                   buffer_get_current_line(editor->current_buffer),
+                   editor_get_cursor_x(editor));
+}
+
+// ' puts the cursor on the first non blank character of the row, ` on the column
+static void editor_jump_to_mark(Editor* editor, const BufferMark* mark, bool exact) {
+  const int line = buffer_get_row_index(editor->current_buffer, mark->row);
+  const int column =
+    exact ? mark->column : buffer_row_get_offset_to_first_char(mark->row, 0);
+  editor_move_to_position(editor, line, column);
+}
+
+// many rows changed, the indexes are rebuilt
+static void editor_buffer_modified(Editor* editor) {
+  BufferRow* first = buffer_get_first_row(editor->current_buffer);
+  if (editor->match_index.active) {
+    match_index_reset(&editor->match_index, first);
+  }
+  if (editor->filtering) {
+    match_index_reset(&editor->filter_index, first);
+    match_index_update(&editor->filter_index, &editor->filter_pattern,
+                       EDITOR_IDLE_SCAN_ROWS);
+    editor->filter_top = 0;
   }
 }
 
-static void editor_move_cursor_x_to_right(Editor* editor, int x, bool insert_mode) {
-  BufferRow* current_line = buffer_get_current_line(editor->current_buffer);
-  const int line_length = buffer_row_get_length(current_line) - 1 + insert_mode;
-  const int chars_till_end = line_length - editor_get_cursor_x(editor);
-  const int chars_till_window_end = editor->window.width - editor->cursor.x - 1;
-  if (x > chars_till_end) {
-    x = chars_till_end;
+// the filtered view and the fold view belong to the buffer shown before
+static void editor_switch_buffer(Editor* editor, Buffer* buffer) {
+  if (buffer == editor->current_buffer) {
+    return;
   }
+  search_pattern_deinit(&editor->filter_pattern);
+  match_index_reset(&editor->filter_index, NULL);
+  editor->filtering = false;
+  editor->filter_top = 0;
+  editor->fold_view = false;
+  editor->end_line_mode = false;
+  editor->current_buffer = buffer;
+  editor_buffer_modified(editor);
+  buffer_scroll_to_top(buffer);
+  editor_home_cursor_xy(editor);
+}
 
-  if (x > chars_till_window_end) {
-    editor->cursor.x = editor->window.width - 1;
-    x -= chars_till_window_end;
-  } else {
-    editor->cursor.x += x;
-    x = 0;
+// buffer of the file, loaded and added to the buffers when not open yet
+static Buffer* editor_get_file_buffer(Editor* editor, const char* filename) {
+  for (size_t i = 0; i < editor->number_of_buffers; ++i) {
+    const char* name = buffer_get_filename(editor->buffers[i]);
+    if (name != NULL && strcmp(name, filename) == 0) {
+      return editor->buffers[i];
+    }
   }
+  Buffer* buffer = buffer_alloc();
+  if (buffer == NULL) {
+    editor_set_error_message(editor, "Failed to allocate memory for buffer");
+    return NULL;
+  }
+  buffer_load_from_file(buffer, filename);
+  if (!editor_append_buffer(editor, buffer)) {
+    buffer_free(buffer);
+    return NULL;
+  }
+  return buffer;
+}
 
-  if (x > 0) {
-    editor->start_column += x;
+// Ctrl-O and Ctrl-I, the jump may lead back to another buffer
+static void editor_follow_jump(Editor* editor, const BufferJump* jump) {
+  if (jump->buffer != editor->current_buffer) {
+    editor_switch_buffer(editor, jump->buffer);
+    editor_mark_dirty_whole_screen(editor);
   }
+  editor_jump_to_mark(editor, &jump->mark, true);
 }
 
-static void editor_move_cursor_x_to_left(Editor* editor, int x) {
-  const int chars_till_window = editor->cursor.x - editor->number_of_line_digits;
+// Ctrl-] and :tag, the tags file is searched in place on every lookup so a
+// regenerated file is picked up
+static void editor_jump_to_tag(Editor* editor, const char* name, int length) {
+  TagFile file;
+  if (!tag_file_open(&file, EDITOR_TAGS_FILE)) {
+    editor_set_error_message(editor, "No tags file");
+    return;
+  }
+  Tag tag;
+  const bool found = tag_file_find(&file, name, length, &tag);
+  tag_file_close(&file);
+  if (!found) {
+    editor_set_error_message(editor, "tag not found");
+    return;
+  }
+  Buffer* buffer = editor_get_file_buffer(editor, tag.filename);
+  int line = 0;
+  int column = 0;
+  BufferRow* row =
+    buffer != NULL ? tag_find_row(&tag, buffer, name, length, &line, &column) : NULL;
+  tag_deinit(&tag);
+  if (buffer == NULL) {
+    return;
+  }
+  editor_push_jump(editor);
+  editor_switch_buffer(editor, buffer);
+  if (row == NULL) {
+    editor_set_message(editor, "Couldn't find tag, just guessing!");
+    return;
+  }
+  editor_move_to_position(editor, line, column);
+  editor_mark_dirty_whole_screen(editor);
+}
 
-  if (x > chars_till_window) {
-    x -= chars_till_window;
-    editor->cursor.x = editor->number_of_line_digits;
+// :cn, :cp and :grep open the file of the entry in its buffer
+static void editor_jump_to_quickfix_entry(Editor* editor,
+                                          const QuickfixEntry* entry) {
+  const QuickfixList* list = &editor->quickfix;
+  Buffer* buffer =
+    editor_get_file_buffer(editor, quickfix_get_filename(list, entry));
+  if (buffer == NULL) {
+    return;
+  }
+  editor_push_jump(editor);
+  editor_switch_buffer(editor, buffer);
+  editor_move_to_position(editor, entry->line, entry->column);
+  editor_mark_dirty_whole_screen(editor);
+
+  char message[128];
+  snprintf(message, sizeof(message), "(%d of %d): %s", list->current + 1,
+           list->number_of_entries, entry->text);
+  editor_set_message(editor, message);
+}
+
+// query of :find without the trailing blanks, malloc'ed
+static char* editor_get_find_query(const char* arguments) {
+  size_t length = strlen(arguments);
+  while (length > 0 && isspace((unsigned char)arguments[length - 1])) {
+    --length;
+  }
+  return strndup(arguments, length);
+}
+
+// the best paths for the :find being typed are shown above the status bar and
+// updated on every key, the paths of the working directory are indexed once
+static void editor_update_finder(Editor* editor) {
+  ExCommand command;
+  const char* error = NULL;
+  if (!command_parse(editor->command.buffer, &command, &error)) {
+    editor_hide_finder(editor);
+    return;
+  }
+  char* query = command.definition->id == ExCommandId_Find
+                  ? editor_get_find_query(command.arguments)
+                  : NULL;
+  command_parsed_deinit(&command);
+  if (query == NULL) {
+    editor_hide_finder(editor);
+    return;
+  }
+  PathIndex* index = &editor->path_index;
+  int number_of_results = 0;
+  if (index->built || path_index_build(index, ".")) {
+    number_of_results =
+      path_index_find(index, query, editor->finder_results, EDITOR_FINDER_RESULTS);
+  }
+  free(query);
+  editor->number_of_finder_results = number_of_results > 0 ? number_of_results : 0;
+  editor->finder_shown = true;
+  // rows left uncovered by fewer results are drawn again
+  editor_mark_dirty_whole_screen(editor);
+}
+
+static void editor_hide_finder(Editor* editor) {
+  if (editor->finder_shown) {
+    editor->finder_shown = false;
+    editor_mark_dirty_whole_screen(editor);
+  }
+}
+
+// best result right above the status bar, the number of matches above them
+static void editor_draw_finder(const Editor* editor) {
+  const PathIndex* index = &editor->path_index;
+  int y = editor->window.height - EDITOR_BOTTOM_BAR_HEIGHT - 1;
+  for (int i = 0; i < editor->number_of_finder_results && y > EDITOR_TOP_BAR_HEIGHT;
+       ++i, --y) {
+    terminal_draw_format(editor->terminal, y, 0, "%c %s", i == 0 ? '>' : ' ',
+                         index->paths[editor->finder_results[i]]);
+    terminal_clear_to_end_of_line(editor->terminal);
+  }
+  terminal_draw_format(editor->terminal, y, 0, "  %d/%d files",
+                       index->number_of_matches, index->number_of_paths);
+  terminal_clear_to_end_of_line(editor->terminal);
+}
+
+// :find query opens the best matching file, :find! indexes the paths again
+static CommandResult editor_command_find(Editor* editor,
+                                         const ExCommand* command,
+                                         int first,
+                                         int last) {
+  (void)first;
+  (void)last;
+  PathIndex* index = &editor->path_index;
+  char* query = editor_get_find_query(command->arguments);
+  if (query == NULL ||
+      ((command->bang || !index->built) && !path_index_build(index, "."))) {
+    free(query);
+    editor_set_error_message(editor, "Out of memory");
+    return CommandResult_Success;
+  }
+  int result = 0;
+  const int number_of_results = path_index_find(index, query, &result, 1);
+  free(query);
+  if (number_of_results <= 0) {
+    editor_set_error_message(editor, "Can't find file in path");
+    return CommandResult_Success;
+  }
+  Buffer* buffer = editor_get_file_buffer(editor, index->paths[result]);
+  if (buffer == NULL) {
+    return CommandResult_Success;
+  }
+  editor_push_jump(editor);
+  editor_switch_buffer(editor, buffer);
+  editor_mark_dirty_whole_screen(editor);
+  return CommandResult_Success;
+}
+
+// the current row was edited in place
+static void editor_row_modified(Editor* editor) {
+  BufferRow* row = buffer_get_current_line(editor->current_buffer);
+  const int line = editor_get_current_line_index(editor);
+  match_index_update_row(&editor->match_index, &editor->search_pattern, row, line);
+  match_index_update_row(&editor->filter_index, &editor->filter_pattern, row, line);
+}
+
+static void editor_rows_inserted(Editor* editor, BufferRow* first, int line, int count) {
+  match_index_insert_rows(&editor->match_index, &editor->search_pattern, first, line,
+                          count);
+  match_index_insert_rows(&editor->filter_index, &editor->filter_pattern, first, line,
+                          count);
+}
+
+// next is the row at line after the removal
+static void editor_rows_removed(Editor* editor, BufferRow* next, int line, int count) {
+  match_index_remove_rows(&editor->match_index, next, line, count);
+  match_index_remove_rows(&editor->filter_index, next, line, count);
+}
+
+bool editor_process_idle(Editor* editor) {
+  bool redraw = false;
+  if (editor->match_index.active &&
+      !match_index_is_complete(&editor->match_index)) {
+    const int counted = match_index_get_number_of_matches(&editor->match_index);
+    match_index_update(&editor->match_index, &editor->search_pattern,
+                       EDITOR_IDLE_SCAN_ROWS);
+    // "match N of M+" follows the index until it is complete
+    if (editor->match_number_shown &&
+        (match_index_get_number_of_matches(&editor->match_index) != counted ||
+         match_index_is_complete(&editor->match_index))) {
+      editor_show_match_number(editor, editor->match_number_line,
+                               editor->match_number_column);
+      redraw = true;
+    }
+  }
+  if (editor->filtering && !match_index_is_complete(&editor->filter_index)) {
+    const int shown = match_index_get_number_of_matches(&editor->filter_index);
+    match_index_update(&editor->filter_index, &editor->filter_pattern,
+                       EDITOR_IDLE_SCAN_ROWS);
+    // new rows only matter while the screen is not full yet
+    if (shown < editor->filter_top + editor_get_number_of_visible_lines(editor) &&
+        match_index_get_number_of_matches(&editor->filter_index) > shown) {
+      editor_filter_sync(editor);
+      editor_mark_dirty_whole_screen(editor);
+      redraw = true;
+    }
+  }
+  return redraw;
+}
+
+// moves the cursor to the given filtered row, the screen scrolls only as much
+// as needed so only the visible rows are touched
+static void editor_filter_move_to(Editor* editor, int entry) {
+  const MatchIndex* index = &editor->filter_index;
+  const int number_of_matches = match_index_get_number_of_matches(index);
+  if (number_of_matches == 0) {
+    return;
+  }
+  if (entry >= number_of_matches) {
+    entry = number_of_matches - 1;
+  }
+  if (entry < 0) {
+    entry = 0;
+  }
+  const int number_of_lines = editor_get_number_of_visible_lines(editor);
+  const int previous_top = editor->filter_top;
+  if (entry < editor->filter_top) {
+    editor->filter_top = entry;
+  } else if (entry >= editor->filter_top + number_of_lines) {
+    editor->filter_top = entry - number_of_lines + 1;
+  }
+  const MatchPosition* match = match_index_get(index, entry);
+  buffer_set_current_row(editor->current_buffer, match->row);
+  editor->cursor.y = entry - editor->filter_top + EDITOR_TOP_BAR_HEIGHT;
+  // keeps the current line index valid for the rest of the editor
+  editor->start_line = match->line - (editor->cursor.y - EDITOR_TOP_BAR_HEIGHT);
+  editor_fix_cursor_position(editor);
+  if (editor->filter_top != previous_top) {
+    editor_mark_dirty_whole_screen(editor);
+  }
+}
+
+static int editor_get_filter_entry(const Editor* editor) {
+  return editor->filter_top + editor->cursor.y - EDITOR_TOP_BAR_HEIGHT;
+}
+
+// extends the index until it has the given filtered row or the buffer ends
+static void editor_filter_extend(Editor* editor, int entry) {
+  MatchIndex* index = &editor->filter_index;
+  while (match_index_get_number_of_matches(index) <= entry &&
+         !match_index_is_complete(index)) {
+    match_index_update(index, &editor->filter_pattern, EDITOR_IDLE_SCAN_ROWS);
+  }
+}
+
+// after other motions or edits the cursor goes to the first shown row at or
+// after the current line
+static void editor_filter_sync(Editor* editor) {
+  const MatchIndex* index = &editor->filter_index;
+  const int line = editor_get_current_line_index(editor);
+  int entry = match_index_find(index, line, -1, false);
+  if (entry < 0) {
+    entry = match_index_get_number_of_matches(index) - 1;
+  }
+  editor_filter_move_to(editor, entry);
+}
+
+// vertical motions move between the shown rows
+static bool editor_process_filter_key(Editor* editor, int key, int count) {
+  const int entry = editor_get_filter_entry(editor);
+  switch (key) {
+    case 'j':
+    case TERMINAL_KEY_DOWN: {
+      editor_filter_extend(editor, entry + count);
+      editor_filter_move_to(editor, entry + count);
+      return true;
+    }
+    case 'k':
+    case TERMINAL_KEY_UP: {
+      editor_filter_move_to(editor, entry - count);
+      return true;
+    }
+    case 'G': {
+      const int target = editor->repeat_count > 0 ? count - 1 : INT_MAX;
+      editor_filter_extend(editor, target);
+      editor_filter_move_to(editor, target);
+      return true;
+    }
+    default:
+      return false;
+  }
+}
+
+static CommandResult editor_process_filter_command(Editor* editor) {
+  search_pattern_deinit(&editor->filter_pattern);
+  match_index_reset(&editor->filter_index, NULL);
+  editor->filtering = false;
+  editor->filter_top = 0;
+  // empty pattern shows all rows again
+  if (editor->command.buffer[0] == '\0') {
+    editor_mark_dirty_whole_screen(editor);
+    return CommandResult_Success;
+  }
+
+  const char* error = NULL;
+  if (!search_pattern_init(&editor->filter_pattern, editor->command.buffer, &error)) {
+    editor_set_error_message(editor, error);
+    return CommandResult_Success;
+  }
+  match_index_reset(&editor->filter_index,
+                    buffer_get_first_row(editor->current_buffer));
+  match_index_update(&editor->filter_index, &editor->filter_pattern,
+                     EDITOR_IDLE_SCAN_ROWS);
+  const int number_of_matches = match_index_get_number_of_matches(&editor->filter_index);
+  if (number_of_matches == 0 && match_index_is_complete(&editor->filter_index)) {
+    match_index_reset(&editor->filter_index, NULL);
+    editor_set_error_message(editor, "Pattern not found");
+    return CommandResult_Success;
+  }
+  editor->filtering = true;
+  editor_filter_sync(editor);
+  editor_mark_dirty_whole_screen(editor);
+  return CommandResult_Success;
+}
+
+// keeps the cursor off the rows hidden in closed folds and finds the screen row
+// of the current one walking up to the top of the screen, a closed fold costs
+// a single step. start_line is adjusted as for filtering so the current line
+// index stays valid.
+static void editor_fold_sync(Editor* editor) {
+  Buffer* buffer = editor->current_buffer;
+  if (!fold_tree_has_closed(&buffer->folds)) {
+    if (editor->fold_view) {
+      editor->fold_view = false;
+      editor_mark_dirty_whole_screen(editor);
+    }
+    return;
+  }
+  if (!editor->fold_view) {
+    editor->fold_view = true;
+    editor->fold_top = editor->start_line;
+  }
+  int line = editor_get_current_line_index(editor);
+  BufferRow* row = buffer_get_current_line(buffer);
+  const Fold* hiding = fold_tree_find_closed(&buffer->folds, buffer, line);
+  if (hiding != NULL && hiding->first != row) {
+    row = hiding->first;
+    line = buffer_get_row_index(buffer, row);
+    buffer_set_current_row(buffer, row);
+  }
+  const int number_of_lines = editor_get_number_of_visible_lines(editor);
+  int top = line;
+  int y = 0;
+  while (top > editor->fold_top && y < number_of_lines - 1) {
+    const Fold* fold = fold_get_closed_at_last(row->prev);
+    row = fold != NULL ? fold->first : row->prev;
+    top = fold != NULL ? buffer_get_row_index(buffer, row) : top - 1;
+    ++y;
+  }
+  editor->cursor.y = y + EDITOR_TOP_BAR_HEIGHT;
+  editor->start_line = line - y;
+  if (hiding != NULL) {
+    editor_fix_cursor_position(editor);
+  }
+  if (top != editor->fold_top) {
+    editor->fold_top = top;
+    editor_mark_dirty_whole_screen(editor);
+  }
+}
+
+static void editor_folds_changed(Editor* editor) {
+  editor_fold_sync(editor);
+  editor_mark_dirty_whole_screen(editor);
+}
+
+// vertical motions step over closed folds without visiting their rows
+static bool editor_process_fold_key(Editor* editor, int key, int count) {
+  if (key == 'k' || key == TERMINAL_KEY_UP) {
+    count = -count;
+  } else if (key != 'j' && key != TERMINAL_KEY_DOWN) {
+    return false;
+  }
+  Buffer* buffer = editor->current_buffer;
+  BufferRow* row = buffer_get_current_line(buffer);
+  BufferRow* target = row;
+  for (int i = 0; i < count && editor_get_next_shown_row(target) != NULL; ++i) {
+    target = editor_get_next_shown_row(target);
+  }
+  for (int i = 0; i > count && target->prev != NULL; --i) {
+    const Fold* fold = fold_get_closed_at_last(target->prev);
+    target = fold != NULL ? fold->first : target->prev;
+  }
+  if (target != row) {
+    buffer_set_current_row(buffer, target);
+    editor->start_line = buffer_get_row_index(buffer, target) -
+                         (editor->cursor.y - EDITOR_TOP_BAR_HEIGHT);
+    editor_fix_cursor_position(editor);
+  }
+  return true;
+}
+
+// adds a closed fold of lines [first, last] in any order
+static void editor_create_fold(Editor* editor, int first, int last) {
+  Buffer* buffer = editor->current_buffer;
+  const int number_of_lines = buffer_get_number_of_lines(buffer);
+  if (first > last) {
+    const int line = first;
+    first = last;
+    last = line;
+  }
+  first = first < 0 ? 0 : first;
+  last = last >= number_of_lines ? number_of_lines - 1 : last;
+  const char* error = NULL;
+  if (!fold_tree_add(&buffer->folds, buffer, buffer_get_row(buffer, first),
+                     buffer_get_row(buffer, last), true, &error)) {
+    editor_set_error_message(editor, error);
+  }
+}
+
+// :set foldmethod=manual keeps the folds, indent and brace replace them
+static void editor_set_fold_method(Editor* editor, const char* method) {
+  Buffer* buffer = editor->current_buffer;
+  if (strcmp(method, "indent") == 0) {
+    fold_tree_clear(&buffer->folds);
+    fold_tree_add_indent_folds(&buffer->folds, buffer, editor->tab_size);
+  } else if (strcmp(method, "brace") == 0) {
+    fold_tree_clear(&buffer->folds);
+    fold_tree_add_brace_folds(&buffer->folds, buffer);
+  } else if (strcmp(method, "manual") != 0) {
+    editor_set_error_message(editor, "Invalid argument");
+    return;
+  }
+  editor_folds_changed(editor);
+}
+
+static const char* editor_get_wrap_message(bool backward) {
+  return backward ? "search hit TOP, continuing at BOTTOM"
+                  : "search hit BOTTOM, continuing at TOP";
+}
+
+// "match 37 of 1204", the total gets a + while the index is still being built
+static void editor_show_match_number(Editor* editor, int line, int column) {
+  const int found = match_index_locate(&editor->match_index, line, column);
+  if (found < 0) {
+    return;
+  }
+  char message[48];
+  snprintf(message, sizeof(message), "match %d of %d%s", found + 1,
+           match_index_get_number_of_matches(&editor->match_index),
+           match_index_is_complete(&editor->match_index) ? "" : "+");
+  editor_set_message(editor, message);
+  editor->match_number_shown = true;
+  editor->match_number_line = line;
+  editor->match_number_column = column;
+}
+
+// n and N with a complete index are two binary searches
+static bool editor_search_next_indexed(Editor* editor, bool backward, int count) {
+  const MatchIndex* index = &editor->match_index;
+  const int number_of_matches = match_index_get_number_of_matches(index);
+  if (!match_index_is_complete(index) || number_of_matches == 0) {
+    return false;
+  }
+  const int line = editor_get_current_line_index(editor);
+  int found = match_index_find(index, line, editor_get_cursor_x(editor), backward);
+  bool wrapped = found < 0;
+  if (found < 0) {
+    found = backward ? number_of_matches - 1 : 0;
+  }
+  const int steps = count - 1;
+  if (backward) {
+    wrapped = wrapped || found - steps < 0;
+    found = ((found - steps) % number_of_matches + number_of_matches) %
+            number_of_matches;
   } else {
-    editor->cursor.x -= x;
-    x = 0;
+    wrapped = wrapped || found + steps >= number_of_matches;
+    found = (found + steps) % number_of_matches;
   }
 
-  if (x > editor->start_column) {
-    editor->start_column = 0;
+  const MatchPosition* match = match_index_get(index, found);
+  editor_move_to_position(editor, match->line, match->column);
+  if (wrapped) {
+    editor_set_message(editor, editor_get_wrap_message(backward));
   } else {
-    editor->start_column -= x;
+    editor_show_match_number(editor, match->line, match->column);
+  }
+  return true;
+}
+
+// reverse searches in the opposite direction than the last search (N)
+static void editor_search_next(Editor* editor, bool reverse, int count) {
+  if (search_pattern_is_empty(&editor->search_pattern)) {
+    editor_set_error_message(editor, "No previous search pattern");
+    return;
+  }
+
+  const bool backward = editor->search_backward != reverse;
+  if (editor_search_next_indexed(editor, backward, count)) {
+    return;
+  }
+  BufferPosition position = {
+    .row = buffer_get_current_line(editor->current_buffer),
+    .line = editor_get_current_line_index(editor),
+    .column = editor_get_cursor_x(editor),
+  };
+  bool wrapped = false;
+  for (int i = 0; i < count; ++i) {
+    if (!buffer_find(editor->current_buffer, &editor->search_pattern, position.row,
+                     position.line, position.column, backward, &position)) {
+      editor_set_error_message(editor, "Pattern not found");
+      return;
+    }
+    wrapped = wrapped || position.wrapped;
+  }
+
+  editor_move_to_position(editor, position.line, position.column);
+  if (wrapped) {
+    editor_set_message(editor, editor_get_wrap_message(backward));
+  } else {
+    editor_show_match_number(editor, position.line, position.column);
+  }
+}
+
+// moves to the match of the pattern typed so far, counted from where the
+// search started, only the visible rows are matched for highlighting
+static void editor_update_incremental_search(Editor* editor) {
+  search_pattern_deinit(&editor->incremental_pattern);
+  editor->highlight_pattern = NULL;
+  editor_move_to_position(editor, editor->search_origin_line,
+                          editor->search_origin_column);
+  editor_mark_dirty_whole_screen(editor);
+
+  const char* error = NULL;
+  // partially typed expressions, e.g. "\(a", are simply not highlighted yet
+  if (editor->command.buffer[0] == '\0' ||
+      !search_pattern_init(&editor->incremental_pattern, editor->command.buffer,
+                           &error)) {
+    return;
+  }
+  editor->highlight_pattern = &editor->incremental_pattern;
+  BufferPosition position;
+  if (buffer_find(editor->current_buffer, &editor->incremental_pattern,
+                  buffer_get_current_line(editor->current_buffer),
+                  editor->search_origin_line, editor->search_origin_column,
+                  editor->command_prompt == '?', &position)) {
+    editor_move_to_position(editor, position.line, position.column);
+    editor_mark_dirty_whole_screen(editor);
+  }
+}
+
+// the confirmed search starts again from the original position
+static void editor_end_incremental_search(Editor* editor) {
+  search_pattern_deinit(&editor->incremental_pattern);
+  editor->highlight_pattern = NULL;
+  editor_move_to_position(editor, editor->search_origin_line,
+                          editor->search_origin_column);
+  editor_mark_dirty_whole_screen(editor);
+}
+
+static CommandResult editor_process_search_command(Editor* editor) {
+  // empty pattern repeats the last search in the new direction
+  if (editor->command.buffer[0] != '\0') {
+    const char* error = NULL;
+    search_pattern_deinit(&editor->search_pattern);
+    if (!search_pattern_init(&editor->search_pattern, editor->command.buffer,
+                             &error)) {
+      match_index_reset(&editor->match_index, NULL);
+      editor_set_error_message(editor, error);
+      return CommandResult_Success;
+    }
+    match_index_reset(&editor->match_index,
+                      buffer_get_first_row(editor->current_buffer));
+    // small buffers are indexed right away, big ones continue when idle
+    match_index_update(&editor->match_index, &editor->search_pattern,
+                       EDITOR_IDLE_SCAN_ROWS);
+  }
+  editor->search_backward = editor->command_prompt == '?';
+  editor_push_jump(editor);
+  editor_search_next(editor, false, 1);
+  return CommandResult_Success;
+}
+
+// ranges this long are rewritten by the worker pool
+#define EDITOR_PARALLEL_ROWS 16384
+
+static WorkerPool* editor_get_worker_pool(Editor* editor) {
+  if (editor->worker_pool == NULL) {
+    WorkerPool* pool = malloc(sizeof(WorkerPool));
+    if (pool == NULL) {
+      return NULL;
+    }
+    if (!worker_pool_init(pool, worker_pool_default_number_of_threads())) {
+      free(pool);
+      return NULL;
+    }
+    editor->worker_pool = pool;
+  }
+  return editor->worker_pool;
+}
+
+// ESC interrupts, other keys typed meanwhile are kept for editor_read_key
+static bool editor_poll_interrupt(void* context) {
+  Editor* editor = context;
+  int key;
+  while ((key = terminal_read_key(editor->terminal)) != TERMINAL_NO_KEY) {
+    if (key == 27) {
+      return false;
+    }
+    if (editor->number_of_typeahead_keys < EDITOR_TYPEAHEAD_SIZE) {
+      editor->typeahead_keys[editor->number_of_typeahead_keys++] = key;
+    }
+  }
+  return true;
+}
+
+int editor_read_key(Editor* editor) {
+  if (editor->next_typeahead_key < editor->number_of_typeahead_keys) {
+    const int key = editor->typeahead_keys[editor->next_typeahead_key++];
+    if (editor->next_typeahead_key == editor->number_of_typeahead_keys) {
+      editor->next_typeahead_key = 0;
+      editor->number_of_typeahead_keys = 0;
+    }
+    return key;
+  }
+  return terminal_read_key(editor->terminal);
+}
+
+// progress of a long command on the message line
+static void editor_show_progress(const Editor* editor, const char* message) {
+  terminal_draw_text(editor->terminal, editor->window.height - 1, 1, message);
+  terminal_flush(editor->terminal);
+}
+
+// marks selects the rows for :g, NULL for every row
+static bool editor_substitute_rows(Editor* editor,
+                                   Substitution* substitution,
+                                   BufferRow* row,
+                                   int count,
+                                   const bool* marks,
+                                   SubstituteResult* result) {
+  if (marks != NULL) {
+    result->substitutions = 0;
+    result->changed_rows = 0;
+    result->last_changed_row = -1;
+    for (int i = 0; i < count && row != NULL; ++i, row = row->next) {
+      SubstituteResult row_result;
+      if (!marks[i]) {
+        continue;
+      }
+      substitute_rows(substitution, row, 1, &row_result);
+      result->substitutions += row_result.substitutions;
+      result->changed_rows += row_result.changed_rows;
+      if (row_result.changed_rows > 0) {
+        result->last_changed_row = i;
+      }
+    }
+    return true;
+  }
+  WorkerPool* pool = NULL;
+  if (count >= EDITOR_PARALLEL_ROWS) {
+    pool = editor_get_worker_pool(editor);
+  }
+  if (pool == NULL) {
+    substitute_rows(substitution, row, count, result);
+    return true;
+  }
+  editor_show_progress(editor, "Substituting... (ESC to interrupt)");
+  return substitute_rows_parallel(substitution, pool, row, count,
+                                  editor_poll_interrupt, editor, result);
+}
+
+static CommandResult editor_process_substitute_command(Editor* editor,
+                                                       const char* arguments,
+                                                       int first,
+                                                       int last,
+                                                       const bool* marks) {
+  const char delimiter = *arguments++;
+  if (delimiter == '\0' || isalnum((unsigned char)delimiter) || delimiter == ' ' ||
+      delimiter == '\\') {
+    editor_set_error_message(editor, "Invalid command syntax");
+    return CommandResult_Success;
+  }
+  char* pattern = command_split_delimited(&arguments, delimiter);
+  char* replacement = command_split_delimited(&arguments, delimiter);
+  if (pattern == NULL || replacement == NULL) {
+    free(pattern);
+    free(replacement);
+    editor_set_error_message(editor, "Out of memory");
+    return CommandResult_Success;
+  }
+
+  // empty pattern reuses the last search
+  const char* pattern_text = pattern;
+  if (pattern[0] == '\0') {
+    pattern_text = editor->search_pattern.pattern;
+  }
+  Substitution substitution;
+  const char* error = NULL;
+  if (pattern_text == NULL) {
+    error = "No previous regular expression";
+  } else if (substitution_init(&substitution, pattern_text, replacement, arguments,
+                               &error)) {
+    SubstituteResult result;
+    BufferRow* row = buffer_get_row(editor->current_buffer, first);
+    const bool completed = editor_substitute_rows(editor, &substitution, row,
+                                                  last - first + 1, marks, &result);
+    const bool count_only = substitution.count_only;
+    substitution_deinit(&substitution);
+
+    if (!completed) {
+      error = "Interrupted";
+    } else if (result.substitutions == 0) {
+      error = "Pattern not found";
+    } else {
+      char message[64];
+      snprintf(message, sizeof(message), "%d %s on %d lines", result.substitutions,
+               count_only ? "matches" : "substitutions", result.changed_rows);
+      if (!count_only) {
+        editor_buffer_modified(editor);
+        editor_move_to_line(editor, first + result.last_changed_row);
+        editor_move_cursor_to_start(editor);
+        editor_mark_dirty_whole_screen(editor);
+      }
+      editor_set_message(editor, message);
+    }
+  }
+  if (error != NULL) {
+    editor_set_error_message(editor, error);
+  }
+  free(pattern);
+  free(replacement);
+  return CommandResult_Success;
+}
+
+// dd and :d, removes count rows starting with the current one
+static void editor_delete_rows(Editor* editor, int count) {
+  const int line = editor_get_current_line_index(editor);
+  const int number_of_lines = buffer_get_number_of_lines(editor->current_buffer);
+  const int removed = buffer_remove_current_rows(editor->current_buffer, count);
+  const bool has_next = line < buffer_get_number_of_lines(editor->current_buffer);
+  editor_rows_removed(editor,
+                      has_next ? buffer_get_current_line(editor->current_buffer) : NULL,
+                      line, removed);
+  if (removed == number_of_lines) {
+    // the buffer got a new empty row
+    editor_rows_inserted(editor, buffer_get_first_row(editor->current_buffer), 0, 1);
+  }
+  if (line >= buffer_get_number_of_lines(editor->current_buffer)) {
+    // removed rows up to the end, cursor lands on the previous row
+    editor_move_cursor_y(editor, -1);
+  }
+  editor_mark_dirty_from_cursor(editor);
+}
+
+static void editor_delete_marked_rows(Editor* editor,
+                                      int first,
+                                      int count,
+                                      const bool* marks) {
+  editor_move_to_line(editor, first);
+  const int removed = buffer_remove_marked_rows(
+    editor->current_buffer, buffer_get_current_line(editor->current_buffer), count,
+    marks);
+  editor_buffer_modified(editor);
+  // the current row is the first one kept after the range start or the last one
+  const int number_of_lines = buffer_get_number_of_lines(editor->current_buffer);
+  if (first >= number_of_lines) {
+    editor_move_cursor_y(editor, number_of_lines - 1 - first);
+  }
+  editor_move_cursor_to_start(editor);
+  editor_mark_dirty_whole_screen(editor);
+
+  char message[48];
+  snprintf(message, sizeof(message), "%d fewer lines", removed);
+  editor_set_message(editor, message);
+}
+
+// :g/pat/cmd and :v/pat/cmd, rows are marked in a single scan first so the
+// command can work on the whole set at once
+static CommandResult editor_process_global_command(Editor* editor,
+                                                   const char* arguments,
+                                                   int first,
+                                                   int last,
+                                                   bool invert) {
+  const char delimiter = *arguments++;
+  if (delimiter == '\0' || isalnum((unsigned char)delimiter) || delimiter == ' ' ||
+      delimiter == '\\') {
+    editor_set_error_message(editor, "Invalid command syntax");
+    return CommandResult_Success;
+  }
+  char* pattern_text = command_split_delimited(&arguments, delimiter);
+  if (pattern_text == NULL) {
+    editor_set_error_message(editor, "Out of memory");
+    return CommandResult_Success;
+  }
+  SearchPattern pattern = {0};
+  const char* error = NULL;
+  if (pattern_text[0] == '\0') {
+    if (search_pattern_is_empty(&editor->search_pattern)) {
+      error = "No previous regular expression";
+    } else if (!search_pattern_clone(&pattern, &editor->search_pattern)) {
+      error = "Out of memory";
+    }
+  } else {
+    search_pattern_init(&pattern, pattern_text, &error);
+  }
+  free(pattern_text);
+
+  const int count = last - first + 1;
+  bool* marks = NULL;
+  int marked = 0;
+  if (error == NULL) {
+    marks = malloc(sizeof(bool) * count);
+    if (marks == NULL) {
+      error = "Out of memory";
+    }
+  }
+  if (error == NULL) {
+    const BufferRow* row = buffer_get_row(editor->current_buffer, first);
+    for (int i = 0; i < count; ++i, row = row->next) {
+      SearchMatch match;
+      marks[i] =
+        search_find_forward(&pattern, row->data, row->len, 0, &match) != invert;
+      marked += marks[i];
+    }
+  }
+  search_pattern_deinit(&pattern);
+
+  // the command runs once over the whole marked set
+  ExCommand command;
+  if (error == NULL && marked == 0) {
+    error = "Pattern not found";
+  } else if (error == NULL && command_parse(arguments, &command, &error)) {
+    const ExCommandId id = command.definition->id;
+    if (command.number_of_addresses > 0) {
+      error = "Ranges are not supported by :g";
+    } else if (id == ExCommandId_Delete) {
+      editor_delete_marked_rows(editor, first, count, marks);
+    } else if (id == ExCommandId_Substitute) {
+      editor_process_substitute_command(editor, command.arguments, first, last, marks);
+    } else {
+      error = "Command not supported by :g";
+    }
+    command_parsed_deinit(&command);
+  }
+  if (error != NULL) {
+    editor_set_error_message(editor, error);
+  }
+  free(marks);
+  return CommandResult_Success;
+}
+
+// shows the entries found so far while :grep runs, ESC interrupts it
+static bool editor_poll_grep(void* context) {
+  Editor* editor = context;
+  char message[64];
+  snprintf(message, sizeof(message), "Searching... %d matches (ESC to interrupt)",
+           editor->quickfix.number_of_entries);
+  editor_show_progress(editor, message);
+  return editor_poll_interrupt(editor);
+}
+
+// :grep pattern [files...] and :vimgrep /pattern/ [files...], the working
+// directory is searched without files, :grep! does not jump to the first match
+static CommandResult editor_process_grep_command(Editor* editor,
+                                                 const char* arguments,
+                                                 bool jump) {
+  const char delimiter = *arguments;
+  char* pattern = NULL;
+  if (delimiter != '\0' && !isalnum((unsigned char)delimiter) && delimiter != '\\' &&
+      delimiter != '_') {
+    ++arguments;
+    pattern = command_split_delimited(&arguments, delimiter);
+  } else {
+    const char* end = arguments;
+    while (*end != '\0' && !isspace((unsigned char)*end)) {
+      ++end;
+    }
+    pattern = strndup(arguments, end - arguments);
+    arguments = end;
+  }
+  // the files are split at blanks in place
+  char* files_text = strdup(arguments);
+  const char** paths = malloc(sizeof(char*) * (strlen(arguments) / 2 + 2));
+  if (pattern == NULL || files_text == NULL || paths == NULL) {
+    free(pattern);
+    free(files_text);
+    free(paths);
+    editor_set_error_message(editor, "Out of memory");
+    return CommandResult_Success;
+  }
+  int number_of_paths = 0;
+  for (char* path = strtok(files_text, " \t"); path != NULL;
+       path = strtok(NULL, " \t")) {
+    paths[number_of_paths++] = path;
+  }
+  if (number_of_paths == 0) {
+    paths[number_of_paths++] = ".";
+  }
+
+  SearchPattern search;
+  const char* error = NULL;
+  // empty pattern reuses the last search
+  const char* pattern_text =
+    pattern[0] != '\0' ? pattern : editor->search_pattern.pattern;
+  char** files = NULL;
+  int number_of_files = 0;
+  WorkerPool* pool = NULL;
+  if (pattern_text == NULL) {
+    error = "No previous regular expression";
+  } else if (search_pattern_init(&search, pattern_text, &error)) {
+    number_of_files = grep_collect_files(paths, number_of_paths, &files);
+    pool = editor_get_worker_pool(editor);
+    if (number_of_files < 0 || pool == NULL) {
+      error = "Out of memory";
+    } else {
+      quickfix_deinit(&editor->quickfix);
+      if (!grep_files(&search, files, number_of_files, pool, &editor->quickfix,
+                      editor_poll_grep, editor)) {
+        error = "Interrupted";
+      } else if (editor->quickfix.number_of_entries == 0) {
+        error = "No match";
+      }
+    }
+    grep_free_files(files, number_of_files > 0 ? number_of_files : 0);
+    search_pattern_deinit(&search);
+  }
+  free(pattern);
+  free(files_text);
+  free(paths);
+  if (error != NULL) {
+    editor_set_error_message(editor, error);
+  } else if (jump) {
+    editor_jump_to_quickfix_entry(editor, quickfix_move(&editor->quickfix, 1));
+  } else {
+    char message[64];
+    snprintf(message, sizeof(message), "%d matches",
+             editor->quickfix.number_of_entries);
+    editor_set_message(editor, message);
+  }
+  return CommandResult_Success;
+}
+
+// resolves a parsed address to a 0 based line, the result may be out of range
+static bool editor_resolve_address(Editor* editor,
+                                   const CommandAddress* address,
+                                   int* line,
+                                   const char** error) {
+  const int current = editor_get_current_line_index(editor);
+  switch (address->type) {
+    case CommandAddressType_Line: {
+      *line = address->line;
+    } break;
+    case CommandAddressType_Current: {
+      *line = current;
+    } break;
+    case CommandAddressType_Last: {
+      *line = buffer_get_number_of_lines(editor->current_buffer) - 1;
+    } break;
+    case CommandAddressType_Mark: {
+      const BufferMark* mark = NULL;
+      if (address->mark >= 'a' && address->mark <= 'z') {
+        mark = buffer_get_mark(editor->current_buffer, address->mark - 'a');
+      }
+      if (mark == NULL) {
+        *error = "Mark not set";
+        return false;
+      }
+      *line = buffer_get_row_index(editor->current_buffer, mark->row);
+    } break;
+    case CommandAddressType_SearchForward:
+    case CommandAddressType_SearchBackward: {
+      SearchPattern pattern = {0};
+      const SearchPattern* search = &editor->search_pattern;
+      if (address->pattern != NULL) {
+        if (!search_pattern_init(&pattern, address->pattern, error)) {
+          return false;
+        }
+        search = &pattern;
+      } else if (search_pattern_is_empty(search)) {
+        *error = "No previous regular expression";
+        return false;
+      }
+      // /pat/ starts on the next line and ?pat? on the previous one
+      const bool backward = address->type == CommandAddressType_SearchBackward;
+      BufferRow* row = buffer_get_current_line(editor->current_buffer);
+      BufferPosition position;
+      const bool found = buffer_find(editor->current_buffer, search, row, current,
+                                     backward ? 0 : row->len, backward, &position);
+      search_pattern_deinit(&pattern);
+      if (!found) {
+        *error = "Pattern not found";
+        return false;
+      }
+      *line = position.line;
+    } break;
+  }
+  *line += address->offset;
+  return true;
+}
+
+static CommandResult editor_command_goto(Editor* editor,
+                                         const ExCommand* command,
+                                         int first,
+                                         int last) {
+  (void)first;
+  if (command->number_of_addresses > 0) {
+    editor_push_jump(editor);
+    editor_move_to_line(editor, last);
+    editor_move_cursor_to_start(editor);
+  }
+  return CommandResult_Success;
+}
+
+// :cnext and :cprevious
+static CommandResult editor_command_quickfix(Editor* editor,
+                                             const ExCommand* command,
+                                             int first,
+                                             int last) {
+  (void)first;
+  (void)last;
+  if (editor->quickfix.number_of_entries == 0) {
+    editor_set_error_message(editor, "No Errors");
+    return CommandResult_Success;
+  }
+  const int count = command->definition->id == ExCommandId_Cnext ? 1 : -1;
+  const QuickfixEntry* entry = quickfix_move(&editor->quickfix, count);
+  if (entry == NULL) {
+    editor_set_error_message(editor, "No more items");
+    return CommandResult_Success;
+  }
+  editor_jump_to_quickfix_entry(editor, entry);
+  return CommandResult_Success;
+}
+
+static CommandResult editor_command_delete(Editor* editor,
+                                           const ExCommand* command,
+                                           int first,
+                                           int last) {
+  (void)command;
+  editor_move_to_line(editor, first);
+  editor_delete_rows(editor, last - first + 1);
+  editor_move_cursor_to_start(editor);
+  return CommandResult_Success;
+}
+
+static CommandResult editor_command_fold(Editor* editor,
+                                         const ExCommand* command,
+                                         int first,
+                                         int last) {
+  (void)command;
+  editor_create_fold(editor, first, last);
+  editor_folds_changed(editor);
+  return CommandResult_Success;
+}
+
+static CommandResult editor_command_global(Editor* editor,
+                                           const ExCommand* command,
+                                           int first,
+                                           int last) {
+  const bool invert = command->definition->id == ExCommandId_Vglobal || command->bang;
+  return editor_process_global_command(editor, command->arguments, first, last,
+                                       invert);
+}
+
+static CommandResult editor_command_grep(Editor* editor,
+                                         const ExCommand* command,
+                                         int first,
+                                         int last) {
+  (void)first;
+  (void)last;
+  return editor_process_grep_command(editor, command->arguments, !command->bang);
+}
+
+static CommandResult editor_command_quit(Editor* editor,
+                                         const ExCommand* command,
+                                         int first,
+                                         int last) {
+  (void)editor;
+  (void)command;
+  (void)first;
+  (void)last;
+  return CommandResult_ShouldExit;
+}
+
+// :set name=value
+static CommandResult editor_command_set(Editor* editor,
+                                        const ExCommand* command,
+                                        int first,
+                                        int last) {
+  (void)first;
+  (void)last;
+  const char* value = strchr(command->arguments, '=');
+  const int length = value != NULL ? (int)(value - command->arguments) : 0;
+  if ((length == 10 && strncmp(command->arguments, "foldmethod", length) == 0) ||
+      (length == 3 && strncmp(command->arguments, "fdm", length) == 0)) {
+    editor_set_fold_method(editor, value + 1);
+  } else {
+    editor_set_error_message(editor, "Unknown option");
+  }
+  return CommandResult_Success;
+}
+
+// :stats shows the averages and maxima of the last frames, refilling its
+// scratch buffer on every use
+static CommandResult editor_command_stats(Editor* editor,
+                                          const ExCommand* command,
+                                          int first,
+                                          int last) {
+  (void)command;
+  (void)first;
+  (void)last;
+#ifdef YASVI_PROFILE
+  if (editor->stats_buffer == NULL) {
+    Buffer* buffer = buffer_alloc();
+    if (buffer == NULL || !editor_append_buffer(editor, buffer)) {
+      buffer_free(buffer);
+      editor_set_error_message(editor, "Failed to allocate memory for buffer");
+      return CommandResult_Success;
+    }
+    editor->stats_buffer = buffer;
+  }
+  char report[EDITOR_STATS_REPORT_SIZE];
+  int length = profile_format(report, sizeof(report));
+  if (length >= (int)sizeof(report)) {
+    length = sizeof(report) - 1;
+  }
+  LineSplitter rows;
+  line_splitter_init(&rows);
+  line_splitter_feed(&rows, report, length);
+  line_splitter_finish(&rows);
+  BufferRow* head = NULL;
+  BufferRow* tail = NULL;
+  int number_of_rows = 0;
+  line_splitter_take_rows(&rows, &head, &tail, &number_of_rows);
+  line_splitter_deinit(&rows);
+  Buffer* buffer = editor->stats_buffer;
+  buffer_replace_rows(buffer, buffer_get_first_row(buffer),
+                      buffer_get_number_of_lines(buffer), head, tail,
+                      number_of_rows);
+  if (editor->current_buffer != buffer) {
+    editor_push_jump(editor);
+    editor_switch_buffer(editor, buffer);
+  } else {
+    editor_buffer_modified(editor);
+    buffer_scroll_to_top(buffer);
+    editor_home_cursor_xy(editor);
+  }
+#else
+  editor_set_error_message(editor, "Built without YASVI_PROFILE");
+#endif
+  return CommandResult_Success;
+}
+
+static bool editor_poll_shell(void* context) {
+  Editor* editor = context;
+  editor_show_progress(editor, "Running... (ESC to interrupt)");
+  return editor_poll_interrupt(editor);
+}
+
+// :{range}!command replaces the rows with what command prints for them, the
+// rows are streamed to it and its output is split straight into new rows
+static CommandResult editor_command_shell(Editor* editor,
+                                          const ExCommand* command,
+                                          int first,
+                                          int last) {
+  if (command->number_of_addresses == 0) {
+    editor_set_error_message(editor, "Only filtering a range is supported");
+    return CommandResult_Success;
+  }
+  if (*command->arguments == '\0') {
+    editor_set_error_message(editor, "Argument required");
+    return CommandResult_Success;
+  }
+  editor_move_to_line(editor, first);
+  const int count = last - first + 1;
+  LineSplitter output;
+  line_splitter_init(&output);
+  int status = 0;
+  const char* error = NULL;
+  const bool filtered = shell_filter_rows(
+    command->arguments, buffer_get_current_line(editor->current_buffer), count,
+    &output, editor_poll_shell, editor, &status, &error);
+  editor_mark_dirty_whole_screen(editor);
+  if (!filtered) {
+    line_splitter_deinit(&output);
+    editor_set_error_message(editor, error);
+    return CommandResult_Success;
+  }
+  BufferRow* head = NULL;
+  BufferRow* tail = NULL;
+  int number_of_rows = 0;
+  line_splitter_take_rows(&output, &head, &tail, &number_of_rows);
+  line_splitter_deinit(&output);
+  Buffer* buffer = editor->current_buffer;
+  const int number_of_lines_before = buffer_get_number_of_lines(buffer);
+  BufferRow* next = buffer_get_row(buffer, last + 1);
+  buffer_replace_rows(buffer, buffer_get_current_line(buffer), count, head, tail,
+                      number_of_rows);
+  // only the range is rescanned, unless an empty row replaced the whole buffer
+  if (buffer_get_number_of_lines(buffer) ==
+      number_of_lines_before - count + number_of_rows) {
+    editor_rows_removed(editor, next, first, count);
+    editor_rows_inserted(editor, head, first, number_of_rows);
+  } else {
+    editor_buffer_modified(editor);
+  }
+  // the current row is the first new one, the one after the range or the last
+  const int number_of_lines = buffer_get_number_of_lines(editor->current_buffer);
+  if (first >= number_of_lines) {
+    editor_move_cursor_y(editor, number_of_lines - 1 - first);
+  }
+  editor_move_cursor_to_start(editor);
+
+  char message[48];
+  if (status != 0) {
+    snprintf(message, sizeof(message), "shell returned %d", status);
+  } else {
+    snprintf(message, sizeof(message), "%d lines filtered", count);
+  }
+  editor_set_message(editor, message);
+  return CommandResult_Success;
+}
+
+// :r file and :r !command insert the file or the output of command below the
+// last line of the range, the rows are linked in at once and highlighted when
+// they are shown
+static CommandResult editor_command_read(Editor* editor,
+                                         const ExCommand* command,
+                                         int first,
+                                         int last) {
+  (void)first;
+  const char* arguments = command->arguments;
+  LineSplitter rows;
+  line_splitter_init(&rows);
+  const char* error = NULL;
+  int status = 0;
+  if (*arguments == '!') {
+    shell_filter_rows(arguments + 1, NULL, 0, &rows, editor_poll_shell, editor,
+                      &status, &error);
+    editor_mark_dirty_whole_screen(editor);
+  } else {
+    const char* filename =
+      *arguments != '\0' ? arguments : buffer_get_filename(editor->current_buffer);
+    if (filename == NULL) {
+      error = "No file name";
+    } else if (!line_splitter_read_file(&rows, filename)) {
+      error = "Can't open file";
+    }
+  }
+  if (error != NULL) {
+    line_splitter_deinit(&rows);
+    editor_set_error_message(editor, error);
+    return CommandResult_Success;
+  }
+  BufferRow* head = NULL;
+  BufferRow* tail = NULL;
+  int number_of_rows = 0;
+  line_splitter_take_rows(&rows, &head, &tail, &number_of_rows);
+  line_splitter_deinit(&rows);
+  if (number_of_rows > 0) {
+    editor_move_to_line(editor, last);
+    const BufferRow* row = buffer_get_current_line(editor->current_buffer);
+    buffer_replace_rows(editor->current_buffer, row->next, 0, head, tail,
+                        number_of_rows);
+    editor_rows_inserted(editor, head, last + 1, number_of_rows);
+    editor_move_rows(editor, 1);
+    editor_move_cursor_to_start(editor);
+    editor_mark_dirty_whole_screen(editor);
+  }
+  char message[48];
+  if (status != 0) {
+    snprintf(message, sizeof(message), "shell returned %d", status);
+  } else {
+    snprintf(message, sizeof(message), "%d more lines", number_of_rows);
+  }
+  editor_set_message(editor, message);
+  return CommandResult_Success;
+}
+
+static CommandResult editor_command_substitute(Editor* editor,
+                                               const ExCommand* command,
+                                               int first,
+                                               int last) {
+  return editor_process_substitute_command(editor, command->arguments, first, last,
+                                           NULL);
+}
+
+// :tag name
+static CommandResult editor_command_tag(Editor* editor,
+                                        const ExCommand* command,
+                                        int first,
+                                        int last) {
+  (void)first;
+  (void)last;
+  if (command->arguments[0] == '\0') {
+    editor_set_error_message(editor, "Argument required");
+    return CommandResult_Success;
+  }
+  editor_jump_to_tag(editor, command->arguments, (int)strlen(command->arguments));
+  return CommandResult_Success;
+}
+
+static CommandResult editor_command_write(Editor* editor,
+                                          const ExCommand* command,
+                                          int first,
+                                          int last) {
+  (void)first;
+  (void)last;
+  return editor_process_save_command(
+    editor, command->arguments, command->definition->id == ExCommandId_WriteQuit);
+}
+
+typedef CommandResult (*EditorCommandHandler)(Editor* editor,
+                                              const ExCommand* command,
+                                              int first,
+                                              int last);
+
+static const EditorCommandHandler editor_command_handlers[ExCommandId_Count] = {
+  [ExCommandId_Goto] = editor_command_goto,
+  [ExCommandId_Cnext] = editor_command_quickfix,
+  [ExCommandId_Cprevious] = editor_command_quickfix,
+  [ExCommandId_Delete] = editor_command_delete,
+  [ExCommandId_Find] = editor_command_find,
+  [ExCommandId_Fold] = editor_command_fold,
+  [ExCommandId_Global] = editor_command_global,
+  [ExCommandId_Grep] = editor_command_grep,
+  [ExCommandId_Quit] = editor_command_quit,
+  [ExCommandId_Read] = editor_command_read,
+  [ExCommandId_Set] = editor_command_set,
+  [ExCommandId_Shell] = editor_command_shell,
+  [ExCommandId_Stats] = editor_command_stats,
+  [ExCommandId_Substitute] = editor_command_substitute,
+  [ExCommandId_Tag] = editor_command_tag,
+  [ExCommandId_Vglobal] = editor_command_global,
+  [ExCommandId_Write] = editor_command_write,
+  [ExCommandId_WriteQuit] = editor_command_write,
+};
+
+static CommandResult editor_execute_command(Editor* editor, const ExCommand* command) {
+  const int number_of_lines = buffer_get_number_of_lines(editor->current_buffer);
+  int first = editor_get_current_line_index(editor);
+  int last = first;
+  const char* error = NULL;
+  if (command->number_of_addresses == 0 &&
+      (command->definition->flags & COMMAND_FLAG_WHOLE_BUFFER)) {
+    first = 0;
+    last = number_of_lines - 1;
+  } else if (command->number_of_addresses > 0) {
+    if (!editor_resolve_address(editor, &command->addresses[0], &first, &error)) {
+      editor_set_error_message(editor, error);
+      return CommandResult_Success;
+    }
+    last = first;
+    if (command->number_of_addresses == 2 &&
+        !editor_resolve_address(editor, &command->addresses[1], &last, &error)) {
+      editor_set_error_message(editor, error);
+      return CommandResult_Success;
+    }
+  }
+  if (first < 0 || last >= number_of_lines || first > last) {
+    editor_set_error_message(editor, "Invalid range");
+    return CommandResult_Success;
+  }
+  return editor_command_handlers[command->definition->id](editor, command, first,
+                                                          last);
+}
+
+// offset to the start of the count-th word in the current row, or to its end
+static int editor_get_offset_to_word(const Editor* editor, int count) {
+  const BufferRow* current_row = buffer_get_current_line(editor->current_buffer);
+  const int start = editor_get_cursor_x(editor);
+  const int position = buffer_row_find_next_word_start(current_row, start, &count);
+  if (position < 0) {
+    return start < current_row->len ? current_row->len - start : 0;
+  }
+  return position - start;
+}
+
+// w, b and e with a count, an empty row counts as a word for w and b
+static void editor_move_words(Editor* editor, int count, int motion) {
+  const BufferRow* row = buffer_get_current_line(editor->current_buffer);
+  int line = editor_get_current_line_index(editor);
+  int index = editor_get_cursor_x(editor);
+  int position = -1;
+  while (true) {
+    if (motion == 'b') {
+      position = buffer_row_find_prev_word_start(row, index, &count);
+    } else if (motion == 'e') {
+      position = buffer_row_find_next_word_end(row, index, &count);
+    } else {
+      position = buffer_row_find_next_word_start(row, index, &count);
+    }
+    if (position >= 0) {
+      break;
+    }
+    const BufferRow* next = motion == 'b' ? row->prev : row->next;
+    if (next == NULL) {
+      // stops at the start of the buffer or at its last character
+      position = motion == 'b' || row->len == 0 ? 0 : row->len - 1;
+      break;
+    }
+    row = next;
+    line += motion == 'b' ? -1 : 1;
+    if (row->len == 0 && motion != 'e' && --count == 0) {
+      position = 0;
+      break;
+    }
+    index = motion == 'b' ? row->len : -1;
+  }
+  editor_move_to_position(editor, line, position);
+}
+
+static void editor_fix_cursor_position(Editor* editor) {
+  const BufferRow* current_row = buffer_get_current_line(editor->current_buffer);
+  int line_length = buffer_row_get_length(current_row);
+
+  if (line_length <= editor_get_cursor_x(editor)) {
+    editor_home_cursor_x(editor);
+    editor_move_cursor_x(editor, line_length, false);
+  }
+}
+
+static void editor_move_cursor_x_to_right(Editor* editor, int x, bool insert_mode) {
+  BufferRow* current_line = buffer_get_current_line(editor->current_buffer);
+  const int line_length = buffer_row_get_length(current_line) - 1 + insert_mode;
+  const int chars_till_end = line_length - editor_get_cursor_x(editor);
+  const int chars_till_window_end = editor->window.width - editor->cursor.x - 1;
+  if (x > chars_till_end) {
+    x = chars_till_end;
+  }
+
+  if (x > chars_till_window_end) {
+    editor->cursor.x = editor->window.width - 1;
+    x -= chars_till_window_end;
+  } else {
+    editor->cursor.x += x;
+    x = 0;
+  }
+
+  if (x > 0) {
+    editor->start_column += x;
+  }
+}
+
+static void editor_move_cursor_x_to_left(Editor* editor, int x) {
+  const int chars_till_window = editor->cursor.x - editor->number_of_line_digits;
+
+  if (x > chars_till_window) {
+    x -= chars_till_window;
+    editor->cursor.x = editor->number_of_line_digits;
+  } else {
+    editor->cursor.x -= x;
+    x = 0;
+  }
+
+  if (x > editor->start_column) {
+    editor->start_column = 0;
+  } else {
+    editor->start_column -= x;
+  }
+}
+
+static void editor_move_cursor_x(Editor* editor, int x, bool insert_mode) {
+  if (x >= 0) {
+    editor_move_cursor_x_to_right(editor, x, insert_mode);
+  } else {
+    editor_move_cursor_x_to_left(editor, -x);
+  }
+}
+
+static void editor_move_cursor_y(Editor* editor, int y) {
+  const int previous_start = editor->start_line;
+  editor->cursor.y += y;
+  if (editor->cursor.y <= EDITOR_TOP_BAR_HEIGHT) {
+    editor->start_line += (editor->cursor.y - 1);
+    if (editor->start_line < 0) {
+      editor->start_line = 0;
+    }
+    editor->cursor.y = 1;
+  } else if (editor->cursor.y > editor->window.height - EDITOR_BOTTOM_BAR_HEIGHT -
+                                  EDITOR_TOP_BAR_HEIGHT) {
+    const int number_of_lines = buffer_get_number_of_lines(editor->current_buffer);
+    editor->start_line +=
+      (editor->cursor.y -
+       (editor->window.height - EDITOR_BOTTOM_BAR_HEIGHT - EDITOR_TOP_BAR_HEIGHT));
+    editor->cursor.y =
+      editor->window.height - EDITOR_BOTTOM_BAR_HEIGHT - EDITOR_TOP_BAR_HEIGHT;
+    if (editor->start_line > number_of_lines - editor->window.height +
+                               EDITOR_BOTTOM_BAR_HEIGHT + EDITOR_TOP_BAR_HEIGHT) {
+      editor->start_line = number_of_lines - editor->window.height +
+                           EDITOR_BOTTOM_BAR_HEIGHT + EDITOR_TOP_BAR_HEIGHT;
+    }
+  }
+  if (editor->start_line != previous_start) {
+    editor_mark_dirty_whole_screen(editor);
+  }
+}
+
+static void editor_move_cursor_to_end(Editor* editor) {
+  const BufferRow* current_row = buffer_get_current_line(editor->current_buffer);
+  editor_move_cursor_x(editor, buffer_row_get_length(current_row), false);
+}
+
+static void editor_delete_chars(Editor* editor, int count) {
+  BufferRow* current_row = buffer_get_current_line(editor->current_buffer);
+  if (buffer_row_remove_chars(current_row, editor_get_cursor_x(editor), count)) {
+    editor_row_modified(editor);
+    editor_fix_cursor_position(editor);
+  }
+}
+
+static void editor_delete_words(Editor* editor, int count) {
+  BufferRow* current_row = buffer_get_current_line(editor->current_buffer);
+  const int offset_to_word = editor_get_offset_to_word(editor, count);
+  if (offset_to_word > 0) {
+    buffer_row_remove_chars(current_row, editor_get_cursor_x(editor),
+                            offset_to_word);
+    editor_row_modified(editor);
+  }
+}
+
+// removes the text from (first_line, first_column) up to last_column of
+// last_line, which is kept, rows in between go and the rest of the last row
+// is joined to the first one
+static void editor_delete_range(Editor* editor,
+                                int first_line,
+                                int first_column,
+                                int last_line,
+                                int last_column) {
+  editor_move_to_line(editor, last_line);
+  BufferRow* row = buffer_get_current_line(editor->current_buffer);
+  if (first_line == last_line) {
+    buffer_row_remove_chars(row, first_column, last_column - first_column);
+    editor_row_modified(editor);
+  } else {
+    buffer_row_remove_chars(row, 0, last_column);
+    editor_row_modified(editor);
+    editor_move_to_line(editor, first_line);
+    buffer_row_trim(buffer_get_current_line(editor->current_buffer), first_column);
+    editor_row_modified(editor);
+    if (last_line - first_line > 1) {
+      editor_move_to_line(editor, first_line + 1);
+      editor_delete_rows(editor, last_line - first_line - 1);
+    }
+    editor_move_to_line(editor, first_line + 1);
+    if (buffer_join_current_line_with_previous(editor->current_buffer) > 0) {
+      editor_rows_removed(editor,
+                          buffer_get_current_line(editor->current_buffer)->next,
+                          first_line + 1, 1);
+      editor_move_cursor_y(editor, -1);
+      editor_row_modified(editor);
+    }
+    editor_mark_dirty_from_cursor(editor);
+  }
+  editor_move_to_position(editor, first_line, first_column);
+}
+
+static int editor_get_bracket_object_type(int key) {
+  switch (key) {
+    case '(':
+    case ')':
+    case 'b':
+      return 1;
+    case '[':
+    case ']':
+      return 2;
+    case '{':
+    case '}':
+    case 'B':
+      return 3;
+    default:
+      return 0;
+  }
+}
+
+// i( and a( like text objects, with change set rows between brackets standing
+// on their own rows leave one empty row for the insert
+static bool editor_delete_text_object(Editor* editor,
+                                      char object,
+                                      int key,
+                                      bool change) {
+  const int type = editor_get_bracket_object_type(key);
+  BufferRow* row = buffer_get_current_line(editor->current_buffer);
+  BufferPosition start;
+  BufferPosition end;
+  if (type == 0 ||
+      !buffer_find_enclosing_brackets(row, editor_get_current_line_index(editor),
+                                      editor_get_cursor_x(editor), type, &start,
+                                      &end)) {
+    return false;
+  }
+  if (object == 'a') {
+    editor_delete_range(editor, start.line, start.column, end.line, end.column + 1);
+    return true;
+  }
+  const int rows_between = end.line - start.line - 1;
+  if (rows_between >= 0 && start.column == start.row->len - 1 &&
+      end.column == buffer_row_get_offset_to_first_char(end.row, 0)) {
+    const int removed = change ? rows_between - 1 : rows_between;
+    if (removed > 0) {
+      editor_move_to_line(editor, start.line + 1);
+      editor_delete_rows(editor, removed);
+    }
+    if (change && rows_between > 0) {
+      editor_move_to_position(editor, start.line + 1, 0);
+      buffer_row_trim(buffer_get_current_line(editor->current_buffer), 0);
+      editor_row_modified(editor);
+      return true;
+    }
+    editor_move_to_line(editor, start.line + 1);
+    return true;
+  }
+  editor_delete_range(editor, start.line, start.column + 1, end.line, end.column);
+  return true;
+}
+
+// jumps from the first bracket at or after the cursor to its pair
+static void editor_move_to_matching_bracket(Editor* editor) {
+  BufferRow* row = buffer_get_current_line(editor->current_buffer);
+  int column = editor_get_cursor_x(editor);
+  buffer_row_highlight_pending(row);
+  while (column < row->len && buffer_row_get_bracket(row, column) == 0) {
+    ++column;
+  }
+  BufferPosition match;
+  if (buffer_find_matching_bracket(row, editor_get_current_line_index(editor),
+                                   column, &match)) {
+    editor_push_jump(editor);
+    editor_move_to_position(editor, match.line, match.column);
+  }
+}
+
+static void editor_set_change(EditorChange* change,
+                              char operator,
+                              char motion,
+                              int count) {
+  change->operator = operator;
+  change->motion = motion;
+  change->object = '\0';
+  change->count = count;
+  change->length = 0;
+}
+
+static bool editor_append_change_text(EditorChange* change,
+                                      const char* text,
+                                      int length) {
+  if (change->length + length > change->capacity) {
+    int capacity = change->capacity > 0 ? change->capacity * 2 : 64;
+    while (capacity < change->length + length) {
+      capacity *= 2;
+    }
+    char* data = (char*)realloc(change->text, capacity);
+    if (data == NULL) {
+      return false;
+    }
+    change->text = data;
+    change->capacity = capacity;
+  }
+  memcpy(&change->text[change->length], text, length);
+  change->length += length;
+  return true;
+}
+
+// keeps the text typed in insert mode for '.'
+static void editor_record_insert_key(Editor* editor, int key) {
+  EditorChange* change = &editor->insert_change;
+  switch (key) {
+    case TERMINAL_KEY_LEFT:
+    case TERMINAL_KEY_RIGHT:
+    case TERMINAL_KEY_UP:
+    case TERMINAL_KEY_DOWN: {
+      // only the text typed after moving is repeated
+      editor_set_change(change, 'i', '\0', 1);
+    } break;
+    case TERMINAL_KEY_BACKSPACE:
+    case 127: {
+      if (change->length > 0 && change->text[change->length - 1] != '\b') {
+        --change->length;
+      } else {
+        editor_append_change_text(change, "\b", 1);
+      }
+    } break;
+    case '\t': {
+      for (int i = 0; i < editor->tab_size; ++i) {
+        editor_append_change_text(change, " ", 1);
+      }
+    } break;
+    default: {
+      const char c = (char)key;
+      editor_append_change_text(change, &c, 1);
+    }
+  }
+}
+
+// runs of plain characters are inserted at once, one highlight per row
+static void editor_insert_text(Editor* editor, const char* text, int length) {
+  int start = 0;
+  while (start < length) {
+    int end = start;
+    while (end < length && text[end] != '\n' && text[end] != '\b') {
+      ++end;
+    }
+    if (end > start) {
+      BufferRow* current_row = buffer_get_current_line(editor->current_buffer);
+      buffer_row_insert_chars(current_row, editor_get_cursor_x(editor),
+                              &text[start], end - start);
+      editor_move_cursor_x(editor, end - start, true);
+      editor_row_modified(editor);
+    }
+    if (end < length) {
+      editor_insert_char(editor, text[end] == '\b' ? 127 : '\n');
+      ++end;
+    }
+    start = end;
+  }
+}
+
+static void editor_apply_change(Editor* editor,
+                                const EditorChange* change,
+                                int count) {
+  switch (change->operator) {
+    case 'x': {
+      editor_delete_chars(editor, count);
+    } break;
+    case 'd': {
+      if (change->motion == 'd') {
+        editor_delete_rows(editor, count);
+      } else if (change->motion == 'w') {
+        editor_delete_words(editor, count);
+      } else {
+        editor_delete_text_object(editor, change->motion, change->object, false);
+      }
+      editor_fix_cursor_position(editor);
+    } break;
+    case 'c':
+    case 'a':
+    case 'i': {
+      if (change->operator == 'c' &&
+          !editor_delete_text_object(editor, change->motion, change->object, true)) {
+        return;
+      }
+      editor->end_line_mode = false;
+      if (change->operator == 'a') {
+        editor_move_cursor_x(editor, 1, true);
+      }
+      for (int i = 0; i < count; ++i) {
+        editor_insert_text(editor, change->text, change->length);
+      }
+      editor_fix_cursor_position(editor);
+    } break;
+    default: {
+    }
+  }
+}
+
+// count given to '.' replaces the one of the change
+static void editor_repeat_change(Editor* editor, int count) {
+  EditorChange* change = &editor->last_change;
+  if (change->operator == '\0') {
+    return;
+  }
+  if (count > 0) {
+    change->count = count;
+  }
+  editor_apply_change(editor, change, change->count);
+}
+
+static void editor_begin_insert(Editor* editor, char operator, int count) {
+  editor->end_line_mode = false;
+  editor->state = EditorState_EditMode;
+  editor_set_change(&editor->insert_change, operator, '\0', count);
+}
+
+static void editor_end_insert(Editor* editor) {
+  EditorChange* change = &editor->insert_change;
+  editor->state = EditorState_Running;
+  // count given to i and a inserts the text that many times
+  for (int i = 1; i < change->count; ++i) {
+    editor_insert_text(editor, change->text, change->length);
   }
+  // just in case we are after last character while appeding/removing last
+  editor_fix_cursor_position(editor);
+  const EditorChange last_change = editor->last_change;
+  editor->last_change = *change;
+  *change = last_change;
 }
 
-static void editor_move_cursor_x(Editor* editor, int x, bool insert_mode) {
-  if (x >= 0) {
-    editor_move_cursor_x_to_right(editor, x, insert_mode);
-  } else {
-    editor_move_cursor_x_to_left(editor, -x);
+// replaces the completed part of the word with the selected candidate
+static void editor_show_completion(Editor* editor, int selected) {
+  EditorCompletion* completion = &editor->completion;
+  BufferRow* row = buffer_get_current_line(editor->current_buffer);
+  const int from = completion->start + completion->prefix_length;
+  const int shown = editor_get_cursor_x(editor) - from;
+  int length = 0;
+  char* text = NULL;
+  if (selected >= 0) {
+    const char* identifier = identifier_index_get(
+      &editor->identifier_index, completion->candidates[selected], &length);
+    length -= completion->prefix_length;
+    // the index may move its text while the row is highlighted again
+    text = malloc(length);
+    if (text == NULL) {
+      editor_set_error_message(editor, "Failed to allocate memory for completion");
+      return;
+    }
+    memcpy(text, identifier + completion->prefix_length, length);
+  }
+  if (shown > 0) {
+    editor_move_cursor_x(editor, -shown, true);
+    buffer_row_remove_chars(row, from, shown);
   }
+  if (length > 0) {
+    buffer_row_insert_chars(row, from, text, length);
+    editor_move_cursor_x(editor, length, true);
+  }
+  editor_row_modified(editor);
+  free(text);
+  completion->selected = selected;
+
+  // '.' repeats the inserted text
+  EditorChange* change = &editor->insert_change;
+  change->length -= shown < change->length ? shown : change->length;
+  editor_append_change_text(change, &row->data[from], length);
 }
 
-static void editor_move_cursor_y(Editor* editor, int y) {
-  const int previous_start = editor->start_line;
-  editor->cursor.y += y;
-  if (editor->cursor.y <= EDITOR_TOP_BAR_HEIGHT) {
-    editor->start_line += (editor->cursor.y - 1);
-    if (editor->start_line < 0) {
-      editor->start_line = 0;
+// Ctrl-N and Ctrl-P complete the identifier before the cursor from the index of
+// all buffers without scanning them, repeating the key cycles through the
+// candidates and back to the typed prefix
+static void editor_complete_identifier(Editor* editor, bool forward) {
+  EditorCompletion* completion = &editor->completion;
+  if (!completion->active) {
+    const BufferRow* row = buffer_get_current_line(editor->current_buffer);
+    const int cursor = editor_get_cursor_x(editor);
+    int start = cursor;
+    while (start > 0 && identifier_index_is_identifier_char(row->data[start - 1])) {
+      --start;
     }
-    editor->cursor.y = 1;
-  } else if (editor->cursor.y > editor->window.height - EDITOR_BOTTOM_BAR_HEIGHT -
-                                  EDITOR_TOP_BAR_HEIGHT) {
-    const int number_of_lines = buffer_get_number_of_lines(editor->current_buffer);
-    editor->start_line +=
-      (editor->cursor.y -
-       (editor->window.height - EDITOR_BOTTOM_BAR_HEIGHT - EDITOR_TOP_BAR_HEIGHT));
-    editor->cursor.y =
-      editor->window.height - EDITOR_BOTTOM_BAR_HEIGHT - EDITOR_TOP_BAR_HEIGHT;
-    if (editor->start_line > number_of_lines - editor->window.height +
-                               EDITOR_BOTTOM_BAR_HEIGHT + EDITOR_TOP_BAR_HEIGHT) {
-      editor->start_line = number_of_lines - editor->window.height +
-                           EDITOR_BOTTOM_BAR_HEIGHT + EDITOR_TOP_BAR_HEIGHT;
+    free(completion->candidates);
+    IdentifierIndex* index = &editor->identifier_index;
+    completion->number_of_candidates = identifier_index_complete(
+      index, &row->data[start], cursor - start, &completion->candidates);
+    // the word the cursor is in was indexed with the typed prefix, it is only
+    // offered when it occurs elsewhere too
+    int end = cursor;
+    while (end < row->len && identifier_index_is_identifier_char(row->data[end])) {
+      ++end;
+    }
+    if (end > cursor && completion->number_of_candidates > 0) {
+      int kept = 0;
+      for (int i = 0; i < completion->number_of_candidates; ++i) {
+        const int id = completion->candidates[i];
+        int length = 0;
+        const char* text = identifier_index_get(index, id, &length);
+        if (length != end - start || memcmp(text, &row->data[start], length) != 0 ||
+            identifier_index_get_count(index, id) > 1) {
+          completion->candidates[kept++] = id;
+        }
+      }
+      completion->number_of_candidates = kept;
     }
+    if (completion->number_of_candidates <= 0) {
+      editor_set_error_message(editor, "Pattern not found");
+      return;
+    }
+    completion->active = true;
+    completion->selected = -1;
+    completion->start = start;
+    completion->prefix_length = cursor - start;
   }
-  if (editor->start_line != previous_start) {
-    editor_mark_dirty_whole_screen(editor);
+  // the typed prefix sits between the last and the first candidate
+  int selected = completion->selected + (forward ? 1 : -1);
+  if (selected >= completion->number_of_candidates) {
+    selected = -1;
+  } else if (selected < -1) {
+    selected = completion->number_of_candidates - 1;
   }
-}
+  editor_show_completion(editor, selected);
 
-static void editor_move_cursor_to_end(Editor* editor) {
-  const BufferRow* current_row = buffer_get_current_line(editor->current_buffer);
-  editor_move_cursor_x(editor, buffer_row_get_length(current_row), false);
+  char message[48];
+  if (selected < 0) {
+    snprintf(message, sizeof(message), "Back at original");
+  } else {
+    snprintf(message, sizeof(message), "match %d of %d", selected + 1,
+             completion->number_of_candidates);
+  }
+  editor_set_message(editor, message);
 }
 
-static void editor_process_editor_key(Editor* editor, int key) {
-  // TODO: scroll buffers
-  Buffer* current_buffer = editor->current_buffer;
+// count is always at least 1, motions and operators apply it in one step
+static void editor_process_editor_key(Editor* editor, int key, int count) {
+  if (editor->filtering && editor_process_filter_key(editor, key, count)) {
+    return;
+  }
+  if (editor_is_fold_view(editor) && editor_process_fold_key(editor, key, count)) {
+    return;
+  }
   switch (key) {
     case 'h':
-    case KEY_LEFT: {
+    case TERMINAL_KEY_LEFT: {
       // Move cursor left
       editor->end_line_mode = false;
-      editor_move_cursor_x(editor, -1, false);
+      editor_move_cursor_x(editor, -count, false);
       return;
     }
     case 'l':
-    case KEY_RIGHT: {
+    case TERMINAL_KEY_RIGHT: {
       // Move cursor right
-      editor_move_cursor_x(editor, 1, false);
+      editor_move_cursor_x(editor, count, false);
       return;
     }
     case 'j':
-    case KEY_DOWN: {
+    case TERMINAL_KEY_DOWN: {
       // Move cursor down
-      if (buffer_current_is_last_row(current_buffer)) {
-        return;
-      }
-      editor_move_cursor_y(editor, 1);
-      buffer_scroll_rows(editor->current_buffer, 1);
-      editor_fix_cursor_position(editor);
+      editor_move_rows(editor, count);
       return;
     }
     case 'k':
-    case KEY_UP: {
+    case TERMINAL_KEY_UP: {
       // Move cursor up
-      if (buffer_current_is_first_row(current_buffer)) {
-        return;
-      }
-      editor_move_cursor_y(editor, -1);
-      buffer_scroll_rows(editor->current_buffer, -1);
-      editor_fix_cursor_position(editor);
+      editor_move_rows(editor, -count);
       return;
     }
     case '^': {
@@ -406,56 +2378,147 @@ static void editor_process_editor_key(Editor* editor, int key) {
       return;
     }
     case '$': {
+      editor_move_rows(editor, count - 1);
       editor_move_cursor_to_end(editor);
       editor->end_line_mode = true;
       return;
     }
     case 'G': {
       editor->end_line_mode = false;
-      editor_move_to_bottom(editor);
+      editor_push_jump(editor);
+      if (editor->repeat_count > 0) {
+        editor_move_to_line(editor, count - 1);
+      } else {
+        editor_move_to_bottom(editor);
+      }
       return;
     }
-    case 'w': {
-      const BufferRow* current_row = buffer_get_current_line(editor->current_buffer);
-      int offset_to_word =
-        buffer_row_get_offset_to_next_word(current_row, editor_get_cursor_x(editor));
-
-      editor_move_cursor_x(editor, offset_to_word, false);
+    case 'w':
+    case 'b':
+    case 'e': {
+      editor->end_line_mode = false;
+      editor_move_words(editor, count, key);
+      return;
+    }
+    case 'n': {
+      editor_push_jump(editor);
+      editor_search_next(editor, false, count);
+      return;
+    }
+    case 'N': {
+      editor_push_jump(editor);
+      editor_search_next(editor, true, count);
+      return;
+    }
+    case 'm':
+    case '\'':
+    case '`': {
+      editor->key_sequence[0] = (char)key;
+      editor->key_sequence[1] = '\0';
+      return;
+    }
+    case 15: {
+      // Ctrl-O
+      BufferJump target;
+      for (int i = 0; i < count; ++i) {
+        if (!buffer_jump_back(editor->current_buffer,
+                              buffer_get_current_line(editor->current_buffer),
+                              editor_get_cursor_x(editor), &target)) {
+          break;
+        }
+        editor_follow_jump(editor, &target);
+      }
+      return;
+    }
+    case 29: {
+      // Ctrl-] jumps to the tag under the cursor
+      const BufferRow* row = buffer_get_current_line(editor->current_buffer);
+      int start = editor_get_cursor_x(editor);
+      if (start >= row->len ||
+          !identifier_index_is_identifier_char(row->data[start])) {
+        editor_set_error_message(editor, "No identifier under cursor");
+        return;
+      }
+      while (start > 0 &&
+             identifier_index_is_identifier_char(row->data[start - 1])) {
+        --start;
+      }
+      int end = editor_get_cursor_x(editor);
+      while (end < row->len && identifier_index_is_identifier_char(row->data[end])) {
+        ++end;
+      }
+      editor->end_line_mode = false;
+      editor_jump_to_tag(editor, &row->data[start], end - start);
       return;
     }
-    case 'b': {
-      const BufferRow* current_row = buffer_get_current_line(editor->current_buffer);
-      int offset_to_word =
-        buffer_row_get_offset_to_prev_word(current_row, editor_get_cursor_x(editor));
-      editor_move_cursor_x(editor, offset_to_word, false);
+    case '\t': {
+      // Ctrl-I
+      BufferJump target;
+      for (int i = 0; i < count; ++i) {
+        if (!buffer_jump_forward(editor->current_buffer, &target)) {
+          break;
+        }
+        editor_follow_jump(editor, &target);
+      }
       return;
     }
     case 'g': {
       editor->key_sequence[0] = 'g';
+      editor->key_sequence[1] = '\0';
       return;
     }
     case 'd': {
       editor->key_sequence[0] = 'd';
+      editor->key_sequence[1] = '\0';
       return;
     }
-    case 'x': {
-      BufferRow* current_row = buffer_get_current_line(editor->current_buffer);
-      if (buffer_row_remove_char(current_row, editor_get_cursor_x(editor))) {
-        editor_fix_cursor_position(editor);
+    case 'c': {
+      editor->key_sequence[0] = 'c';
+      editor->key_sequence[1] = '\0';
+      return;
+    }
+    case 'z': {
+      editor->key_sequence[0] = 'z';
+      editor->key_sequence[1] = '\0';
+      return;
+    }
+    case '%': {
+      editor->end_line_mode = false;
+      editor_move_to_matching_bracket(editor);
+      return;
+    }
+    case 'q': {
+      if (editor->recording_register != '\0') {
+        editor_stop_recording(editor);
+        return;
       }
+      editor->key_sequence[0] = 'q';
+      editor->key_sequence[1] = '\0';
+      return;
+    }
+    case '@': {
+      editor->key_sequence[0] = '@';
+      editor->key_sequence[1] = '\0';
+      return;
+    }
+    case 'x': {
+      editor_delete_chars(editor, count);
+      editor_set_change(&editor->last_change, 'x', '\0', count);
       return;
     }
     case 'i': {
-      editor->end_line_mode = false;
-      editor->state = EditorState_EditMode;
+      editor_begin_insert(editor, 'i', count);
       return;
     }
     case 'a': {
-      editor->end_line_mode = false;
-      editor->state = EditorState_EditMode;
+      editor_begin_insert(editor, 'a', count);
       editor_move_cursor_x(editor, 1, true);
       return;
     }
+    case '.': {
+      editor_repeat_change(editor, editor->repeat_count);
+      return;
+    }
     case 27: {
       editor_clear_error_message(editor);
       return;
@@ -470,16 +2533,17 @@ static void editor_process_editor_key(Editor* editor, int key) {
 }
 
 static bool editor_append_buffer(Editor* editor, Buffer* buffer) {
-  editor->buffers = NULL;
-  editor->buffers = (Buffer**)realloc(
+  Buffer** buffers = (Buffer**)realloc(
     editor->buffers, sizeof(Buffer*) * (editor->number_of_buffers + 1));
-  if (editor->buffers == NULL) {
+  if (buffers == NULL) {
     editor_set_error_message(editor, "Failed to allocate memory for buffers");
     return false;
   }
 
+  editor->buffers = buffers;
   editor->buffers[editor->number_of_buffers] = buffer;
   editor->number_of_buffers++;
+  buffer->jumplist = &editor->jumplist;
   return true;
 }
 
@@ -526,6 +2590,36 @@ static int editor_write_highlight_style(Editor* editor,
   return 10;
 }
 
+static const char* search_highlight_style = "\e[0;30;43m";
+
+// next non empty match of the highlight pattern ending after column
+static bool editor_find_highlight(const Editor* editor,
+                                  const BufferRow* row,
+                                  int column,
+                                  SearchMatch* match) {
+  const SearchPattern* pattern = editor->highlight_pattern;
+  // the first search of the row is reused while it is drawn
+  bool found = false;
+  if (match->start < 0) {
+    found = search_find_forward(pattern, row->data, row->len, 0, match);
+  } else {
+    const int start = match->start + (match->length > 0 ? match->length : 1);
+    found = start <= row->len &&
+            search_find_next(pattern, row->data, row->len, start, match);
+  }
+  while (found) {
+    if (match->length > 0 && match->start + match->length > column) {
+      return true;
+    }
+    const int start = match->start + (match->length > 0 ? match->length : 1);
+    found = start <= row->len &&
+            search_find_next(pattern, row->data, row->len, start, match);
+  }
+  match->start = row->len;
+  match->length = 0;
+  return false;
+}
+
 static void editor_decorate_and_draw_line(Editor* editor,
                                           int line_number,
                                           BufferRow* row,
@@ -535,11 +2629,30 @@ static void editor_decorate_and_draw_line(Editor* editor,
   const char* hl = &row->highlight_data[editor->start_column];
   int index = 0;
   EHighlightToken token = EHighlightToken_Normal;
+  SearchMatch match = {-1, 0};
+  bool highlighting = editor->highlight_pattern != NULL &&
+                      editor_find_highlight(editor, row, editor->start_column, &match);
+  bool in_match = false;
   for (int i = 0; i < row->len - editor->start_column && index < n; ++i) {
     if (line[i] == '\0') {
       break;  // End of line
     }
-    if (token != hl[i]) {
+    const int column = editor->start_column + i;
+    if (highlighting && column >= match.start + match.length) {
+      highlighting = editor_find_highlight(editor, row, column, &match);
+    }
+    if (highlighting && column >= match.start) {
+      if (!in_match && n - index > 10) {
+        memcpy(&buffer[index], search_highlight_style, 10);
+        index += 10;
+        in_match = true;
+      }
+    } else if (in_match) {
+      // style of the token has to be restored after the match
+      in_match = false;
+      token = EHighlightToken_Count;
+    }
+    if (!in_match && token != hl[i]) {
       token = hl[i];
       index +=
         editor_write_highlight_style(editor, token, &buffer[index], n - index);
@@ -552,6 +2665,39 @@ static void editor_decorate_and_draw_line(Editor* editor,
   buffer[index] = '\0';
 }
 
+static const char* fold_line_style = "\e[0;36;40m";
+
+// closed fold drawn in place of its rows, e.g. "+--12 lines: int main() {"
+static void editor_draw_fold_line(const Editor* editor,
+                                  const Fold* fold,
+                                  int number_of_rows,
+                                  char* buffer,
+                                  int n) {
+  static const char dashes[] = "----------------";
+  const int level = fold_get_level(fold);
+  char label[48];
+  const int label_length =
+    snprintf(label, sizeof(label), "+-%.*s%d lines: ",
+             level < (int)sizeof(dashes) ? level : (int)sizeof(dashes) - 1, dashes,
+             number_of_rows);
+  const BufferRow* row = fold->first;
+  const int indent = buffer_row_get_offset_to_first_char(row, 0);
+  const int width = editor->window.width - editor->number_of_line_digits;
+  int text_length = width - label_length;
+  if (text_length > row->len - indent) {
+    text_length = row->len - indent;
+  }
+  snprintf(buffer, n, "%s%.*s%.*s", fold_line_style, width, label,
+           text_length > 0 ? text_length : 0, &row->data[indent]);
+}
+
+static BufferRow* editor_get_filtered_row(const Editor* editor, int entry) {
+  if (entry >= match_index_get_number_of_matches(&editor->filter_index)) {
+    return NULL;
+  }
+  return match_index_get(&editor->filter_index, entry)->row;
+}
+
 static void editor_draw_buffers(Editor* editor) {
   int line_number = 1;
   editor->string_rendering_ongoing = false;
@@ -564,8 +2710,23 @@ static void editor_draw_buffers(Editor* editor) {
     // Draw current buffer
     const int window_height =
       editor->window.height - EDITOR_BOTTOM_BAR_HEIGHT - EDITOR_TOP_BAR_HEIGHT + 1;
-    BufferRow* row = buffer_get_row(editor->current_buffer, editor->start_line);
-    int max_digits = count_digits(editor->start_line + window_height);
+    const MatchIndex* filter_index = &editor->filter_index;
+    int entry = editor->filter_top;
+    BufferRow* row = NULL;
+    int max_digits = 0;
+    // line of row in the fold view
+    int row_line = editor->fold_top;
+    const bool fold_view = editor_is_fold_view(editor);
+    if (editor->filtering) {
+      row = editor_get_filtered_row(editor, entry);
+      max_digits = count_digits(buffer_get_number_of_lines(editor->current_buffer));
+    } else if (fold_view) {
+      row = buffer_get_row(editor->current_buffer, editor->fold_top);
+      max_digits = count_digits(buffer_get_number_of_lines(editor->current_buffer));
+    } else {
+      row = buffer_get_row(editor->current_buffer, editor->start_line);
+      max_digits = count_digits(editor->start_line + window_height);
+    }
 
     editor->number_of_line_digits = max_digits + 1;
     if (editor->cursor.x <= editor->number_of_line_digits) {
@@ -574,7 +2735,20 @@ static void editor_draw_buffers(Editor* editor) {
 
     while (line_number < window_height) {
       int row_number = line_number + editor->start_line;
+      if (editor->filtering && row != NULL) {
+        row_number = match_index_get(filter_index, entry)->line + 1;
+      } else if (fold_view) {
+        row_number = row_line + 1;
+      }
+      const Fold* fold = fold_view && row != NULL ? fold_get_closed_at_first(row) : NULL;
+      int number_of_folded_rows = 1;
+      if (fold != NULL) {
+        number_of_folded_rows =
+          buffer_get_row_index(editor->current_buffer, fold->last) - row_line + 1;
+      }
 
+      // rows inserted in bulk are highlighted once they are shown
+      buffer_row_highlight_pending(row);
       if (row != NULL && row->dirty) {
         static char line_buffer[1024];
         memcpy(line_buffer, highlight_styles[EHighlightToken_Normal], 10);
@@ -586,20 +2760,28 @@ static void editor_draw_buffers(Editor* editor) {
           ++line_length;
         }
         line_buffer[line_length] = '\0';
-        if (editor->start_column < buffer_row_get_length(row)) {
+        if (fold != NULL) {
+          editor_draw_fold_line(editor, fold, number_of_folded_rows,
+                                &line_buffer[line_length],
+                                sizeof(line_buffer) - line_length);
+        } else if (editor->start_column < buffer_row_get_length(row)) {
           editor_decorate_and_draw_line(editor, line_number, row,
                                         &line_buffer[line_length],
                                         sizeof(line_buffer) - line_length);
         }
-        mvaddstr(line_number, 0, line_buffer);
-        clrtoeol();
+        terminal_draw_text(editor->terminal, line_number, 0, line_buffer);
+        terminal_clear_to_end_of_line(editor->terminal);
         row->dirty = false;
-        row = row->next;
-      } else if (row != NULL) {
-        row = row->next;
+        PROFILE_COUNT(ProfileCounter_RowsRedrawn, 1);
       } else if (row == NULL) {
-        move(line_number, 0);
-        clrtoeol();
+        terminal_move(editor->terminal, line_number, 0);
+        terminal_clear_to_end_of_line(editor->terminal);
+      }
+      if (row != NULL) {
+        // a closed fold is skipped without visiting its rows
+        row_line += number_of_folded_rows;
+        row = editor->filtering ? editor_get_filtered_row(editor, ++entry)
+                                : editor_get_next_shown_row(row);
       }
 
       line_number++;
@@ -607,45 +2789,271 @@ static void editor_draw_buffers(Editor* editor) {
   }
 }
 
+// total count for operator sequences, e.g. 2d3w deletes 6 words
+static int editor_get_sequence_count(const Editor* editor) {
+  int count = editor->repeat_count > 0 ? editor->repeat_count : 1;
+  const int inner_count = atoi(&editor->key_sequence[1]);
+  if (inner_count > 0) {
+    count *= inner_count;
+  }
+  return count;
+}
+
 static void editor_process_gkey_sequence(Editor* editor, int key) {
-  if (key == 'g') {
-    editor->key_sequence[0] = 0;
-    editor_move_to_top(editor);
+  if (key == 'g' && editor->filtering) {
+    editor_filter_move_to(editor, editor_get_sequence_count(editor) - 1);
+  } else if (key == 'g') {
+    editor_push_jump(editor);
+    if (editor->repeat_count > 0) {
+      editor_move_to_line(editor, editor_get_sequence_count(editor) - 1);
+    } else {
+      editor_move_to_top(editor);
+      editor_fix_cursor_position(editor);
+    }
+  }
+  editor->key_sequence[0] = 0;
+  editor->repeat_count = 0;
+}
+
+// text objects of d and c wait for the bracket after i or a
+static void editor_process_object_sequence(Editor* editor, int key) {
+  const char operator = editor->key_sequence[0];
+  const char object = editor->key_sequence[strlen(editor->key_sequence) - 1];
+  editor->key_sequence[0] = 0;
+  editor->repeat_count = 0;
+  if (operator == 'd') {
+    if (editor_delete_text_object(editor, object, key, false)) {
+      editor_set_change(&editor->last_change, 'd', object, 1);
+      editor->last_change.object = (char)key;
+    }
     editor_fix_cursor_position(editor);
-  } else {
-    editor->key_sequence[0] = 0;
+  } else if (editor_delete_text_object(editor, object, key, true)) {
+    editor_begin_insert(editor, 'c', 1);
+    editor->insert_change.motion = object;
+    editor->insert_change.object = (char)key;
   }
 }
 
 static void editor_process_dkey_sequence(Editor* editor, int key) {
-  BufferRow* current_row = buffer_get_current_line(editor->current_buffer);
-  const int number_of_lines = buffer_get_number_of_lines(editor->current_buffer);
-  switch (key) {
+  const size_t length = strlen(editor->key_sequence);
+  const char last = editor->key_sequence[length - 1];
+  if (last == 'i' || last == 'a') {
+    editor_process_object_sequence(editor, key);
+    return;
+  }
+  if ((key == 'i' || key == 'a') && length < sizeof(editor->key_sequence) - 1) {
+    editor->key_sequence[length] = (char)key;
+    editor->key_sequence[length + 1] = '\0';
+    return;
+  }
+  const int count = editor_get_sequence_count(editor);
+  switch (editor->key_sequence[0] == 'd' ? key : 0) {
     case 'd': {
-      if (number_of_lines <= 1) {
-        buffer_row_replace_line(current_row, "\n");
-      } else {
-        int offset = buffer_remove_current_row(editor->current_buffer);
-
-        if (offset < 0) {
-          editor_move_cursor_y(editor, -1);
-        }
-      }
-      editor_mark_dirty_from_cursor(editor);
+      editor_delete_rows(editor, count);
+      editor_set_change(&editor->last_change, 'd', 'd', count);
     } break;
     case 'w': {
       // Delete word
-      int offset_to_word =
-        buffer_row_get_offset_to_next_word(current_row, editor_get_cursor_x(editor));
-      if (offset_to_word > 0) {
-        buffer_row_remove_chars(current_row, editor_get_cursor_x(editor),
-                                offset_to_word);
-      }
+      editor_delete_words(editor, count);
+      editor_set_change(&editor->last_change, 'd', 'w', count);
     } break;
   }
 
   editor_fix_cursor_position(editor);
   editor->key_sequence[0] = 0;
+  editor->repeat_count = 0;
+}
+
+// m sets a mark, ' and ` jump to it
+static void editor_process_mark_sequence(Editor* editor, int key) {
+  const char command = editor->key_sequence[0];
+  editor->key_sequence[0] = '\0';
+  editor->repeat_count = 0;
+  if (key < 'a' || key > 'z') {
+    editor_set_error_message(editor, "Invalid mark");
+    return;
+  }
+  if (command == 'm') {
+    buffer_set_mark(editor->current_buffer, key - 'a',
+                    buffer_get_current_line(editor->current_buffer),
+                    editor_get_cursor_x(editor));
+    return;
+  }
+  const BufferMark* mark = buffer_get_mark(editor->current_buffer, key - 'a');
+  if (mark == NULL) {
+    editor_set_error_message(editor, "Mark not set");
+    return;
+  }
+  editor_push_jump(editor);
+  editor_jump_to_mark(editor, mark, command == '`');
+}
+
+// fold to the line reached by the motion of zf
+static void editor_create_fold_to_motion(Editor* editor,
+                                         int key,
+                                         int count,
+                                         bool counted) {
+  const int line = editor_get_current_line_index(editor);
+  switch (key) {
+    case 'j':
+    case TERMINAL_KEY_DOWN: {
+      editor_create_fold(editor, line, line + count);
+    } break;
+    case 'k':
+    case TERMINAL_KEY_UP: {
+      editor_create_fold(editor, line, line - count);
+    } break;
+    case 'G': {
+      const int number_of_lines = buffer_get_number_of_lines(editor->current_buffer);
+      editor_create_fold(editor, line, counted ? count - 1 : number_of_lines - 1);
+    } break;
+    case '%': {
+      BufferPosition position;
+      if (buffer_find_matching_bracket(buffer_get_current_line(editor->current_buffer),
+                                       line, editor_get_cursor_x(editor), &position)) {
+        editor_create_fold(editor, line, position.line);
+      } else {
+        editor_set_error_message(editor, "No matching bracket");
+      }
+    } break;
+  }
+}
+
+// zf{motion} and zF add closed folds, zo, zc and za open, close and toggle the
+// fold under the cursor, zR, zM and zE open, close and drop all of them and zd
+// drops one
+static void editor_process_zkey_sequence(Editor* editor, int key) {
+  if (key == 'f' && editor->key_sequence[1] == '\0') {
+    editor->key_sequence[1] = 'f';
+    editor->key_sequence[2] = '\0';
+    return;
+  }
+  const bool create = editor->key_sequence[1] == 'f';
+  const int inner_count = create ? atoi(&editor->key_sequence[2]) : 0;
+  const bool counted = editor->repeat_count > 0 || inner_count > 0;
+  int count = editor->repeat_count > 0 ? editor->repeat_count : 1;
+  if (inner_count > 0) {
+    count *= inner_count;
+  }
+  editor->key_sequence[0] = '\0';
+  editor->repeat_count = 0;
+
+  Buffer* buffer = editor->current_buffer;
+  FoldTree* folds = &buffer->folds;
+  const int line = editor_get_current_line_index(editor);
+  Fold* closed = fold_tree_find_closed(folds, buffer, line);
+  Fold* innermost = fold_tree_find(folds, buffer, line);
+  if (create) {
+    editor_create_fold_to_motion(editor, key, count, counted);
+  } else if (key == 'F') {
+    editor_create_fold(editor, line, line + count - 1);
+  } else if (key == 'R' || key == 'M') {
+    fold_tree_set_all_closed(folds, key == 'M');
+  } else if (key == 'E') {
+    fold_tree_clear(folds);
+  } else if (key != 'o' && key != 'c' && key != 'a' && key != 'd') {
+    return;
+  } else if (innermost == NULL) {
+    editor_set_error_message(editor, "No fold found");
+    return;
+  } else if (key == 'd') {
+    fold_tree_remove(folds, closed != NULL ? closed : innermost);
+  } else if (closed != NULL && key != 'c') {
+    fold_set_closed(folds, closed, false);
+  } else if (key != 'o') {
+    // closes the innermost fold still open
+    while (innermost->closed && innermost->parent->parent != NULL) {
+      innermost = innermost->parent;
+    }
+    fold_set_closed(folds, innermost, true);
+  }
+  editor_folds_changed(editor);
+}
+
+static EditorMacro* editor_get_macro(Editor* editor, int name) {
+  if (name >= 'a' && name <= 'z') {
+    return &editor->macros[name - 'a'];
+  }
+  if (name >= 'A' && name <= 'Z') {
+    return &editor->macros[name - 'A'];
+  }
+  return NULL;
+}
+
+static void editor_start_recording(Editor* editor, int name) {
+  EditorMacro* macro = editor_get_macro(editor, name);
+  if (macro == NULL) {
+    editor_set_error_message(editor, "Invalid register");
+    return;
+  }
+  // uppercase register appends to the recorded keys
+  if (name >= 'a') {
+    macro->length = 0;
+  }
+  editor->recording_register = (char)name;
+}
+
+static void editor_record_key(Editor* editor, int key) {
+  EditorMacro* macro = editor_get_macro(editor, editor->recording_register);
+  if (macro->length == macro->capacity) {
+    const int capacity = macro->capacity > 0 ? macro->capacity * 2 : 32;
+    int* keys = (int*)realloc(macro->keys, sizeof(int) * capacity);
+    if (keys == NULL) {
+      editor->recording_register = '\0';
+      editor_set_error_message(editor, "Failed to allocate memory for macro");
+      return;
+    }
+    macro->keys = keys;
+    macro->capacity = capacity;
+  }
+  macro->keys[macro->length++] = key;
+}
+
+static void editor_stop_recording(Editor* editor) {
+  EditorMacro* macro = editor_get_macro(editor, editor->recording_register);
+  // drop the q which stopped the recording, replayed keys are not recorded
+  if (editor->replay_depth == 0 && macro->length > 0) {
+    --macro->length;
+  }
+  editor->recording_register = '\0';
+}
+
+// keys go straight to editor_process_key, the screen is drawn once at the end
+static void editor_replay_macro(Editor* editor, int name, int count) {
+  if (name == '@') {
+    name = editor->last_macro_register;
+  }
+  const EditorMacro* macro = editor_get_macro(editor, name);
+  if (macro == NULL) {
+    editor_set_error_message(editor, "Invalid register");
+    return;
+  }
+  if (editor->replay_depth >= EDITOR_MAX_REPLAY_DEPTH) {
+    editor_set_error_message(editor, "Macro recursion too deep");
+    editor->replay_interrupted = true;
+    return;
+  }
+  editor->last_macro_register = (char)name;
+  if (editor->replay_depth++ == 0) {
+    editor->replay_interrupted = false;
+  }
+  int replayed = 0;
+  for (int i = 0; i < count && !editor->replay_interrupted; ++i) {
+    // recording into the replayed register may shorten it
+    for (int k = 0; k < macro->length && !editor->replay_interrupted; ++k) {
+      editor_process_key(editor, macro->keys[k]);
+      if (editor_should_exit(editor)) {
+        editor->replay_interrupted = true;
+      } else if (++replayed % EDITOR_REPLAY_POLL_KEYS == 0 &&
+                 !editor_poll_interrupt(editor)) {
+        editor->replay_interrupted = true;
+        editor_set_error_message(editor, "Interrupted");
+      }
+    }
+  }
+  if (--editor->replay_depth == 0) {
+    editor_mark_dirty_whole_screen(editor);
+  }
 }
 
 static bool editor_process_key_sequence(Editor* editor, int key) {
@@ -662,25 +3070,54 @@ static bool editor_process_key_sequence(Editor* editor, int key) {
       editor->key_sequence[current_length + 1] = '\0';
       return true;
     } else {
-      editor->repeat_count = atoi(editor->key_sequence) - 1;
+      editor->repeat_count = atoi(editor->key_sequence);
       editor->key_sequence[0] = '\0';
       return false;
     }
   }
+  // register names are taken as they are
+  if (editor->key_sequence[0] == 'q' && key != 27) {
+    editor->key_sequence[0] = '\0';
+    editor->repeat_count = 0;
+    editor_start_recording(editor, key);
+    return true;
+  } else if ((editor->key_sequence[0] == 'm' || editor->key_sequence[0] == '\'' ||
+              editor->key_sequence[0] == '`') &&
+             key != 27) {
+    editor_process_mark_sequence(editor, key);
+    return true;
+  } else if (editor->key_sequence[0] == '@' && key != 27) {
+    const int count = editor_get_sequence_count(editor);
+    editor->key_sequence[0] = '\0';
+    editor->repeat_count = 0;
+    editor_replay_macro(editor, key, count);
+    return true;
+  }
+  // count between operator and motion
+  if (key >= '0' && key <= '9' && (key != '0' || current_length > 1)) {
+    editor->key_sequence[current_length] = (char)key;
+    editor->key_sequence[current_length + 1] = '\0';
+    return true;
+  }
   switch (key) {
     case 27: {
       editor->key_sequence[0] = '\0';
+      editor->repeat_count = 0;
       return true;
     }
     default: {
       if (editor->key_sequence[0] == 'g') {
         editor_process_gkey_sequence(editor, key);
         return true;
-      } else if (editor->key_sequence[0] == 'd') {
+      } else if (editor->key_sequence[0] == 'd' || editor->key_sequence[0] == 'c') {
         editor_process_dkey_sequence(editor, key);
         return true;
+      } else if (editor->key_sequence[0] == 'z') {
+        editor_process_zkey_sequence(editor, key);
+        return true;
       }
       editor->key_sequence[0] = 0;
+      editor->repeat_count = 0;
       return true;
     }
   }
@@ -690,18 +3127,18 @@ static bool editor_process_key_sequence(Editor* editor, int key) {
 void editor_insert_char(Editor* editor, int key) {
   BufferRow* current_row = buffer_get_current_line(editor->current_buffer);
   switch (key) {
-    case KEY_LEFT: {
+    case TERMINAL_KEY_LEFT: {
       // Move cursor left
       editor->end_line_mode = false;
       editor_move_cursor_x(editor, -1, true);
       return;
     }
-    case KEY_RIGHT: {
+    case TERMINAL_KEY_RIGHT: {
       // Move cursor right
       editor_move_cursor_x(editor, 1, true);
       return;
     }
-    case KEY_UP: {
+    case TERMINAL_KEY_UP: {
       // Move cursor up
       if (buffer_current_is_first_row(editor->current_buffer)) {
         return;
@@ -711,7 +3148,7 @@ void editor_insert_char(Editor* editor, int key) {
       editor_fix_cursor_position(editor);
       return;
     }
-    case KEY_DOWN: {
+    case TERMINAL_KEY_DOWN: {
       // Move cursor down
       if (buffer_current_is_last_row(editor->current_buffer)) {
         return;
@@ -721,16 +3158,21 @@ void editor_insert_char(Editor* editor, int key) {
       editor_fix_cursor_position(editor);
       return;
     }
-    case KEY_BACKSPACE:
+    case TERMINAL_KEY_BACKSPACE:
     case 127: {
       // Handle backspace
       if (editor->cursor.x > editor->number_of_line_digits) {
         editor_move_cursor_x(editor, -1, true);
         buffer_row_remove_char(current_row, editor_get_cursor_x(editor));
+        editor_row_modified(editor);
       } else if (editor->cursor.x == editor->number_of_line_digits) {
+        const int line = editor_get_current_line_index(editor);
         int chars = buffer_join_current_line_with_previous(editor->current_buffer);
         if (chars > 0) {
+          editor_rows_removed(editor, buffer_get_current_line(editor->current_buffer)->next,
+                              line, 1);
           editor_move_cursor_y(editor, -1);
+          editor_row_modified(editor);
           editor_move_cursor_x(editor, editor->current_buffer->current_row->len,
                                false);
           editor_move_cursor_x(editor, -chars + 1, true);
@@ -741,6 +3183,9 @@ void editor_insert_char(Editor* editor, int key) {
     case '\n': {
       editor_mark_dirty_from_cursor(editor);
       buffer_break_current_line(editor->current_buffer, editor_get_cursor_x(editor));
+      editor_row_modified(editor);
+      editor_rows_inserted(editor, current_row->next,
+                           editor_get_current_line_index(editor) + 1, 1);
       editor_move_cursor_y(editor, 1);
       editor_home_cursor_x(editor);
       buffer_scroll_rows(editor->current_buffer, 1);
@@ -752,16 +3197,18 @@ void editor_insert_char(Editor* editor, int key) {
         buffer_row_insert_char(current_row, editor_get_cursor_x(editor), ' ');
         editor_move_cursor_x(editor, 1, true);
       }
+      editor_row_modified(editor);
       return;
     }
     default: {
       buffer_row_insert_char(current_row, editor_get_cursor_x(editor), (char)key);
       editor_move_cursor_x(editor, 1, true);
+      editor_row_modified(editor);
     }
   };
 }
 
-void editor_process_key(Editor* editor, int key) {
+static void editor_dispatch_key(Editor* editor, int key) {
   bool done = false;
   editor->key = key;
   while (!done) {
@@ -798,32 +3245,46 @@ void editor_process_key(Editor* editor, int key) {
           }
         }
         switch (key) {
-          case ':': {
+          case ':':
+          case '/':
+          case '?':
+          case '&': {
             if (editor->error_message) {
               editor_clear_error_message(editor);
             }
             command_init(&editor->command);
+            editor->command_prompt = (char)key;
+            editor->search_origin_line = editor_get_current_line_index(editor);
+            editor->search_origin_column = editor_get_cursor_x(editor);
             editor->state = EditorState_CollectingCommand;
             return;
           } break;
           default: {
-            editor_restore_cursor_position(editor);
-            for (int i = 0; i < editor->repeat_count + 1; ++i) {
-              editor_process_editor_key(editor, key);
-              move(editor->cursor.y, editor->cursor.x);
+            const int count = editor->repeat_count > 0 ? editor->repeat_count : 1;
+            editor_process_editor_key(editor, key, count);
+            // operators waiting for a motion keep the count
+            if (editor->key_sequence[0] == 0 ||
+                (editor->key_sequence[0] >= '0' && editor->key_sequence[0] <= '9')) {
+              editor->repeat_count = 0;
             }
-            editor->repeat_count = 0;
+            editor_restore_cursor_position(editor);
             return;
           }
         }
         break;
       case EditorState_EditMode:
         if (key == 27) {
-          editor->state = EditorState_Running;
-          // just in case we are after last character while appeding/removing last
-          editor_fix_cursor_position(editor);
+          editor->completion.active = false;
+          editor_end_insert(editor);
+          return;
+        }
+        if (key == 14 || key == 16) {
+          // Ctrl-N and Ctrl-P
+          editor_complete_identifier(editor, key == 14);
           return;
         }
+        editor->completion.active = false;
+        editor_record_insert_key(editor, key);
         editor_insert_char(editor, key);
         return;
       case EditorState_Exiting:
@@ -832,6 +3293,47 @@ void editor_process_key(Editor* editor, int key) {
   }
 }
 
+void editor_process_key(Editor* editor, int key) {
+  PROFILE_BEGIN(ProfileTimer_Dispatch);
+  if (editor->recording_register != '\0' && editor->replay_depth == 0) {
+    editor_record_key(editor, key);
+  }
+  editor_dispatch_key(editor, key);
+  // motions and edits may leave the cursor on a hidden row
+  if (editor->state != EditorState_CollectingCommand &&
+      editor->state != EditorState_Exiting) {
+    if (editor->filtering) {
+      editor_filter_sync(editor);
+    } else {
+      editor_fold_sync(editor);
+    }
+  }
+  PROFILE_END(ProfileTimer_Dispatch);
+}
+
+bool editor_execute_ex_command(Editor* editor, const char* text) {
+  if (editor_should_exit(editor)) {
+    return false;
+  }
+  if (editor->state != EditorState_Running) {
+    // e.g. a key script left insert mode or a prompt open
+    editor_dispatch_key(editor, 27);
+  }
+  command_deinit(&editor->command);
+  command_init(&editor->command);
+  // a : typed in front of it as in a .exrc
+  while (*text == ':' || *text == ' ' || *text == '\t') {
+    ++text;
+  }
+  for (; *text != '\0' && *text != '\n'; ++text) {
+    command_append(&editor->command, *text);
+  }
+  editor->command_prompt = ':';
+  editor->state = EditorState_ProcessingCommand;
+  editor_dispatch_key(editor, '\n');
+  return !editor_should_exit(editor);
+}
+
 bool editor_should_exit(const Editor* editor) {
   return editor->state == EditorState_Exiting;
 }
@@ -839,28 +3341,48 @@ bool editor_should_exit(const Editor* editor) {
 void editor_draw_status_bar(const Editor* editor) {
   if (editor->state == EditorState_CollectingCommand) {
     if (editor->command.buffer != NULL) {
-      mvaddch(editor->window.height - 1, 0, ':');
-      mvaddstr(editor->window.height - 1, 1, editor->command.buffer);
+      terminal_draw_char(editor->terminal, editor->window.height - 1, 0,
+                         editor->command_prompt);
+      terminal_draw_text(editor->terminal, editor->window.height - 1, 1,
+                         editor->command.buffer);
     }
   }
   if (editor->error_message) {
-    mvaddstr(editor->window.height - 1, 1, editor->error_message);
+    terminal_draw_text(editor->terminal, editor->window.height - 1, 1,
+                       editor->error_message);
   }
   if (editor->status_bar) {
-    mvaddstr(editor->window.height - 2, 0, editor->status_bar);
+    terminal_draw_text(editor->terminal, editor->window.height - 2, 0,
+                       editor->status_bar);
   }
   if (editor->key_sequence[0] != 0) {
-    mvaddstr(editor->window.height - 1, editor->window.width - 10,
-             editor->key_sequence);
+    terminal_draw_text(editor->terminal, editor->window.height - 1,
+                       editor->window.width - 10, editor->key_sequence);
+  }
+  terminal_draw_format(editor->terminal, editor->window.height - 1,
+                       editor->window.width - 30, "'%c'(%d) ", editor->key,
+                       editor->key);
+  if (editor->recording_register != '\0') {
+    terminal_draw_format(editor->terminal, editor->window.height - 1,
+                         editor->window.width - 45, "recording @%c",
+                         editor->recording_register);
+  } else {
+    terminal_draw_text(editor->terminal, editor->window.height - 1,
+                       editor->window.width - 45, "            ");
   }
-  mvprintw(editor->window.height - 1, editor->window.width - 30, "'%c'(%d) ",
-           editor->key, editor->key);
 }
 
 void editor_redraw_screen(Editor* editor) {
+  if (editor->replay_depth > 0 || editor->headless) {
+    return;
+  }
   // clear();
-  curs_set(0);
+  PROFILE_BEGIN(ProfileTimer_Render);
+  terminal_show_cursor(editor->terminal, false);
   editor_draw_buffers(editor);
+  if (editor->finder_shown) {
+    editor_draw_finder(editor);
+  }
   editor_draw_status_bar(editor);
   switch (editor->state) {
     case EditorState_Running:
@@ -870,14 +3392,43 @@ void editor_redraw_screen(Editor* editor) {
     default:
       break;
   }
-  window_redraw_screen(&editor->window);
-  curs_set(1);
+  // shown before the flush, buffered backends would hide it until the next frame
+  terminal_show_cursor(editor->terminal, true);
+  PROFILE_END(ProfileTimer_Render);
+  terminal_flush(editor->terminal);
+  PROFILE_END_FRAME();
 }
 
-void editor_init(Editor* editor) {
-  window_init(&editor->window);
+// a headless editor draws nowhere
+static Terminal editor_null_terminal = {
+  .operations = &terminal_null_operations,
+  .width = EDITOR_HEADLESS_WIDTH,
+  .height = EDITOR_HEADLESS_HEIGHT,
+};
+
+bool editor_init(Editor* editor) {
+  if (!editor->headless && !terminal_init(editor->terminal)) {
+    return false;
+  }
+  match_index_init(&editor->match_index, false);
+  match_index_init(&editor->filter_index, true);
+  identifier_index_init(&editor->identifier_index);
+  quickfix_init(&editor->quickfix);
+  path_index_init(&editor->path_index);
+  buffer_row_set_identifier_index(&editor->identifier_index);
+  if (editor->headless) {
+    // the screen only bounds scrolling
+    editor->terminal = &editor_null_terminal;
+    editor->window.width = EDITOR_HEADLESS_WIDTH;
+    editor->window.height = EDITOR_HEADLESS_HEIGHT;
+    editor_home_cursor_xy(editor);
+    return true;
+  }
+  editor->window.width = editor->terminal->width;
+  editor->window.height = editor->terminal->height;
   editor_home_cursor_xy(editor);
-  move(editor->cursor.y, editor->cursor.x);
+  terminal_move(editor->terminal, editor->cursor.y, editor->cursor.x);
+  return true;
 }
 
 void editor_deinit(Editor* editor) {
@@ -885,11 +3436,30 @@ void editor_deinit(Editor* editor) {
     buffer_free(editor->buffers[i]);
   }
   free(editor->buffers);
+  buffer_row_set_identifier_index(NULL);
+  identifier_index_deinit(&editor->identifier_index);
+  free(editor->completion.candidates);
+  quickfix_deinit(&editor->quickfix);
+  path_index_deinit(&editor->path_index);
+  search_pattern_deinit(&editor->search_pattern);
+  search_pattern_deinit(&editor->incremental_pattern);
+  match_index_deinit(&editor->match_index);
+  search_pattern_deinit(&editor->filter_pattern);
+  match_index_deinit(&editor->filter_index);
+  for (int i = 0; i < EDITOR_NUMBER_OF_MACROS; ++i) {
+    free(editor->macros[i].keys);
+  }
+  free(editor->last_change.text);
+  free(editor->insert_change.text);
+  if (editor->worker_pool != NULL) {
+    worker_pool_deinit(editor->worker_pool);
+    free(editor->worker_pool);
+  }
   if (editor->error_message) {
     free(editor->error_message);
     editor->error_message = NULL;
   }
-  window_deinit(&editor->window);
+  terminal_deinit(editor->terminal);
 }
 
 void editor_load_file(Editor* editor, const char* filename) {
@@ -22,7 +22,14 @@
 #include "buffer.h"
 #include "command.h"
 #include "cursor.h"
+#include "identifier_index.h"
+#include "match_index.h"
+#include "path_index.h"
+#include "quickfix.h"
+#include "search.h"
+#include "terminal.h"
 #include "window.h"
+#include "worker_pool.h"
 
 typedef enum {
   EditorState_Running,
@@ -32,9 +39,57 @@ typedef enum {
   EditorState_Exiting,
 } EditorState;
 
+// keys recorded with q{register} and replayed with @{register}
+typedef struct {
+  int* keys;
+  int length;
+  int capacity;
+} EditorMacro;
+
+#define EDITOR_NUMBER_OF_MACROS 26
+// paths shown while :find is typed
+#define EDITOR_FINDER_RESULTS 10
+// screen size assumed without a terminal
+#define EDITOR_HEADLESS_WIDTH 80
+#define EDITOR_HEADLESS_HEIGHT 24
+// keys typed while a long command runs, processed after it
+#define EDITOR_TYPEAHEAD_SIZE 256
+// text of the :stats report
+#define EDITOR_STATS_REPORT_SIZE 2048
+
+// last change repeated with '.', applied through the buffer api
+typedef struct {
+  // 'x', 'd', 'c', 'i' or 'a', '\0' when nothing was changed yet
+  char operator;
+  // 'd' or 'w' for the 'd' operator, 'i' or 'a' for text objects
+  char motion;
+  // bracket of the text object
+  char object;
+  int count;
+  // typed in insert mode, '\n' breaks the line and '\b' is a backspace
+  char* text;
+  int length;
+  int capacity;
+} EditorChange;
+
+// Ctrl-N and Ctrl-P in insert mode, active until another key is typed
+typedef struct {
+  bool active;
+  // identifier ids in alphabetical order
+  int* candidates;
+  int number_of_candidates;
+  // -1 while the typed prefix is shown
+  int selected;
+  // column of the completed word and the length of the typed part of it
+  int start;
+  int prefix_length;
+} EditorCompletion;
+
 typedef struct {
   EditorState state;
   Command command;
+  // ':' for ex commands, '/' and '?' for searches
+  char command_prompt;
   Window window;
   char* error_message;
   Cursor cursor;
@@ -42,6 +97,8 @@ typedef struct {
   Buffer* current_buffer;
   Buffer** buffers;
   size_t number_of_buffers;
+  // Ctrl-O and Ctrl-I across all buffers
+  BufferJumplist jumplist;
   bool end_line_mode;
   char* status_bar;
   char key_sequence[32];
@@ -52,12 +109,81 @@ typedef struct {
   bool string_rendering_ongoing;
   bool multiline_comment_ongoing;
   int key;
+  SearchPattern search_pattern;
+  bool search_backward;
+  // matches of search_pattern, filled in while the editor is idle
+  MatchIndex match_index;
+  // the error message shows "match N of M" for this position, it is updated
+  // while the index grows
+  bool match_number_shown;
+  int match_number_line;
+  int match_number_column;
+  // pattern typed so far in the / and ? prompt and where typing started
+  SearchPattern incremental_pattern;
+  int search_origin_line;
+  int search_origin_column;
+  // matches of it are highlighted in the visible rows, may be NULL
+  const SearchPattern* highlight_pattern;
+  // only rows matching filter_pattern are shown while filtering (&pattern)
+  SearchPattern filter_pattern;
+  MatchIndex filter_index;
+  bool filtering;
+  // filtered row shown at the top of the screen
+  int filter_top;
+  // set while the buffer has closed folds, the screen shows rows from
+  // fold_top on with every closed fold as a single row
+  bool fold_view;
+  int fold_top;
+  // created on the first command big enough to need it
+  WorkerPool* worker_pool;
+  EditorMacro macros[EDITOR_NUMBER_OF_MACROS];
+  // '\0' when not recording
+  char recording_register;
+  char last_macro_register;
+  // where the editor draws and reads keys from, set before editor_init
+  Terminal* terminal;
+  // no terminal is used, keys and commands come from a script (vi -e), set
+  // before editor_init
+  bool headless;
+  // messages of a headless editor are not printed to stderr (vi -s)
+  bool silent;
+  // errors reported so far, vi -e exits with a failure status when not 0
+  int number_of_errors;
+  // nested @ replays, nothing is drawn while it is not 0
+  int replay_depth;
+  bool replay_interrupted;
+  EditorChange last_change;
+  // filled while in insert mode, becomes last_change on ESC
+  EditorChange insert_change;
+  // identifiers of all buffers for completion
+  IdentifierIndex identifier_index;
+  EditorCompletion completion;
+  // filled by :grep
+  QuickfixList quickfix;
+  // paths of the working directory for :find, built on its first use
+  PathIndex path_index;
+  int finder_results[EDITOR_FINDER_RESULTS];
+  int number_of_finder_results;
+  bool finder_shown;
+  // scratch buffer without a file filled by :stats, one of the buffers
+  Buffer* stats_buffer;
+  int typeahead_keys[EDITOR_TYPEAHEAD_SIZE];
+  int number_of_typeahead_keys;
+  int next_typeahead_key;
 } Editor;
 
+// keys typed during a long command first, then the terminal ones
+int editor_read_key(Editor* editor);
 void editor_process_key(Editor* editor, int key);
+// background work between key presses, returns true when a redraw is needed
+bool editor_process_idle(Editor* editor);
 bool editor_should_exit(const Editor* editor);
+// runs text as if typed after ':', a leading ':' is skipped. Returns false
+// once the editor should exit, a failed command adds to number_of_errors.
+bool editor_execute_ex_command(Editor* editor, const char* text);
 void editor_redraw_screen(Editor* editor);
-void editor_init(Editor* editor);
+// false when the terminal cannot be set up, nothing needs to be released then
+bool editor_init(Editor* editor);
 void editor_deinit(Editor* editor);
 void editor_load_file(Editor* editor, const char* filename);
 void editor_create_new_file(Editor* editor);
\ No newline at end of file
@@ -0,0 +1,432 @@
+/*
+ Copyright (c) 2025 Mateusz Stadnik
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "fold.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "buffer.h"
+
+#define FOLD_INITIAL_CAPACITY 4
+// bracket type of '{' as returned by buffer_row_get_bracket
+#define FOLD_BRACE 3
+
+static bool fold_reserve_children(Fold* fold, int count) {
+  if (count <= fold->children_capacity) {
+    return true;
+  }
+  int capacity = fold->children_capacity ? fold->children_capacity * 2
+                                         : FOLD_INITIAL_CAPACITY;
+  while (capacity < count) {
+    capacity *= 2;
+  }
+  Fold** children = realloc(fold->children, sizeof(Fold*) * capacity);
+  if (children == NULL) {
+    return false;
+  }
+  fold->children = children;
+  fold->children_capacity = capacity;
+  return true;
+}
+
+// number of children of parent starting at or before line
+static int fold_count_children_before(const Fold* parent, Buffer* buffer, int line) {
+  int low = 0;
+  int high = parent->number_of_children;
+  while (low < high) {
+    const int middle = low + (high - low) / 2;
+    if (buffer_get_row_index(buffer, parent->children[middle]->first) <= line) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+  return low;
+}
+
+static Fold* fold_find_child(const Fold* parent, Buffer* buffer, int line) {
+  const int before = fold_count_children_before(parent, buffer, line);
+  if (before == 0) {
+    return NULL;
+  }
+  Fold* child = parent->children[before - 1];
+  return buffer_get_row_index(buffer, child->last) >= line ? child : NULL;
+}
+
+static bool fold_is_inside(const Fold* fold, const Fold* ancestor) {
+  for (; fold != NULL; fold = fold->parent) {
+    if (fold == ancestor) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// frees the fold with everything nested in it
+static void fold_drop(FoldTree* tree, Fold* fold) {
+  for (int i = 0; i < fold->number_of_children; ++i) {
+    fold_drop(tree, fold->children[i]);
+  }
+  if (fold->first->fold_first == fold) {
+    fold->first->fold_first = NULL;
+  }
+  if (fold->last->fold_last == fold) {
+    fold->last->fold_last = NULL;
+  }
+  if (fold->closed) {
+    --tree->number_of_closed;
+  }
+  free(fold->children);
+  free(fold);
+}
+
+void fold_tree_clear(FoldTree* tree) {
+  for (int i = 0; i < tree->root.number_of_children; ++i) {
+    fold_drop(tree, tree->root.children[i]);
+  }
+  free(tree->root.children);
+  memset(tree, 0, sizeof(FoldTree));
+}
+
+bool fold_tree_add(FoldTree* tree,
+                   Buffer* buffer,
+                   BufferRow* first,
+                   BufferRow* last,
+                   bool closed,
+                   const char** error) {
+  const int first_line = buffer_get_row_index(buffer, first);
+  const int last_line = buffer_get_row_index(buffer, last);
+  if (first_line < 0 || last_line < first_line) {
+    *error = "Invalid range";
+    return false;
+  }
+  // innermost fold containing the whole range
+  Fold* parent = &tree->root;
+  for (Fold* child = fold_find_child(parent, buffer, first_line);
+       child != NULL && buffer_get_row_index(buffer, child->last) >= last_line;
+       child = fold_find_child(child, buffer, first_line)) {
+    if (child->first == first && child->last == last) {
+      *error = "Fold already exists";
+      return false;
+    }
+    parent = child;
+  }
+
+  // children of parent inside the range become children of the new fold
+  const int begin = fold_count_children_before(parent, buffer, first_line - 1);
+  if (begin > 0 &&
+      buffer_get_row_index(buffer, parent->children[begin - 1]->last) >= first_line) {
+    *error = "Folds may not overlap";
+    return false;
+  }
+  int end = begin;
+  while (end < parent->number_of_children &&
+         buffer_get_row_index(buffer, parent->children[end]->first) <= last_line) {
+    if (buffer_get_row_index(buffer, parent->children[end]->last) > last_line) {
+      *error = "Folds may not overlap";
+      return false;
+    }
+    ++end;
+  }
+
+  Fold* fold = (Fold*)calloc(1, sizeof(Fold));
+  if (fold == NULL || !fold_reserve_children(fold, end - begin) ||
+      !fold_reserve_children(parent, parent->number_of_children + 1)) {
+    if (fold != NULL) {
+      free(fold->children);
+      free(fold);
+    }
+    *error = "Failed to allocate memory for fold";
+    return false;
+  }
+  if (end > begin) {
+    memcpy(fold->children, &parent->children[begin], sizeof(Fold*) * (end - begin));
+  }
+  fold->number_of_children = end - begin;
+  for (int i = 0; i < fold->number_of_children; ++i) {
+    fold->children[i]->parent = fold;
+  }
+  memmove(&parent->children[begin + 1], &parent->children[end],
+          sizeof(Fold*) * (parent->number_of_children - end));
+  parent->children[begin] = fold;
+  parent->number_of_children += 1 - (end - begin);
+
+  fold->first = first;
+  fold->last = last;
+  fold->parent = parent;
+  if (first->fold_first == NULL || fold_is_inside(first->fold_first, fold)) {
+    first->fold_first = fold;
+  }
+  if (last->fold_last == NULL || fold_is_inside(last->fold_last, fold)) {
+    last->fold_last = fold;
+  }
+  fold_set_closed(tree, fold, closed);
+  return true;
+}
+
+void fold_tree_remove(FoldTree* tree, Fold* fold) {
+  Fold* parent = fold->parent;
+  int position = 0;
+  while (parent->children[position] != fold) {
+    ++position;
+  }
+  const int moved = fold->number_of_children;
+  const int after = parent->number_of_children - position - 1;
+  if (!fold_reserve_children(parent, parent->number_of_children - 1 + moved)) {
+    // out of memory, the nested folds go away too
+    memmove(&parent->children[position], &parent->children[position + 1],
+            sizeof(Fold*) * after);
+    --parent->number_of_children;
+    fold_drop(tree, fold);
+    return;
+  }
+  memmove(&parent->children[position + moved], &parent->children[position + 1],
+          sizeof(Fold*) * after);
+  if (moved > 0) {
+    memcpy(&parent->children[position], fold->children, sizeof(Fold*) * moved);
+  }
+  parent->number_of_children += moved - 1;
+  for (int i = 0; i < moved; ++i) {
+    fold->children[i]->parent = parent;
+  }
+
+  if (fold->first->fold_first == fold) {
+    const bool same = moved > 0 && fold->children[0]->first == fold->first;
+    fold->first->fold_first = same ? fold->children[0] : NULL;
+  }
+  if (fold->last->fold_last == fold) {
+    const bool same = moved > 0 && fold->children[moved - 1]->last == fold->last;
+    fold->last->fold_last = same ? fold->children[moved - 1] : NULL;
+  }
+  if (fold->closed) {
+    --tree->number_of_closed;
+  }
+  free(fold->children);
+  free(fold);
+}
+
+void fold_tree_forget_row(FoldTree* tree, BufferRow* row) {
+  while (row->fold_first != NULL) {
+    fold_tree_remove(tree, row->fold_first);
+  }
+  while (row->fold_last != NULL) {
+    fold_tree_remove(tree, row->fold_last);
+  }
+}
+
+Fold* fold_tree_find(FoldTree* tree, Buffer* buffer, int line) {
+  Fold* fold = NULL;
+  for (Fold* child = fold_find_child(&tree->root, buffer, line); child != NULL;
+       child = fold_find_child(child, buffer, line)) {
+    fold = child;
+  }
+  return fold;
+}
+
+Fold* fold_tree_find_closed(FoldTree* tree, Buffer* buffer, int line) {
+  if (tree->number_of_closed == 0) {
+    return NULL;
+  }
+  for (Fold* child = fold_find_child(&tree->root, buffer, line); child != NULL;
+       child = fold_find_child(child, buffer, line)) {
+    if (child->closed) {
+      return child;
+    }
+  }
+  return NULL;
+}
+
+void fold_set_closed(FoldTree* tree, Fold* fold, bool closed) {
+  if (fold->closed != closed) {
+    tree->number_of_closed += closed ? 1 : -1;
+    fold->closed = closed;
+  }
+}
+
+static void fold_set_all_closed(FoldTree* tree, Fold* fold, bool closed) {
+  for (int i = 0; i < fold->number_of_children; ++i) {
+    fold_set_closed(tree, fold->children[i], closed);
+    fold_set_all_closed(tree, fold->children[i], closed);
+  }
+}
+
+void fold_tree_set_all_closed(FoldTree* tree, bool closed) {
+  fold_set_all_closed(tree, &tree->root, closed);
+}
+
+bool fold_tree_has_closed(const FoldTree* tree) {
+  return tree->number_of_closed > 0;
+}
+
+int fold_get_level(const Fold* fold) {
+  int level = 0;
+  for (; fold->parent != NULL; fold = fold->parent) {
+    ++level;
+  }
+  return level;
+}
+
+Fold* fold_get_closed_at_first(const BufferRow* row) {
+  Fold* fold = row->fold_first;
+  while (fold != NULL && !fold->closed) {
+    const bool nested = fold->number_of_children > 0 && fold->children[0]->first == row;
+    fold = nested ? fold->children[0] : NULL;
+  }
+  return fold;
+}
+
+Fold* fold_get_closed_at_last(const BufferRow* row) {
+  Fold* fold = row->fold_last;
+  while (fold != NULL && !fold->closed) {
+    Fold* child =
+      fold->number_of_children > 0 ? fold->children[fold->number_of_children - 1] : NULL;
+    fold = child != NULL && child->last == row ? child : NULL;
+  }
+  return fold;
+}
+
+static bool fold_is_blank(const BufferRow* row) {
+  for (int i = 0; i < row->len; ++i) {
+    if (row->data[i] != ' ' && row->data[i] != '\t') {
+      return false;
+    }
+  }
+  return true;
+}
+
+static int fold_get_indent_level(const BufferRow* row, int shift_width) {
+  int column = 0;
+  for (int i = 0; i < row->len; ++i) {
+    if (row->data[i] == ' ') {
+      ++column;
+    } else if (row->data[i] == '\t') {
+      column += shift_width - column % shift_width;
+    } else {
+      break;
+    }
+  }
+  return column / shift_width;
+}
+
+static void fold_add_silently(FoldTree* tree,
+                              Buffer* buffer,
+                              BufferRow* first,
+                              BufferRow* last) {
+  // folds overlapping the existing ones are skipped
+  const char* error = NULL;
+  if (first != last) {
+    fold_tree_add(tree, buffer, first, last, true, &error);
+  }
+}
+
+void fold_tree_add_indent_folds(FoldTree* tree, Buffer* buffer, int shift_width) {
+  const int number_of_lines = buffer_get_number_of_lines(buffer);
+  if (number_of_lines == 0 || shift_width <= 0) {
+    return;
+  }
+  int* levels = malloc(sizeof(int) * number_of_lines);
+  if (levels == NULL) {
+    return;
+  }
+  // blank rows take the lower level of the rows around them
+  int maximum = 0;
+  int level = 0;
+  int line = 0;
+  for (const BufferRow* row = buffer->head; row != NULL; row = row->next, ++line) {
+    if (!fold_is_blank(row)) {
+      level = fold_get_indent_level(row, shift_width);
+    }
+    levels[line] = level;
+    if (level > maximum) {
+      maximum = level;
+    }
+  }
+  level = 0;
+  line = number_of_lines - 1;
+  for (const BufferRow* row = buffer->tail; row != NULL; row = row->prev, --line) {
+    if (!fold_is_blank(row)) {
+      level = levels[line];
+    } else if (level < levels[line]) {
+      levels[line] = level;
+    }
+  }
+
+  // rows where the currently open levels start
+  BufferRow** starts = malloc(sizeof(BufferRow*) * (maximum + 1));
+  if (starts == NULL) {
+    free(levels);
+    return;
+  }
+  int depth = 0;
+  line = 0;
+  for (BufferRow* row = buffer->head; row != NULL; row = row->next, ++line) {
+    while (depth > levels[line]) {
+      fold_add_silently(tree, buffer, starts[--depth], row->prev);
+    }
+    while (depth < levels[line]) {
+      starts[depth++] = row;
+    }
+  }
+  while (depth > 0) {
+    fold_add_silently(tree, buffer, starts[--depth], buffer->tail);
+  }
+  free(starts);
+  free(levels);
+}
+
+static bool fold_has_brace_after(const BufferRow* row, int index) {
+  for (int i = index + 1; i < row->len; ++i) {
+    if (buffer_row_get_bracket(row, i) == FOLD_BRACE) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void fold_tree_add_brace_folds(FoldTree* tree, Buffer* buffer) {
+  const int type = FOLD_BRACE - 1;
+  BufferRow** opened = NULL;
+  int depth = 0;
+  int capacity = 0;
+  for (BufferRow* row = buffer->head; row != NULL; row = row->next) {
+    buffer_row_highlight_pending(row);
+    if (row->bracket_balance[type] == 0 && row->bracket_lowest[type] == 0) {
+      continue;  // braces of the row match each other
+    }
+    for (int i = 0; i < row->len; ++i) {
+      const int bracket = buffer_row_get_bracket(row, i);
+      if (bracket == FOLD_BRACE) {
+        if (depth == capacity) {
+          const int size = capacity ? capacity * 2 : FOLD_INITIAL_CAPACITY;
+          BufferRow** resized = realloc(opened, sizeof(BufferRow*) * size);
+          if (resized == NULL) {
+            free(opened);
+            return;
+          }
+          opened = resized;
+          capacity = size;
+        }
+        opened[depth++] = row;
+      } else if (bracket == -FOLD_BRACE && depth > 0) {
+        // "} else {" ends the fold above so the next one can start on the row
+        BufferRow* last = fold_has_brace_after(row, i) ? row->prev : row;
+        fold_add_silently(tree, buffer, opened[--depth], last);
+      }
+    }
+  }
+  free(opened);
+}
@@ -0,0 +1,85 @@
+/*
+ Copyright (c) 2025 Mateusz Stadnik
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <stdbool.h>
+
+#include "buffer_row.h"
+
+struct Buffer;
+
+// rows [first, last] shown as a single line while closed, folds are anchored to
+// their rows so edits around and inside them keep them in place
+typedef struct Fold {
+  BufferRow* first;
+  BufferRow* last;
+  bool closed;
+  struct Fold* parent;
+  // nested folds sorted by their rows, they never overlap
+  struct Fold** children;
+  int number_of_children;
+  int children_capacity;
+} Fold;
+
+// nested folds form an interval tree, lookups by line use binary searches over
+// the row indexes of the buffer
+typedef struct FoldTree {
+  // holds the top level folds, has no rows
+  Fold root;
+  int number_of_closed;
+} FoldTree;
+
+// drops all folds, the rows have to be still alive
+void fold_tree_clear(FoldTree* tree);
+// adds the fold of rows [first, last], it may contain other folds but may not
+// partially overlap any, error tells why it was refused
+bool fold_tree_add(FoldTree* tree,
+                   struct Buffer* buffer,
+                   BufferRow* first,
+                   BufferRow* last,
+                   bool closed,
+                   const char** error);
+// nested folds move up to the parent of the removed one
+void fold_tree_remove(FoldTree* tree, Fold* fold);
+// drops the folds starting or ending at a row going away
+void fold_tree_forget_row(FoldTree* tree, BufferRow* row);
+
+// innermost fold containing line, NULL when there is none
+Fold* fold_tree_find(FoldTree* tree, struct Buffer* buffer, int line);
+// outermost closed fold containing line, it hides the line
+Fold* fold_tree_find_closed(FoldTree* tree, struct Buffer* buffer, int line);
+
+void fold_set_closed(FoldTree* tree, Fold* fold, bool closed);
+// zR and zM
+void fold_tree_set_all_closed(FoldTree* tree, bool closed);
+bool fold_tree_has_closed(const FoldTree* tree);
+// number of folds containing the fold, 1 for the top level ones
+int fold_get_level(const Fold* fold);
+
+// closed fold shown in place of a visible row starting (or ending) it, O(depth)
+// without looking at the rows inside
+Fold* fold_get_closed_at_first(const BufferRow* row);
+Fold* fold_get_closed_at_last(const BufferRow* row);
+
+// closed folds of the lines indented deeper than their surroundings, one
+// level per shift_width columns
+void fold_tree_add_indent_folds(FoldTree* tree,
+                                struct Buffer* buffer,
+                                int shift_width);
+// closed folds between '{' and '}' on different rows, rows without unmatched
+// braces are skipped using their bracket summary
+void fold_tree_add_brace_folds(FoldTree* tree, struct Buffer* buffer);
@@ -0,0 +1,460 @@
+/*
+ Copyright (c) 2025 Mateusz Stadnik
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include "grep.h"
+
+#include <dirent.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#ifdef YASVI_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#define GREP_INITIAL_SIZE 64
+// files read without mmap are searched a block at a time
+#define GREP_BLOCK_SIZE 65536
+// a file with a zero byte in its first block is not searched
+#define GREP_BINARY_CHECK_SIZE 4096
+// longer matching lines are cut in the quickfix list
+#define GREP_MAX_TEXT 256
+// mapped files are searched in chunks of whole lines fitting an int
+#define GREP_MAX_CHUNK (1 << 30)
+
+static bool grep_grow(void** data, int* capacity, int needed, size_t size) {
+  if (needed <= *capacity) {
+    return true;
+  }
+  int new_capacity = *capacity ? *capacity * 2 : GREP_INITIAL_SIZE;
+  while (new_capacity < needed) {
+    new_capacity *= 2;
+  }
+  void* resized = realloc(*data, size * new_capacity);
+  if (resized == NULL) {
+    return false;
+  }
+  *data = resized;
+  *capacity = new_capacity;
+  return true;
+}
+
+typedef struct GrepFileList {
+  char** files;
+  int number_of_files;
+  int capacity;
+} GrepFileList;
+
+static bool grep_add_file(GrepFileList* list, const char* path) {
+  if (!grep_grow((void**)&list->files, &list->capacity, list->number_of_files + 1,
+                 sizeof(char*))) {
+    return false;
+  }
+  char* copy = strdup(path);
+  if (copy == NULL) {
+    return false;
+  }
+  list->files[list->number_of_files++] = copy;
+  return true;
+}
+
+// symbolic links are followed only when given, as with grep -r, so links to
+// parent directories can not loop
+static bool grep_add_path(GrepFileList* list, const char* path, bool given) {
+  struct stat status;
+  if ((given ? stat(path, &status) : lstat(path, &status)) != 0) {
+    return true;  // nothing to search
+  }
+  if (!S_ISDIR(status.st_mode)) {
+    return !S_ISREG(status.st_mode) || grep_add_file(list, path);
+  }
+  DIR* directory = opendir(path);
+  if (directory == NULL) {
+    return true;
+  }
+  const size_t path_length = strlen(path);
+  bool result = true;
+  struct dirent* entry = NULL;
+  while (result && (entry = readdir(directory)) != NULL) {
+    if (entry->d_name[0] == '.') {
+      continue;
+    }
+    char* child = malloc(path_length + strlen(entry->d_name) + 2);
+    if (child == NULL) {
+      result = false;
+      break;
+    }
+    // ./name is shown as name
+    if (strcmp(path, ".") == 0) {
+      strcpy(child, entry->d_name);
+    } else if (path_length > 0 && path[path_length - 1] == '/') {
+      sprintf(child, "%s%s", path, entry->d_name);
+    } else {
+      sprintf(child, "%s/%s", path, entry->d_name);
+    }
+    result = grep_add_path(list, child, false);
+    free(child);
+  }
+  closedir(directory);
+  return result;
+}
+
+static int grep_compare_files(const void* a, const void* b) {
+  return strcmp(*(char* const*)a, *(char* const*)b);
+}
+
+int grep_collect_files(const char* const* paths,
+                       int number_of_paths,
+                       char*** files) {
+  GrepFileList list = {NULL, 0, 0};
+  for (int i = 0; i < number_of_paths; ++i) {
+    const int first = list.number_of_files;
+    if (!grep_add_path(&list, paths[i], true)) {
+      grep_free_files(list.files, list.number_of_files);
+      *files = NULL;
+      return -1;
+    }
+    // directories are listed in no particular order
+    qsort(&list.files[first], list.number_of_files - first, sizeof(char*),
+          grep_compare_files);
+  }
+  *files = list.files;
+  return list.number_of_files;
+}
+
+void grep_free_files(char** files, int number_of_files) {
+  for (int i = 0; i < number_of_files; ++i) {
+    free(files[i]);
+  }
+  free(files);
+}
+
+typedef struct GrepMatch {
+  int line;
+  int column;
+  // in the text of the file result
+  int offset;
+  int length;
+} GrepMatch;
+
+typedef struct GrepFileResult {
+  GrepMatch* matches;
+  int number_of_matches;
+  int capacity;
+  // matching lines one after another
+  char* text;
+  int text_length;
+  int text_capacity;
+  bool done;
+} GrepFileResult;
+
+typedef struct GrepContext {
+  // one per worker
+  SearchPattern* patterns;
+  char** files;
+  GrepFileResult* results;
+  // results before it are in the quickfix list
+  int next_result;
+  QuickfixList* list;
+  WorkerPoolPoll poll;
+  void* poll_context;
+#ifdef YASVI_THREADS
+  pthread_mutex_t mutex;
+#endif
+} GrepContext;
+
+static void grep_add_match(GrepFileResult* result,
+                           int line,
+                           int column,
+                           const char* text,
+                           int length) {
+  while (length > 0 && text[length - 1] == '\r') {
+    --length;
+  }
+  if (length > GREP_MAX_TEXT) {
+    length = GREP_MAX_TEXT;
+  }
+  if (!grep_grow((void**)&result->matches, &result->capacity,
+                 result->number_of_matches + 1, sizeof(GrepMatch)) ||
+      !grep_grow((void**)&result->text, &result->text_capacity,
+                 result->text_length + length, 1)) {
+    return;  // the line is left out
+  }
+  GrepMatch* match = &result->matches[result->number_of_matches++];
+  match->line = line;
+  match->column = column;
+  match->offset = result->text_length;
+  match->length = length;
+  memcpy(&result->text[result->text_length], text, length);
+  result->text_length += length;
+}
+
+static int grep_count_lines(const char* text, int start, int end, int* line_start) {
+  int count = 0;
+  const char* newline = NULL;
+  while (start < end &&
+         (newline = memchr(text + start, '\n', end - start)) != NULL) {
+    ++count;
+    start = (int)(newline - text) + 1;
+    *line_start = start;
+  }
+  return count;
+}
+
+// text holds whole lines, line is the number of its first line and is moved
+// past them. A literal pattern is searched in the whole text at once and lines
+// are only counted up to the matches, a regexp is run on every line.
+static void grep_search_chunk(GrepFileResult* result,
+                              const SearchPattern* pattern,
+                              const char* text,
+                              int length,
+                              int* line) {
+  int line_start = 0;
+  if (pattern->regexp == NULL) {
+    SearchMatch match;
+    int position = 0;
+    while (position < length &&
+           search_find_forward(pattern, text, length, position, &match)) {
+      *line += grep_count_lines(text, line_start, match.start, &line_start);
+      const char* newline = memchr(text + match.start, '\n', length - match.start);
+      const int line_end = newline != NULL ? (int)(newline - text) : length;
+      grep_add_match(result, *line, match.start - line_start, text + line_start,
+                     line_end - line_start);
+      position = line_end;
+    }
+    *line += grep_count_lines(text, line_start, length, &line_start);
+    return;
+  }
+  while (line_start < length) {
+    const char* newline = memchr(text + line_start, '\n', length - line_start);
+    const int line_end = newline != NULL ? (int)(newline - text) : length;
+    SearchMatch match;
+    if (search_find_forward(pattern, text + line_start, line_end - line_start, 0,
+                            &match)) {
+      grep_add_match(result, *line, match.start, text + line_start,
+                     line_end - line_start);
+    }
+    if (newline == NULL) {
+      break;
+    }
+    ++*line;
+    line_start = line_end + 1;
+  }
+}
+
+static bool grep_is_binary(const char* data, size_t size) {
+  const size_t length =
+    size < GREP_BINARY_CHECK_SIZE ? size : GREP_BINARY_CHECK_SIZE;
+  return memchr(data, '\0', length) != NULL;
+}
+
+#ifdef YASVI_MMAP
+static void grep_search_file(GrepFileResult* result,
+                             const SearchPattern* pattern,
+                             const char* filename) {
+  const int descriptor = open(filename, O_RDONLY);
+  if (descriptor < 0) {
+    return;
+  }
+  struct stat status;
+  if (fstat(descriptor, &status) != 0 || status.st_size == 0) {
+    close(descriptor);
+    return;
+  }
+  const size_t size = (size_t)status.st_size;
+  const char* data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+  close(descriptor);
+  if (data == MAP_FAILED) {
+    return;
+  }
+  posix_madvise((void*)data, size, POSIX_MADV_SEQUENTIAL);
+  if (!grep_is_binary(data, size)) {
+    int line = 0;
+    size_t offset = 0;
+    while (offset < size) {
+      size_t length = size - offset;
+      if (length > GREP_MAX_CHUNK) {
+        // cut after the last whole line of the chunk
+        length = GREP_MAX_CHUNK;
+        while (length > 1 && data[offset + length - 1] != '\n') {
+          --length;
+        }
+      }
+      grep_search_chunk(result, pattern, data + offset, (int)length, &line);
+      offset += length;
+    }
+  }
+  munmap((void*)data, size);
+}
+#else
+static void grep_search_file(GrepFileResult* result,
+                             const SearchPattern* pattern,
+                             const char* filename) {
+  FILE* file = fopen(filename, "r");
+  if (file == NULL) {
+    return;
+  }
+  int capacity = GREP_BLOCK_SIZE;
+  char* block = malloc(capacity);
+  int length = 0;
+  int line = 0;
+  bool first = true;
+  while (block != NULL) {
+    const size_t read = fread(block + length, 1, capacity - length, file);
+    if (first && grep_is_binary(block, read)) {
+      break;
+    }
+    first = false;
+    length += (int)read;
+    if (read == 0) {
+      // the last line without '\n'
+      grep_search_chunk(result, pattern, block, length, &line);
+      break;
+    }
+    int end = length;
+    while (end > 0 && block[end - 1] != '\n') {
+      --end;
+    }
+    if (end == 0) {
+      if (length == capacity) {
+        // a line longer than the block
+        char* grown = realloc(block, capacity * 2);
+        if (grown == NULL) {
+          break;
+        }
+        block = grown;
+        capacity *= 2;
+      }
+      continue;
+    }
+    grep_search_chunk(result, pattern, block, end, &line);
+    memmove(block, block + end, length - end);
+    length -= end;
+  }
+  free(block);
+  fclose(file);
+}
+#endif
+
+static void grep_lock(GrepContext* context) {
+#ifdef YASVI_THREADS
+  pthread_mutex_lock(&context->mutex);
+#else
+  (void)context;
+#endif
+}
+
+static void grep_unlock(GrepContext* context) {
+#ifdef YASVI_THREADS
+  pthread_mutex_unlock(&context->mutex);
+#else
+  (void)context;
+#endif
+}
+
+static void grep_task(void* data, int index, int worker) {
+  GrepContext* context = data;
+  GrepFileResult result = {0};
+  grep_search_file(&result, &context->patterns[worker], context->files[index]);
+  result.done = true;
+  grep_lock(context);
+  context->results[index] = result;
+  grep_unlock(context);
+}
+
+// moves the results of the files finished so far, in order, to the quickfix
+// list, only the calling thread touches the list
+static void grep_publish(GrepContext* context) {
+  while (true) {
+    grep_lock(context);
+    GrepFileResult result = context->results[context->next_result];
+    grep_unlock(context);
+    if (!result.done) {
+      return;
+    }
+    if (result.number_of_matches > 0) {
+      const int file =
+        quickfix_add_file(context->list, context->files[context->next_result]);
+      for (int i = 0; i < result.number_of_matches && file >= 0; ++i) {
+        const GrepMatch* match = &result.matches[i];
+        quickfix_add_entry(context->list, file, match->line, match->column,
+                           &result.text[match->offset], match->length);
+      }
+    }
+    free(result.matches);
+    free(result.text);
+    ++context->next_result;
+  }
+}
+
+static bool grep_poll(void* data) {
+  GrepContext* context = data;
+  grep_publish(context);
+  return context->poll == NULL || context->poll(context->poll_context);
+}
+
+bool grep_files(const SearchPattern* pattern,
+                char** files,
+                int number_of_files,
+                WorkerPool* pool,
+                QuickfixList* list,
+                WorkerPoolPoll poll,
+                void* poll_context) {
+  const int number_of_threads = worker_pool_get_number_of_threads(pool);
+  GrepContext context = {
+    .files = files,
+    .list = list,
+    .poll = poll,
+    .poll_context = poll_context,
+  };
+  context.patterns = calloc(number_of_threads, sizeof(SearchPattern));
+  // one more always unfinished result stops the publishing
+  context.results = calloc(number_of_files + 1, sizeof(GrepFileResult));
+  int number_of_patterns = 0;
+  bool result = context.patterns != NULL && context.results != NULL;
+  for (; result && number_of_patterns < number_of_threads; ++number_of_patterns) {
+    result = search_pattern_clone(&context.patterns[number_of_patterns], pattern);
+  }
+  if (result) {
+#ifdef YASVI_THREADS
+    pthread_mutex_init(&context.mutex, NULL);
+#endif
+    result = worker_pool_run(pool, grep_task, &context, number_of_files, grep_poll,
+                             &context);
+    grep_publish(&context);
+#ifdef YASVI_THREADS
+    pthread_mutex_destroy(&context.mutex);
+#endif
+  }
+  // left by a cancelled run
+  for (int i = context.next_result; context.results != NULL && i < number_of_files;
+       ++i) {
+    free(context.results[i].matches);
+    free(context.results[i].text);
+  }
+  for (int i = 0; i < number_of_patterns; ++i) {
+    search_pattern_deinit(&context.patterns[i]);
+  }
+  free(context.patterns);
+  free(context.results);
+  return result;
+}
@@ -0,0 +1,43 @@
+/*
+ Copyright (c) 2025 Mateusz Stadnik
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <stdbool.h>
+
+#include "quickfix.h"
+#include "search.h"
+#include "worker_pool.h"
+
+// files to search, directories are walked recursively skipping hidden entries
+// such as .git and the files found in them are sorted. Returns their number and
+// the malloc'ed names, or -1 when out of memory.
+int grep_collect_files(const char* const* paths,
+                       int number_of_paths,
+                       char*** files);
+void grep_free_files(char** files, int number_of_files);
+
+// searches every file on the pool, a matching line becomes a quickfix entry.
+// Entries are added in the order of the files while the search is still
+// running so poll can show them. Binary files are skipped. Returns false when
+// poll cancelled the search, the entries found until then are kept.
+bool grep_files(const SearchPattern* pattern,
+                char** files,
+                int number_of_files,
+                WorkerPool* pool,
+                QuickfixList* list,
+                WorkerPoolPoll poll,
+                void* poll_context);
@@ -0,0 +1,329 @@
+/*
+ Copyright (c) 2025 Mateusz Stadnik
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "identifier_index.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define IDENTIFIER_INDEX_INITIAL_SIZE 1024
+// recent ids of a bucket scanned one by one before they are merged
+#define IDENTIFIER_INDEX_RECENT_SIZE 256
+
+void identifier_index_init(IdentifierIndex* index) {
+  memset(index, 0, sizeof(IdentifierIndex));
+}
+
+void identifier_index_deinit(IdentifierIndex* index) {
+  free(index->entries);
+  free(index->table);
+  free(index->text);
+  for (int i = 0; i < IDENTIFIER_INDEX_BUCKETS; ++i) {
+    free(index->buckets[i].ids);
+    free(index->buckets[i].recent);
+  }
+  identifier_index_init(index);
+}
+
+bool identifier_index_is_identifier_char(char c) {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+         c == '_';
+}
+
+static int identifier_index_get_bucket(char c) {
+  if (c >= 'a' && c <= 'z') {
+    return c - 'a';
+  }
+  if (c >= 'A' && c <= 'Z') {
+    return 26 + c - 'A';
+  }
+  return IDENTIFIER_INDEX_BUCKETS - 1;
+}
+
+// FNV-1a
+static uint32_t identifier_index_hash(const char* text, int length) {
+  uint32_t hash = 2166136261u;
+  for (int i = 0; i < length; ++i) {
+    hash = (hash ^ (unsigned char)text[i]) * 16777619u;
+  }
+  return hash;
+}
+
+static bool identifier_index_grow(void** data, int* capacity, int needed, size_t size) {
+  if (needed <= *capacity) {
+    return true;
+  }
+  int new_capacity = *capacity ? *capacity * 2 : IDENTIFIER_INDEX_INITIAL_SIZE;
+  while (new_capacity < needed) {
+    new_capacity *= 2;
+  }
+  void* resized = realloc(*data, size * new_capacity);
+  if (resized == NULL) {
+    return false;
+  }
+  *data = resized;
+  *capacity = new_capacity;
+  return true;
+}
+
+static void identifier_index_insert_slot(IdentifierIndex* index, int id) {
+  const uint32_t mask = (uint32_t)index->table_size - 1;
+  uint32_t slot = index->entries[id].hash & mask;
+  while (index->table[slot] != 0) {
+    slot = (slot + 1) & mask;
+  }
+  index->table[slot] = id + 1;
+}
+
+// keeps the table at most half full
+static bool identifier_index_rehash(IdentifierIndex* index) {
+  if ((index->number_of_entries + 1) * 2 <= index->table_size) {
+    return true;
+  }
+  const int size = index->table_size ? index->table_size * 2
+                                     : IDENTIFIER_INDEX_INITIAL_SIZE;
+  int* table = calloc(size, sizeof(int));
+  if (table == NULL) {
+    return false;
+  }
+  free(index->table);
+  index->table = table;
+  index->table_size = size;
+  for (int id = 0; id < index->number_of_entries; ++id) {
+    identifier_index_insert_slot(index, id);
+  }
+  return true;
+}
+
+static int identifier_index_find(const IdentifierIndex* index,
+                                 const char* text,
+                                 int length,
+                                 uint32_t hash) {
+  if (index->table_size == 0) {
+    return -1;
+  }
+  const uint32_t mask = (uint32_t)index->table_size - 1;
+  for (uint32_t slot = hash & mask; index->table[slot] != 0;
+       slot = (slot + 1) & mask) {
+    const IdentifierEntry* entry = &index->entries[index->table[slot] - 1];
+    if (entry->hash == hash && entry->length == length &&
+        memcmp(&index->text[entry->offset], text, length) == 0) {
+      return index->table[slot] - 1;
+    }
+  }
+  return -1;
+}
+
+typedef struct IdentifierCandidate {
+  const char* text;
+  int length;
+  int id;
+} IdentifierCandidate;
+
+static int identifier_index_compare(const void* a, const void* b) {
+  const IdentifierCandidate* first = (const IdentifierCandidate*)a;
+  const IdentifierCandidate* second = (const IdentifierCandidate*)b;
+  const int length = first->length < second->length ? first->length : second->length;
+  const int result = memcmp(first->text, second->text, length);
+  return result != 0 ? result : first->length - second->length;
+}
+
+static IdentifierCandidate identifier_index_get_candidate(const IdentifierIndex* index,
+                                                          int id) {
+  const IdentifierEntry* entry = &index->entries[id];
+  return (IdentifierCandidate){&index->text[entry->offset], entry->length, id};
+}
+
+// sorts the recent ids and merges them into the sorted ones from the back
+static void identifier_index_merge(IdentifierIndex* index, IdentifierBucket* bucket) {
+  const int count = bucket->number_of_recent;
+  IdentifierCandidate* recent = malloc(sizeof(IdentifierCandidate) * count);
+  if (recent == NULL ||
+      !identifier_index_grow((void**)&bucket->ids, &bucket->capacity,
+                             bucket->number_of_ids + count, sizeof(int))) {
+    free(recent);
+    return;  // the recent ids are still scanned
+  }
+  for (int i = 0; i < count; ++i) {
+    recent[i] = identifier_index_get_candidate(index, bucket->recent[i]);
+  }
+  qsort(recent, count, sizeof(IdentifierCandidate), identifier_index_compare);
+  int i = bucket->number_of_ids - 1;
+  int j = count - 1;
+  for (int k = bucket->number_of_ids + count - 1; j >= 0; --k) {
+    const IdentifierCandidate sorted =
+      i >= 0 ? identifier_index_get_candidate(index, bucket->ids[i])
+             : (IdentifierCandidate){NULL, 0, -1};
+    if (i >= 0 && identifier_index_compare(&sorted, &recent[j]) > 0) {
+      bucket->ids[k] = bucket->ids[i--];
+    } else {
+      bucket->ids[k] = recent[j--].id;
+    }
+  }
+  bucket->number_of_ids += count;
+  bucket->number_of_recent = 0;
+  free(recent);
+}
+
+int identifier_index_add(IdentifierIndex* index, const char* text, int length) {
+  const uint32_t hash = identifier_index_hash(text, length);
+  int id = identifier_index_find(index, text, length, hash);
+  if (id >= 0) {
+    ++index->entries[id].count;
+    return id;
+  }
+
+  IdentifierBucket* bucket = &index->buckets[identifier_index_get_bucket(text[0])];
+  if (!identifier_index_rehash(index) ||
+      !identifier_index_grow((void**)&index->entries, &index->entries_capacity,
+                             index->number_of_entries + 1, sizeof(IdentifierEntry)) ||
+      !identifier_index_grow((void**)&index->text, &index->text_capacity,
+                             index->text_length + length, 1) ||
+      !identifier_index_grow((void**)&bucket->recent, &bucket->recent_capacity,
+                             bucket->number_of_recent + 1, sizeof(int))) {
+    return -1;
+  }
+  id = index->number_of_entries++;
+  IdentifierEntry* entry = &index->entries[id];
+  entry->hash = hash;
+  entry->offset = index->text_length;
+  entry->length = length;
+  entry->count = 1;
+  memcpy(&index->text[index->text_length], text, length);
+  index->text_length += length;
+  bucket->recent[bucket->number_of_recent++] = id;
+  identifier_index_insert_slot(index, id);
+  // merged when the recent ids are a fraction of the sorted ones, so a load
+  // merges a logarithmic number of times
+  if (bucket->number_of_recent >
+      bucket->number_of_ids / 8 + IDENTIFIER_INDEX_RECENT_SIZE) {
+    identifier_index_merge(index, bucket);
+  }
+  return id;
+}
+
+void identifier_index_release(IdentifierIndex* index, int id) {
+  if (id >= 0 && id < index->number_of_entries && index->entries[id].count > 0) {
+    --index->entries[id].count;
+  }
+}
+
+const char* identifier_index_get(const IdentifierIndex* index, int id, int* length) {
+  *length = index->entries[id].length;
+  return &index->text[index->entries[id].offset];
+}
+
+int identifier_index_get_count(const IdentifierIndex* index, int id) {
+  return index->entries[id].count;
+}
+
+static bool identifier_index_has_prefix(const IdentifierCandidate* candidate,
+                                        const char* prefix,
+                                        int length) {
+  return candidate->length > length && memcmp(candidate->text, prefix, length) == 0;
+}
+
+static bool identifier_index_push_candidate(IdentifierCandidate** candidates,
+                                            int* number_of_candidates,
+                                            int* capacity,
+                                            IdentifierCandidate candidate) {
+  if (!identifier_index_grow((void**)candidates, capacity, *number_of_candidates + 1,
+                             sizeof(IdentifierCandidate))) {
+    return false;
+  }
+  (*candidates)[(*number_of_candidates)++] = candidate;
+  return true;
+}
+
+int identifier_index_complete(IdentifierIndex* index,
+                              const char* prefix,
+                              int length,
+                              int** ids) {
+  *ids = NULL;
+  if (length <= 0) {
+    return 0;
+  }
+  IdentifierBucket* bucket = &index->buckets[identifier_index_get_bucket(prefix[0])];
+  if (bucket->number_of_recent > IDENTIFIER_INDEX_RECENT_SIZE) {
+    identifier_index_merge(index, bucket);
+  }
+  // first sorted id not below the prefix
+  const IdentifierCandidate key = {prefix, length, -1};
+  int low = 0;
+  int high = bucket->number_of_ids;
+  while (low < high) {
+    const int middle = low + (high - low) / 2;
+    const IdentifierCandidate candidate =
+      identifier_index_get_candidate(index, bucket->ids[middle]);
+    if (identifier_index_compare(&candidate, &key) < 0) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+
+  IdentifierCandidate* candidates = NULL;
+  int number_of_candidates = 0;
+  int capacity = 0;
+  bool failed = false;
+  for (int i = low; i < bucket->number_of_ids && !failed &&
+                    number_of_candidates < IDENTIFIER_INDEX_MAX_CANDIDATES;
+       ++i) {
+    const IdentifierCandidate candidate =
+      identifier_index_get_candidate(index, bucket->ids[i]);
+    if (candidate.length == length) {
+      continue;  // the prefix itself
+    }
+    if (!identifier_index_has_prefix(&candidate, prefix, length)) {
+      break;
+    }
+    if (index->entries[candidate.id].count > 0) {
+      failed = !identifier_index_push_candidate(&candidates, &number_of_candidates,
+                                                &capacity, candidate);
+    }
+  }
+  for (int i = 0; i < bucket->number_of_recent && !failed; ++i) {
+    const IdentifierCandidate candidate =
+      identifier_index_get_candidate(index, bucket->recent[i]);
+    if (identifier_index_has_prefix(&candidate, prefix, length) &&
+        index->entries[candidate.id].count > 0) {
+      failed = !identifier_index_push_candidate(&candidates, &number_of_candidates,
+                                                &capacity, candidate);
+    }
+  }
+  if (failed) {
+    free(candidates);
+    return -1;
+  }
+  if (number_of_candidates == 0) {
+    return 0;
+  }
+  qsort(candidates, number_of_candidates, sizeof(IdentifierCandidate),
+        identifier_index_compare);
+  if (number_of_candidates > IDENTIFIER_INDEX_MAX_CANDIDATES) {
+    number_of_candidates = IDENTIFIER_INDEX_MAX_CANDIDATES;
+  }
+  *ids = malloc(sizeof(int) * number_of_candidates);
+  if (*ids == NULL) {
+    free(candidates);
+    return -1;
+  }
+  for (int i = 0; i < number_of_candidates; ++i) {
+    (*ids)[i] = candidates[i].id;
+  }
+  free(candidates);
+  return number_of_candidates;
+}
@@ -0,0 +1,83 @@
+/*
+ Copyright (c) 2025 Mateusz Stadnik
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// letters, digits and '_', the first character of an identifier is not a digit
+#define IDENTIFIER_INDEX_BUCKETS 53
+
+typedef struct IdentifierEntry {
+  uint32_t hash;
+  // position in the text of the index
+  int offset;
+  int length;
+  // occurrences in the indexed rows, an entry at 0 stays to be reused
+  int count;
+} IdentifierEntry;
+
+// at most this many candidates are returned, the first ones in order
+#define IDENTIFIER_INDEX_MAX_CANDIDATES 1000
+
+typedef struct IdentifierBucket {
+  // sorted by text
+  int* ids;
+  int number_of_ids;
+  int capacity;
+  // added since the last merge into ids, merged once there are enough of them
+  // so a load does not move the sorted ids for every new identifier
+  int* recent;
+  int number_of_recent;
+  int recent_capacity;
+} IdentifierBucket;
+
+// identifiers of all highlighted rows with their occurrence counts, the rows
+// keep the ids they added so an edited row only replaces its own ones
+typedef struct IdentifierIndex {
+  // ids are positions in entries and never change
+  IdentifierEntry* entries;
+  int number_of_entries;
+  int entries_capacity;
+  // open addressing table of id + 1, 0 marks an empty slot
+  int* table;
+  int table_size;
+  char* text;
+  int text_length;
+  int text_capacity;
+  // ids by the first character, completion binary searches one bucket
+  IdentifierBucket buckets[IDENTIFIER_INDEX_BUCKETS];
+} IdentifierIndex;
+
+void identifier_index_init(IdentifierIndex* index);
+void identifier_index_deinit(IdentifierIndex* index);
+bool identifier_index_is_identifier_char(char c);
+
+// counts an occurrence, returns the id of the identifier or -1 when out of memory
+int identifier_index_add(IdentifierIndex* index, const char* text, int length);
+// drops an occurrence counted by identifier_index_add
+void identifier_index_release(IdentifierIndex* index, int id);
+const char* identifier_index_get(const IdentifierIndex* index, int id, int* length);
+int identifier_index_get_count(const IdentifierIndex* index, int id);
+
+// ids of the identifiers in use starting with prefix and longer than it, in
+// alphabetical order. Returns their number and the malloc'ed ids, or -1 when
+// out of memory.
+int identifier_index_complete(IdentifierIndex* index,
+                              const char* prefix,
+                              int length,
+                              int** ids);
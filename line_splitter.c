@@ -0,0 +1,142 @@
+/*
+ Copyright (c) 2025 Mateusz Stadnik
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "line_splitter.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+void line_splitter_init(LineSplitter* splitter) {
+  memset(splitter, 0, sizeof(LineSplitter));
+}
+
+void line_splitter_deinit(LineSplitter* splitter) {
+  BufferRow* row = splitter->head;
+  while (row != NULL) {
+    BufferRow* next = row->next;
+    buffer_row_free(row);
+    row = next;
+  }
+  free(splitter->partial);
+  line_splitter_init(splitter);
+}
+
+static bool line_splitter_add_row(LineSplitter* splitter,
+                                  const char* text,
+                                  int length) {
+  // \r\n line endings lose the \r as when loading a file
+  if (length > 0 && text[length - 1] == '\r') {
+    --length;
+  }
+  BufferRow* row = buffer_row_alloc(text, length);
+  if (row == NULL) {
+    return false;
+  }
+  row->prev = splitter->tail;
+  if (splitter->tail != NULL) {
+    splitter->tail->next = row;
+  } else {
+    splitter->head = row;
+  }
+  splitter->tail = row;
+  ++splitter->number_of_rows;
+  return true;
+}
+
+static bool line_splitter_keep_partial(LineSplitter* splitter,
+                                       const char* data,
+                                       size_t length) {
+  const size_t needed = splitter->partial_length + length;
+  if (needed > (size_t)splitter->partial_capacity) {
+    size_t capacity =
+      splitter->partial_capacity > 0 ? (size_t)splitter->partial_capacity : 256;
+    while (capacity < needed) {
+      capacity *= 2;
+    }
+    char* partial = realloc(splitter->partial, capacity);
+    if (partial == NULL) {
+      return false;
+    }
+    splitter->partial = partial;
+    splitter->partial_capacity = (int)capacity;
+  }
+  memcpy(&splitter->partial[splitter->partial_length], data, length);
+  splitter->partial_length = (int)needed;
+  return true;
+}
+
+bool line_splitter_feed(LineSplitter* splitter, const char* data, size_t length) {
+  const char* end = data + length;
+  while (data < end) {
+    const char* newline = memchr(data, '\n', end - data);
+    if (newline == NULL) {
+      return line_splitter_keep_partial(splitter, data, end - data);
+    }
+    if (splitter->partial_length > 0) {
+      // only a line crossing blocks is copied twice
+      if (!line_splitter_keep_partial(splitter, data, newline - data) ||
+          !line_splitter_add_row(splitter, splitter->partial,
+                                 splitter->partial_length)) {
+        return false;
+      }
+      splitter->partial_length = 0;
+    } else if (!line_splitter_add_row(splitter, data, (int)(newline - data))) {
+      return false;
+    }
+    data = newline + 1;
+  }
+  return true;
+}
+
+bool line_splitter_finish(LineSplitter* splitter) {
+  if (splitter->partial_length == 0) {
+    return true;
+  }
+  const bool added =
+    line_splitter_add_row(splitter, splitter->partial, splitter->partial_length);
+  splitter->partial_length = 0;
+  return added;
+}
+
+bool line_splitter_read_file(LineSplitter* splitter, const char* filename) {
+  FILE* file = fopen(filename, "rb");
+  if (file == NULL) {
+    return false;
+  }
+  char* block = malloc(LINE_SPLITTER_BLOCK_SIZE);
+  bool result = block != NULL;
+  size_t length = 0;
+  while (result && (length = fread(block, 1, LINE_SPLITTER_BLOCK_SIZE, file)) > 0) {
+    result = line_splitter_feed(splitter, block, length);
+  }
+  result = result && !ferror(file) && line_splitter_finish(splitter);
+  free(block);
+  fclose(file);
+  return result;
+}
+
+void line_splitter_take_rows(LineSplitter* splitter,
+                             BufferRow** head,
+                             BufferRow** tail,
+                             int* number_of_rows) {
+  *head = splitter->head;
+  *tail = splitter->tail;
+  *number_of_rows = splitter->number_of_rows;
+  splitter->head = NULL;
+  splitter->tail = NULL;
+  splitter->number_of_rows = 0;
+}
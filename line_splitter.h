@@ -0,0 +1,53 @@
+/*
+ Copyright (c) 2025 Mateusz Stadnik
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "buffer_row.h"
+
+// blocks of text read at once by the users of the splitter
+#define LINE_SPLITTER_BLOCK_SIZE 65536
+
+// splits text arriving in blocks into rows linked from head to tail, each line
+// is copied once, straight from the block into its row
+typedef struct LineSplitter {
+  BufferRow* head;
+  BufferRow* tail;
+  int number_of_rows;
+  // unterminated line at the end of the last block
+  char* partial;
+  int partial_length;
+  int partial_capacity;
+} LineSplitter;
+
+void line_splitter_init(LineSplitter* splitter);
+// frees the rows still owned by the splitter
+void line_splitter_deinit(LineSplitter* splitter);
+// false when out of memory, the rows split until then are kept
+bool line_splitter_feed(LineSplitter* splitter, const char* data, size_t length);
+// feeds the whole file block by block and finishes, false when it can not be
+// read or out of memory
+bool line_splitter_read_file(LineSplitter* splitter, const char* filename);
+// the last line does not need to end with a newline
+bool line_splitter_finish(LineSplitter* splitter);
+// passes the rows to the caller, the splitter is empty afterwards
+void line_splitter_take_rows(LineSplitter* splitter,
+                             BufferRow** head,
+                             BufferRow** tail,
+                             int* number_of_rows);
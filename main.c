@@ -14,12 +14,73 @@
  You should have received a copy of the GNU General Public License
  along with this program. If not, see <https://www.gnu.org/licenses/>.
  */
+#define _POSIX_C_SOURCE 200809L
 
-#include <ncurses.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "editor.h"
-#include "window.h"
+#include "terminal.h"
+
+// blocks of a key script fed to the editor at once
+#define MAIN_KEYS_BLOCK_SIZE 4096
+
+static void print_usage(const char* name) {
+  fprintf(stderr,
+          "usage: %s [-T terminal] [-e] [-s] [-c command]... [-k keys] [file]\n",
+          name);
+  fprintf(stderr, "  -T terminal curses (default) or ansi\n");
+  fprintf(stderr, "  -e          no terminal, run a script and exit\n");
+  fprintf(stderr, "  -s          do not print messages in -e mode\n");
+  fprintf(stderr, "  -c command  ex command to run in -e mode\n");
+  fprintf(stderr, "  -k keys     file with keys to type in -e mode\n");
+  fprintf(stderr, "  without -c and -k, -e reads ex commands from stdin\n");
+}
+
+// keys of the file are processed as if typed, returns false if it can't be read
+static bool main_type_keys(Editor* editor, const char* filename) {
+  FILE* file = fopen(filename, "rb");
+  if (file == NULL) {
+    fprintf(stderr, "Can't open %s\n", filename);
+    return false;
+  }
+  unsigned char keys[MAIN_KEYS_BLOCK_SIZE];
+  size_t length = 0;
+  while (!editor_should_exit(editor) &&
+         (length = fread(keys, 1, sizeof(keys), file)) > 0) {
+    for (size_t i = 0; i < length && !editor_should_exit(editor); ++i) {
+      editor_process_key(editor, keys[i]);
+    }
+  }
+  fclose(file);
+  return true;
+}
+
+// vi -e: commands and keys run against the buffer without a terminal, the
+// editor exits at the end of the script without writing. The exit status is 1
+// when a command failed.
+static int main_run_script(Editor* editor,
+                           char** commands,
+                           int number_of_commands,
+                           const char* keys) {
+  bool running = true;
+  for (int i = 0; i < number_of_commands && running; ++i) {
+    running = editor_execute_ex_command(editor, commands[i]);
+  }
+  if (running && keys != NULL && !main_type_keys(editor, keys)) {
+    return 1;
+  }
+  if (running && number_of_commands == 0 && keys == NULL) {
+    char* line = NULL;
+    size_t capacity = 0;
+    while (getline(&line, &capacity, stdin) != -1 &&
+           editor_execute_ex_command(editor, line)) {
+    }
+    free(line);
+  }
+  return editor->number_of_errors > 0 ? 1 : 0;
+}
 
 int main(int argc, char* argv[]) {
   int key = 0;
@@ -41,25 +102,92 @@ int main(int argc, char* argv[]) {
     .start_column = 0,
     .start_line = 0,
     .string_rendering_ongoing = false,
+    .worker_pool = NULL,
   };
-  editor_init(&editor);
-  if (argc > 1) {
-    editor_load_file(&editor, argv[1]);
+  char** commands = calloc(argc, sizeof(char*));
+  int number_of_commands = 0;
+  const char* keys = NULL;
+  const char* filename = NULL;
+  const char* terminal_name = "curses";
+  for (int i = 1; i < argc; ++i) {
+    const char* argument = argv[i];
+    if (argument[0] == '-' && argument[1] != '\0' && strchr("ckT", argument[1]) &&
+        argument[2] == '\0' && i + 1 < argc) {
+      if (argument[1] == 'c') {
+        commands[number_of_commands++] = argv[++i];
+      } else if (argument[1] == 'k') {
+        keys = argv[++i];
+      } else {
+        terminal_name = argv[++i];
+      }
+    } else if (argument[0] == '-' && argument[1] != '\0' &&
+               strspn(&argument[1], "es") == strlen(&argument[1])) {
+      // -e, -s and -es
+      editor.headless = editor.headless || strchr(argument, 'e') != NULL;
+      editor.silent = editor.silent || strchr(argument, 's') != NULL;
+    } else if (argument[0] != '-' && filename == NULL) {
+      filename = argument;
+    } else {
+      print_usage(argv[0]);
+      free(commands);
+      return 2;
+    }
+  }
+  if (!editor.headless && (number_of_commands > 0 || keys != NULL)) {
+    print_usage(argv[0]);
+    free(commands);
+    return 2;
+  }
+
+  Terminal curses_terminal = {.operations = &terminal_curses_operations};
+  AnsiTerminal ansi_terminal;
+  if (strcmp(terminal_name, "ansi") == 0) {
+    if (!terminal_ansi_setup(&ansi_terminal)) {
+      fprintf(stderr, "ANSI terminal support is not built in\n");
+      free(commands);
+      return 2;
+    }
+    editor.terminal = &ansi_terminal.terminal;
+  } else if (strcmp(terminal_name, "curses") == 0) {
+    editor.terminal = &curses_terminal;
+  } else {
+    print_usage(argv[0]);
+    free(commands);
+    return 2;
+  }
+
+  if (!editor_init(&editor)) {
+    fprintf(stderr, "Failed to initialize the %s terminal\n", terminal_name);
+    free(commands);
+    return 1;
+  }
+  if (filename != NULL) {
+    editor_load_file(&editor, filename);
   } else {
     editor_create_new_file(&editor);
   }
 
+  if (editor.headless) {
+    const int status = main_run_script(&editor, commands, number_of_commands, keys);
+    free(commands);
+    editor_deinit(&editor);
+    return status;
+  }
+  free(commands);
+
   while (true) {
     if (key >= 0) {
       editor_redraw_screen(&editor);
     }
-    key = getch();
-    if (key != -1) {
+    key = editor_read_key(&editor);
+    if (key != TERMINAL_NO_KEY) {
       editor_process_key(&editor, key);
 
       if (editor_should_exit(&editor)) {
         break;
       }
+    } else if (editor_process_idle(&editor)) {
+      key = 0;
     }
   }
   editor_deinit(&editor);
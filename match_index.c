@@ -0,0 +1,262 @@
+/*
+ Copyright (c) 2025 Mateusz Stadnik
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "match_index.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define MATCH_INDEX_INITIAL_CAPACITY 64
+
+void match_index_init(MatchIndex* index, bool rows_only) {
+  index->rows_only = rows_only;
+  index->matches = NULL;
+  index->number_of_matches = 0;
+  index->capacity = 0;
+  index->next_row = NULL;
+  index->next_line = 0;
+  index->active = false;
+}
+
+void match_index_deinit(MatchIndex* index) {
+  free(index->matches);
+  match_index_init(index, index->rows_only);
+}
+
+void match_index_reset(MatchIndex* index, BufferRow* first) {
+  index->number_of_matches = 0;
+  index->next_row = first;
+  index->next_line = 0;
+  index->active = first != NULL;
+}
+
+static bool match_index_push(MatchIndex* index,
+                             BufferRow* row,
+                             int line,
+                             int column) {
+  if (index->number_of_matches == index->capacity) {
+    const int capacity =
+      index->capacity ? index->capacity * 2 : MATCH_INDEX_INITIAL_CAPACITY;
+    MatchPosition* matches = realloc(index->matches, sizeof(MatchPosition) * capacity);
+    if (matches == NULL) {
+      return false;
+    }
+    index->matches = matches;
+    index->capacity = capacity;
+  }
+  index->matches[index->number_of_matches].line = line;
+  index->matches[index->number_of_matches].column = column;
+  index->matches[index->number_of_matches].row = row;
+  ++index->number_of_matches;
+  return true;
+}
+
+// appends the matches of a row, false when out of memory
+static bool match_index_scan_row(MatchIndex* index,
+                                 const SearchPattern* pattern,
+                                 BufferRow* row,
+                                 int line) {
+  SearchMatch match;
+  bool found = search_find_forward(pattern, row->data, row->len, 0, &match);
+  while (found) {
+    if (!match_index_push(index, row, line, match.start)) {
+      return false;
+    }
+    if (index->rows_only) {
+      break;
+    }
+    const int column = match.start + (match.length > 0 ? match.length : 1);
+    found = column <= row->len &&
+            search_find_next(pattern, row->data, row->len, column, &match);
+  }
+  return true;
+}
+
+bool match_index_update(MatchIndex* index,
+                        const SearchPattern* pattern,
+                        int number_of_rows) {
+  if (!index->active) {
+    return false;
+  }
+  BufferRow* row = index->next_row;
+  int line = index->next_line;
+  for (int i = 0; i < number_of_rows && row != NULL; ++i, ++line, row = row->next) {
+    if (!match_index_scan_row(index, pattern, row, line)) {
+      // out of memory, an incomplete index is never used
+      index->active = false;
+      return false;
+    }
+  }
+  index->next_row = row;
+  index->next_line = line;
+  return row == NULL;
+}
+
+bool match_index_is_complete(const MatchIndex* index) {
+  return index->active && index->next_row == NULL;
+}
+
+int match_index_get_number_of_matches(const MatchIndex* index) {
+  return index->number_of_matches;
+}
+
+const MatchPosition* match_index_get(const MatchIndex* index, int i) {
+  return &index->matches[i];
+}
+
+static int match_index_compare(const MatchPosition* match, int line, int column) {
+  if (match->line != line) {
+    return match->line < line ? -1 : 1;
+  }
+  if (match->column != column) {
+    return match->column < column ? -1 : 1;
+  }
+  return 0;
+}
+
+// first match not before (line, column)
+static int match_index_lower_bound(const MatchIndex* index, int line, int column) {
+  int low = 0;
+  int high = index->number_of_matches;
+  while (low < high) {
+    const int middle = low + (high - low) / 2;
+    if (match_index_compare(&index->matches[middle], line, column) < 0) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+  return low;
+}
+
+int match_index_find(const MatchIndex* index, int line, int column, bool backward) {
+  if (backward) {
+    return match_index_lower_bound(index, line, column) - 1;
+  }
+  const int found = match_index_lower_bound(index, line, column + 1);
+  return found < index->number_of_matches ? found : -1;
+}
+
+int match_index_locate(const MatchIndex* index, int line, int column) {
+  const int found = match_index_lower_bound(index, line, column);
+  if (found < index->number_of_matches &&
+      match_index_compare(&index->matches[found], line, column) == 0) {
+    return found;
+  }
+  return -1;
+}
+
+// replaces the matches in [from, to) with the ones of count rows starting at
+// row, they are scanned to the end of the array and rotated into place
+static void match_index_rescan_rows(MatchIndex* index,
+                                    const SearchPattern* pattern,
+                                    int from,
+                                    int to,
+                                    BufferRow* row,
+                                    int line,
+                                    int count) {
+  MatchPosition* matches = index->matches;
+  if (to > from) {
+    memmove(&matches[from], &matches[to],
+            sizeof(MatchPosition) * (index->number_of_matches - to));
+    index->number_of_matches -= to - from;
+  }
+
+  const int tail = index->number_of_matches;
+  for (int i = 0; i < count && row != NULL; ++i, ++line, row = row->next) {
+    if (!match_index_scan_row(index, pattern, row, line)) {
+      index->active = false;
+      return;
+    }
+  }
+  const int added = index->number_of_matches - tail;
+  if (added == 0 || tail == from) {
+    return;
+  }
+  MatchPosition* scanned = malloc(sizeof(MatchPosition) * added);
+  if (scanned == NULL) {
+    index->active = false;
+    return;
+  }
+  matches = index->matches;
+  memcpy(scanned, &matches[tail], sizeof(MatchPosition) * added);
+  memmove(&matches[from + added], &matches[from],
+          sizeof(MatchPosition) * (tail - from));
+  memcpy(&matches[from], scanned, sizeof(MatchPosition) * added);
+  free(scanned);
+}
+
+static void match_index_shift_lines(MatchIndex* index, int from, int lines) {
+  for (int i = from; i < index->number_of_matches; ++i) {
+    index->matches[i].line += lines;
+  }
+}
+
+void match_index_update_row(MatchIndex* index,
+                            const SearchPattern* pattern,
+                            BufferRow* row,
+                            int line) {
+  if (!index->active || line >= index->next_line) {
+    return;  // the scan gets there later
+  }
+  const int from = match_index_lower_bound(index, line, 0);
+  const int to = match_index_lower_bound(index, line + 1, 0);
+  match_index_rescan_rows(index, pattern, from, to, row, line, 1);
+}
+
+void match_index_insert_rows(MatchIndex* index,
+                             const SearchPattern* pattern,
+                             BufferRow* first,
+                             int line,
+                             int count) {
+  if (!index->active || line > index->next_line) {
+    return;
+  }
+  if (line == index->next_line) {
+    // inserted right before the scan position, e.g. appended to the buffer
+    index->next_row = first;
+    return;
+  }
+  const int from = match_index_lower_bound(index, line, 0);
+  match_index_shift_lines(index, from, count);
+  index->next_line += count;
+  match_index_rescan_rows(index, pattern, from, from, first, line, count);
+}
+
+void match_index_remove_rows(MatchIndex* index,
+                             BufferRow* next,
+                             int line,
+                             int count) {
+  if (!index->active || line > index->next_line) {
+    return;
+  }
+  const int from = match_index_lower_bound(index, line, 0);
+  const int to = match_index_lower_bound(index, line + count, 0);
+  if (to > from) {
+    memmove(&index->matches[from], &index->matches[to],
+            sizeof(MatchPosition) * (index->number_of_matches - to));
+    index->number_of_matches -= to - from;
+  }
+  match_index_shift_lines(index, from, -count);
+  if (index->next_line >= line + count) {
+    index->next_line -= count;
+  } else {
+    // the scan position was removed, continue with the row after the range
+    index->next_row = next;
+    index->next_line = line;
+  }
+}
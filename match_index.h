@@ -0,0 +1,79 @@
+/*
+ Copyright (c) 2025 Mateusz Stadnik
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+
+#include "buffer_row.h"
+#include "search.h"
+
+typedef struct MatchPosition {
+  int line;
+  int column;
+  BufferRow* row;
+} MatchPosition;
+
+// positions of every match in the buffer sorted by line and column, filled a
+// few rows at a time so big buffers do not block the editor
+typedef struct MatchIndex {
+  MatchPosition* matches;
+  int number_of_matches;
+  int capacity;
+  // where the scan continues, NULL once the whole buffer was scanned
+  BufferRow* next_row;
+  int next_line;
+  bool active;
+  // only the first match of every row is kept, e.g. for filtering rows
+  bool rows_only;
+} MatchIndex;
+
+void match_index_init(MatchIndex* index, bool rows_only);
+void match_index_deinit(MatchIndex* index);
+// drops all matches and starts scanning again from first, NULL disables it
+void match_index_reset(MatchIndex* index, BufferRow* first);
+// scans up to number_of_rows rows, returns true when the index is complete
+bool match_index_update(MatchIndex* index,
+                        const SearchPattern* pattern,
+                        int number_of_rows);
+bool match_index_is_complete(const MatchIndex* index);
+
+// edits keep the scanned part of the index up to date without a rescan
+void match_index_update_row(MatchIndex* index,
+                            const SearchPattern* pattern,
+                            BufferRow* row,
+                            int line);
+// count rows starting with first were inserted at line
+void match_index_insert_rows(MatchIndex* index,
+                             const SearchPattern* pattern,
+                             BufferRow* first,
+                             int line,
+                             int count);
+// count rows starting at line were removed, next is the row now at line
+void match_index_remove_rows(MatchIndex* index,
+                             BufferRow* next,
+                             int line,
+                             int count);
+
+int match_index_get_number_of_matches(const MatchIndex* index);
+const MatchPosition* match_index_get(const MatchIndex* index, int i);
+
+// index of the first match after (line, column), or of the last one before it
+// when backward, -1 when there is none
+int match_index_find(const MatchIndex* index, int line, int column, bool backward);
+// index of the match starting exactly at (line, column) or -1
+int match_index_locate(const MatchIndex* index, int line, int column);
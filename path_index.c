@@ -0,0 +1,242 @@
+/*
+ Copyright (c) 2025 Mateusz Stadnik
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include "path_index.h"
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "grep.h"
+
+// score of every matched character and the bonuses added to it
+#define PATH_INDEX_MATCH_SCORE 16
+#define PATH_INDEX_COMPONENT_BONUS 24
+#define PATH_INDEX_WORD_BONUS 16
+#define PATH_INDEX_CONSECUTIVE_BONUS 8
+#define PATH_INDEX_FILENAME_BONUS 8
+#define PATH_INDEX_CASE_BONUS 1
+// taken for every skipped character between the first and the last match
+#define PATH_INDEX_GAP_PENALTY 1
+
+void path_index_init(PathIndex* index) {
+  memset(index, 0, sizeof(PathIndex));
+}
+
+void path_index_deinit(PathIndex* index) {
+  grep_free_files(index->paths, index->number_of_paths);
+  free(index->lengths);
+  free(index->masks);
+  free(index->query);
+  free(index->matches);
+  path_index_init(index);
+}
+
+static int path_index_lower(char c) {
+  return tolower((unsigned char)c);
+}
+
+static uint64_t path_index_get_mask(const char* text, int length) {
+  uint64_t mask = 0;
+  for (int i = 0; i < length; ++i) {
+    mask |= (uint64_t)1 << (path_index_lower(text[i]) & 63);
+  }
+  return mask;
+}
+
+bool path_index_build(PathIndex* index, const char* root) {
+  path_index_deinit(index);
+  const int number_of_paths = grep_collect_files(&root, 1, &index->paths);
+  if (number_of_paths < 0) {
+    return false;
+  }
+  index->number_of_paths = number_of_paths;
+  index->lengths = malloc(sizeof(int) * (number_of_paths + 1));
+  index->masks = malloc(sizeof(uint64_t) * (number_of_paths + 1));
+  index->matches = malloc(sizeof(int) * (number_of_paths + 1));
+  if (index->lengths == NULL || index->masks == NULL || index->matches == NULL) {
+    path_index_deinit(index);
+    return false;
+  }
+  for (int i = 0; i < number_of_paths; ++i) {
+    index->lengths[i] = (int)strlen(index->paths[i]);
+    index->masks[i] = path_index_get_mask(index->paths[i], index->lengths[i]);
+  }
+  index->built = true;
+  return true;
+}
+
+static bool path_index_is_word_start(const char* path, int i) {
+  if (i == 0) {
+    return true;
+  }
+  const char previous = path[i - 1];
+  return previous == '_' || previous == '-' || previous == '.' ||
+         previous == ' ' ||
+         (islower((unsigned char)previous) && isupper((unsigned char)path[i]));
+}
+
+int path_index_score(const char* path,
+                     int length,
+                     const char* query,
+                     int query_length) {
+  if (query_length == 0) {
+    return 0;
+  }
+  // the first occurrence of the query ends at end, walking back from there
+  // finds the shortest one ending there
+  int matched = 0;
+  int end = -1;
+  for (int i = 0; i < length; ++i) {
+    if (path_index_lower(path[i]) == path_index_lower(query[matched]) &&
+        ++matched == query_length) {
+      end = i;
+      break;
+    }
+  }
+  if (end < 0) {
+    return -1;
+  }
+  int start = end;
+  for (int i = end, left = query_length - 1; i >= 0; --i) {
+    if (path_index_lower(path[i]) == path_index_lower(query[left]) && --left < 0) {
+      start = i;
+      break;
+    }
+  }
+
+  const char* slash = NULL;
+  for (int i = length - 1; i >= 0 && slash == NULL; --i) {
+    if (path[i] == '/') {
+      slash = &path[i];
+    }
+  }
+  const int filename_start = slash != NULL ? (int)(slash - path) + 1 : 0;
+  int score = 0;
+  bool consecutive = false;
+  matched = 0;
+  for (int i = start; i <= end; ++i) {
+    if (path_index_lower(path[i]) != path_index_lower(query[matched])) {
+      score -= PATH_INDEX_GAP_PENALTY;
+      consecutive = false;
+      continue;
+    }
+    score += PATH_INDEX_MATCH_SCORE;
+    if (i == 0 || path[i - 1] == '/') {
+      score += PATH_INDEX_COMPONENT_BONUS;
+    } else if (path_index_is_word_start(path, i)) {
+      score += PATH_INDEX_WORD_BONUS;
+    }
+    if (consecutive) {
+      score += PATH_INDEX_CONSECUTIVE_BONUS;
+    }
+    if (i >= filename_start) {
+      score += PATH_INDEX_FILENAME_BONUS;
+    }
+    if (path[i] == query[matched]) {
+      score += PATH_INDEX_CASE_BONUS;
+    }
+    consecutive = true;
+    ++matched;
+  }
+  return score > 0 ? score : 0;
+}
+
+// better score first, then shorter paths
+static bool path_index_is_better(const PathIndex* index,
+                                 int score,
+                                 int id,
+                                 int other_score,
+                                 int other_id) {
+  if (score != other_score) {
+    return score > other_score;
+  }
+  if (index->lengths[id] != index->lengths[other_id]) {
+    return index->lengths[id] < index->lengths[other_id];
+  }
+  return id < other_id;
+}
+
+int path_index_find(PathIndex* index,
+                    const char* query,
+                    int* results,
+                    int max_results) {
+  const int query_length = (int)strlen(query);
+  int* scores = malloc(sizeof(int) * (max_results + 1));
+  char* copy = strdup(query);
+  if (scores == NULL || copy == NULL) {
+    free(scores);
+    free(copy);
+    return -1;
+  }
+  // a longer query only matches the paths matched by its start
+  const bool narrow = index->query != NULL &&
+                      strncmp(query, index->query, strlen(index->query)) == 0;
+  free(index->query);
+  index->query = copy;
+
+  // the mask filter is a branchless pass over a flat array
+  const uint64_t query_mask = path_index_get_mask(query, query_length);
+  int* matches = index->matches;
+  int number_of_candidates = 0;
+  if (narrow) {
+    for (int i = 0; i < index->number_of_matches; ++i) {
+      const int id = matches[i];
+      matches[number_of_candidates] = id;
+      number_of_candidates += (index->masks[id] & query_mask) == query_mask;
+    }
+  } else {
+    for (int id = 0; id < index->number_of_paths; ++id) {
+      matches[number_of_candidates] = id;
+      number_of_candidates += (index->masks[id] & query_mask) == query_mask;
+    }
+  }
+
+  int number_of_matches = 0;
+  int number_of_results = 0;
+  for (int i = 0; i < number_of_candidates; ++i) {
+    const int id = matches[i];
+    const int score =
+      path_index_score(index->paths[id], index->lengths[id], query, query_length);
+    if (score < 0) {
+      continue;
+    }
+    matches[number_of_matches++] = id;
+    // insertion into the few best ones kept sorted
+    int position = number_of_results;
+    while (position > 0 &&
+           path_index_is_better(index, score, id, scores[position - 1],
+                                results[position - 1])) {
+      if (position < max_results) {
+        scores[position] = scores[position - 1];
+        results[position] = results[position - 1];
+      }
+      --position;
+    }
+    if (position < max_results) {
+      scores[position] = score;
+      results[position] = id;
+      if (number_of_results < max_results) {
+        ++number_of_results;
+      }
+    }
+  }
+  index->number_of_matches = number_of_matches;
+  free(scores);
+  return number_of_results;
+}
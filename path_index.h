@@ -0,0 +1,54 @@
+/*
+ Copyright (c) 2025 Mateusz Stadnik
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// paths of a project tree for fuzzy finding, a query matches a path when its
+// characters appear in the path in order, ignoring case
+typedef struct PathIndex {
+  char** paths;
+  int* lengths;
+  // bit c % 64 is set for every lowercased character c of the path, paths
+  // missing a character of the query are rejected with one compare
+  uint64_t* masks;
+  int number_of_paths;
+  bool built;
+  // paths matching query, a longer query starting with it only checks them
+  char* query;
+  int* matches;
+  int number_of_matches;
+} PathIndex;
+
+void path_index_init(PathIndex* index);
+void path_index_deinit(PathIndex* index);
+// walks root as :grep does, replacing the paths indexed before
+bool path_index_build(PathIndex* index, const char* root);
+
+// up to max_results paths matching query, best first. Returns their number and
+// fills results with their positions in paths, or -1 when out of memory.
+int path_index_find(PathIndex* index,
+                    const char* query,
+                    int* results,
+                    int max_results);
+// higher is better, -1 when query does not match. Matches at the start of path
+// components and words, consecutive ones and ones in the file name score more.
+int path_index_score(const char* path,
+                     int length,
+                     const char* query,
+                     int query_length);
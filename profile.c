@@ -0,0 +1,179 @@
+/*
+ Copyright (c) 2025 Mateusz Stadnik
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "profile.h"
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+typedef struct Profile {
+  ProfileFrame frames[PROFILE_NUMBER_OF_FRAMES];
+  int next_frame;
+  int number_of_frames;
+  long long total_frames;
+  ProfileFrame current;
+  long long starts[ProfileTimer_Count];
+  // a timer begun again while running, e.g. keys of a macro dispatched from a
+  // key, keeps its first start
+  int depths[ProfileTimer_Count];
+} Profile;
+
+static Profile profile;
+// allocations of the editor and of worker threads since the last frame end
+static _Atomic long long profile_allocations;
+
+static const char* profile_timer_names[ProfileTimer_Count] = {
+  "input decode (us)", "key dispatch (us)", "highlight (us)", "render (us)",
+  "terminal flush (us)",
+};
+
+static const char* profile_counter_names[ProfileCounter_Count] = {
+  "rows highlighted",
+  "rows redrawn",
+  "bytes written",
+  "allocations",
+};
+
+static long long profile_now(void) {
+  struct timespec time;
+  clock_gettime(CLOCK_MONOTONIC, &time);
+  return (long long)time.tv_sec * 1000000000LL + time.tv_nsec;
+}
+
+void profile_begin(ProfileTimer timer) {
+  if (profile.depths[timer]++ == 0) {
+    profile.starts[timer] = profile_now();
+  }
+}
+
+void profile_end(ProfileTimer timer) {
+  if (profile.depths[timer] > 0 && --profile.depths[timer] == 0) {
+    profile.current.nanoseconds[timer] += profile_now() - profile.starts[timer];
+  }
+}
+
+void profile_cancel(ProfileTimer timer) {
+  if (profile.depths[timer] > 0) {
+    --profile.depths[timer];
+  }
+}
+
+void profile_count(ProfileCounter counter, long long count) {
+  profile.current.counters[counter] += count;
+}
+
+void profile_end_frame(void) {
+  profile.current.counters[ProfileCounter_Allocations] +=
+    atomic_exchange(&profile_allocations, 0);
+  profile.frames[profile.next_frame] = profile.current;
+  profile.next_frame = (profile.next_frame + 1) % PROFILE_NUMBER_OF_FRAMES;
+  if (profile.number_of_frames < PROFILE_NUMBER_OF_FRAMES) {
+    ++profile.number_of_frames;
+  }
+  ++profile.total_frames;
+  memset(&profile.current, 0, sizeof(ProfileFrame));
+}
+
+void profile_reset(void) {
+  memset(&profile, 0, sizeof(Profile));
+  atomic_store(&profile_allocations, 0);
+}
+
+void profile_summarize(ProfileSummary* summary) {
+  memset(summary, 0, sizeof(ProfileSummary));
+  summary->number_of_frames = profile.number_of_frames;
+  summary->total_frames = profile.total_frames;
+  if (profile.number_of_frames == 0) {
+    return;
+  }
+  ProfileFrame total = {{0}, {0}};
+  for (int i = 0; i < profile.number_of_frames; ++i) {
+    const ProfileFrame* frame = &profile.frames[i];
+    for (int j = 0; j < ProfileTimer_Count; ++j) {
+      total.nanoseconds[j] += frame->nanoseconds[j];
+      if (frame->nanoseconds[j] > summary->maximum.nanoseconds[j]) {
+        summary->maximum.nanoseconds[j] = frame->nanoseconds[j];
+      }
+    }
+    for (int j = 0; j < ProfileCounter_Count; ++j) {
+      total.counters[j] += frame->counters[j];
+      if (frame->counters[j] > summary->maximum.counters[j]) {
+        summary->maximum.counters[j] = frame->counters[j];
+      }
+    }
+  }
+  for (int j = 0; j < ProfileTimer_Count; ++j) {
+    summary->average_nanoseconds[j] =
+      (double)total.nanoseconds[j] / profile.number_of_frames;
+  }
+  for (int j = 0; j < ProfileCounter_Count; ++j) {
+    summary->average_counters[j] =
+      (double)total.counters[j] / profile.number_of_frames;
+  }
+}
+
+int profile_format(char* text, size_t size) {
+  ProfileSummary summary;
+  profile_summarize(&summary);
+  int length = snprintf(text, size, "%lld frames, per frame of the last %d:\n\n",
+                        summary.total_frames, summary.number_of_frames);
+  length += snprintf(length < (int)size ? &text[length] : NULL,
+                     length < (int)size ? size - length : 0, "%-22s %10s %10s\n",
+                     "", "average", "maximum");
+  for (int i = 0; i < ProfileTimer_Count; ++i) {
+    length += snprintf(length < (int)size ? &text[length] : NULL,
+                       length < (int)size ? size - length : 0,
+                       "%-22s %10.1f %10.1f\n", profile_timer_names[i],
+                       summary.average_nanoseconds[i] / 1e3,
+                       summary.maximum.nanoseconds[i] / 1e3);
+  }
+  for (int i = 0; i < ProfileCounter_Count; ++i) {
+    length += snprintf(length < (int)size ? &text[length] : NULL,
+                       length < (int)size ? size - length : 0,
+                       "%-22s %10.1f %10lld\n", profile_counter_names[i],
+                       summary.average_counters[i], summary.maximum.counters[i]);
+  }
+  return length;
+}
+
+#ifdef YASVI_PROFILE_ALLOCATIONS
+
+// worker threads allocate too so the counter is atomic
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* pointer, size_t size);
+
+void* __wrap_malloc(size_t size) {
+  atomic_fetch_add_explicit(&profile_allocations, 1, memory_order_relaxed);
+  return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t count, size_t size) {
+  atomic_fetch_add_explicit(&profile_allocations, 1, memory_order_relaxed);
+  return __real_calloc(count, size);
+}
+
+void* __wrap_realloc(void* pointer, size_t size) {
+  atomic_fetch_add_explicit(&profile_allocations, 1, memory_order_relaxed);
+  return __real_realloc(pointer, size);
+}
+
+#endif
@@ -0,0 +1,88 @@
+/*
+ Copyright (c) 2025 Mateusz Stadnik
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <stddef.h>
+
+// frames kept for the averages and maxima shown by :stats
+#define PROFILE_NUMBER_OF_FRAMES 256
+
+// timers nest, highlighting is also part of the dispatch or render around it
+typedef enum ProfileTimer {
+  // turning the bytes read from the terminal into a key
+  ProfileTimer_Input,
+  ProfileTimer_Dispatch,
+  ProfileTimer_Highlight,
+  // drawing into the terminal, without the flush
+  ProfileTimer_Render,
+  ProfileTimer_Flush,
+  ProfileTimer_Count,
+} ProfileTimer;
+
+typedef enum ProfileCounter {
+  ProfileCounter_RowsHighlighted,
+  ProfileCounter_RowsRedrawn,
+  ProfileCounter_BytesWritten,
+  // malloc, calloc and realloc calls of the editor itself, counted with
+  // YASVI_PROFILE_ALLOCATIONS
+  ProfileCounter_Allocations,
+  ProfileCounter_Count,
+} ProfileCounter;
+
+// work done between the end of the previous frame and a flush of the screen
+typedef struct ProfileFrame {
+  long long nanoseconds[ProfileTimer_Count];
+  long long counters[ProfileCounter_Count];
+} ProfileFrame;
+
+typedef struct ProfileSummary {
+  int number_of_frames;
+  // over the kept frames
+  double average_nanoseconds[ProfileTimer_Count];
+  double average_counters[ProfileCounter_Count];
+  ProfileFrame maximum;
+  // frames since the start, including those no longer kept
+  long long total_frames;
+} ProfileSummary;
+
+// with YASVI_PROFILE the editor is built with timers and counters around every
+// step of a frame, YASVI_PROFILE_ALLOCATIONS needs malloc, calloc and realloc
+// wrapped by the linker (-Wl,--wrap=malloc and so on)
+#ifdef YASVI_PROFILE
+#define PROFILE_BEGIN(timer) profile_begin(timer)
+#define PROFILE_END(timer) profile_end(timer)
+#define PROFILE_CANCEL(timer) profile_cancel(timer)
+#define PROFILE_COUNT(counter, count) profile_count(counter, count)
+#define PROFILE_END_FRAME() profile_end_frame()
+#else
+#define PROFILE_BEGIN(timer) ((void)0)
+#define PROFILE_END(timer) ((void)0)
+#define PROFILE_CANCEL(timer) ((void)0)
+#define PROFILE_COUNT(counter, count) ((void)0)
+#define PROFILE_END_FRAME() ((void)0)
+#endif
+
+void profile_begin(ProfileTimer timer);
+void profile_end(ProfileTimer timer);
+// stops the timer without adding its time, e.g. for a read which got no key
+void profile_cancel(ProfileTimer timer);
+void profile_count(ProfileCounter counter, long long count);
+void profile_end_frame(void);
+void profile_reset(void);
+void profile_summarize(ProfileSummary* summary);
+// lines of the :stats report, returns the length as snprintf does
+int profile_format(char* text, size_t size);
@@ -0,0 +1,106 @@
+/*
+ Copyright (c) 2025 Mateusz Stadnik
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include "quickfix.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define QUICKFIX_INITIAL_SIZE 64
+
+void quickfix_init(QuickfixList* list) {
+  memset(list, 0, sizeof(QuickfixList));
+  list->current = -1;
+}
+
+void quickfix_deinit(QuickfixList* list) {
+  for (int i = 0; i < list->number_of_files; ++i) {
+    free(list->files[i]);
+  }
+  for (int i = 0; i < list->number_of_entries; ++i) {
+    free(list->entries[i].text);
+  }
+  free(list->files);
+  free(list->entries);
+  quickfix_init(list);
+}
+
+static bool quickfix_grow(void** data, int* capacity, int needed, size_t size) {
+  if (needed <= *capacity) {
+    return true;
+  }
+  const int new_capacity = *capacity ? *capacity * 2 : QUICKFIX_INITIAL_SIZE;
+  void* resized = realloc(*data, size * new_capacity);
+  if (resized == NULL) {
+    return false;
+  }
+  *data = resized;
+  *capacity = new_capacity;
+  return true;
+}
+
+int quickfix_add_file(QuickfixList* list, const char* filename) {
+  if (!quickfix_grow((void**)&list->files, &list->files_capacity,
+                     list->number_of_files + 1, sizeof(char*))) {
+    return -1;
+  }
+  char* copy = strdup(filename);
+  if (copy == NULL) {
+    return -1;
+  }
+  list->files[list->number_of_files] = copy;
+  return list->number_of_files++;
+}
+
+bool quickfix_add_entry(QuickfixList* list,
+                        int file,
+                        int line,
+                        int column,
+                        const char* text,
+                        int length) {
+  if (!quickfix_grow((void**)&list->entries, &list->capacity,
+                     list->number_of_entries + 1, sizeof(QuickfixEntry))) {
+    return false;
+  }
+  char* copy = malloc(length + 1);
+  if (copy == NULL) {
+    return false;
+  }
+  memcpy(copy, text, length);
+  copy[length] = '\0';
+  QuickfixEntry* entry = &list->entries[list->number_of_entries++];
+  entry->file = file;
+  entry->line = line;
+  entry->column = column;
+  entry->text = copy;
+  return true;
+}
+
+const char* quickfix_get_filename(const QuickfixList* list,
+                                  const QuickfixEntry* entry) {
+  return list->files[entry->file];
+}
+
+const QuickfixEntry* quickfix_move(QuickfixList* list, int count) {
+  const int target = list->current + count;
+  if (target < 0 || target >= list->number_of_entries) {
+    return NULL;
+  }
+  list->current = target;
+  return &list->entries[target];
+}
@@ -0,0 +1,60 @@
+/*
+ Copyright (c) 2025 Mateusz Stadnik
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <stdbool.h>
+
+typedef struct QuickfixEntry {
+  // index in the files of the list
+  int file;
+  // 0 based
+  int line;
+  int column;
+  // the matching line
+  char* text;
+} QuickfixEntry;
+
+// positions found by :grep, visited with :cn and :cp
+typedef struct QuickfixList {
+  char** files;
+  int number_of_files;
+  int files_capacity;
+  QuickfixEntry* entries;
+  int number_of_entries;
+  int capacity;
+  // -1 before the first entry is visited
+  int current;
+} QuickfixList;
+
+void quickfix_init(QuickfixList* list);
+// drops all entries and files
+void quickfix_deinit(QuickfixList* list);
+
+// returns the index of the copied filename or -1 when out of memory
+int quickfix_add_file(QuickfixList* list, const char* filename);
+bool quickfix_add_entry(QuickfixList* list,
+                        int file,
+                        int line,
+                        int column,
+                        const char* text,
+                        int length);
+const char* quickfix_get_filename(const QuickfixList* list,
+                                  const QuickfixEntry* entry);
+
+// makes the entry count entries away from the current one current, NULL
+// without moving when there is no such entry
+const QuickfixEntry* quickfix_move(QuickfixList* list, int count);
@@ -0,0 +1,973 @@
+/*
+ Copyright (c) 2025 Mateusz Stadnik
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "regexp.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef enum {
+  RegexpNode_Set,
+  RegexpNode_Empty,
+  RegexpNode_Bol,
+  RegexpNode_Eol,
+  RegexpNode_Concat,
+  RegexpNode_Alternate,
+  RegexpNode_Star,
+  RegexpNode_Plus,
+  RegexpNode_Quest,
+} RegexpNodeType;
+
+typedef struct RegexpNode {
+  RegexpNodeType type;
+  int set;
+  int left;
+  int right;
+} RegexpNode;
+
+typedef enum {
+  RegexpOp_Set,
+  RegexpOp_Match,
+  RegexpOp_Jump,
+  RegexpOp_Split,
+  RegexpOp_Bol,
+  RegexpOp_Eol,
+} RegexpOp;
+
+typedef struct RegexpInst {
+  RegexpOp op;
+  int x;
+  int y;
+} RegexpInst;
+
+typedef uint32_t RegexpSet[8];
+
+typedef struct RegexpProgram {
+  RegexpInst* insts;
+  int number_of_insts;
+} RegexpProgram;
+
+typedef struct RegexpDfaState {
+  int* insts;
+  int number_of_insts;
+  bool match;
+  bool dead;
+} RegexpDfaState;
+
+// states are sets of NFA instructions, created on first use and cached
+typedef struct RegexpDfa {
+  const RegexpProgram* program;
+  const struct Regexp* regexp;
+  bool unanchored;
+  RegexpDfaState states[REGEXP_DFA_MAX_STATES];
+  int number_of_states;
+  // number_of_symbols transitions per state, -1 when not computed yet
+  int* transitions;
+  int number_of_symbols;
+  int* inst_pool;
+  int inst_pool_used;
+  int inst_pool_size;
+  int hash_table[REGEXP_DFA_MAX_STATES * 2];
+  int start_states[2];
+  // scratch space for epsilon closures
+  int* sparse;
+  int* dense;
+  int dense_count;
+  int* stack;
+} RegexpDfa;
+
+struct Regexp {
+  RegexpSet* sets;
+  int number_of_sets;
+  // bytes which no set distinguishes share one class
+  unsigned char byte_class[256];
+  unsigned char class_representative[256];
+  int number_of_classes;
+  RegexpProgram forward;
+  RegexpProgram reverse;
+  RegexpDfa forward_dfa;
+  RegexpDfa reverse_dfa;
+  // match starts of the text of the last regexp_search, next_starts[i -
+  // scanned_from] is the first one at or after i or -1 for i up to scanned_to
+  int* next_starts;
+  int scanned_from;
+  int scanned_to;
+};
+
+typedef struct RegexpParser {
+  const char* pattern;
+  int position;
+  RegexpNode* nodes;
+  int number_of_nodes;
+  RegexpSet* sets;
+  int number_of_sets;
+  const char* error;
+} RegexpParser;
+
+static void regexp_set_add(RegexpSet set, unsigned char c) {
+  set[c >> 5] |= 1u << (c & 31);
+}
+
+static bool regexp_set_contains(const RegexpSet set, unsigned char c) {
+  return (set[c >> 5] >> (c & 31)) & 1;
+}
+
+static void regexp_set_add_range(RegexpSet set, int from, int to) {
+  for (int c = from; c <= to; ++c) {
+    regexp_set_add(set, (unsigned char)c);
+  }
+}
+
+static void regexp_set_invert(RegexpSet set) {
+  for (int i = 0; i < 8; ++i) {
+    set[i] = ~set[i];
+  }
+}
+
+static int regexp_parser_add_node(RegexpParser* parser,
+                                  RegexpNodeType type,
+                                  int left,
+                                  int right) {
+  RegexpNode* node = &parser->nodes[parser->number_of_nodes];
+  node->type = type;
+  node->set = -1;
+  node->left = left;
+  node->right = right;
+  return parser->number_of_nodes++;
+}
+
+static int regexp_parser_add_set(RegexpParser* parser) {
+  memset(parser->sets[parser->number_of_sets], 0, sizeof(RegexpSet));
+  int node = regexp_parser_add_node(parser, RegexpNode_Set, -1, -1);
+  parser->nodes[node].set = parser->number_of_sets++;
+  return node;
+}
+
+static uint32_t* regexp_parser_node_set(RegexpParser* parser, int node) {
+  return parser->sets[parser->nodes[node].set];
+}
+
+// \s \d \w and their negations, false for other characters
+static bool regexp_add_class_escape(RegexpSet set, char c) {
+  RegexpSet class_set = {0};
+  switch (c) {
+    case 's':
+    case 'S':
+      regexp_set_add(class_set, ' ');
+      regexp_set_add(class_set, '\t');
+      break;
+    case 'd':
+    case 'D':
+      regexp_set_add_range(class_set, '0', '9');
+      break;
+    case 'w':
+    case 'W':
+      regexp_set_add_range(class_set, '0', '9');
+      regexp_set_add_range(class_set, 'a', 'z');
+      regexp_set_add_range(class_set, 'A', 'Z');
+      regexp_set_add(class_set, '_');
+      break;
+    default:
+      return false;
+  }
+  if (c >= 'A' && c <= 'Z') {
+    regexp_set_invert(class_set);
+  }
+  for (int i = 0; i < 8; ++i) {
+    set[i] |= class_set[i];
+  }
+  return true;
+}
+
+static char regexp_unescape(char c) {
+  switch (c) {
+    case 't':
+      return '\t';
+    case 'e':
+      return 27;
+    case 'r':
+      return '\r';
+    default:
+      return c;
+  }
+}
+
+static const struct {
+  const char* name;
+  const char* ranges;
+} regexp_named_classes[] = {
+  {"alpha", "azAZ"},     {"digit", "09"},      {"alnum", "azAZ09"},
+  {"upper", "AZ"},       {"lower", "az"},      {"space", "  \t\r"},
+  {"blank", "  \t\t"},   {"xdigit", "09afAF"}, {"punct", "!/:@[`{~"},
+};
+
+static bool regexp_parse_named_class(RegexpParser* parser, RegexpSet set) {
+  const char* start = &parser->pattern[parser->position + 2];
+  const char* end = strstr(start, ":]");
+  if (end == NULL) {
+    return false;
+  }
+  const int number_of_classes =
+    sizeof(regexp_named_classes) / sizeof(regexp_named_classes[0]);
+  for (int i = 0; i < number_of_classes; ++i) {
+    const char* name = regexp_named_classes[i].name;
+    if ((int)strlen(name) == end - start &&
+        strncmp(name, start, end - start) == 0) {
+      for (const char* r = regexp_named_classes[i].ranges; *r; r += 2) {
+        regexp_set_add_range(set, (unsigned char)r[0], (unsigned char)r[1]);
+      }
+      parser->position += (end - start) + 4;
+      return true;
+    }
+  }
+  return false;
+}
+
+static int regexp_parse_bracket(RegexpParser* parser) {
+  int node = regexp_parser_add_set(parser);
+  uint32_t* set = regexp_parser_node_set(parser, node);
+  const char* pattern = parser->pattern;
+  bool negate = false;
+  // skip '['
+  ++parser->position;
+  if (pattern[parser->position] == '^') {
+    negate = true;
+    ++parser->position;
+  }
+
+  bool first = true;
+  while (pattern[parser->position] != ']' || first) {
+    char c = pattern[parser->position];
+    if (c == '\0') {
+      parser->error = "Missing ] in pattern";
+      return -1;
+    }
+    first = false;
+    if (c == '[' && pattern[parser->position + 1] == ':' &&
+        regexp_parse_named_class(parser, set)) {
+      continue;
+    }
+    if (c == '\\' && pattern[parser->position + 1] != '\0') {
+      ++parser->position;
+      c = pattern[parser->position];
+      if (regexp_add_class_escape(set, c)) {
+        ++parser->position;
+        continue;
+      }
+      c = regexp_unescape(c);
+    }
+    ++parser->position;
+    if (pattern[parser->position] == '-' && pattern[parser->position + 1] != ']' &&
+        pattern[parser->position + 1] != '\0') {
+      char to = pattern[parser->position + 1];
+      parser->position += 2;
+      if (to == '\\' && pattern[parser->position] != '\0') {
+        to = regexp_unescape(pattern[parser->position++]);
+      }
+      if ((unsigned char)to < (unsigned char)c) {
+        parser->error = "Reverse range in character class";
+        return -1;
+      }
+      regexp_set_add_range(set, (unsigned char)c, (unsigned char)to);
+    } else {
+      regexp_set_add(set, (unsigned char)c);
+    }
+  }
+  // skip ']'
+  ++parser->position;
+  if (negate) {
+    regexp_set_invert(set);
+  }
+  return node;
+}
+
+static int regexp_parse_alternate(RegexpParser* parser);
+
+static bool regexp_parser_at_branch_end(const RegexpParser* parser, int position) {
+  const char* p = &parser->pattern[position];
+  return p[0] == '\0' || (p[0] == '\\' && (p[1] == '|' || p[1] == ')'));
+}
+
+static int regexp_parse_atom(RegexpParser* parser, bool branch_start) {
+  const char* pattern = parser->pattern;
+  const char c = pattern[parser->position];
+
+  if (c == '^' && branch_start) {
+    ++parser->position;
+    return regexp_parser_add_node(parser, RegexpNode_Bol, -1, -1);
+  }
+  if (c == '$' && regexp_parser_at_branch_end(parser, parser->position + 1)) {
+    ++parser->position;
+    return regexp_parser_add_node(parser, RegexpNode_Eol, -1, -1);
+  }
+  if (c == '.') {
+    ++parser->position;
+    int node = regexp_parser_add_set(parser);
+    regexp_set_invert(regexp_parser_node_set(parser, node));
+    return node;
+  }
+  if (c == '[' && strchr(&pattern[parser->position + 1], ']') != NULL) {
+    return regexp_parse_bracket(parser);
+  }
+
+  int node = -1;
+  if (c == '\\') {
+    const char escaped = pattern[parser->position + 1];
+    if (escaped == '\0') {
+      parser->error = "Trailing \\ in pattern";
+      return -1;
+    }
+    parser->position += 2;
+    if (escaped == '(') {
+      node = regexp_parse_alternate(parser);
+      if (node < 0) {
+        return -1;
+      }
+      if (pattern[parser->position] != '\\' ||
+          pattern[parser->position + 1] != ')') {
+        parser->error = "Unmatched \\(";
+        return -1;
+      }
+      parser->position += 2;
+      return node;
+    }
+    node = regexp_parser_add_set(parser);
+    uint32_t* set = regexp_parser_node_set(parser, node);
+    if (!regexp_add_class_escape(set, escaped)) {
+      regexp_set_add(set, (unsigned char)regexp_unescape(escaped));
+    }
+    return node;
+  }
+
+  ++parser->position;
+  node = regexp_parser_add_set(parser);
+  regexp_set_add(regexp_parser_node_set(parser, node), (unsigned char)c);
+  return node;
+}
+
+static int regexp_parse_repeat(RegexpParser* parser, bool branch_start) {
+  int node = regexp_parse_atom(parser, branch_start);
+  while (node >= 0) {
+    const char* p = &parser->pattern[parser->position];
+    if (p[0] == '*') {
+      node = regexp_parser_add_node(parser, RegexpNode_Star, node, -1);
+      parser->position += 1;
+    } else if (p[0] == '\\' && p[1] == '+') {
+      node = regexp_parser_add_node(parser, RegexpNode_Plus, node, -1);
+      parser->position += 2;
+    } else if (p[0] == '\\' && (p[1] == '?' || p[1] == '=')) {
+      node = regexp_parser_add_node(parser, RegexpNode_Quest, node, -1);
+      parser->position += 2;
+    } else {
+      break;
+    }
+  }
+  return node;
+}
+
+static int regexp_parse_concat(RegexpParser* parser) {
+  int node = -1;
+  bool branch_start = true;
+  while (!regexp_parser_at_branch_end(parser, parser->position)) {
+    // '*' at the start of a branch is a literal
+    int next = -1;
+    if (branch_start && parser->pattern[parser->position] == '*') {
+      ++parser->position;
+      next = regexp_parser_add_set(parser);
+      regexp_set_add(regexp_parser_node_set(parser, next), '*');
+    } else {
+      next = regexp_parse_repeat(parser, branch_start);
+    }
+    if (next < 0) {
+      return -1;
+    }
+    node = node < 0 ? next
+                    : regexp_parser_add_node(parser, RegexpNode_Concat, node, next);
+    branch_start = false;
+  }
+  if (node < 0) {
+    node = regexp_parser_add_node(parser, RegexpNode_Empty, -1, -1);
+  }
+  return node;
+}
+
+static int regexp_parse_alternate(RegexpParser* parser) {
+  int node = regexp_parse_concat(parser);
+  while (node >= 0 && parser->pattern[parser->position] == '\\' &&
+         parser->pattern[parser->position + 1] == '|') {
+    parser->position += 2;
+    int right = regexp_parse_concat(parser);
+    if (right < 0) {
+      return -1;
+    }
+    node = regexp_parser_add_node(parser, RegexpNode_Alternate, node, right);
+  }
+  return node;
+}
+
+static int regexp_emit(RegexpProgram* program, RegexpOp op, int x, int y) {
+  RegexpInst* inst = &program->insts[program->number_of_insts];
+  inst->op = op;
+  inst->x = x;
+  inst->y = y;
+  return program->number_of_insts++;
+}
+
+// reverse emits concatenations backwards and swaps anchors
+static void regexp_compile_node(const RegexpNode* nodes,
+                                int index,
+                                RegexpProgram* program,
+                                bool reverse) {
+  const RegexpNode* node = &nodes[index];
+  switch (node->type) {
+    case RegexpNode_Set:
+      regexp_emit(program, RegexpOp_Set, node->set, 0);
+      break;
+    case RegexpNode_Empty:
+      break;
+    case RegexpNode_Bol:
+      regexp_emit(program, reverse ? RegexpOp_Eol : RegexpOp_Bol, 0, 0);
+      break;
+    case RegexpNode_Eol:
+      regexp_emit(program, reverse ? RegexpOp_Bol : RegexpOp_Eol, 0, 0);
+      break;
+    case RegexpNode_Concat:
+      regexp_compile_node(nodes, reverse ? node->right : node->left, program,
+                          reverse);
+      regexp_compile_node(nodes, reverse ? node->left : node->right, program,
+                          reverse);
+      break;
+    case RegexpNode_Alternate: {
+      const int split = regexp_emit(program, RegexpOp_Split, 0, 0);
+      program->insts[split].x = program->number_of_insts;
+      regexp_compile_node(nodes, node->left, program, reverse);
+      const int jump = regexp_emit(program, RegexpOp_Jump, 0, 0);
+      program->insts[split].y = program->number_of_insts;
+      regexp_compile_node(nodes, node->right, program, reverse);
+      program->insts[jump].x = program->number_of_insts;
+    } break;
+    case RegexpNode_Star: {
+      const int split = regexp_emit(program, RegexpOp_Split, 0, 0);
+      program->insts[split].x = program->number_of_insts;
+      regexp_compile_node(nodes, node->left, program, reverse);
+      regexp_emit(program, RegexpOp_Jump, split, 0);
+      program->insts[split].y = program->number_of_insts;
+    } break;
+    case RegexpNode_Plus: {
+      const int start = program->number_of_insts;
+      regexp_compile_node(nodes, node->left, program, reverse);
+      const int split = regexp_emit(program, RegexpOp_Split, start, 0);
+      program->insts[split].y = program->number_of_insts;
+    } break;
+    case RegexpNode_Quest: {
+      const int split = regexp_emit(program, RegexpOp_Split, 0, 0);
+      program->insts[split].x = program->number_of_insts;
+      regexp_compile_node(nodes, node->left, program, reverse);
+      program->insts[split].y = program->number_of_insts;
+    } break;
+  }
+}
+
+static bool regexp_compile_program(RegexpProgram* program,
+                                   const RegexpNode* nodes,
+                                   int root,
+                                   int number_of_nodes,
+                                   bool reverse) {
+  // every node emits at most two instructions, plus the final match
+  program->insts = malloc(sizeof(RegexpInst) * (number_of_nodes * 2 + 1));
+  program->number_of_insts = 0;
+  if (program->insts == NULL) {
+    return false;
+  }
+  regexp_compile_node(nodes, root, program, reverse);
+  regexp_emit(program, RegexpOp_Match, 0, 0);
+  return true;
+}
+
+static void regexp_compute_byte_classes(Regexp* regexp) {
+  int class_of[256] = {0};
+  int number_of_classes = 1;
+  int remap[512];
+  for (int s = 0; s < regexp->number_of_sets; ++s) {
+    // split every class which has members both in and out of the set
+    for (int k = 0; k < number_of_classes; ++k) {
+      remap[k] = -1;
+    }
+    for (int c = 0; c < 256; ++c) {
+      if (regexp_set_contains(regexp->sets[s], (unsigned char)c)) {
+        const int k = class_of[c];
+        if (remap[k] < 0) {
+          remap[k] = number_of_classes++;
+        }
+        class_of[c] = remap[k];
+      }
+    }
+    // compact classes which moved entirely
+    int used[512] = {0};
+    for (int c = 0; c < 256; ++c) {
+      used[class_of[c]] = 1;
+    }
+    int next = 0;
+    for (int k = 0; k < number_of_classes; ++k) {
+      remap[k] = used[k] ? next++ : -1;
+    }
+    for (int c = 0; c < 256; ++c) {
+      class_of[c] = remap[class_of[c]];
+    }
+    number_of_classes = next;
+  }
+
+  regexp->number_of_classes = number_of_classes;
+  for (int c = 255; c >= 0; --c) {
+    regexp->byte_class[c] = (unsigned char)class_of[c];
+    regexp->class_representative[class_of[c]] = (unsigned char)c;
+  }
+}
+
+static void regexp_dfa_flush(RegexpDfa* dfa) {
+  dfa->number_of_states = 0;
+  dfa->inst_pool_used = 0;
+  dfa->start_states[0] = -1;
+  dfa->start_states[1] = -1;
+  memset(dfa->hash_table, 0xff, sizeof(dfa->hash_table));
+}
+
+static void regexp_dfa_deinit(RegexpDfa* dfa) {
+  free(dfa->transitions);
+  free(dfa->inst_pool);
+  free(dfa->sparse);
+  free(dfa->dense);
+  free(dfa->stack);
+  dfa->transitions = NULL;
+  dfa->inst_pool = NULL;
+  dfa->sparse = NULL;
+  dfa->dense = NULL;
+  dfa->stack = NULL;
+}
+
+static bool regexp_dfa_init(RegexpDfa* dfa,
+                            const Regexp* regexp,
+                            const RegexpProgram* program,
+                            bool unanchored) {
+  const int number_of_insts = program->number_of_insts;
+  dfa->program = program;
+  dfa->regexp = regexp;
+  dfa->unanchored = unanchored;
+  // one extra symbol marks the end of the text
+  dfa->number_of_symbols = regexp->number_of_classes + 1;
+  dfa->transitions =
+    malloc(sizeof(int) * REGEXP_DFA_MAX_STATES * dfa->number_of_symbols);
+  dfa->inst_pool_size = number_of_insts * 8 < 1024 ? 1024 : number_of_insts * 8;
+  dfa->inst_pool = malloc(sizeof(int) * dfa->inst_pool_size);
+  dfa->sparse = calloc(number_of_insts, sizeof(int));
+  dfa->dense = malloc(sizeof(int) * number_of_insts);
+  dfa->stack = malloc(sizeof(int) * (number_of_insts * 2 + 2));
+  if (dfa->transitions == NULL || dfa->inst_pool == NULL || dfa->sparse == NULL ||
+      dfa->dense == NULL || dfa->stack == NULL) {
+    regexp_dfa_deinit(dfa);
+    return false;
+  }
+  regexp_dfa_flush(dfa);
+  return true;
+}
+
+static void regexp_dfa_clear_set(RegexpDfa* dfa) {
+  dfa->dense_count = 0;
+}
+
+static bool regexp_dfa_set_insert(RegexpDfa* dfa, int pc) {
+  const int index = dfa->sparse[pc];
+  if (index >= 0 && index < dfa->dense_count && dfa->dense[index] == pc) {
+    return false;
+  }
+  dfa->sparse[pc] = dfa->dense_count;
+  dfa->dense[dfa->dense_count++] = pc;
+  return true;
+}
+
+// follows epsilon transitions, unresolved $ stays in the set until the end
+static void regexp_dfa_add_thread(RegexpDfa* dfa, int pc, bool at_bol, bool at_eol) {
+  const RegexpInst* insts = dfa->program->insts;
+  int top = 0;
+  dfa->stack[top++] = pc;
+  while (top > 0) {
+    pc = dfa->stack[--top];
+    if (!regexp_dfa_set_insert(dfa, pc)) {
+      continue;
+    }
+    const RegexpInst* inst = &insts[pc];
+    switch (inst->op) {
+      case RegexpOp_Jump:
+        dfa->stack[top++] = inst->x;
+        break;
+      case RegexpOp_Split:
+        dfa->stack[top++] = inst->y;
+        dfa->stack[top++] = inst->x;
+        break;
+      case RegexpOp_Bol:
+        if (at_bol) {
+          dfa->stack[top++] = pc + 1;
+        }
+        break;
+      case RegexpOp_Eol:
+        if (at_eol) {
+          dfa->stack[top++] = pc + 1;
+        }
+        break;
+      default:
+        break;
+    }
+  }
+}
+
+static int regexp_compare_ints(const void* a, const void* b) {
+  return *(const int*)a - *(const int*)b;
+}
+
+static unsigned regexp_hash_insts(const int* insts, int count) {
+  unsigned hash = 2166136261u;
+  for (int i = 0; i < count; ++i) {
+    hash = (hash ^ (unsigned)insts[i]) * 16777619u;
+  }
+  return hash;
+}
+
+// turns the scratch set into a cached state, -1 when the cache was flushed
+static int regexp_dfa_intern(RegexpDfa* dfa, bool* flushed) {
+  const RegexpInst* insts = dfa->program->insts;
+  // keep only instructions that matter for future steps
+  int count = 0;
+  bool match = false;
+  for (int i = 0; i < dfa->dense_count; ++i) {
+    const int pc = dfa->dense[i];
+    const RegexpOp op = insts[pc].op;
+    if (op == RegexpOp_Set || op == RegexpOp_Eol) {
+      dfa->dense[count++] = pc;
+    } else if (op == RegexpOp_Match) {
+      match = true;
+    }
+  }
+  qsort(dfa->dense, count, sizeof(int), regexp_compare_ints);
+  // match flag is a part of the state identity
+  const unsigned hash = regexp_hash_insts(dfa->dense, count) ^ (match ? 0x9e37u : 0);
+
+  const int mask = REGEXP_DFA_MAX_STATES * 2 - 1;
+  int slot = hash & mask;
+  while (dfa->hash_table[slot] >= 0) {
+    const RegexpDfaState* state = &dfa->states[dfa->hash_table[slot]];
+    if (state->number_of_insts == count && state->match == match &&
+        memcmp(state->insts, dfa->dense, sizeof(int) * count) == 0) {
+      return dfa->hash_table[slot];
+    }
+    slot = (slot + 1) & mask;
+  }
+
+  if (dfa->number_of_states == REGEXP_DFA_MAX_STATES ||
+      dfa->inst_pool_used + count > dfa->inst_pool_size) {
+    regexp_dfa_flush(dfa);
+    *flushed = true;
+    slot = hash & mask;
+  }
+
+  const int index = dfa->number_of_states++;
+  RegexpDfaState* state = &dfa->states[index];
+  state->insts = &dfa->inst_pool[dfa->inst_pool_used];
+  memcpy(state->insts, dfa->dense, sizeof(int) * count);
+  dfa->inst_pool_used += count;
+  state->number_of_insts = count;
+  state->match = match;
+  state->dead = count == 0 && !match;
+  for (int s = 0; s < dfa->number_of_symbols; ++s) {
+    dfa->transitions[index * dfa->number_of_symbols + s] = -1;
+  }
+  dfa->hash_table[slot] = index;
+  return index;
+}
+
+static int regexp_dfa_start(RegexpDfa* dfa, bool at_bol) {
+  int* start = &dfa->start_states[at_bol ? 1 : 0];
+  if (*start < 0) {
+    bool flushed = false;
+    regexp_dfa_clear_set(dfa);
+    regexp_dfa_add_thread(dfa, 0, at_bol, false);
+    *start = regexp_dfa_intern(dfa, &flushed);
+  }
+  return *start;
+}
+
+// symbol is a byte class or number_of_symbols - 1 for the end of the text
+static int regexp_dfa_step(RegexpDfa* dfa, int from, int symbol) {
+  int* transition = &dfa->transitions[from * dfa->number_of_symbols + symbol];
+  if (*transition >= 0) {
+    return *transition;
+  }
+
+  const RegexpInst* insts = dfa->program->insts;
+  const RegexpDfaState* state = &dfa->states[from];
+  const bool end_of_text = symbol == dfa->number_of_symbols - 1;
+  const unsigned char c = dfa->regexp->class_representative[symbol];
+
+  regexp_dfa_clear_set(dfa);
+  if (end_of_text && state->match) {
+    regexp_dfa_add_thread(dfa, dfa->program->number_of_insts - 1, false, false);
+  }
+  for (int i = 0; i < state->number_of_insts; ++i) {
+    const int pc = state->insts[i];
+    const RegexpInst* inst = &insts[pc];
+    if (end_of_text) {
+      if (inst->op == RegexpOp_Eol) {
+        regexp_dfa_add_thread(dfa, pc + 1, false, true);
+      }
+    } else if (inst->op == RegexpOp_Set &&
+               regexp_set_contains(dfa->regexp->sets[inst->x], c)) {
+      regexp_dfa_add_thread(dfa, pc + 1, false, false);
+    }
+  }
+  if (dfa->unanchored && !end_of_text) {
+    regexp_dfa_add_thread(dfa, 0, false, false);
+  }
+
+  bool flushed = false;
+  const int to = regexp_dfa_intern(dfa, &flushed);
+  if (!flushed) {
+    dfa->transitions[from * dfa->number_of_symbols + symbol] = to;
+  }
+  return to;
+}
+
+bool regexp_is_literal(const char* pattern) {
+  return strpbrk(pattern, ".*[^$\\") == NULL;
+}
+
+static void regexp_free_parts(Regexp* regexp) {
+  free(regexp->next_starts);
+  regexp_dfa_deinit(&regexp->forward_dfa);
+  regexp_dfa_deinit(&regexp->reverse_dfa);
+  free(regexp->forward.insts);
+  free(regexp->reverse.insts);
+  free(regexp->sets);
+}
+
+static bool regexp_init_dfas(Regexp* regexp) {
+  regexp->next_starts = malloc(sizeof(int) * (REGEXP_STARTS_WINDOW + 1));
+  regexp->scanned_to = -1;
+  if (regexp->next_starts == NULL) {
+    return false;
+  }
+  if (!regexp_dfa_init(&regexp->forward_dfa, regexp, &regexp->forward, false)) {
+    return false;
+  }
+  return regexp_dfa_init(&regexp->reverse_dfa, regexp, &regexp->reverse, true);
+}
+
+Regexp* regexp_compile(const char* pattern, const char** error) {
+  const int length = strlen(pattern);
+  // every character creates at most a set, a repeat and a concat node
+  const int max_nodes = length * 3 + 2;
+  RegexpParser parser = {
+    .pattern = pattern,
+    .position = 0,
+    .nodes = malloc(sizeof(RegexpNode) * max_nodes),
+    .number_of_nodes = 0,
+    .sets = malloc(sizeof(RegexpSet) * (length + 1)),
+    .number_of_sets = 0,
+    .error = NULL,
+  };
+  Regexp* regexp = calloc(1, sizeof(Regexp));
+  if (parser.nodes == NULL || parser.sets == NULL || regexp == NULL) {
+    free(parser.nodes);
+    free(parser.sets);
+    free(regexp);
+    *error = "Out of memory";
+    return NULL;
+  }
+
+  const int root = regexp_parse_alternate(&parser);
+  if (root >= 0 && pattern[parser.position] != '\0') {
+    parser.error = "Unmatched \\)";
+  }
+  if (parser.error != NULL || root < 0) {
+    *error = parser.error;
+    free(parser.nodes);
+    free(parser.sets);
+    free(regexp);
+    return NULL;
+  }
+
+  regexp->sets = parser.sets;
+  regexp->number_of_sets = parser.number_of_sets;
+  regexp_compute_byte_classes(regexp);
+  const bool compiled =
+    regexp_compile_program(&regexp->forward, parser.nodes, root,
+                           parser.number_of_nodes, false) &&
+    regexp_compile_program(&regexp->reverse, parser.nodes, root,
+                           parser.number_of_nodes, true) &&
+    regexp_init_dfas(regexp);
+  free(parser.nodes);
+  if (!compiled) {
+    regexp_free_parts(regexp);
+    free(regexp);
+    *error = "Out of memory";
+    return NULL;
+  }
+  return regexp;
+}
+
+static bool regexp_copy_program(RegexpProgram* to, const RegexpProgram* from) {
+  to->number_of_insts = from->number_of_insts;
+  to->insts = malloc(sizeof(RegexpInst) * from->number_of_insts);
+  if (to->insts == NULL) {
+    return false;
+  }
+  memcpy(to->insts, from->insts, sizeof(RegexpInst) * from->number_of_insts);
+  return true;
+}
+
+Regexp* regexp_clone(const Regexp* regexp) {
+  Regexp* clone = calloc(1, sizeof(Regexp));
+  if (clone == NULL) {
+    return NULL;
+  }
+  clone->number_of_sets = regexp->number_of_sets;
+  clone->number_of_classes = regexp->number_of_classes;
+  memcpy(clone->byte_class, regexp->byte_class, sizeof(clone->byte_class));
+  memcpy(clone->class_representative, regexp->class_representative,
+         sizeof(clone->class_representative));
+  clone->sets = malloc(sizeof(RegexpSet) * (regexp->number_of_sets + 1));
+  if (clone->sets == NULL || !regexp_copy_program(&clone->forward, &regexp->forward) ||
+      !regexp_copy_program(&clone->reverse, &regexp->reverse) ||
+      !regexp_init_dfas(clone)) {
+    regexp_free_parts(clone);
+    free(clone);
+    return NULL;
+  }
+  memcpy(clone->sets, regexp->sets, sizeof(RegexpSet) * regexp->number_of_sets);
+  return clone;
+}
+
+void regexp_free(Regexp* regexp) {
+  if (regexp == NULL) {
+    return;
+  }
+  regexp_free_parts(regexp);
+  free(regexp);
+}
+
+static int regexp_find_longest_end(Regexp* regexp,
+                                   const char* text,
+                                   int len,
+                                   int start) {
+  RegexpDfa* dfa = &regexp->forward_dfa;
+  int state = regexp_dfa_start(dfa, start == 0);
+  int end = dfa->states[state].match ? start : -1;
+  int i = start;
+  for (; i < len; ++i) {
+    state = regexp_dfa_step(dfa, state, regexp->byte_class[(unsigned char)text[i]]);
+    if (dfa->states[state].dead) {
+      return end;
+    }
+    if (dfa->states[state].match) {
+      end = i + 1;
+    }
+  }
+  state = regexp_dfa_step(dfa, state, dfa->number_of_symbols - 1);
+  if (dfa->states[state].match) {
+    end = len;
+  }
+  return end;
+}
+
+// one pass of the reversed pattern from the end of the text down to start
+// records the next match start of the positions in the window after start
+static void regexp_scan_starts(Regexp* regexp,
+                               const char* text,
+                               int len,
+                               int start) {
+  const int window_end =
+    len - start > REGEXP_STARTS_WINDOW ? start + REGEXP_STARTS_WINDOW : len;
+  int* next_starts = regexp->next_starts;
+  RegexpDfa* dfa = &regexp->reverse_dfa;
+  int state = regexp_dfa_start(dfa, true);
+  int next = dfa->states[state].match ? len : -1;
+  if (window_end == len) {
+    next_starts[len - start] = next;
+  }
+  for (int i = len - 1; i >= start; --i) {
+    state = regexp_dfa_step(dfa, state, regexp->byte_class[(unsigned char)text[i]]);
+    if (dfa->states[state].match) {
+      next = i;
+    }
+    if (i <= window_end) {
+      next_starts[i - start] = next;
+    }
+  }
+  // ^ may only match at the real start of the text
+  if (start == 0) {
+    state = regexp_dfa_step(dfa, state, dfa->number_of_symbols - 1);
+    if (dfa->states[state].match) {
+      next_starts[0] = 0;
+    }
+  }
+  regexp->scanned_from = start;
+  regexp->scanned_to = window_end;
+}
+
+static bool regexp_match_at(Regexp* regexp,
+                            const char* text,
+                            int len,
+                            int leftmost,
+                            RegexpMatch* match) {
+  if (leftmost < 0) {
+    return false;
+  }
+  const int end = regexp_find_longest_end(regexp, text, len, leftmost);
+  if (end < 0) {
+    return false;
+  }
+  match->start = leftmost;
+  match->length = end - leftmost;
+  return true;
+}
+
+bool regexp_search(Regexp* regexp,
+                   const char* text,
+                   int len,
+                   int start,
+                   RegexpMatch* match) {
+  if (regexp == NULL || start < 0 || start > len) {
+    return false;
+  }
+  regexp_scan_starts(regexp, text, len, start);
+  return regexp_match_at(regexp, text, len, regexp->next_starts[0], match);
+}
+
+bool regexp_search_next(Regexp* regexp,
+                        const char* text,
+                        int len,
+                        int start,
+                        RegexpMatch* match) {
+  if (regexp == NULL || start < 0 || start > len) {
+    return false;
+  }
+  if (start < regexp->scanned_from || start > regexp->scanned_to) {
+    // past the window of a long text
+    return regexp_search(regexp, text, len, start, match);
+  }
+  return regexp_match_at(regexp, text, len,
+                         regexp->next_starts[start - regexp->scanned_from], match);
+}
@@ -0,0 +1,71 @@
+/*
+ Copyright (c) 2025 Mateusz Stadnik
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+
+// Supported syntax (vi magic mode):
+//  .  [abc] [^a-z] [[:alpha:]]  \s \S \d \D \w \W  \t
+//  *  \+  \?  \=  \|  \( \)  ^ at the start, $ at the end of a branch
+// Patterns are compiled to a Thompson NFA which is executed by a lazily built
+// DFA, so matching is linear in the length of the text. All memory needed by
+// the matcher, the match start window included, is allocated by
+// regexp_compile() and regexp_clone().
+
+// number of DFA states kept before the cache is flushed
+#ifndef REGEXP_DFA_MAX_STATES
+#define REGEXP_DFA_MAX_STATES 64
+#endif
+
+// positions whose next match start is kept from one reverse scan, longer texts
+// are scanned again for every window of this size
+#ifndef REGEXP_STARTS_WINDOW
+#define REGEXP_STARTS_WINDOW 1024
+#endif
+
+typedef struct Regexp Regexp;
+
+typedef struct RegexpMatch {
+  int start;
+  int length;
+} RegexpMatch;
+
+// error is set to a static description when compilation fails
+Regexp* regexp_compile(const char* pattern, const char** error);
+// copy with an independent DFA cache, e.g. for other threads
+Regexp* regexp_clone(const Regexp* regexp);
+void regexp_free(Regexp* regexp);
+
+// true when pattern contains no special characters
+bool regexp_is_literal(const char* pattern);
+
+// leftmost-longest match starting at or after start, the match starts of the
+// text are kept for regexp_search_next
+bool regexp_search(Regexp* regexp,
+                   const char* text,
+                   int len,
+                   int start,
+                   RegexpMatch* match);
+// continues in the unchanged text of the last regexp_search with a start not
+// before the previous one, the match starts found then are reused so a whole
+// row is searched in linear time
+bool regexp_search_next(Regexp* regexp,
+                        const char* text,
+                        int len,
+                        int start,
+                        RegexpMatch* match);
@@ -0,0 +1,225 @@
+/*
+ Copyright (c) 2025 Mateusz Stadnik
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "search.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// bytes ordered from the most to the least frequent in source code and text,
+// everything not listed is treated as rare
+static const char byte_frequency_order[] =
+  " etaoinsrlcdhupmfgybw_v(),;=.k\t*x-\"/>0{}1TSEIRANCOLDP2<MF[]'&+:#qjBUzHGK!"
+  "W3Y48V5X69Z7JQ|%\\?@^~`$";
+
+#define SEARCH_PREFILTER_MIN_RANK 24
+
+static int search_byte_rank(unsigned char c) {
+  if (c == '\0') {
+    return sizeof(byte_frequency_order);
+  }
+  const char* position = strchr(byte_frequency_order, c);
+  if (position == NULL) {
+    return sizeof(byte_frequency_order);
+  }
+  return position - byte_frequency_order;
+}
+
+bool search_pattern_init(SearchPattern* pattern,
+                         const char* text,
+                         const char** error) {
+  pattern->regexp = NULL;
+  pattern->length = strlen(text);
+  pattern->pattern = malloc(pattern->length + 1);
+  if (pattern->pattern == NULL) {
+    pattern->length = 0;
+    *error = "Out of memory";
+    return false;
+  }
+  memcpy(pattern->pattern, text, pattern->length + 1);
+
+  if (!regexp_is_literal(text)) {
+    pattern->regexp = regexp_compile(text, error);
+    if (pattern->regexp == NULL) {
+      search_pattern_deinit(pattern);
+      return false;
+    }
+    return true;
+  }
+
+  for (int i = 0; i < 256; ++i) {
+    pattern->shift[i] = pattern->length;
+  }
+  for (int i = 0; i < pattern->length - 1; ++i) {
+    pattern->shift[(unsigned char)text[i]] = pattern->length - 1 - i;
+  }
+
+  int rarest_rank = -1;
+  pattern->rare_index = 0;
+  for (int i = 0; i < pattern->length; ++i) {
+    const int rank = search_byte_rank((unsigned char)text[i]);
+    if (rank > rarest_rank) {
+      rarest_rank = rank;
+      pattern->rare_index = i;
+    }
+  }
+  // memchr on a common byte stops too often, horspool skips better then
+  pattern->use_prefilter =
+    pattern->length < 3 || rarest_rank >= SEARCH_PREFILTER_MIN_RANK;
+  return true;
+}
+
+bool search_pattern_clone(SearchPattern* to, const SearchPattern* from) {
+  *to = *from;
+  to->regexp = NULL;
+  to->pattern = malloc(from->length + 1);
+  if (to->pattern == NULL) {
+    return false;
+  }
+  memcpy(to->pattern, from->pattern, from->length + 1);
+  if (from->regexp != NULL) {
+    to->regexp = regexp_clone(from->regexp);
+    if (to->regexp == NULL) {
+      search_pattern_deinit(to);
+      return false;
+    }
+  }
+  return true;
+}
+
+void search_pattern_deinit(SearchPattern* pattern) {
+  regexp_free(pattern->regexp);
+  pattern->regexp = NULL;
+  free(pattern->pattern);
+  pattern->pattern = NULL;
+  pattern->length = 0;
+}
+
+bool search_pattern_is_empty(const SearchPattern* pattern) {
+  return pattern->pattern == NULL || pattern->length == 0;
+}
+
+static int search_find_prefiltered(const SearchPattern* pattern,
+                                   const char* text,
+                                   int len,
+                                   int start) {
+  const int rare_index = pattern->rare_index;
+  const char rare = pattern->pattern[rare_index];
+  const int last_start = len - pattern->length;
+  int position = start;
+  while (position <= last_start) {
+    const char* hit = memchr(text + position + rare_index, rare,
+                             last_start - position + 1);
+    if (hit == NULL) {
+      return -1;
+    }
+    const int candidate = hit - text - rare_index;
+    if (memcmp(text + candidate, pattern->pattern, pattern->length) == 0) {
+      return candidate;
+    }
+    position = candidate + 1;
+  }
+  return -1;
+}
+
+static int search_find_horspool(const SearchPattern* pattern,
+                                 const char* text,
+                                 int len,
+                                 int start) {
+  const int last = pattern->length - 1;
+  const char last_char = pattern->pattern[last];
+  int position = start;
+  while (position + last < len) {
+    const char c = text[position + last];
+    if (c == last_char && memcmp(text + position, pattern->pattern, last) == 0) {
+      return position;
+    }
+    position += pattern->shift[(unsigned char)c];
+  }
+  return -1;
+}
+
+bool search_find_forward(const SearchPattern* pattern,
+                         const char* text,
+                         int len,
+                         int start,
+                         SearchMatch* match) {
+  if (pattern->regexp != NULL) {
+    RegexpMatch regexp_match;
+    if (!regexp_search(pattern->regexp, text, len, start, &regexp_match)) {
+      return false;
+    }
+    match->start = regexp_match.start;
+    match->length = regexp_match.length;
+    return true;
+  }
+  if (search_pattern_is_empty(pattern) || start < 0 ||
+      start + pattern->length > len) {
+    return false;
+  }
+
+  const int found = pattern->use_prefilter
+                      ? search_find_prefiltered(pattern, text, len, start)
+                      : search_find_horspool(pattern, text, len, start);
+  if (found < 0) {
+    return false;
+  }
+  match->start = found;
+  match->length = pattern->length;
+  return true;
+}
+
+bool search_find_next(const SearchPattern* pattern,
+                      const char* text,
+                      int len,
+                      int start,
+                      SearchMatch* match) {
+  if (pattern->regexp == NULL) {
+    return search_find_forward(pattern, text, len, start, match);
+  }
+  RegexpMatch regexp_match;
+  if (!regexp_search_next(pattern->regexp, text, len, start, &regexp_match)) {
+    return false;
+  }
+  match->start = regexp_match.start;
+  match->length = regexp_match.length;
+  return true;
+}
+
+bool search_find_backward(const SearchPattern* pattern,
+                          const char* text,
+                          int len,
+                          int end,
+                          SearchMatch* match) {
+  if (search_pattern_is_empty(pattern)) {
+    return false;
+  }
+  if (end > len) {
+    end = len;
+  }
+
+  bool found = false;
+  SearchMatch candidate;
+  bool searched = search_find_forward(pattern, text, len, 0, &candidate);
+  while (searched && candidate.start < end) {
+    *match = candidate;
+    found = true;
+    searched = candidate.start + 1 <= len &&
+               search_find_next(pattern, text, len, candidate.start + 1, &candidate);
+  }
+  return found;
+}
@@ -0,0 +1,68 @@
+/*
+ Copyright (c) 2025 Mateusz Stadnik
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+
+#include "regexp.h"
+
+typedef struct SearchPattern {
+  char* pattern;
+  int length;
+  // Boyer-Moore-Horspool shift table
+  int shift[256];
+  // least frequent byte of the pattern, used to prefilter with memchr
+  int rare_index;
+  bool use_prefilter;
+  // NULL for literal patterns
+  Regexp* regexp;
+} SearchPattern;
+
+typedef struct SearchMatch {
+  int start;
+  int length;
+} SearchMatch;
+
+// error describes why the pattern could not be compiled
+bool search_pattern_init(SearchPattern* pattern,
+                         const char* text,
+                         const char** error);
+// copy with its own matcher state, e.g. for other threads
+bool search_pattern_clone(SearchPattern* to, const SearchPattern* from);
+void search_pattern_deinit(SearchPattern* pattern);
+bool search_pattern_is_empty(const SearchPattern* pattern);
+
+// first match starting at or after start
+bool search_find_forward(const SearchPattern* pattern,
+                         const char* text,
+                         int len,
+                         int start,
+                         SearchMatch* match);
+// next match in the unchanged text of the last search_find_forward with the
+// pattern, start is not before the previous one
+bool search_find_next(const SearchPattern* pattern,
+                      const char* text,
+                      int len,
+                      int start,
+                      SearchMatch* match);
+// last match starting before end
+bool search_find_backward(const SearchPattern* pattern,
+                          const char* text,
+                          int len,
+                          int end,
+                          SearchMatch* match);
@@ -0,0 +1,283 @@
+/*
+ Copyright (c) 2025 Mateusz Stadnik
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include "shell.h"
+
+#include <stddef.h>
+
+#ifdef YASVI_SHELL
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// milliseconds of waiting before poll is called, it is also called after
+// every few blocks while a lot of output keeps arriving
+#define SHELL_POLL_INTERVAL 10
+#define SHELL_POLL_BLOCKS 64
+// milliseconds an interrupted command gets to exit after SIGTERM before it is
+// killed
+#define SHELL_KILL_TIMEOUT 500
+
+// rows not written yet, offset is the position in row, row->len when only its
+// newline is left
+typedef struct ShellInput {
+  BufferRow* row;
+  int remaining;
+  int offset;
+} ShellInput;
+
+static pid_t shell_spawn(const char* command, int input, int output) {
+  const pid_t pid = fork();
+  if (pid != 0) {
+    return pid;
+  }
+  // the editor ignores SIGPIPE while writing, the command must not
+  signal(SIGPIPE, SIG_DFL);
+  if (dup2(input, STDIN_FILENO) < 0 || dup2(output, STDOUT_FILENO) < 0 ||
+      dup2(output, STDERR_FILENO) < 0) {
+    _exit(127);
+  }
+  if (input != STDIN_FILENO) {
+    close(input);
+  }
+  if (output != STDOUT_FILENO && output != STDERR_FILENO) {
+    close(output);
+  }
+  execl("/bin/sh", "sh", "-c", command, (char*)NULL);
+  _exit(127);
+}
+
+// writes as many rows as the pipe takes with one writev, the rows and their
+// newlines are not copied. Returns false when the command stopped reading.
+static bool shell_write_rows(int fd, ShellInput* input) {
+  static const char newline = '\n';
+  struct iovec vectors[SHELL_ROWS_PER_WRITE * 2];
+  int number_of_vectors = 0;
+  const BufferRow* row = input->row;
+  int offset = input->offset;
+  for (int i = 0; i < input->remaining && i < SHELL_ROWS_PER_WRITE; ++i) {
+    if (offset < row->len) {
+      vectors[number_of_vectors].iov_base = &row->data[offset];
+      vectors[number_of_vectors].iov_len = row->len - offset;
+      ++number_of_vectors;
+    }
+    vectors[number_of_vectors].iov_base = (void*)&newline;
+    vectors[number_of_vectors].iov_len = 1;
+    ++number_of_vectors;
+    row = row->next;
+    offset = 0;
+  }
+  ssize_t written = writev(fd, vectors, number_of_vectors);
+  if (written < 0) {
+    return errno == EAGAIN || errno == EINTR;
+  }
+  while (written > 0) {
+    const int left = input->row->len - input->offset + 1;
+    if (written < left) {
+      input->offset += (int)written;
+      break;
+    }
+    written -= left;
+    input->row = input->row->next;
+    input->offset = 0;
+    --input->remaining;
+  }
+  return true;
+}
+
+static bool shell_run(int input_fd,
+                      int output_fd,
+                      ShellInput* input,
+                      LineSplitter* output,
+                      ShellPoll poll_callback,
+                      void* poll_context,
+                      const char** error) {
+  char* block = malloc(LINE_SPLITTER_BLOCK_SIZE);
+  if (block == NULL) {
+    *error = "Out of memory";
+    return false;
+  }
+  bool result = true;
+  int iterations = 0;
+  while (output_fd >= 0) {
+    if (input_fd >= 0 && input->remaining == 0) {
+      // end of input, e.g. sort starts writing only now
+      close(input_fd);
+      input_fd = -1;
+    }
+    struct pollfd fds[2];
+    int number_of_fds = 0;
+    fds[number_of_fds].fd = output_fd;
+    fds[number_of_fds++].events = POLLIN;
+    if (input_fd >= 0) {
+      fds[number_of_fds].fd = input_fd;
+      fds[number_of_fds++].events = POLLOUT;
+    }
+    const int ready = poll(fds, number_of_fds, SHELL_POLL_INTERVAL);
+    if (ready < 0 && errno != EINTR) {
+      *error = "Can't wait for the command";
+      result = false;
+      break;
+    }
+    if ((ready <= 0 || ++iterations % SHELL_POLL_BLOCKS == 0) &&
+        poll_callback != NULL && !poll_callback(poll_context)) {
+      *error = "Interrupted";
+      result = false;
+      break;
+    }
+    if (ready <= 0) {
+      continue;
+    }
+    if (number_of_fds > 1 && (fds[1].revents & (POLLOUT | POLLERR | POLLHUP))) {
+      if (!shell_write_rows(input_fd, input)) {
+        // the command exited or closed its input, what it printed is kept
+        input->remaining = 0;
+      }
+    }
+    if (fds[0].revents & (POLLIN | POLLERR | POLLHUP)) {
+      const ssize_t length = read(output_fd, block, LINE_SPLITTER_BLOCK_SIZE);
+      if (length < 0 && errno != EAGAIN && errno != EINTR) {
+        *error = "Can't read the command output";
+        result = false;
+        break;
+      }
+      if (length == 0) {
+        close(output_fd);
+        output_fd = -1;
+      } else if (length > 0 && !line_splitter_feed(output, block, length)) {
+        *error = "Out of memory";
+        result = false;
+        break;
+      }
+    }
+  }
+  if (input_fd >= 0) {
+    close(input_fd);
+  }
+  if (output_fd >= 0) {
+    close(output_fd);
+  }
+  free(block);
+  return result;
+}
+
+// a stopped command gets SIGTERM first, one ignoring it is killed after a while
+static int shell_wait(pid_t pid, bool stop) {
+  int wait_status = 0;
+  if (stop) {
+    kill(pid, SIGTERM);
+    for (int waited = 0; waited < SHELL_KILL_TIMEOUT;
+         waited += SHELL_POLL_INTERVAL) {
+      const pid_t exited = waitpid(pid, &wait_status, WNOHANG);
+      if (exited == pid || (exited < 0 && errno != EINTR)) {
+        return wait_status;
+      }
+      poll(NULL, 0, SHELL_POLL_INTERVAL);
+    }
+    kill(pid, SIGKILL);
+  }
+  while (waitpid(pid, &wait_status, 0) < 0 && errno == EINTR) {
+  }
+  return wait_status;
+}
+
+bool shell_filter_rows(const char* command,
+                       BufferRow* first,
+                       int count,
+                       LineSplitter* output,
+                       ShellPoll poll,
+                       void* poll_context,
+                       int* status,
+                       const char** error) {
+  int input_pipe[2];
+  int output_pipe[2];
+  if (pipe(input_pipe) != 0) {
+    *error = "Can't create a pipe";
+    return false;
+  }
+  if (pipe(output_pipe) != 0) {
+    close(input_pipe[0]);
+    close(input_pipe[1]);
+    *error = "Can't create a pipe";
+    return false;
+  }
+  // ends kept by the editor must not leak into the command
+  fcntl(input_pipe[1], F_SETFD, FD_CLOEXEC);
+  fcntl(output_pipe[0], F_SETFD, FD_CLOEXEC);
+  fcntl(input_pipe[1], F_SETFL, O_NONBLOCK);
+  fcntl(output_pipe[0], F_SETFL, O_NONBLOCK);
+
+  // writing to a command which exited fails with EPIPE instead
+  struct sigaction ignore;
+  struct sigaction previous;
+  memset(&ignore, 0, sizeof(ignore));
+  ignore.sa_handler = SIG_IGN;
+  sigaction(SIGPIPE, &ignore, &previous);
+
+  const pid_t pid = shell_spawn(command, input_pipe[0], output_pipe[1]);
+  close(input_pipe[0]);
+  close(output_pipe[1]);
+  bool result = false;
+  if (pid < 0) {
+    close(input_pipe[1]);
+    close(output_pipe[0]);
+    *error = "Can't start the command";
+  } else {
+    ShellInput input = {first, first != NULL ? count : 0, 0};
+    result = shell_run(input_pipe[1], output_pipe[0], &input, output, poll,
+                       poll_context, error);
+    const int wait_status = shell_wait(pid, !result);
+    *status = WIFEXITED(wait_status) ? WEXITSTATUS(wait_status) : -1;
+    if (result && !line_splitter_finish(output)) {
+      *error = "Out of memory";
+      result = false;
+    }
+  }
+  sigaction(SIGPIPE, &previous, NULL);
+  return result;
+}
+
+#else
+
+bool shell_filter_rows(const char* command,
+                       BufferRow* first,
+                       int count,
+                       LineSplitter* output,
+                       ShellPoll poll,
+                       void* poll_context,
+                       int* status,
+                       const char** error) {
+  (void)command;
+  (void)first;
+  (void)count;
+  (void)output;
+  (void)poll;
+  (void)poll_context;
+  (void)status;
+  *error = "Shell commands are not supported";
+  return false;
+}
+
+#endif
@@ -0,0 +1,42 @@
+/*
+ Copyright (c) 2025 Mateusz Stadnik
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <stdbool.h>
+
+#include "buffer_row.h"
+#include "line_splitter.h"
+
+// rows written to the command at once
+#define SHELL_ROWS_PER_WRITE 512
+
+// called every few milliseconds while the command runs, false kills it
+typedef bool (*ShellPoll)(void* context);
+
+// runs command with /bin/sh, writing count rows from first to its input and
+// splitting everything it prints, standard error included, into output. Input
+// and output are multiplexed with poll() so neither side can block the other.
+// Returns false with error set when the command could not run or poll stopped
+// it, otherwise status is its exit status.
+bool shell_filter_rows(const char* command,
+                       BufferRow* first,
+                       int count,
+                       LineSplitter* output,
+                       ShellPoll poll,
+                       void* poll_context,
+                       int* status,
+                       const char** error);
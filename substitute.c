@@ -0,0 +1,456 @@
+/*
+ Copyright (c) 2025 Mateusz Stadnik
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "substitute.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define SUBSTITUTE_INITIAL_MATCHES 16
+#define SUBSTITUTE_MIN_CHUNK_ROWS 4096
+// chunks per thread, smaller chunks balance uneven rows better
+#define SUBSTITUTE_CHUNKS_PER_THREAD 8
+// rows processed between cancellation checks
+#define SUBSTITUTE_CANCEL_CHECK_ROWS 1024
+
+typedef struct SubstituteChange {
+  BufferRow* row;
+  char* data;
+  int len;
+} SubstituteChange;
+
+typedef struct SubstituteChunk {
+  BufferRow* first;
+  int first_index;
+  int count;
+  SubstituteChange* changes;
+  int number_of_changes;
+  int changes_capacity;
+  SubstituteResult result;
+} SubstituteChunk;
+
+typedef struct SubstituteJob {
+  SubstituteChunk* chunks;
+  // one substitution per worker thread
+  Substitution* substitutions;
+  WorkerPool* pool;
+} SubstituteJob;
+
+// false with error set when the replacement can not be applied
+static bool substitution_parse_replacement(Substitution* substitution,
+                                           const char* replacement,
+                                           const char** error) {
+  const int length = strlen(replacement);
+  substitution->replacement = malloc(length + 1);
+  substitution->match_references = malloc(sizeof(int) * (length + 1));
+  if (substitution->replacement == NULL || substitution->match_references == NULL) {
+    *error = "Out of memory";
+    return false;
+  }
+
+  int out = 0;
+  for (int i = 0; i < length; ++i) {
+    char c = replacement[i];
+    if (c == '&') {
+      substitution->match_references[substitution->number_of_references++] = out;
+      continue;
+    }
+    if (c == '\\' && i + 1 < length) {
+      c = replacement[++i];
+      if (c == '0') {
+        substitution->match_references[substitution->number_of_references++] = out;
+        continue;
+      }
+      // the regexps have no groups to refer to
+      if (c >= '1' && c <= '9') {
+        *error = "No capture groups";
+        return false;
+      }
+      // rows are replaced one by one, never split
+      if (c == 'n' || c == 'r') {
+        *error = "Line breaks in the replacement are not supported";
+        return false;
+      }
+      if (c == 't') {
+        c = '\t';
+      }
+    }
+    substitution->replacement[out++] = c;
+  }
+  substitution->replacement[out] = '\0';
+  substitution->replacement_length = out;
+  return true;
+}
+
+bool substitution_init(Substitution* substitution,
+                       const char* pattern,
+                       const char* replacement,
+                       const char* flags,
+                       const char** error) {
+  memset(substitution, 0, sizeof(Substitution));
+  for (const char* flag = flags; *flag != '\0'; ++flag) {
+    switch (*flag) {
+      case 'g':
+        substitution->global = true;
+        break;
+      case 'n':
+        substitution->count_only = true;
+        break;
+      case ' ':
+        break;
+      default:
+        *error = "Trailing characters";
+        return false;
+    }
+  }
+
+  if (!search_pattern_init(&substitution->pattern, pattern, error)) {
+    return false;
+  }
+  substitution->matches =
+    malloc(sizeof(SearchMatch) * SUBSTITUTE_INITIAL_MATCHES);
+  substitution->matches_capacity = SUBSTITUTE_INITIAL_MATCHES;
+  if (substitution->matches == NULL) {
+    substitution_deinit(substitution);
+    *error = "Out of memory";
+    return false;
+  }
+  if (!substitution_parse_replacement(substitution, replacement, error)) {
+    substitution_deinit(substitution);
+    return false;
+  }
+  return true;
+}
+
+bool substitution_clone(Substitution* to, const Substitution* from) {
+  memset(to, 0, sizeof(Substitution));
+  to->global = from->global;
+  to->count_only = from->count_only;
+  to->replacement_length = from->replacement_length;
+  to->number_of_references = from->number_of_references;
+  to->replacement = malloc(from->replacement_length + 1);
+  to->match_references = malloc(sizeof(int) * (from->number_of_references + 1));
+  to->matches = malloc(sizeof(SearchMatch) * SUBSTITUTE_INITIAL_MATCHES);
+  to->matches_capacity = SUBSTITUTE_INITIAL_MATCHES;
+  if (to->replacement == NULL || to->match_references == NULL ||
+      to->matches == NULL || !search_pattern_clone(&to->pattern, &from->pattern)) {
+    substitution_deinit(to);
+    return false;
+  }
+  memcpy(to->replacement, from->replacement, from->replacement_length + 1);
+  memcpy(to->match_references, from->match_references,
+         sizeof(int) * from->number_of_references);
+  return true;
+}
+
+void substitution_deinit(Substitution* substitution) {
+  search_pattern_deinit(&substitution->pattern);
+  free(substitution->replacement);
+  free(substitution->match_references);
+  free(substitution->matches);
+  substitution->replacement = NULL;
+  substitution->match_references = NULL;
+  substitution->matches = NULL;
+  substitution->matches_capacity = 0;
+}
+
+static bool substitution_push_match(Substitution* substitution,
+                                    int index,
+                                    const SearchMatch* match) {
+  if (index == substitution->matches_capacity) {
+    const int capacity = substitution->matches_capacity * 2;
+    SearchMatch* matches =
+      realloc(substitution->matches, sizeof(SearchMatch) * capacity);
+    if (matches == NULL) {
+      return false;
+    }
+    substitution->matches = matches;
+    substitution->matches_capacity = capacity;
+  }
+  substitution->matches[index] = *match;
+  return true;
+}
+
+// collects matches of the row, an empty match right after a previous match
+// is skipped like in vi
+static int substitution_find_matches(Substitution* substitution,
+                                     const char* data,
+                                     int len) {
+  int number_of_matches = 0;
+  const SearchPattern* pattern = &substitution->pattern;
+  int position = 0;
+  int previous_end = -1;
+  SearchMatch match;
+  // the row is searched once, later matches reuse the first search
+  for (bool found = search_find_forward(pattern, data, len, 0, &match); found;
+       found = position <= len &&
+               search_find_next(pattern, data, len, position, &match)) {
+    if (match.length == 0 && match.start == previous_end) {
+      position = match.start + 1;
+      continue;
+    }
+    if (!substitution_push_match(substitution, number_of_matches, &match)) {
+      break;
+    }
+    ++number_of_matches;
+    if (!substitution->global) {
+      break;
+    }
+    previous_end = match.start + match.length;
+    position = match.length > 0 ? previous_end : match.start + 1;
+  }
+  return number_of_matches;
+}
+
+static int substitution_replacement_length(const Substitution* substitution,
+                                           const SearchMatch* match) {
+  return substitution->replacement_length +
+         substitution->number_of_references * match->length;
+}
+
+static char* substitution_write_replacement(const Substitution* substitution,
+                                            char* out,
+                                            const char* data,
+                                            const SearchMatch* match) {
+  int copied = 0;
+  for (int i = 0; i < substitution->number_of_references; ++i) {
+    const int reference = substitution->match_references[i];
+    memcpy(out, substitution->replacement + copied, reference - copied);
+    out += reference - copied;
+    copied = reference;
+    memcpy(out, data + match->start, match->length);
+    out += match->length;
+  }
+  memcpy(out, substitution->replacement + copied,
+         substitution->replacement_length - copied);
+  return out + substitution->replacement_length - copied;
+}
+
+int substitution_build_row(Substitution* substitution,
+                           const char* data,
+                           int len,
+                           char** new_data,
+                           int* new_len) {
+  *new_data = NULL;
+  const int number_of_matches = substitution_find_matches(substitution, data, len);
+  if (number_of_matches == 0 || substitution->count_only) {
+    return number_of_matches;
+  }
+
+  int length = len;
+  for (int i = 0; i < number_of_matches; ++i) {
+    const SearchMatch* match = &substitution->matches[i];
+    length += substitution_replacement_length(substitution, match) - match->length;
+  }
+
+  char* result = malloc(length + 1);
+  if (result == NULL) {
+    return 0;
+  }
+  char* out = result;
+  int copied = 0;
+  for (int i = 0; i < number_of_matches; ++i) {
+    const SearchMatch* match = &substitution->matches[i];
+    memcpy(out, data + copied, match->start - copied);
+    out += match->start - copied;
+    out = substitution_write_replacement(substitution, out, data, match);
+    copied = match->start + match->length;
+  }
+  memcpy(out, data + copied, len - copied);
+  result[length] = '\0';
+
+  *new_data = result;
+  *new_len = length;
+  return number_of_matches;
+}
+
+void substitute_rows(Substitution* substitution,
+                     BufferRow* first,
+                     int count,
+                     SubstituteResult* result) {
+  result->substitutions = 0;
+  result->changed_rows = 0;
+  result->last_changed_row = -1;
+
+  BufferRow* row = first;
+  for (int i = 0; i < count && row != NULL; ++i, row = row->next) {
+    char* new_data = NULL;
+    int new_len = 0;
+    const int substitutions = substitution_build_row(substitution, row->data,
+                                                     row->len, &new_data, &new_len);
+    if (substitutions == 0) {
+      continue;
+    }
+    result->substitutions += substitutions;
+    result->changed_rows++;
+    result->last_changed_row = i;
+    if (new_data != NULL) {
+      buffer_row_set_data(row, new_data, new_len, new_len + 1);
+      buffer_row_highlight_line(row);
+    }
+  }
+}
+
+static bool substitute_chunk_push_change(SubstituteChunk* chunk,
+                                         BufferRow* row,
+                                         char* data,
+                                         int len) {
+  if (chunk->number_of_changes == chunk->changes_capacity) {
+    const int capacity = chunk->changes_capacity ? chunk->changes_capacity * 2 : 64;
+    SubstituteChange* changes =
+      realloc(chunk->changes, sizeof(SubstituteChange) * capacity);
+    if (changes == NULL) {
+      return false;
+    }
+    chunk->changes = changes;
+    chunk->changes_capacity = capacity;
+  }
+  SubstituteChange* change = &chunk->changes[chunk->number_of_changes++];
+  change->row = row;
+  change->data = data;
+  change->len = len;
+  return true;
+}
+
+// runs on a worker thread, rows are only read here
+static void substitute_chunk_task(void* context, int index, int worker) {
+  SubstituteJob* job = context;
+  SubstituteChunk* chunk = &job->chunks[index];
+  Substitution* substitution = &job->substitutions[worker];
+  SubstituteResult* result = &chunk->result;
+
+  BufferRow* row = chunk->first;
+  for (int i = 0; i < chunk->count; ++i, row = row->next) {
+    if (i % SUBSTITUTE_CANCEL_CHECK_ROWS == 0 &&
+        worker_pool_is_cancelled(job->pool)) {
+      return;
+    }
+    char* new_data = NULL;
+    int new_len = 0;
+    const int substitutions = substitution_build_row(substitution, row->data,
+                                                     row->len, &new_data, &new_len);
+    if (substitutions == 0) {
+      continue;
+    }
+    if (new_data != NULL && !substitute_chunk_push_change(chunk, row, new_data,
+                                                          new_len)) {
+      free(new_data);
+      continue;
+    }
+    result->substitutions += substitutions;
+    result->changed_rows++;
+    result->last_changed_row = chunk->first_index + i;
+  }
+}
+
+static void substitute_free_chunks(SubstituteChunk* chunks,
+                                   int number_of_chunks,
+                                   bool free_data) {
+  for (int c = 0; c < number_of_chunks; ++c) {
+    if (free_data) {
+      for (int i = 0; i < chunks[c].number_of_changes; ++i) {
+        free(chunks[c].changes[i].data);
+      }
+    }
+    free(chunks[c].changes);
+  }
+  free(chunks);
+}
+
+bool substitute_rows_parallel(Substitution* substitution,
+                              WorkerPool* pool,
+                              BufferRow* first,
+                              int count,
+                              WorkerPoolPoll poll,
+                              void* poll_context,
+                              SubstituteResult* result) {
+  result->substitutions = 0;
+  result->changed_rows = 0;
+  result->last_changed_row = -1;
+
+  const int number_of_threads = worker_pool_get_number_of_threads(pool);
+  int chunk_rows = count / (number_of_threads * SUBSTITUTE_CHUNKS_PER_THREAD);
+  if (chunk_rows < SUBSTITUTE_MIN_CHUNK_ROWS) {
+    chunk_rows = SUBSTITUTE_MIN_CHUNK_ROWS;
+  }
+  const int number_of_chunks = (count + chunk_rows - 1) / chunk_rows;
+  SubstituteJob job = {
+    .chunks = calloc(number_of_chunks, sizeof(SubstituteChunk)),
+    .substitutions = calloc(number_of_threads, sizeof(Substitution)),
+    .pool = pool,
+  };
+  int number_of_clones = 0;
+  if (job.chunks != NULL && job.substitutions != NULL) {
+    while (number_of_clones < number_of_threads &&
+           substitution_clone(&job.substitutions[number_of_clones], substitution)) {
+      ++number_of_clones;
+    }
+  }
+  if (number_of_clones < number_of_threads) {
+    for (int i = 0; i < number_of_clones; ++i) {
+      substitution_deinit(&job.substitutions[i]);
+    }
+    free(job.chunks);
+    free(job.substitutions);
+    // not enough memory for the parallel run, fall back to a single pass
+    substitute_rows(substitution, first, count, result);
+    return true;
+  }
+
+  // one walk over the list to find where every chunk starts
+  BufferRow* row = first;
+  int number_of_rows = 0;
+  for (int c = 0; c < number_of_chunks; ++c) {
+    SubstituteChunk* chunk = &job.chunks[c];
+    chunk->first = row;
+    chunk->first_index = number_of_rows;
+    chunk->result.last_changed_row = -1;
+    while (row != NULL && chunk->count < chunk_rows && number_of_rows < count) {
+      row = row->next;
+      ++chunk->count;
+      ++number_of_rows;
+    }
+  }
+
+  const bool completed = worker_pool_run(pool, substitute_chunk_task, &job,
+                                         number_of_chunks, poll, poll_context);
+  for (int i = 0; i < number_of_threads; ++i) {
+    substitution_deinit(&job.substitutions[i]);
+  }
+  free(job.substitutions);
+  if (!completed) {
+    substitute_free_chunks(job.chunks, number_of_chunks, true);
+    return false;
+  }
+
+  // stitch the chunks in order, highlighting depends on the previous row
+  for (int c = 0; c < number_of_chunks; ++c) {
+    SubstituteChunk* chunk = &job.chunks[c];
+    for (int i = 0; i < chunk->number_of_changes; ++i) {
+      SubstituteChange* change = &chunk->changes[i];
+      buffer_row_set_data(change->row, change->data, change->len, change->len + 1);
+      buffer_row_highlight_line(change->row);
+    }
+    result->substitutions += chunk->result.substitutions;
+    result->changed_rows += chunk->result.changed_rows;
+    if (chunk->result.last_changed_row >= 0) {
+      result->last_changed_row = chunk->result.last_changed_row;
+    }
+  }
+  substitute_free_chunks(job.chunks, number_of_chunks, false);
+  return true;
+}
@@ -0,0 +1,81 @@
+/*
+ Copyright (c) 2025 Mateusz Stadnik
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+
+#include "buffer_row.h"
+#include "search.h"
+#include "worker_pool.h"
+
+typedef struct Substitution {
+  SearchPattern pattern;
+  // replacement with escapes resolved, & is inserted at match_references
+  char* replacement;
+  int replacement_length;
+  int* match_references;
+  int number_of_references;
+  // g flag
+  bool global;
+  // n flag, matches are only counted
+  bool count_only;
+  // match positions of the current row, reused between rows
+  SearchMatch* matches;
+  int matches_capacity;
+} Substitution;
+
+typedef struct SubstituteResult {
+  int substitutions;
+  int changed_rows;
+  // index relative to the first row, -1 when nothing was changed
+  int last_changed_row;
+} SubstituteResult;
+
+bool substitution_init(Substitution* substitution,
+                       const char* pattern,
+                       const char* replacement,
+                       const char* flags,
+                       const char** error);
+// copy with independent scratch space for another thread
+bool substitution_clone(Substitution* to, const Substitution* from);
+void substitution_deinit(Substitution* substitution);
+
+// builds the new row contents in a single allocation of the exact size,
+// new_data is NULL when the row has no match
+int substitution_build_row(Substitution* substitution,
+                           const char* data,
+                           int len,
+                           char** new_data,
+                           int* new_len);
+
+// rewrites count rows starting from first, every changed row is highlighted once
+void substitute_rows(Substitution* substitution,
+                     BufferRow* first,
+                     int count,
+                     SubstituteResult* result);
+
+// rows are split into chunks which the pool rewrites off the row list, the
+// results are applied in order on the calling thread, nothing is changed when
+// poll cancels the run
+bool substitute_rows_parallel(Substitution* substitution,
+                              WorkerPool* pool,
+                              BufferRow* first,
+                              int count,
+                              WorkerPoolPoll poll,
+                              void* poll_context,
+                              SubstituteResult* result);
@@ -0,0 +1,469 @@
+/*
+ Copyright (c) 2025 Mateusz Stadnik
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include "tags.h"
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef YASVI_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define TAG_FILE_HEADER "!_TAG_"
+#define TAG_FILE_SORTED_HEADER "!_TAG_FILE_SORTED\t"
+
+#ifdef YASVI_MMAP
+static bool tag_file_map(TagFile* file, const char* filename) {
+  const int descriptor = open(filename, O_RDONLY);
+  if (descriptor < 0) {
+    return false;
+  }
+  struct stat status;
+  if (fstat(descriptor, &status) != 0) {
+    close(descriptor);
+    return false;
+  }
+  file->size = (size_t)status.st_size;
+  file->data = NULL;
+  if (file->size > 0) {
+    void* data = mmap(NULL, file->size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+    if (data == MAP_FAILED) {
+      close(descriptor);
+      return false;
+    }
+    // lookups touch a few pages spread over the whole file
+    posix_madvise(data, file->size, POSIX_MADV_RANDOM);
+    file->data = data;
+  }
+  // the mapping stays valid without the descriptor
+  close(descriptor);
+  return true;
+}
+
+// line starting at offset without the '\n', NULL past the end of the file
+static const char* tag_file_get_line(TagFile* file, size_t offset, size_t* length) {
+  if (offset >= file->size) {
+    return NULL;
+  }
+  const char* line = file->data + offset;
+  const char* end = memchr(line, '\n', file->size - offset);
+  *length = end != NULL ? (size_t)(end - line) : file->size - offset;
+  return line;
+}
+#else
+static bool tag_file_reserve_line(TagFile* file, size_t size) {
+  if (size <= file->line_capacity) {
+    return true;
+  }
+  size_t capacity = file->line_capacity ? file->line_capacity * 2 : 256;
+  while (capacity < size) {
+    capacity *= 2;
+  }
+  char* line = realloc(file->line, capacity);
+  if (line == NULL) {
+    return false;
+  }
+  file->line = line;
+  file->line_capacity = capacity;
+  return true;
+}
+
+static bool tag_file_map(TagFile* file, const char* filename) {
+  file->file = fopen(filename, "r");
+  if (file->file == NULL) {
+    return false;
+  }
+  file->blocks = malloc(sizeof(TagFileBlock) * TAG_FILE_NUMBER_OF_BLOCKS);
+  if (file->blocks == NULL || fseek(file->file, 0, SEEK_END) != 0) {
+    free(file->blocks);
+    fclose(file->file);
+    return false;
+  }
+  file->size = (size_t)ftell(file->file);
+  file->age = 0;
+  for (int i = 0; i < TAG_FILE_NUMBER_OF_BLOCKS; ++i) {
+    file->blocks[i].index = -1;
+    file->blocks[i].age = 0;
+  }
+  return true;
+}
+
+// reads the block through the cache, NULL if it can not be read
+static const TagFileBlock* tag_file_get_block(TagFile* file, long index) {
+  TagFileBlock* oldest = &file->blocks[0];
+  for (int i = 0; i < TAG_FILE_NUMBER_OF_BLOCKS; ++i) {
+    TagFileBlock* block = &file->blocks[i];
+    if (block->index == index) {
+      block->age = ++file->age;
+      return block;
+    }
+    if (block->age < oldest->age) {
+      oldest = block;
+    }
+  }
+  oldest->index = -1;
+  if (fseek(file->file, index * TAG_FILE_BLOCK_SIZE, SEEK_SET) != 0) {
+    return NULL;
+  }
+  const size_t read = fread(oldest->data, 1, TAG_FILE_BLOCK_SIZE, file->file);
+  if (read == 0) {
+    return NULL;
+  }
+  oldest->index = index;
+  oldest->length = (int)read;
+  oldest->age = ++file->age;
+  return oldest;
+}
+
+// line starting at offset without the '\n', NULL past the end of the file. A
+// line within one block points into the cache, a longer one is copied.
+static const char* tag_file_get_line(TagFile* file, size_t offset, size_t* length) {
+  if (offset >= file->size) {
+    return NULL;
+  }
+  size_t copied = 0;
+  while (offset + copied < file->size) {
+    const size_t position = offset + copied;
+    const TagFileBlock* block =
+      tag_file_get_block(file, position / TAG_FILE_BLOCK_SIZE);
+    if (block == NULL) {
+      return NULL;
+    }
+    const int start = (int)(position % TAG_FILE_BLOCK_SIZE);
+    if (start >= block->length) {
+      break;
+    }
+    const char* data = block->data + start;
+    const char* end = memchr(data, '\n', block->length - start);
+    const size_t part =
+      end != NULL ? (size_t)(end - data) : (size_t)(block->length - start);
+    if (copied == 0 && end != NULL) {
+      *length = part;
+      return data;
+    }
+    if (!tag_file_reserve_line(file, copied + part + 1)) {
+      return NULL;
+    }
+    memcpy(file->line + copied, data, part);
+    copied += part;
+    if (end != NULL) {
+      break;
+    }
+  }
+  *length = copied;
+  return file->line;
+}
+#endif
+
+// offset of the first line starting at or after offset
+static size_t tag_file_get_line_start(TagFile* file, size_t offset) {
+  if (offset == 0) {
+    return 0;
+  }
+  size_t length = 0;
+  if (tag_file_get_line(file, offset - 1, &length) == NULL) {
+    return file->size;
+  }
+  return offset + length;
+}
+
+static void tag_file_read_header(TagFile* file) {
+  const int header_length = (int)strlen(TAG_FILE_HEADER);
+  const int sorted_length = (int)strlen(TAG_FILE_SORTED_HEADER);
+  size_t offset = 0;
+  size_t length = 0;
+  const char* line = NULL;
+  while ((line = tag_file_get_line(file, offset, &length)) != NULL &&
+         length >= (size_t)header_length &&
+         strncmp(line, TAG_FILE_HEADER, header_length) == 0) {
+    if (length > (size_t)sorted_length &&
+        strncmp(line, TAG_FILE_SORTED_HEADER, sorted_length) == 0) {
+      file->sorted = line[sorted_length] - '0';
+    }
+    offset += length + 1;
+  }
+}
+
+bool tag_file_open(TagFile* file, const char* filename) {
+  memset(file, 0, sizeof(TagFile));
+  if (!tag_file_map(file, filename)) {
+    return false;
+  }
+  // ctags sorts unless told otherwise
+  file->sorted = 1;
+  tag_file_read_header(file);
+  return true;
+}
+
+void tag_file_close(TagFile* file) {
+#ifdef YASVI_MMAP
+  if (file->data != NULL) {
+    munmap((void*)file->data, file->size);
+  }
+#else
+  if (file->file != NULL) {
+    fclose(file->file);
+  }
+  free(file->blocks);
+#endif
+  free(file->line);
+  memset(file, 0, sizeof(TagFile));
+}
+
+// compares the name field of the line with name, the same way ctags sorts
+static int tag_compare(const char* line,
+                       size_t line_length,
+                       const char* name,
+                       int length,
+                       bool ignore_case) {
+  const char* tab = memchr(line, '\t', line_length);
+  const int name_length = tab != NULL ? (int)(tab - line) : (int)line_length;
+  const int common = name_length < length ? name_length : length;
+  for (int i = 0; i < common; ++i) {
+    const int first =
+      ignore_case ? toupper((unsigned char)line[i]) : (unsigned char)line[i];
+    const int second =
+      ignore_case ? toupper((unsigned char)name[i]) : (unsigned char)name[i];
+    if (first != second) {
+      return first - second;
+    }
+  }
+  return name_length - length;
+}
+
+// offset of the first line with a name not sorting before name
+static size_t tag_file_lower_bound(TagFile* file,
+                                   const char* name,
+                                   int length,
+                                   bool ignore_case) {
+  size_t low = 0;
+  size_t high = file->size;
+  size_t result = file->size;
+  while (low < high) {
+    const size_t middle = low + (high - low) / 2;
+    const size_t start = tag_file_get_line_start(file, middle);
+    size_t line_length = 0;
+    const char* line =
+      start < high ? tag_file_get_line(file, start, &line_length) : NULL;
+    if (line == NULL) {
+      // no line starts in [middle, high)
+      high = middle;
+    } else if (tag_compare(line, line_length, name, length, ignore_case) < 0) {
+      low = start + line_length + 1;
+    } else {
+      result = start;
+      high = middle;
+    }
+  }
+  return result;
+}
+
+static char* tag_copy(const char* text, size_t length) {
+  char* copy = malloc(length + 1);
+  if (copy != NULL) {
+    memcpy(copy, text, length);
+    copy[length] = '\0';
+  }
+  return copy;
+}
+
+// name<TAB>file<TAB>address[;"<TAB>extension fields]
+static bool tag_parse(const char* line, size_t length, Tag* tag) {
+  const char* end = line + length;
+  const char* filename = memchr(line, '\t', length);
+  if (filename == NULL) {
+    return false;
+  }
+  ++filename;
+  const char* address = memchr(filename, '\t', end - filename);
+  if (address == NULL) {
+    return false;
+  }
+  const char* filename_end = address++;
+  const char* address_end = address;
+  if (address < end && (*address == '/' || *address == '?')) {
+    const char delimiter = *address;
+    for (address_end = address + 1; address_end < end && *address_end != delimiter;
+         ++address_end) {
+      if (*address_end == '\\' && address_end + 1 < end) {
+        ++address_end;
+      }
+    }
+    if (address_end < end) {
+      ++address_end;
+    }
+  } else {
+    while (address_end < end && isdigit((unsigned char)*address_end)) {
+      ++address_end;
+    }
+  }
+  tag->filename = tag_copy(filename, filename_end - filename);
+  tag->address = tag_copy(address, address_end - address);
+  if (tag->filename == NULL || tag->address == NULL) {
+    tag_deinit(tag);
+    return false;
+  }
+  return true;
+}
+
+bool tag_file_find(TagFile* file, const char* name, int length, Tag* tag) {
+  tag->filename = NULL;
+  tag->address = NULL;
+  if (length <= 0) {
+    return false;
+  }
+  size_t offset = 0;
+  // names equal ignoring case are next to each other in a case folded file
+  bool ignore_case = false;
+  if (file->sorted != 0) {
+    ignore_case = file->sorted == 2;
+    offset = tag_file_lower_bound(file, name, length, ignore_case);
+  }
+  size_t line_length = 0;
+  const char* line = NULL;
+  while ((line = tag_file_get_line(file, offset, &line_length)) != NULL) {
+    if (tag_compare(line, line_length, name, length, false) == 0) {
+      return tag_parse(line, line_length, tag);
+    }
+    if (file->sorted != 0 &&
+        tag_compare(line, line_length, name, length, ignore_case) > 0) {
+      return false;
+    }
+    offset += line_length + 1;
+  }
+  return false;
+}
+
+void tag_deinit(Tag* tag) {
+  free(tag->filename);
+  free(tag->address);
+  tag->filename = NULL;
+  tag->address = NULL;
+}
+
+static int tag_get_row_length(const BufferRow* row) {
+  int length = row->len;
+  while (length > 0 &&
+         (row->data[length - 1] == '\n' || row->data[length - 1] == '\r')) {
+    --length;
+  }
+  return length;
+}
+
+static const char* tag_find_text(const char* text,
+                                 int text_length,
+                                 const char* pattern,
+                                 int length) {
+  for (int i = 0; i + length <= text_length; ++i) {
+    if (memcmp(&text[i], pattern, length) == 0) {
+      return &text[i];
+    }
+  }
+  return NULL;
+}
+
+// ctags patterns are literal text with optional ^ and $ anchors, only the
+// delimiter and '\' are escaped
+static bool tag_row_matches(const BufferRow* row,
+                            const char* text,
+                            int length,
+                            bool anchored_start,
+                            bool anchored_end) {
+  const int row_length = tag_get_row_length(row);
+  if (anchored_start && anchored_end) {
+    return row_length == length && memcmp(row->data, text, length) == 0;
+  }
+  if (anchored_start) {
+    return row_length >= length && memcmp(row->data, text, length) == 0;
+  }
+  if (anchored_end) {
+    return row_length >= length &&
+           memcmp(&row->data[row_length - length], text, length) == 0;
+  }
+  return tag_find_text(row->data, row_length, text, length) != NULL;
+}
+
+static BufferRow* tag_find_pattern_row(const char* address,
+                                       Buffer* buffer,
+                                       int* line) {
+  const char delimiter = address[0];
+  const int address_length = (int)strlen(address);
+  char* text = malloc(address_length + 1);
+  if (text == NULL) {
+    return NULL;
+  }
+  int end = address_length;
+  if (end > 1 && address[end - 1] == delimiter) {
+    --end;
+  }
+  int start = 1;
+  const bool anchored_start = start < end && address[start] == '^';
+  if (anchored_start) {
+    ++start;
+  }
+  const bool anchored_end = end > start && address[end - 1] == '$' &&
+                            (end - 2 < start || address[end - 2] != '\\');
+  if (anchored_end) {
+    --end;
+  }
+  int length = 0;
+  for (int i = start; i < end; ++i) {
+    if (address[i] == '\\' && i + 1 < end &&
+        (address[i + 1] == delimiter || address[i + 1] == '\\')) {
+      ++i;
+    }
+    text[length++] = address[i];
+  }
+  int index = 0;
+  BufferRow* row = buffer_get_first_row(buffer);
+  for (; row != NULL; row = row->next, ++index) {
+    if (tag_row_matches(row, text, length, anchored_start, anchored_end)) {
+      break;
+    }
+  }
+  free(text);
+  *line = index;
+  return row;
+}
+
+BufferRow* tag_find_row(const Tag* tag,
+                        Buffer* buffer,
+                        const char* name,
+                        int length,
+                        int* line,
+                        int* column) {
+  BufferRow* row = NULL;
+  if (tag->address[0] == '/' || tag->address[0] == '?') {
+    row = tag_find_pattern_row(tag->address, buffer, line);
+  } else {
+    *line = atoi(tag->address) - 1;
+    row = *line >= 0 ? buffer_get_row(buffer, *line) : NULL;
+  }
+  if (row == NULL) {
+    return NULL;
+  }
+  const char* found =
+    tag_find_text(row->data, tag_get_row_length(row), name, length);
+  *column = found != NULL ? (int)(found - row->data) : 0;
+  return row;
+}
@@ -0,0 +1,78 @@
+/*
+ Copyright (c) 2025 Mateusz Stadnik
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#include "buffer.h"
+
+// blocks of the tags file kept in memory when it can not be mapped
+#define TAG_FILE_BLOCK_SIZE 4096
+#define TAG_FILE_NUMBER_OF_BLOCKS 16
+
+typedef struct TagFileBlock {
+  // -1 when the block holds nothing
+  long index;
+  int length;
+  // last use, the least recently used block is replaced
+  unsigned int age;
+  char data[TAG_FILE_BLOCK_SIZE];
+} TagFileBlock;
+
+// ctags file searched in place, with YASVI_MMAP the file is mapped, otherwise
+// it is read through a small block cache, it is never loaded as a whole
+typedef struct TagFile {
+  size_t size;
+#ifdef YASVI_MMAP
+  const char* data;
+#else
+  FILE* file;
+  TagFileBlock* blocks;
+  unsigned int age;
+#endif
+  // lines longer than a block are copied here
+  char* line;
+  size_t line_capacity;
+  // value of !_TAG_FILE_SORTED, 1 sorted, 2 sorted ignoring case, 0 unsorted
+  int sorted;
+} TagFile;
+
+typedef struct Tag {
+  char* filename;
+  // line number or /pattern/ and ?pattern? searching for the whole line
+  char* address;
+} Tag;
+
+// false when the file can not be opened
+bool tag_file_open(TagFile* file, const char* filename);
+void tag_file_close(TagFile* file);
+
+// first tag with the given name, binary search unless the file is not sorted,
+// the tag is filled with malloc'ed strings to be freed with tag_deinit
+bool tag_file_find(TagFile* file, const char* name, int length, Tag* tag);
+void tag_deinit(Tag* tag);
+
+// row the address of the tag points to in the buffer, NULL if not found, column
+// is the position of name in it or 0
+BufferRow* tag_find_row(const Tag* tag,
+                        Buffer* buffer,
+                        const char* name,
+                        int length,
+                        int* line,
+                        int* column);
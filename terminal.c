@@ -0,0 +1,340 @@
+/*
+ Copyright (c) 2025 Mateusz Stadnik
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "terminal.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "profile.h"
+
+bool terminal_init(Terminal* terminal) {
+  memset(&terminal->statistics, 0, sizeof(TerminalStatistics));
+  return terminal->operations->init(terminal);
+}
+
+void terminal_deinit(Terminal* terminal) {
+  terminal->operations->deinit(terminal);
+}
+
+void terminal_draw_text(Terminal* terminal, int y, int x, const char* text) {
+  ++terminal->statistics.draws;
+  terminal->operations->draw(terminal, y, x, text, (int)strlen(text));
+}
+
+void terminal_draw_char(Terminal* terminal, int y, int x, char c) {
+  ++terminal->statistics.draws;
+  terminal->operations->draw(terminal, y, x, &c, 1);
+}
+
+void terminal_draw_format(Terminal* terminal,
+                          int y,
+                          int x,
+                          const char* format,
+                          ...) {
+  char text[TERMINAL_FORMAT_SIZE];
+  va_list arguments;
+  va_start(arguments, format);
+  vsnprintf(text, sizeof(text), format, arguments);
+  va_end(arguments);
+  terminal_draw_text(terminal, y, x, text);
+}
+
+void terminal_clear_to_end_of_line(Terminal* terminal) {
+  ++terminal->statistics.clears;
+  terminal->operations->clear_to_end_of_line(terminal);
+}
+
+void terminal_move(Terminal* terminal, int y, int x) {
+  ++terminal->statistics.moves;
+  terminal->operations->move(terminal, y, x);
+}
+
+void terminal_show_cursor(Terminal* terminal, bool visible) {
+  terminal->operations->show_cursor(terminal, visible);
+}
+
+void terminal_flush(Terminal* terminal) {
+  ++terminal->statistics.flushes;
+  PROFILE_BEGIN(ProfileTimer_Flush);
+  terminal->operations->flush(terminal);
+  PROFILE_END(ProfileTimer_Flush);
+  PROFILE_COUNT(ProfileCounter_BytesWritten,
+                terminal->statistics.bytes - terminal->statistics.flushed_bytes);
+  terminal->statistics.flushed_bytes = terminal->statistics.bytes;
+}
+
+int terminal_read_key(Terminal* terminal) {
+  PROFILE_BEGIN(ProfileTimer_Input);
+  const int key = terminal->operations->read_key(terminal);
+  if (key != TERMINAL_NO_KEY) {
+    PROFILE_END(ProfileTimer_Input);
+  } else {
+    PROFILE_CANCEL(ProfileTimer_Input);
+  }
+  return key;
+}
+
+int terminal_format_move(char* buffer, int y, int x) {
+  return snprintf(buffer, 16, "\x1b[%d;%dH", y + 1, x + 1);
+}
+
+static bool terminal_null_init(Terminal* terminal) {
+  (void)terminal;
+  return true;
+}
+
+static void terminal_null_deinit(Terminal* terminal) {
+  (void)terminal;
+}
+
+static void terminal_null_draw(Terminal* terminal,
+                               int y,
+                               int x,
+                               const char* text,
+                               int length) {
+  (void)terminal;
+  (void)y;
+  (void)x;
+  (void)text;
+  (void)length;
+}
+
+static void terminal_null_clear_to_end_of_line(Terminal* terminal) {
+  (void)terminal;
+}
+
+static void terminal_null_move(Terminal* terminal, int y, int x) {
+  (void)terminal;
+  (void)y;
+  (void)x;
+}
+
+static void terminal_null_show_cursor(Terminal* terminal, bool visible) {
+  (void)terminal;
+  (void)visible;
+}
+
+static void terminal_null_flush(Terminal* terminal) {
+  (void)terminal;
+}
+
+static int terminal_null_read_key(Terminal* terminal) {
+  (void)terminal;
+  return TERMINAL_NO_KEY;
+}
+
+const TerminalOperations terminal_null_operations = {
+  terminal_null_init,
+  terminal_null_deinit,
+  terminal_null_draw,
+  terminal_null_clear_to_end_of_line,
+  terminal_null_move,
+  terminal_null_show_cursor,
+  terminal_null_flush,
+  terminal_null_read_key,
+};
+
+// VirtualTerminal is laid out with its Terminal first
+static VirtualTerminal* terminal_virtual_get(Terminal* terminal) {
+  return (VirtualTerminal*)terminal;
+}
+
+static bool terminal_virtual_init(Terminal* terminal) {
+  VirtualTerminal* virtual_terminal = terminal_virtual_get(terminal);
+  const size_t size = (size_t)terminal->height * (terminal->width + 1);
+  virtual_terminal->cells = malloc(size);
+  virtual_terminal->colors = malloc(size);
+  if (virtual_terminal->cells == NULL || virtual_terminal->colors == NULL) {
+    free(virtual_terminal->cells);
+    free(virtual_terminal->colors);
+    virtual_terminal->cells = NULL;
+    virtual_terminal->colors = NULL;
+    return false;
+  }
+  memset(virtual_terminal->cells, ' ', size);
+  memset(virtual_terminal->colors, 39, size);
+  for (int y = 0; y < terminal->height; ++y) {
+    virtual_terminal->cells[y * (terminal->width + 1) + terminal->width] = '\0';
+  }
+  virtual_terminal->cursor_y = 0;
+  virtual_terminal->cursor_x = 0;
+  virtual_terminal->cursor_visible = true;
+  virtual_terminal->color = 39;
+  return true;
+}
+
+static void terminal_virtual_deinit(Terminal* terminal) {
+  VirtualTerminal* virtual_terminal = terminal_virtual_get(terminal);
+  free(virtual_terminal->cells);
+  free(virtual_terminal->colors);
+  free(virtual_terminal->keys);
+  virtual_terminal->cells = NULL;
+  virtual_terminal->colors = NULL;
+  virtual_terminal->keys = NULL;
+  virtual_terminal->number_of_keys = 0;
+  virtual_terminal->keys_capacity = 0;
+  virtual_terminal->next_key = 0;
+}
+
+// the foreground color of an SGR sequence between [ and m, the last one wins
+static void terminal_virtual_apply_style(VirtualTerminal* terminal,
+                                         const char* parameters,
+                                         int length) {
+  int value = 0;
+  for (int i = 0; i <= length; ++i) {
+    if (i < length && parameters[i] >= '0' && parameters[i] <= '9') {
+      value = value * 10 + parameters[i] - '0';
+      continue;
+    }
+    if (value == 0) {
+      terminal->color = 39;
+    } else if ((value >= 30 && value <= 39) || (value >= 90 && value <= 97)) {
+      terminal->color = (unsigned char)value;
+    }
+    value = 0;
+  }
+}
+
+static void terminal_virtual_draw(Terminal* terminal,
+                                  int y,
+                                  int x,
+                                  const char* text,
+                                  int length) {
+  VirtualTerminal* virtual_terminal = terminal_virtual_get(terminal);
+  char move[16];
+  terminal->statistics.bytes += terminal_format_move(move, y, x) + length;
+  if (y < 0 || y >= terminal->height) {
+    return;
+  }
+  const int row = y * (terminal->width + 1);
+  for (int i = 0; i < length; ++i) {
+    if (text[i] == '\x1b' && i + 1 < length && text[i + 1] == '[') {
+      const int start = i + 2;
+      int end = start;
+      while (end < length && text[end] != 'm') {
+        ++end;
+      }
+      terminal_virtual_apply_style(virtual_terminal, &text[start], end - start);
+      i = end;
+      continue;
+    }
+    if (x >= 0 && x < terminal->width) {
+      virtual_terminal->cells[row + x] = text[i];
+      virtual_terminal->colors[row + x] = virtual_terminal->color;
+    }
+    ++x;
+  }
+  virtual_terminal->cursor_y = y;
+  virtual_terminal->cursor_x = x;
+}
+
+static void terminal_virtual_clear_to_end_of_line(Terminal* terminal) {
+  VirtualTerminal* virtual_terminal = terminal_virtual_get(terminal);
+  // \e[K
+  terminal->statistics.bytes += 3;
+  const int y = virtual_terminal->cursor_y;
+  if (y < 0 || y >= terminal->height) {
+    return;
+  }
+  const int row = y * (terminal->width + 1);
+  for (int x = virtual_terminal->cursor_x < 0 ? 0 : virtual_terminal->cursor_x;
+       x < terminal->width; ++x) {
+    virtual_terminal->cells[row + x] = ' ';
+    virtual_terminal->colors[row + x] = 39;
+  }
+}
+
+static void terminal_virtual_move(Terminal* terminal, int y, int x) {
+  VirtualTerminal* virtual_terminal = terminal_virtual_get(terminal);
+  char move[16];
+  terminal->statistics.bytes += terminal_format_move(move, y, x);
+  virtual_terminal->cursor_y = y;
+  virtual_terminal->cursor_x = x;
+}
+
+static void terminal_virtual_show_cursor(Terminal* terminal, bool visible) {
+  // \e[?25h and \e[?25l
+  terminal->statistics.bytes += 6;
+  terminal_virtual_get(terminal)->cursor_visible = visible;
+}
+
+static void terminal_virtual_flush(Terminal* terminal) {
+  (void)terminal;
+}
+
+static int terminal_virtual_read_key(Terminal* terminal) {
+  VirtualTerminal* virtual_terminal = terminal_virtual_get(terminal);
+  if (virtual_terminal->next_key >= virtual_terminal->number_of_keys) {
+    return TERMINAL_NO_KEY;
+  }
+  return virtual_terminal->keys[virtual_terminal->next_key++];
+}
+
+static const TerminalOperations terminal_virtual_operations = {
+  terminal_virtual_init,
+  terminal_virtual_deinit,
+  terminal_virtual_draw,
+  terminal_virtual_clear_to_end_of_line,
+  terminal_virtual_move,
+  terminal_virtual_show_cursor,
+  terminal_virtual_flush,
+  terminal_virtual_read_key,
+};
+
+void terminal_virtual_setup(VirtualTerminal* terminal, int width, int height) {
+  memset(terminal, 0, sizeof(VirtualTerminal));
+  terminal->terminal.operations = &terminal_virtual_operations;
+  terminal->terminal.width = width;
+  terminal->terminal.height = height;
+}
+
+const char* terminal_virtual_get_row(const VirtualTerminal* terminal, int y) {
+  return &terminal->cells[y * (terminal->terminal.width + 1)];
+}
+
+int terminal_virtual_get_color(const VirtualTerminal* terminal, int y, int x) {
+  return terminal->colors[y * (terminal->terminal.width + 1) + x];
+}
+
+bool terminal_virtual_push_keys(VirtualTerminal* terminal,
+                                const int* keys,
+                                int count) {
+  if (terminal->next_key > 0) {
+    // keys already read are dropped
+    terminal->number_of_keys -= terminal->next_key;
+    memmove(terminal->keys, &terminal->keys[terminal->next_key],
+            sizeof(int) * terminal->number_of_keys);
+    terminal->next_key = 0;
+  }
+  if (terminal->number_of_keys + count > terminal->keys_capacity) {
+    int capacity = terminal->keys_capacity > 0 ? terminal->keys_capacity : 64;
+    while (capacity < terminal->number_of_keys + count) {
+      capacity *= 2;
+    }
+    int* resized = realloc(terminal->keys, sizeof(int) * capacity);
+    if (resized == NULL) {
+      return false;
+    }
+    terminal->keys = resized;
+    terminal->keys_capacity = capacity;
+  }
+  memcpy(&terminal->keys[terminal->number_of_keys], keys, sizeof(int) * count);
+  terminal->number_of_keys += count;
+  return true;
+}
@@ -0,0 +1,136 @@
+/*
+ Copyright (c) 2025 Mateusz Stadnik
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// keys other than characters, the values match curses
+#define TERMINAL_KEY_DOWN 0402
+#define TERMINAL_KEY_UP 0403
+#define TERMINAL_KEY_LEFT 0404
+#define TERMINAL_KEY_RIGHT 0405
+#define TERMINAL_KEY_BACKSPACE 0407
+// returned by terminal_read_key when no key is waiting
+#define TERMINAL_NO_KEY -1
+#define TERMINAL_FORMAT_SIZE 256
+
+struct Terminal;
+
+// a backend, drawing calls only update what is shown on the next flush
+typedef struct TerminalOperations {
+  // sets the size, false when the terminal can not be used
+  bool (*init)(struct Terminal* terminal);
+  void (*deinit)(struct Terminal* terminal);
+  // text may hold SGR escape sequences (\e[...m) which take no cells
+  void (*draw)(struct Terminal* terminal,
+               int y,
+               int x,
+               const char* text,
+               int length);
+  // from the end of the last drawn text or the cursor moved to
+  void (*clear_to_end_of_line)(struct Terminal* terminal);
+  void (*move)(struct Terminal* terminal, int y, int x);
+  void (*show_cursor)(struct Terminal* terminal, bool visible);
+  void (*flush)(struct Terminal* terminal);
+  // TERMINAL_NO_KEY when no key is waiting, it does not block
+  int (*read_key)(struct Terminal* terminal);
+} TerminalOperations;
+
+// counted for every backend, bytes are the ones sent to the terminal or, for
+// the virtual one, the ones a plain ANSI terminal would get
+typedef struct TerminalStatistics {
+  size_t bytes;
+  // bytes up to the last flush
+  size_t flushed_bytes;
+  int draws;
+  int clears;
+  int moves;
+  int flushes;
+} TerminalStatistics;
+
+typedef struct Terminal {
+  const TerminalOperations* operations;
+  int width;
+  int height;
+  TerminalStatistics statistics;
+} Terminal;
+
+bool terminal_init(Terminal* terminal);
+void terminal_deinit(Terminal* terminal);
+void terminal_draw_text(Terminal* terminal, int y, int x, const char* text);
+void terminal_draw_char(Terminal* terminal, int y, int x, char c);
+// printf formatted text, cut at TERMINAL_FORMAT_SIZE bytes
+void terminal_draw_format(Terminal* terminal, int y, int x, const char* format, ...);
+void terminal_clear_to_end_of_line(Terminal* terminal);
+void terminal_move(Terminal* terminal, int y, int x);
+void terminal_show_cursor(Terminal* terminal, bool visible);
+void terminal_flush(Terminal* terminal);
+int terminal_read_key(Terminal* terminal);
+
+// length of the ANSI sequence moving the cursor to y, x written to buffer,
+// which holds at least 16 bytes
+int terminal_format_move(char* buffer, int y, int x);
+
+// draws nothing and reads no keys, e.g. for scripts
+extern const TerminalOperations terminal_null_operations;
+// curses, the default one
+extern const TerminalOperations terminal_curses_operations;
+
+// ANSI escape sequences written straight to stdout, keys read from stdin in
+// raw mode, available with YASVI_ANSI
+typedef struct AnsiTerminal {
+  Terminal terminal;
+  // written on flush
+  char* output;
+  size_t output_length;
+  size_t output_capacity;
+  // bytes read but not returned as keys yet
+  unsigned char input[16];
+  int input_length;
+  // struct termios saved by init
+  void* saved_mode;
+} AnsiTerminal;
+
+// false without YASVI_ANSI, the terminal then draws nothing
+bool terminal_ansi_setup(AnsiTerminal* terminal);
+
+// screen kept in memory for tests and benchmarks, keys come from a queue
+typedef struct VirtualTerminal {
+  Terminal terminal;
+  // height rows of width characters, each ended with '\0'
+  char* cells;
+  // SGR foreground color of every cell, 39 is the default one
+  unsigned char* colors;
+  int cursor_y;
+  int cursor_x;
+  bool cursor_visible;
+  unsigned char color;
+  int* keys;
+  int number_of_keys;
+  int keys_capacity;
+  int next_key;
+} VirtualTerminal;
+
+void terminal_virtual_setup(VirtualTerminal* terminal, int width, int height);
+// row y of the screen as a string
+const char* terminal_virtual_get_row(const VirtualTerminal* terminal, int y);
+int terminal_virtual_get_color(const VirtualTerminal* terminal, int y, int x);
+// keys returned by the following terminal_read_key calls
+bool terminal_virtual_push_keys(VirtualTerminal* terminal,
+                                const int* keys,
+                                int count);
@@ -0,0 +1,203 @@
+/*
+ Copyright (c) 2025 Mateusz Stadnik
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#define _DEFAULT_SOURCE
+
+#include "terminal.h"
+
+#include <string.h>
+
+#ifdef YASVI_ANSI
+#include <stdlib.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+
+// size used when the terminal does not report one
+#define TERMINAL_ANSI_DEFAULT_WIDTH 80
+#define TERMINAL_ANSI_DEFAULT_HEIGHT 24
+
+static AnsiTerminal* terminal_ansi_get(Terminal* terminal) {
+  return (AnsiTerminal*)terminal;
+}
+
+static void terminal_ansi_write(AnsiTerminal* terminal,
+                                const char* data,
+                                size_t length) {
+  if (terminal->output_length + length > terminal->output_capacity) {
+    size_t capacity =
+        terminal->output_capacity > 0 ? terminal->output_capacity : 4096;
+    while (capacity < terminal->output_length + length) {
+      capacity *= 2;
+    }
+    char* output = realloc(terminal->output, capacity);
+    if (output == NULL) {
+      return;
+    }
+    terminal->output = output;
+    terminal->output_capacity = capacity;
+  }
+  memcpy(&terminal->output[terminal->output_length], data, length);
+  terminal->output_length += length;
+}
+
+static void terminal_ansi_flush(Terminal* terminal) {
+  AnsiTerminal* ansi_terminal = terminal_ansi_get(terminal);
+  size_t written = 0;
+  while (written < ansi_terminal->output_length) {
+    const ssize_t result = write(STDOUT_FILENO, &ansi_terminal->output[written],
+                                 ansi_terminal->output_length - written);
+    if (result <= 0) {
+      break;
+    }
+    written += result;
+  }
+  terminal->statistics.bytes += written;
+  ansi_terminal->output_length = 0;
+}
+
+static bool terminal_ansi_init(Terminal* terminal) {
+  AnsiTerminal* ansi_terminal = terminal_ansi_get(terminal);
+  struct termios* saved_mode = malloc(sizeof(struct termios));
+  if (saved_mode == NULL || tcgetattr(STDIN_FILENO, saved_mode) != 0) {
+    free(saved_mode);
+    return false;
+  }
+  ansi_terminal->saved_mode = saved_mode;
+  // raw input as curses raw() and nodelay(), reads return at once
+  struct termios mode = *saved_mode;
+  mode.c_iflag &= ~(BRKINT | ICRNL | INPCK | ISTRIP | IXON);
+  mode.c_oflag &= ~OPOST;
+  mode.c_cflag |= CS8;
+  mode.c_lflag &= ~(ECHO | ICANON | IEXTEN | ISIG);
+  mode.c_cc[VMIN] = 0;
+  mode.c_cc[VTIME] = 0;
+  tcsetattr(STDIN_FILENO, TCSAFLUSH, &mode);
+
+  struct winsize size;
+  if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) == 0 && size.ws_col > 0 &&
+      size.ws_row > 0) {
+    terminal->width = size.ws_col;
+    terminal->height = size.ws_row;
+  } else {
+    terminal->width = TERMINAL_ANSI_DEFAULT_WIDTH;
+    terminal->height = TERMINAL_ANSI_DEFAULT_HEIGHT;
+  }
+  // alternate screen, cleared
+  static const char enter[] = "\x1b[?1049h\x1b[2J";
+  terminal_ansi_write(ansi_terminal, enter, sizeof(enter) - 1);
+  terminal_ansi_flush(terminal);
+  return true;
+}
+
+static void terminal_ansi_deinit(Terminal* terminal) {
+  AnsiTerminal* ansi_terminal = terminal_ansi_get(terminal);
+  static const char leave[] = "\x1b[0m\x1b[?25h\x1b[?1049l";
+  terminal_ansi_write(ansi_terminal, leave, sizeof(leave) - 1);
+  terminal_ansi_flush(terminal);
+  if (ansi_terminal->saved_mode != NULL) {
+    tcsetattr(STDIN_FILENO, TCSAFLUSH, ansi_terminal->saved_mode);
+  }
+  free(ansi_terminal->saved_mode);
+  free(ansi_terminal->output);
+  ansi_terminal->saved_mode = NULL;
+  ansi_terminal->output = NULL;
+  ansi_terminal->output_length = 0;
+  ansi_terminal->output_capacity = 0;
+}
+
+static void terminal_ansi_move(Terminal* terminal, int y, int x) {
+  char move[16];
+  const int length = terminal_format_move(move, y, x);
+  terminal_ansi_write(terminal_ansi_get(terminal), move, length);
+}
+
+static void terminal_ansi_draw(Terminal* terminal,
+                               int y,
+                               int x,
+                               const char* text,
+                               int length) {
+  terminal_ansi_move(terminal, y, x);
+  terminal_ansi_write(terminal_ansi_get(terminal), text, length);
+}
+
+static void terminal_ansi_clear_to_end_of_line(Terminal* terminal) {
+  terminal_ansi_write(terminal_ansi_get(terminal), "\x1b[K", 3);
+}
+
+static void terminal_ansi_show_cursor(Terminal* terminal, bool visible) {
+  terminal_ansi_write(terminal_ansi_get(terminal),
+                      visible ? "\x1b[?25h" : "\x1b[?25l", 6);
+}
+
+// arrow keys arrive as \e[A to \e[D, a lone ESC is the key itself, Enter is
+// turned into \n as curses does
+static int terminal_ansi_read_key(Terminal* terminal) {
+  AnsiTerminal* ansi_terminal = terminal_ansi_get(terminal);
+  unsigned char* input = ansi_terminal->input;
+  const int room = (int)sizeof(ansi_terminal->input) - ansi_terminal->input_length;
+  if (room > 0) {
+    const ssize_t length =
+        read(STDIN_FILENO, &input[ansi_terminal->input_length], room);
+    if (length > 0) {
+      ansi_terminal->input_length += (int)length;
+    }
+  }
+  if (ansi_terminal->input_length == 0) {
+    return TERMINAL_NO_KEY;
+  }
+  int key = input[0];
+  int used = 1;
+  if (key == 27 && ansi_terminal->input_length >= 3 && input[1] == '[' &&
+      input[2] >= 'A' && input[2] <= 'D') {
+    static const int arrows[] = {TERMINAL_KEY_UP, TERMINAL_KEY_DOWN,
+                                 TERMINAL_KEY_RIGHT, TERMINAL_KEY_LEFT};
+    key = arrows[input[2] - 'A'];
+    used = 3;
+  } else if (key == '\r') {
+    key = '\n';
+  }
+  ansi_terminal->input_length -= used;
+  memmove(input, &input[used], ansi_terminal->input_length);
+  return key;
+}
+
+static const TerminalOperations terminal_ansi_operations = {
+  terminal_ansi_init,
+  terminal_ansi_deinit,
+  terminal_ansi_draw,
+  terminal_ansi_clear_to_end_of_line,
+  terminal_ansi_move,
+  terminal_ansi_show_cursor,
+  terminal_ansi_flush,
+  terminal_ansi_read_key,
+};
+
+bool terminal_ansi_setup(AnsiTerminal* terminal) {
+  memset(terminal, 0, sizeof(AnsiTerminal));
+  terminal->terminal.operations = &terminal_ansi_operations;
+  return true;
+}
+
+#else
+
+bool terminal_ansi_setup(AnsiTerminal* terminal) {
+  memset(terminal, 0, sizeof(AnsiTerminal));
+  terminal->terminal.operations = &terminal_null_operations;
+  return false;
+}
+
+#endif
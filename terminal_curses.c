@@ -0,0 +1,106 @@
+/*
+ Copyright (c) 2025 Mateusz Stadnik
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "terminal.h"
+
+#include <ncurses.h>
+
+static bool terminal_curses_init(Terminal* terminal) {
+  initscr();
+  cbreak();
+  raw();
+  keypad(stdscr, true);
+  nodelay(stdscr, true);
+  noecho();
+  clear();
+  refresh();
+  getmaxyx(stdscr, terminal->height, terminal->width);
+  start_color();
+  init_pair(1, COLOR_RED, COLOR_BLACK);
+  init_pair(2, COLOR_GREEN, COLOR_BLACK);
+  init_pair(3, 8, COLOR_BLACK);
+  init_pair(4, COLOR_YELLOW, COLOR_BLACK);
+  init_pair(5, COLOR_BLUE, COLOR_BLACK);
+  init_pair(6, COLOR_CYAN, COLOR_BLACK);
+  return true;
+}
+
+static void terminal_curses_deinit(Terminal* terminal) {
+  (void)terminal;
+  endwin();
+}
+
+static void terminal_curses_draw(Terminal* terminal,
+                                 int y,
+                                 int x,
+                                 const char* text,
+                                 int length) {
+  // curses does not tell what it sends, the text is the best estimate
+  terminal->statistics.bytes += length;
+  mvaddnstr(y, x, text, length);
+}
+
+static void terminal_curses_clear_to_end_of_line(Terminal* terminal) {
+  (void)terminal;
+  clrtoeol();
+}
+
+static void terminal_curses_move(Terminal* terminal, int y, int x) {
+  (void)terminal;
+  move(y, x);
+}
+
+static void terminal_curses_show_cursor(Terminal* terminal, bool visible) {
+  (void)terminal;
+  curs_set(visible ? 1 : 0);
+}
+
+static void terminal_curses_flush(Terminal* terminal) {
+  (void)terminal;
+  refresh();
+}
+
+static int terminal_curses_read_key(Terminal* terminal) {
+  (void)terminal;
+  const int key = getch();
+  switch (key) {
+    case ERR:
+      return TERMINAL_NO_KEY;
+    case KEY_DOWN:
+      return TERMINAL_KEY_DOWN;
+    case KEY_UP:
+      return TERMINAL_KEY_UP;
+    case KEY_LEFT:
+      return TERMINAL_KEY_LEFT;
+    case KEY_RIGHT:
+      return TERMINAL_KEY_RIGHT;
+    case KEY_BACKSPACE:
+      return TERMINAL_KEY_BACKSPACE;
+    default:
+      return key;
+  }
+}
+
+const TerminalOperations terminal_curses_operations = {
+  terminal_curses_init,
+  terminal_curses_deinit,
+  terminal_curses_draw,
+  terminal_curses_clear_to_end_of_line,
+  terminal_curses_move,
+  terminal_curses_show_cursor,
+  terminal_curses_flush,
+  terminal_curses_read_key,
+};
@@ -104,6 +104,100 @@ void test_buffer_row_get_offset_to_prev_word(void) {
   buffer_free(buffer);
 }
 
+void test_buffer_row_find_word(void) {
+  Buffer* buffer = buffer_alloc();
+  TEST_CHECK(buffer != NULL);
+
+  // words crossing the 64 character blocks of the bitmap
+  char line[200];
+  for (int i = 0; i < 199; ++i) {
+    line[i] = i % 7 < 4 ? 'a' : ' ';
+  }
+  line[199] = '\0';
+  buffer_append_line(buffer, line);
+  BufferRow* row = buffer->current_row;
+
+  int count = 1;
+  TEST_CHECK(buffer_row_find_next_word_start(row, 0, &count) == 7);
+  TEST_CHECK(count == 0);
+  count = 20;
+  TEST_CHECK(buffer_row_find_next_word_start(row, 0, &count) == 140);
+  count = 3;
+  TEST_CHECK(buffer_row_find_next_word_end(row, 60, &count) == 80);
+  count = 10;
+  TEST_CHECK(buffer_row_find_prev_word_start(row, 150, &count) == 84);
+  count = 100;
+  TEST_CHECK(buffer_row_find_next_word_start(row, 0, &count) == -1);
+  TEST_CHECK(count == 100 - 28);
+  count = 2;
+  TEST_CHECK(buffer_row_find_prev_word_start(row, 3, &count) == -1);
+  TEST_CHECK(count == 1);
+
+  // edits invalidate the bitmap
+  buffer_row_insert_chars(row, 0, "  ", 2);
+  count = 1;
+  TEST_CHECK(buffer_row_find_next_word_start(row, 0, &count) == 2);
+  buffer_row_trim(row, 5);
+  count = 2;
+  TEST_CHECK(buffer_row_find_next_word_end(row, 0, &count) == -1);
+  TEST_CHECK(count == 1);
+
+  buffer_free(buffer);
+}
+
+void test_buffer_find_matching_bracket(void) {
+  Buffer* buffer = buffer_alloc();
+  TEST_CHECK(buffer != NULL);
+
+  buffer_append_line(buffer, "f() {");
+  buffer_append_line(buffer, "  g(\"}\", ')');  // }");
+  buffer_append_line(buffer, "  { { } }");
+  buffer_append_line(buffer, "  /* { */");
+  buffer_append_line(buffer, "}");
+  BufferRow* first = buffer->head;
+  BufferRow* last = buffer->tail;
+
+  TEST_CHECK(first->next->bracket_balance[0] == 0);
+  TEST_CHECK(first->next->bracket_balance[2] == 0);
+  TEST_CHECK(last->bracket_balance[2] == -1);
+  TEST_CHECK(last->bracket_lowest[2] == -1);
+
+  BufferPosition position;
+  TEST_CHECK(buffer_find_matching_bracket(first, 0, 4, &position));
+  TEST_CHECK(position.row == last);
+  TEST_CHECK(position.line == 4 && position.column == 0);
+  TEST_CHECK(buffer_find_matching_bracket(last, 4, 0, &position));
+  TEST_CHECK(position.row == first && position.column == 4);
+  TEST_CHECK(buffer_find_matching_bracket(first->next, 1, 3, &position));
+  TEST_CHECK(position.line == 1 && position.column == 12);
+  TEST_CHECK(!buffer_find_matching_bracket(first, 0, 0, &position));
+
+  BufferPosition start;
+  TEST_CHECK(buffer_find_enclosing_brackets(first->next->next, 2, 5, 3, &start,
+                                            &position));
+  TEST_CHECK(start.column == 4 && position.line == 2 && position.column == 6);
+  TEST_CHECK(buffer_find_enclosing_brackets(first->next, 1, 2, 3, &start,
+                                            &position));
+  TEST_CHECK(start.line == 0 && position.line == 4);
+  TEST_CHECK(!buffer_find_enclosing_brackets(first, 0, 0, 2, &start, &position));
+  buffer_free(buffer);
+
+  // rows inserted as with :r are not highlighted yet
+  buffer = buffer_alloc();
+  buffer_append_line(buffer, "int a;");
+  BufferRow* head = buffer_row_alloc("f(\")\") {", 9);
+  BufferRow* tail = buffer_row_alloc("}", 1);
+  head->next = tail;
+  tail->prev = head;
+  buffer_replace_rows(buffer, buffer->head, 0, head, tail, 2);
+  TEST_CHECK(head->highlight_pending && tail->highlight_pending);
+  TEST_CHECK(buffer_find_matching_bracket(head, 0, 1, &position));
+  TEST_CHECK(position.row == head && position.column == 5);
+  TEST_CHECK(buffer_find_enclosing_brackets(tail, 1, 0, 3, &start, &position));
+  TEST_CHECK(start.row == head && start.column == 7);
+  buffer_free(buffer);
+}
+
 void test_buffer_row_remove_character(void) {
   Buffer* buffer = buffer_alloc();
   TEST_CHECK(buffer != NULL);
@@ -156,14 +250,215 @@ void test_buffer_insert_character(void) {
   buffer_free(buffer);
 }
 
+void test_buffer_scroll_rows(void) {
+  Buffer* buffer = buffer_alloc();
+  TEST_CHECK(buffer != NULL);
+
+  for (int i = 0; i < 10; ++i) {
+    buffer_append_line(buffer, "line");
+  }
+
+  TEST_CHECK(buffer_scroll_rows(buffer, 4) == 4);
+  TEST_CHECK(buffer->current_row == buffer_get_row(buffer, 4));
+
+  // scrolling is clamped to the buffer boundaries
+  TEST_CHECK(buffer_scroll_rows(buffer, 100) == 5);
+  TEST_CHECK(buffer_current_is_last_row(buffer));
+
+  TEST_CHECK(buffer_scroll_rows(buffer, -100) == -9);
+  TEST_CHECK(buffer_current_is_first_row(buffer));
+
+  buffer_free(buffer);
+}
+
+void test_buffer_remove_current_rows(void) {
+  Buffer* buffer = buffer_alloc();
+  TEST_CHECK(buffer != NULL);
+
+  buffer_append_line(buffer, "first");
+  buffer_append_line(buffer, "second");
+  buffer_append_line(buffer, "third");
+  buffer_append_line(buffer, "fourth");
+
+  buffer_scroll_rows(buffer, 1);
+  TEST_CHECK(buffer_remove_current_rows(buffer, 2) == 2);
+  TEST_CHECK(buffer_get_number_of_lines(buffer) == 2);
+  TEST_CHECK(strcmp(buffer->current_row->data, "fourth") == 0);
+  TEST_CHECK(buffer->head->next == buffer->current_row);
+  TEST_CHECK(buffer->current_row->prev == buffer->head);
+
+  // removing past the end moves to the previous row
+  TEST_CHECK(buffer_remove_current_rows(buffer, 10) == 1);
+  TEST_CHECK(strcmp(buffer->current_row->data, "first") == 0);
+  TEST_CHECK(buffer->tail == buffer->current_row);
+
+  // buffer always keeps one row
+  TEST_CHECK(buffer_remove_current_rows(buffer, 1) == 1);
+  TEST_CHECK(buffer_get_number_of_lines(buffer) == 1);
+  TEST_CHECK(buffer->current_row != NULL);
+  TEST_CHECK(buffer->current_row->len == 0);
+
+  buffer_free(buffer);
+}
+
+static bool buffer_check_row_indexes(Buffer* buffer) {
+  int index = 0;
+  for (BufferRow* row = buffer->head; row != NULL; row = row->next, ++index) {
+    if (buffer_get_row_index(buffer, row) != index) {
+      return false;
+    }
+  }
+  return index == buffer_get_number_of_lines(buffer);
+}
+
+void test_buffer_get_row_index(void) {
+  Buffer* buffer = buffer_alloc();
+  TEST_CHECK(buffer != NULL);
+  for (int i = 0; i < 100; ++i) {
+    buffer_append_line(buffer, "row");
+  }
+  TEST_CHECK(buffer_check_row_indexes(buffer));
+
+  // single row edits keep the tree up to date
+  unsigned int seed = 1;
+  for (int i = 0; i < 500; ++i) {
+    seed = seed * 1103515245u + 12345u;
+    const int line = (int)((seed >> 8) % buffer_get_number_of_lines(buffer));
+    buffer->current_row = buffer_get_row(buffer, line);
+    if ((seed >> 4) % 3 == 0) {
+      buffer_remove_current_rows(buffer, 1 + (int)((seed >> 12) % 3));
+    } else {
+      buffer_break_current_line(buffer, 0);
+    }
+    TEST_CHECK(buffer->tree_valid);
+    TEST_CHECK(buffer_check_row_indexes(buffer));
+  }
+
+  // bulk removal rebuilds it
+  bool marks[10] = {true, false, true};
+  buffer_remove_marked_rows(buffer, buffer->head, 10, marks);
+  TEST_CHECK(buffer_check_row_indexes(buffer));
+
+  buffer_free(buffer);
+}
+
+void test_buffer_marks_and_jumps(void) {
+  Buffer* buffer = buffer_alloc();
+  TEST_CHECK(buffer != NULL);
+  for (int i = 0; i < 10; ++i) {
+    buffer_append_line(buffer, "row");
+  }
+  BufferRow* third = buffer_get_row(buffer, 2);
+  BufferRow* fifth = buffer_get_row(buffer, 4);
+  buffer_set_mark(buffer, 0, fifth, 2);
+  TEST_CHECK(buffer_get_mark(buffer, 0)->row == fifth);
+  TEST_CHECK(buffer_get_mark(buffer, 1) == NULL);
+
+  // rows inserted above move the mark along
+  buffer->current_row = buffer->head;
+  buffer_break_current_line(buffer, 0);
+  TEST_CHECK(buffer_get_row_index(buffer, buffer_get_mark(buffer, 0)->row) == 5);
+
+  BufferJumplist jumplist = {0};
+  BufferJump target;
+  TEST_CHECK(!buffer_jump_back(buffer, buffer->head, 0, &target));
+  buffer->jumplist = &jumplist;
+  TEST_CHECK(!buffer_jump_back(buffer, buffer->head, 0, &target));
+  buffer_push_jump(buffer, third, 1);
+  buffer_push_jump(buffer, fifth, 0);
+  TEST_CHECK(buffer_jump_back(buffer, buffer->tail, 3, &target));
+  TEST_CHECK(target.buffer == buffer && target.mark.row == fifth);
+  TEST_CHECK(buffer_jump_back(buffer, fifth, 0, &target));
+  TEST_CHECK(target.mark.row == third && target.mark.column == 1);
+  TEST_CHECK(!buffer_jump_back(buffer, third, 1, &target));
+  TEST_CHECK(buffer_jump_forward(buffer, &target));
+  TEST_CHECK(buffer_jump_forward(buffer, &target));
+  TEST_CHECK(target.mark.row == buffer->tail && target.mark.column == 3);
+  TEST_CHECK(!buffer_jump_forward(buffer, &target));
+
+  // removing the row drops its mark and jumps
+  buffer->current_row = fifth;
+  buffer_remove_current_rows(buffer, 1);
+  TEST_CHECK(buffer_get_mark(buffer, 0) == NULL);
+  TEST_CHECK(jumplist.number_of_jumps == 2);
+  TEST_CHECK(buffer_jump_back(buffer, buffer->head, 0, &target));
+  TEST_CHECK(target.mark.row == third);
+
+  // a jump into another buffer leads back to the first one
+  Buffer* other = buffer_alloc();
+  buffer_append_line(other, "other");
+  other->jumplist = &jumplist;
+  buffer_push_jump(buffer, third, 2);
+  TEST_CHECK(buffer_jump_back(other, other->head, 0, &target));
+  TEST_CHECK(target.buffer == buffer && target.mark.row == third);
+  TEST_CHECK(buffer_jump_forward(buffer, &target));
+  TEST_CHECK(target.buffer == other && target.mark.row == other->head);
+  // freeing a buffer drops its jumps
+  buffer_free(other);
+  TEST_CHECK(jumplist.number_of_jumps == 1);
+  TEST_CHECK(jumplist.jumps[0].buffer == buffer);
+
+  buffer_free(buffer);
+}
+
+void test_buffer_remove_marked_rows(void) {
+  Buffer* buffer = buffer_alloc();
+  TEST_CHECK(buffer != NULL);
+
+  const char* lines[] = {"a", "b", "c", "d", "e", "f"};
+  for (int i = 0; i < 6; ++i) {
+    buffer_append_line(buffer, lines[i]);
+  }
+  buffer_scroll_rows(buffer, 2);
+
+  // removes b, c and e from the range b..e, the current row c goes to d
+  const bool marks[] = {true, true, false, true};
+  TEST_CHECK(buffer_remove_marked_rows(buffer, buffer->head->next, 4, marks) == 3);
+  TEST_CHECK(buffer_get_number_of_lines(buffer) == 3);
+  TEST_CHECK(strcmp(buffer->current_row->data, "d") == 0);
+  const char* expected[] = {"a", "d", "f"};
+  BufferRow* row = buffer->head;
+  for (int i = 0; i < 3; ++i, row = row->next) {
+    TEST_CHECK(strcmp(row->data, expected[i]) == 0);
+    TEST_CHECK(row->prev == (i == 0 ? NULL : buffer_get_row(buffer, i - 1)));
+  }
+  TEST_CHECK(row == NULL);
+  TEST_CHECK(strcmp(buffer->tail->data, "f") == 0);
+
+  // removing the tail moves the current row back
+  const bool tail_marks[] = {false, true};
+  buffer_scroll_rows(buffer, 1);
+  TEST_CHECK(buffer_remove_marked_rows(buffer, buffer->head->next, 2, tail_marks) ==
+             1);
+  TEST_CHECK(strcmp(buffer->tail->data, "d") == 0);
+  TEST_CHECK(buffer->tail->next == NULL);
+  TEST_CHECK(buffer->current_row == buffer->tail);
+
+  // buffer always keeps one row
+  const bool all_marks[] = {true, true};
+  TEST_CHECK(buffer_remove_marked_rows(buffer, buffer->head, 2, all_marks) == 2);
+  TEST_CHECK(buffer_get_number_of_lines(buffer) == 1);
+  TEST_CHECK(buffer->current_row == buffer->head);
+  TEST_CHECK(buffer->current_row->len == 0);
+
+  buffer_free(buffer);
+}
+
 TEST_LIST = {
   {"test_buffer_alloc", test_buffer_alloc},
   {"test_buffer_row_get_offset_to_next_word",
    test_buffer_row_get_offset_to_next_word},
   {"test_buffer_row_get_offset_to_prev_word",
    test_buffer_row_get_offset_to_prev_word},
+  {"test_buffer_row_find_word", test_buffer_row_find_word},
+  {"test_buffer_find_matching_bracket", test_buffer_find_matching_bracket},
   {"test_buffer_row_remove_character", test_buffer_row_remove_character},
   {"test_buffer_insert_character", test_buffer_insert_character},
+  {"test_buffer_scroll_rows", test_buffer_scroll_rows},
+  {"test_buffer_remove_current_rows", test_buffer_remove_current_rows},
+  {"test_buffer_remove_marked_rows", test_buffer_remove_marked_rows},
+  {"test_buffer_get_row_index", test_buffer_get_row_index},
+  {"test_buffer_marks_and_jumps", test_buffer_marks_and_jumps},
 
   {NULL, NULL}  // zeroed record marking the end of the list
 };
\ No newline at end of file
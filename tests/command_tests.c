@@ -17,6 +17,8 @@
 
 #include "acutest.h"
 
+#include "command.h"
+
 void test_command(void) {
   void* mem;
 
@@ -29,7 +31,119 @@ void test_command(void) {
   free(mem);
 }
 
+static void check_address(const CommandAddress* address,
+                          CommandAddressType type,
+                          int line,
+                          int offset) {
+  TEST_CHECK(address->type == type);
+  if (type == CommandAddressType_Line) {
+    TEST_CHECK(address->line == line);
+  }
+  TEST_CHECK(address->offset == offset);
+}
+
+void test_command_parse_range(void) {
+  ExCommand command;
+  const char* error = NULL;
+
+  TEST_CHECK(command_parse("%s/a/b/g", &command, &error));
+  TEST_CHECK(command.definition->id == ExCommandId_Substitute);
+  TEST_CHECK(command.number_of_addresses == 2);
+  check_address(&command.addresses[0], CommandAddressType_Line, 0, 0);
+  check_address(&command.addresses[1], CommandAddressType_Last, 0, 0);
+  TEST_CHECK(strcmp(command.arguments, "/a/b/g") == 0);
+  command_parsed_deinit(&command);
+
+  TEST_CHECK(command_parse("3,.+2d", &command, &error));
+  TEST_CHECK(command.definition->id == ExCommandId_Delete);
+  check_address(&command.addresses[0], CommandAddressType_Line, 2, 0);
+  check_address(&command.addresses[1], CommandAddressType_Current, 0, 2);
+  command_parsed_deinit(&command);
+
+  TEST_CHECK(command_parse("'a,$-1", &command, &error));
+  TEST_CHECK(command.definition->id == ExCommandId_Goto);
+  TEST_CHECK(command.addresses[0].type == CommandAddressType_Mark);
+  TEST_CHECK(command.addresses[0].mark == 'a');
+  check_address(&command.addresses[1], CommandAddressType_Last, 0, -1);
+  command_parsed_deinit(&command);
+
+  TEST_CHECK(command_parse("/fo\\/o/,?bar?s/x/y/", &command, &error));
+  TEST_CHECK(command.addresses[0].type == CommandAddressType_SearchForward);
+  TEST_CHECK(strcmp(command.addresses[0].pattern, "fo/o") == 0);
+  TEST_CHECK(command.addresses[1].type == CommandAddressType_SearchBackward);
+  TEST_CHECK(strcmp(command.addresses[1].pattern, "bar") == 0);
+  command_parsed_deinit(&command);
+
+  // empty pattern reuses the last search
+  TEST_CHECK(command_parse("//d", &command, &error));
+  TEST_CHECK(command.addresses[0].pattern == NULL);
+  command_parsed_deinit(&command);
+
+  TEST_CHECK(command_parse(",5d", &command, &error));
+  check_address(&command.addresses[0], CommandAddressType_Current, 0, 0);
+  check_address(&command.addresses[1], CommandAddressType_Line, 4, 0);
+  command_parsed_deinit(&command);
+
+  TEST_CHECK(!command_parse("1,2,3d", &command, &error));
+  TEST_CHECK(error != NULL);
+  TEST_CHECK(!command_parse("'1d", &command, &error));
+  TEST_CHECK(error != NULL);
+}
+
+void test_command_parse_name(void) {
+  ExCommand command;
+  const char* error = NULL;
+
+  const struct {
+    const char* text;
+    ExCommandId id;
+  } commands[] = {
+    {"q", ExCommandId_Quit},        {"quit", ExCommandId_Quit},
+    {"w", ExCommandId_Write},       {"wr", ExCommandId_Write},
+    {"wq", ExCommandId_WriteQuit},  {"s/a/b/", ExCommandId_Substitute},
+    {"su/a/b/", ExCommandId_Substitute}, {"g/a/d", ExCommandId_Global},
+    {"v/a/d", ExCommandId_Vglobal}, {"d", ExCommandId_Delete},
+    {"42", ExCommandId_Goto},       {"ta main", ExCommandId_Tag},
+    {"gr a", ExCommandId_Grep},     {"vim /a/", ExCommandId_Grep},
+    {"cn", ExCommandId_Cnext},      {"cp", ExCommandId_Cprevious},
+    {"fin main", ExCommandId_Find}, {"fo", ExCommandId_Fold},
+    {"r file", ExCommandId_Read},   {"$read !ls", ExCommandId_Read},
+    {"stats", ExCommandId_Stats},   {"se", ExCommandId_Set},
+  };
+  for (size_t i = 0; i < sizeof(commands) / sizeof(commands[0]); ++i) {
+    TEST_CHECK(command_parse(commands[i].text, &command, &error));
+    TEST_MSG("%s: %s", commands[i].text, error ? error : "");
+    TEST_CHECK(command.definition != NULL && command.definition->id == commands[i].id);
+    TEST_MSG("%s", commands[i].text);
+    command_parsed_deinit(&command);
+  }
+
+  TEST_CHECK(command_parse("w  file.txt", &command, &error));
+  TEST_CHECK(strcmp(command.arguments, "file.txt") == 0);
+  TEST_CHECK(!command.bang);
+  command_parsed_deinit(&command);
+
+  TEST_CHECK(command_parse("g!/a/d", &command, &error));
+  TEST_CHECK(command.bang);
+  TEST_CHECK(strcmp(command.arguments, "/a/d") == 0);
+  command_parsed_deinit(&command);
+
+  TEST_CHECK(command_parse("%!sort -u", &command, &error));
+  TEST_CHECK(command.definition->id == ExCommandId_Shell);
+  TEST_CHECK(command.number_of_addresses == 2);
+  TEST_CHECK(!command.bang);
+  TEST_CHECK(strcmp(command.arguments, "sort -u") == 0);
+  command_parsed_deinit(&command);
+
+  TEST_CHECK(!command_parse("nonsense", &command, &error));
+  TEST_CHECK(!command_parse("writes", &command, &error));
+  TEST_CHECK(!command_parse("1,2q", &command, &error));
+  TEST_CHECK(strcmp(error, "No range allowed") == 0);
+}
+
 TEST_LIST = {
   {"test_command", test_command},
+  {"test_command_parse_range", test_command_parse_range},
+  {"test_command_parse_name", test_command_parse_name},
   {NULL, NULL}  // zeroed record marking the end of the list
 };
\ No newline at end of file
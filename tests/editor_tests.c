@@ -0,0 +1,188 @@
+/*
+ Copyright (c) 2025 Mateusz Stadnik
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "acutest.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "buffer.h"
+#include "editor.h"
+#include "terminal.h"
+
+#define TEST_FILE "build/editor_test.c"
+#define KEY_ESCAPE 27
+
+// the editor on a virtual terminal with lines loaded from a file, drawn once
+// so the visible rows are highlighted and indexed
+static void start(Editor* editor,
+                  VirtualTerminal* terminal,
+                  const char* const* lines,
+                  int count) {
+  FILE* file = fopen(TEST_FILE, "w");
+  TEST_ASSERT(file != NULL);
+  for (int i = 0; i < count; ++i) {
+    fprintf(file, "%s\n", lines[i]);
+  }
+  fclose(file);
+  *editor = (Editor){
+    .state = EditorState_Running,
+    .cursor = {2, 0},
+    .number_of_line_digits = 3,
+    .tab_size = 2,
+  };
+  terminal_virtual_setup(terminal, 80, 24);
+  editor->terminal = &terminal->terminal;
+  TEST_ASSERT(editor_init(editor));
+  editor_load_file(editor, TEST_FILE);
+  editor_redraw_screen(editor);
+}
+
+static void type(Editor* editor, const char* keys) {
+  for (; *keys != '\0'; ++keys) {
+    editor_process_key(editor, (unsigned char)*keys);
+  }
+}
+
+static void check_rows(Editor* editor, const char* const* lines, int count) {
+  Buffer* buffer = editor->current_buffer;
+  TEST_CHECK(buffer_get_number_of_lines(buffer) == count);
+  TEST_MSG("%d lines", buffer_get_number_of_lines(buffer));
+  for (int i = 0; i < count; ++i) {
+    const BufferRow* row = buffer_get_row(buffer, i);
+    TEST_ASSERT(row != NULL);
+    TEST_CHECK(strcmp(row->data, lines[i]) == 0);
+    TEST_MSG("row %d: '%s', expected '%s'", i, row->data, lines[i]);
+  }
+}
+
+static void stop(Editor* editor) {
+  editor_deinit(editor);
+  remove(TEST_FILE);
+}
+
+void test_editor_complete_inside_word(void) {
+  Editor editor;
+  VirtualTerminal terminal;
+  const char* lines[] = {"alphabet_long", "beta"};
+  start(&editor, &terminal, lines, 2);
+  // the edited row "albeta" is indexed too but is not a candidate
+  type(&editor, "jial\x0e\x1b");
+  const char* completed[] = {"alphabet_long", "alphabet_longbeta"};
+  check_rows(&editor, completed, 2);
+  stop(&editor);
+}
+
+static bool message_contains(const Editor* editor, const char* text) {
+  return editor->error_message != NULL && strstr(editor->error_message, text);
+}
+
+void test_editor_macros(void) {
+  Editor editor;
+  VirtualTerminal terminal;
+  const char* lines[] = {"a", "b", "c", "d", "e", "f"};
+  start(&editor, &terminal, lines, 6);
+  type(&editor, "qa$a!\x1bjq");
+  type(&editor, "@a");
+  type(&editor, "2@a");
+  type(&editor, "@@");
+  const char* replayed[] = {"a!", "b!", "c!", "d!", "e!", "f"};
+  check_rows(&editor, replayed, 6);
+
+  // an uppercase register appends to the recorded keys
+  type(&editor, "qb$a1\x1bq");
+  type(&editor, "qB$a2\x1bq");
+  type(&editor, "k@b");
+  const char* appended[] = {"a!", "b!", "c!", "d!", "e!12", "f12"};
+  check_rows(&editor, appended, 6);
+  stop(&editor);
+}
+
+void test_editor_macro_limits(void) {
+  Editor editor;
+  VirtualTerminal terminal;
+  const char* lines[] = {"x", "y"};
+  start(&editor, &terminal, lines, 2);
+  // a register replaying itself stops at the nesting limit
+  type(&editor, "qa$a+\x1bq");
+  type(&editor, "qA@aq");
+  TEST_CHECK(message_contains(&editor, "Macro recursion too deep"));
+  TEST_CHECK(editor.replay_depth == 0);
+  const BufferRow* row = buffer_get_row(editor.current_buffer, 0);
+  TEST_CHECK(row->len > 2 && row->len <= 102);
+  TEST_MSG("%d characters", row->len);
+
+  // ESC typed while a long replay runs interrupts it
+  type(&editor, "jqb$a.\x1bq");
+  const int escape = KEY_ESCAPE;
+  TEST_ASSERT(terminal_virtual_push_keys(&terminal, &escape, 1));
+  type(&editor, "10000@b");
+  TEST_CHECK(message_contains(&editor, "Interrupted"));
+  row = buffer_get_row(editor.current_buffer, 1);
+  TEST_CHECK(row->len > 2 && row->len < 10000);
+  TEST_MSG("%d characters", row->len);
+  stop(&editor);
+}
+
+void test_editor_repeat_deletes(void) {
+  Editor editor;
+  VirtualTerminal terminal;
+  const char* lines[] = {"abcdefghij", "one two three four five", "l1", "l2",
+                         "l3", "l4", "l5", "l6"};
+  start(&editor, &terminal, lines, 8);
+  // a count given to . replaces the one of the change
+  type(&editor, "x.2x.1.");
+  type(&editor, "jdw.2.");
+  type(&editor, "jdd.2.");
+  const char* repeated[] = {"hij", "five", "l5", "l6"};
+  check_rows(&editor, repeated, 4);
+  stop(&editor);
+}
+
+void test_editor_repeat_text_objects(void) {
+  Editor editor;
+  VirtualTerminal terminal;
+  const char* lines[] = {"f(a, b) g(c)", "h(x) k(y)"};
+  start(&editor, &terminal, lines, 2);
+  type(&editor, "lldi($h.");
+  type(&editor, "j^llci(new\x1b$h.");
+  const char* repeated[] = {"f() g()", "h(new) k(new)"};
+  check_rows(&editor, repeated, 2);
+  stop(&editor);
+}
+
+void test_editor_repeat_insert(void) {
+  Editor editor;
+  VirtualTerminal terminal;
+  const char* lines[] = {"ab", "cd"};
+  start(&editor, &terminal, lines, 2);
+  type(&editor, "iXY\x1b.");
+  type(&editor, "j^2iZ\x1b" "3.");
+  const char* repeated[] = {"XYXYab", "ZZZZZcd"};
+  check_rows(&editor, repeated, 2);
+  stop(&editor);
+}
+
+TEST_LIST = {
+  {"test_editor_complete_inside_word", test_editor_complete_inside_word},
+  {"test_editor_macros", test_editor_macros},
+  {"test_editor_macro_limits", test_editor_macro_limits},
+  {"test_editor_repeat_deletes", test_editor_repeat_deletes},
+  {"test_editor_repeat_text_objects", test_editor_repeat_text_objects},
+  {"test_editor_repeat_insert", test_editor_repeat_insert},
+  {NULL, NULL}  // zeroed record marking the end of the list
+};
@@ -0,0 +1,160 @@
+/*
+ Copyright (c) 2025 Mateusz Stadnik
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "acutest.h"
+
+#include "buffer.h"
+#include "fold.h"
+
+static Buffer* create_buffer(int number_of_lines) {
+  Buffer* buffer = buffer_alloc();
+  for (int i = 0; i < number_of_lines; ++i) {
+    buffer_append_line(buffer, "line");
+  }
+  return buffer;
+}
+
+static bool add_fold(Buffer* buffer, int first, int last) {
+  const char* error = NULL;
+  return fold_tree_add(&buffer->folds, buffer, buffer_get_row(buffer, first),
+                       buffer_get_row(buffer, last), false, &error);
+}
+
+static void check_fold(Buffer* buffer, const Fold* fold, int first, int last) {
+  TEST_ASSERT(fold != NULL);
+  TEST_CHECK(buffer_get_row_index(buffer, fold->first) == first);
+  TEST_CHECK(buffer_get_row_index(buffer, fold->last) == last);
+  TEST_MSG("fold %d-%d", buffer_get_row_index(buffer, fold->first),
+           buffer_get_row_index(buffer, fold->last));
+}
+
+void test_fold_tree_add(void) {
+  Buffer* buffer = create_buffer(20);
+  FoldTree* folds = &buffer->folds;
+  TEST_CHECK(add_fold(buffer, 2, 4));
+  TEST_CHECK(add_fold(buffer, 6, 8));
+  // contains both folds added before
+  TEST_CHECK(add_fold(buffer, 1, 10));
+  TEST_CHECK(add_fold(buffer, 3, 4));
+  TEST_CHECK(!add_fold(buffer, 8, 12));
+  TEST_CHECK(!add_fold(buffer, 2, 4));
+
+  TEST_CHECK(fold_tree_find(folds, buffer, 0) == NULL);
+  check_fold(buffer, fold_tree_find(folds, buffer, 1), 1, 10);
+  check_fold(buffer, fold_tree_find(folds, buffer, 2), 2, 4);
+  check_fold(buffer, fold_tree_find(folds, buffer, 4), 3, 4);
+  check_fold(buffer, fold_tree_find(folds, buffer, 7), 6, 8);
+  check_fold(buffer, fold_tree_find(folds, buffer, 9), 1, 10);
+  TEST_CHECK(fold_tree_find(folds, buffer, 11) == NULL);
+  TEST_CHECK(fold_get_level(fold_tree_find(folds, buffer, 4)) == 3);
+
+  // the outermost closed fold hides the line
+  TEST_CHECK(fold_tree_find_closed(folds, buffer, 4) == NULL);
+  fold_set_closed(folds, fold_tree_find(folds, buffer, 4), true);
+  fold_set_closed(folds, fold_tree_find(folds, buffer, 2), true);
+  check_fold(buffer, fold_tree_find_closed(folds, buffer, 4), 2, 4);
+  TEST_CHECK(fold_tree_has_closed(folds));
+  check_fold(buffer, fold_get_closed_at_first(buffer_get_row(buffer, 2)), 2, 4);
+  check_fold(buffer, fold_get_closed_at_last(buffer_get_row(buffer, 4)), 2, 4);
+  TEST_CHECK(fold_get_closed_at_first(buffer_get_row(buffer, 1)) == NULL);
+
+  fold_tree_set_all_closed(folds, false);
+  TEST_CHECK(!fold_tree_has_closed(folds));
+  buffer_free(buffer);
+}
+
+void test_fold_tree_edits(void) {
+  Buffer* buffer = create_buffer(20);
+  FoldTree* folds = &buffer->folds;
+  TEST_CHECK(add_fold(buffer, 2, 10));
+  TEST_CHECK(add_fold(buffer, 4, 6));
+  TEST_CHECK(add_fold(buffer, 4, 5));
+
+  // rows inserted inside a fold extend it
+  buffer_set_current_row(buffer, buffer_get_row(buffer, 3));
+  buffer_break_current_line(buffer, 0);
+  check_fold(buffer, fold_tree_find(folds, buffer, 3), 2, 11);
+  check_fold(buffer, fold_tree_find(folds, buffer, 7), 5, 7);
+
+  // a fold goes away with its first row, the nested ones stay
+  buffer_set_current_row(buffer, buffer_get_row(buffer, 5));
+  buffer_remove_current_rows(buffer, 1);
+  check_fold(buffer, fold_tree_find(folds, buffer, 5), 2, 10);
+
+  // removing the fold moves its children up
+  TEST_CHECK(add_fold(buffer, 5, 6));
+  fold_tree_remove(folds, fold_tree_find(folds, buffer, 2));
+  TEST_CHECK(fold_tree_find(folds, buffer, 2) == NULL);
+  check_fold(buffer, fold_tree_find(folds, buffer, 5), 5, 6);
+  TEST_CHECK(fold_get_level(fold_tree_find(folds, buffer, 5)) == 1);
+
+  fold_tree_clear(folds);
+  TEST_CHECK(fold_tree_find(folds, buffer, 5) == NULL);
+  TEST_CHECK(buffer_get_row(buffer, 5)->fold_first == NULL);
+  buffer_free(buffer);
+}
+
+void test_fold_tree_add_indent_folds(void) {
+  Buffer* buffer = buffer_alloc();
+  buffer_append_line(buffer, "int main() {");
+  buffer_append_line(buffer, "  if (a) {");
+  buffer_append_line(buffer, "    b();");
+  buffer_append_line(buffer, "");
+  buffer_append_line(buffer, "    c();");
+  buffer_append_line(buffer, "  }");
+  buffer_append_line(buffer, "}");
+  buffer_append_line(buffer, "");
+  buffer_append_line(buffer, "void f() {");
+  buffer_append_line(buffer, "  g();");
+  buffer_append_line(buffer, "}");
+  FoldTree* folds = &buffer->folds;
+  fold_tree_add_indent_folds(folds, buffer, 2);
+  TEST_CHECK(fold_tree_find(folds, buffer, 0) == NULL);
+  check_fold(buffer, fold_tree_find(folds, buffer, 1), 1, 5);
+  check_fold(buffer, fold_tree_find(folds, buffer, 3), 2, 4);
+  TEST_CHECK(fold_tree_find(folds, buffer, 7) == NULL);
+  // single rows are not folded
+  TEST_CHECK(fold_tree_find(folds, buffer, 9) == NULL);
+  check_fold(buffer, fold_tree_find_closed(folds, buffer, 3), 1, 5);
+  buffer_free(buffer);
+}
+
+void test_fold_tree_add_brace_folds(void) {
+  Buffer* buffer = buffer_alloc();
+  buffer_append_line(buffer, "int main() {");
+  buffer_append_line(buffer, "  if (a) { b(); }");
+  buffer_append_line(buffer, "  if (c) {");
+  buffer_append_line(buffer, "    puts(\"{\");");
+  buffer_append_line(buffer, "  } else {");
+  buffer_append_line(buffer, "    d();");
+  buffer_append_line(buffer, "  }");
+  buffer_append_line(buffer, "}");
+  FoldTree* folds = &buffer->folds;
+  fold_tree_add_brace_folds(folds, buffer);
+  check_fold(buffer, fold_tree_find(folds, buffer, 1), 0, 7);
+  check_fold(buffer, fold_tree_find(folds, buffer, 3), 2, 3);
+  check_fold(buffer, fold_tree_find(folds, buffer, 5), 4, 6);
+  buffer_free(buffer);
+}
+
+TEST_LIST = {
+  {"test_fold_tree_add", test_fold_tree_add},
+  {"test_fold_tree_edits", test_fold_tree_edits},
+  {"test_fold_tree_add_indent_folds", test_fold_tree_add_indent_folds},
+  {"test_fold_tree_add_brace_folds", test_fold_tree_add_brace_folds},
+  {NULL, NULL}  // zeroed record marking the end of the list
+};
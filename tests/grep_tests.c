@@ -0,0 +1,158 @@
+/*
+ Copyright (c) 2025 Mateusz Stadnik
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "acutest.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "grep.h"
+
+#define GREP_TEST_DIRECTORY "build/grep_test"
+
+static void write_file(const char* filename, const char* text) {
+  FILE* file = fopen(filename, "w");
+  TEST_ASSERT(file != NULL);
+  fputs(text, file);
+  fclose(file);
+}
+
+static void create_tree(void) {
+  mkdir(GREP_TEST_DIRECTORY, 0755);
+  mkdir(GREP_TEST_DIRECTORY "/src", 0755);
+  mkdir(GREP_TEST_DIRECTORY "/.git", 0755);
+  write_file(GREP_TEST_DIRECTORY "/a.c",
+             "int main() {\n  return buffer_alloc();\n}\n");
+  write_file(GREP_TEST_DIRECTORY "/src/b.c",
+             "// buffer_alloc\nBuffer* buffer_alloc() {\r\n  return NULL;\n}");
+  write_file(GREP_TEST_DIRECTORY "/.git/c.c", "buffer_alloc\n");
+  // binary files are skipped
+  FILE* file = fopen(GREP_TEST_DIRECTORY "/d.o", "wb");
+  TEST_ASSERT(file != NULL);
+  fwrite("buffer_alloc\0\n", 1, 14, file);
+  fclose(file);
+}
+
+static void remove_tree(void) {
+  remove(GREP_TEST_DIRECTORY "/a.c");
+  remove(GREP_TEST_DIRECTORY "/src/b.c");
+  remove(GREP_TEST_DIRECTORY "/.git/c.c");
+  remove(GREP_TEST_DIRECTORY "/d.o");
+  rmdir(GREP_TEST_DIRECTORY "/src");
+  rmdir(GREP_TEST_DIRECTORY "/.git");
+  rmdir(GREP_TEST_DIRECTORY);
+}
+
+static void check_entry(const QuickfixList* list,
+                        int index,
+                        const char* filename,
+                        int line,
+                        int column,
+                        const char* text) {
+  const QuickfixEntry* entry = &list->entries[index];
+  TEST_CHECK(strcmp(quickfix_get_filename(list, entry), filename) == 0);
+  TEST_CHECK(entry->line == line && entry->column == column);
+  TEST_CHECK(strcmp(entry->text, text) == 0);
+  TEST_MSG("%d: %s:%d:%d %s", index, quickfix_get_filename(list, entry), entry->line,
+           entry->column, entry->text);
+}
+
+static int poll_calls = 0;
+
+static bool count_polls(void* context) {
+  (void)context;
+  ++poll_calls;
+  return true;
+}
+
+static void grep(WorkerPool* pool, const char* pattern, QuickfixList* list) {
+  const char* paths[] = {GREP_TEST_DIRECTORY};
+  char** files = NULL;
+  const int number_of_files = grep_collect_files(paths, 1, &files);
+  TEST_CHECK(number_of_files == 3);
+  SearchPattern search;
+  const char* error = NULL;
+  TEST_ASSERT(search_pattern_init(&search, pattern, &error));
+  quickfix_deinit(list);
+  TEST_CHECK(grep_files(&search, files, number_of_files, pool, list, count_polls,
+                        NULL));
+  search_pattern_deinit(&search);
+  grep_free_files(files, number_of_files);
+}
+
+void test_grep_files(void) {
+  create_tree();
+  WorkerPool pool;
+  TEST_ASSERT(worker_pool_init(&pool, 4));
+  QuickfixList list;
+  quickfix_init(&list);
+
+  grep(&pool, "buffer_alloc", &list);
+  TEST_ASSERT(list.number_of_entries == 3);
+  // the order of the files does not depend on the workers
+  check_entry(&list, 0, GREP_TEST_DIRECTORY "/a.c", 1, 9,
+              "  return buffer_alloc();");
+  check_entry(&list, 1, GREP_TEST_DIRECTORY "/src/b.c", 0, 3, "// buffer_alloc");
+  check_entry(&list, 2, GREP_TEST_DIRECTORY "/src/b.c", 1, 8,
+              "Buffer* buffer_alloc() {");
+
+  grep(&pool, "^[a-z]\\+ ", &list);
+  TEST_ASSERT(list.number_of_entries == 1);
+  check_entry(&list, 0, GREP_TEST_DIRECTORY "/a.c", 0, 0, "int main() {");
+
+  // a line without '\n' at the end of the file
+  grep(&pool, "^}$", &list);
+  TEST_CHECK(list.number_of_entries == 2);
+
+  grep(&pool, "nothing", &list);
+  TEST_CHECK(list.number_of_entries == 0);
+
+  quickfix_deinit(&list);
+  worker_pool_deinit(&pool);
+  remove_tree();
+}
+
+void test_quickfix_move(void) {
+  QuickfixList list;
+  quickfix_init(&list);
+  TEST_CHECK(quickfix_move(&list, 1) == NULL);
+  const int file = quickfix_add_file(&list, "a.c");
+  TEST_CHECK(quickfix_add_entry(&list, file, 3, 1, "first", 5));
+  TEST_CHECK(quickfix_add_entry(&list, file, 7, 2, "second line", 6));
+
+  const QuickfixEntry* entry = quickfix_move(&list, 1);
+  TEST_ASSERT(entry != NULL);
+  TEST_CHECK(entry->line == 3 && strcmp(entry->text, "first") == 0);
+  entry = quickfix_move(&list, 1);
+  TEST_ASSERT(entry != NULL);
+  TEST_CHECK(entry->line == 7 && strcmp(entry->text, "second") == 0);
+  TEST_CHECK(quickfix_move(&list, 1) == NULL);
+  TEST_CHECK(list.current == 1);
+  entry = quickfix_move(&list, -1);
+  TEST_CHECK(entry != NULL && entry->line == 3);
+  TEST_CHECK(quickfix_move(&list, -1) == NULL);
+  TEST_CHECK(strcmp(quickfix_get_filename(&list, entry), "a.c") == 0);
+  quickfix_deinit(&list);
+}
+
+TEST_LIST = {
+  {"test_grep_files", test_grep_files},
+  {"test_quickfix_move", test_quickfix_move},
+  {NULL, NULL}  // zeroed record marking the end of the list
+};
@@ -0,0 +1,124 @@
+/*
+ Copyright (c) 2025 Mateusz Stadnik
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "acutest.h"
+
+#include <string.h>
+
+#include "buffer.h"
+#include "identifier_index.h"
+
+static int find_id(const IdentifierIndex* index, const char* text) {
+  for (int id = 0; id < index->number_of_entries; ++id) {
+    int length = 0;
+    const char* identifier = identifier_index_get(index, id, &length);
+    if (length == (int)strlen(text) && memcmp(identifier, text, length) == 0) {
+      return id;
+    }
+  }
+  return -1;
+}
+
+static void check_candidates(IdentifierIndex* index,
+                             const char* prefix,
+                             const char** expected,
+                             int count) {
+  int* ids = NULL;
+  const int number_of_ids =
+    identifier_index_complete(index, prefix, (int)strlen(prefix), &ids);
+  TEST_CHECK(number_of_ids == count);
+  TEST_MSG("prefix %s: %d candidates", prefix, number_of_ids);
+  for (int i = 0; i < number_of_ids && i < count; ++i) {
+    int length = 0;
+    const char* identifier = identifier_index_get(index, ids[i], &length);
+    TEST_CHECK(length == (int)strlen(expected[i]) &&
+               memcmp(identifier, expected[i], length) == 0);
+    TEST_MSG("%d: %.*s", i, length, identifier);
+  }
+  free(ids);
+}
+
+void test_identifier_index_add(void) {
+  IdentifierIndex index;
+  identifier_index_init(&index);
+  const int id = identifier_index_add(&index, "buffer_row", 10);
+  TEST_CHECK(identifier_index_add(&index, "buffer_row_free", 15) != id);
+  TEST_CHECK(identifier_index_add(&index, "buffer_rowx", 10) == id);
+  TEST_CHECK(identifier_index_get_count(&index, id) == 2);
+  identifier_index_add(&index, "buffer", 6);
+  identifier_index_add(&index, "Buffer", 6);
+
+  const char* expected[] = {"buffer", "buffer_row", "buffer_row_free"};
+  check_candidates(&index, "buf", expected, 3);
+  check_candidates(&index, "buffer_row", expected + 2, 1);
+
+  // identifiers no longer used are not offered
+  identifier_index_release(&index, id);
+  identifier_index_release(&index, id);
+  TEST_CHECK(identifier_index_get_count(&index, id) == 0);
+  const char* left[] = {"buffer", "buffer_row_free"};
+  check_candidates(&index, "buf", left, 2);
+  TEST_CHECK(identifier_index_add(&index, "buffer_row", 10) == id);
+
+  // enough to rehash the table a few times
+  char name[16];
+  for (int i = 0; i < 5000; ++i) {
+    snprintf(name, sizeof(name), "name%d", i);
+    identifier_index_add(&index, name, (int)strlen(name));
+  }
+  TEST_CHECK(find_id(&index, "name4999") >= 0);
+  const char* expected_names[] = {"name4990", "name4991", "name4992", "name4993",
+                                  "name4994", "name4995", "name4996", "name4997",
+                                  "name4998", "name4999"};
+  check_candidates(&index, "name499", expected_names, 10);
+  int* ids = NULL;
+  // name490 to name499 and name4900 to name4999
+  TEST_CHECK(identifier_index_complete(&index, "name49", 6, &ids) == 110);
+  free(ids);
+  identifier_index_deinit(&index);
+}
+
+void test_identifier_index_rows(void) {
+  IdentifierIndex index;
+  identifier_index_init(&index);
+  buffer_row_set_identifier_index(&index);
+  Buffer* buffer = buffer_alloc();
+  buffer_append_line(buffer, "int counter = counter_max;");
+  buffer_append_line(buffer, "// counted in comments");
+  buffer_append_line(buffer, "counter++;");
+  TEST_CHECK(identifier_index_get_count(&index, find_id(&index, "counter")) == 2);
+  TEST_CHECK(find_id(&index, "counted") < 0);
+
+  // an edit replaces only the identifiers of the edited row
+  BufferRow* row = buffer_get_row(buffer, 2);
+  buffer_row_replace_line(row, "count++;");
+  TEST_CHECK(identifier_index_get_count(&index, find_id(&index, "counter")) == 1);
+  TEST_CHECK(identifier_index_get_count(&index, find_id(&index, "count")) == 1);
+  const char* expected[] = {"counter", "counter_max"};
+  check_candidates(&index, "count", expected, 2);
+
+  buffer_free(buffer);
+  TEST_CHECK(identifier_index_get_count(&index, find_id(&index, "counter")) == 0);
+  buffer_row_set_identifier_index(NULL);
+  identifier_index_deinit(&index);
+}
+
+TEST_LIST = {
+  {"test_identifier_index_add", test_identifier_index_add},
+  {"test_identifier_index_rows", test_identifier_index_rows},
+  {NULL, NULL}  // zeroed record marking the end of the list
+};
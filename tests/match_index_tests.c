@@ -0,0 +1,188 @@
+/*
+ Copyright (c) 2025 Mateusz Stadnik
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "acutest.h"
+
+#include "buffer.h"
+#include "match_index.h"
+
+static Buffer* create_buffer(void) {
+  Buffer* buffer = buffer_alloc();
+  buffer_append_line(buffer, "foo bar foo");
+  buffer_append_line(buffer, "nothing");
+  buffer_append_line(buffer, "foofoo");
+  buffer_append_line(buffer, "");
+  buffer_append_line(buffer, "the end foo");
+  return buffer;
+}
+
+void test_match_index_update(void) {
+  Buffer* buffer = create_buffer();
+  SearchPattern pattern;
+  const char* error = NULL;
+  TEST_CHECK(search_pattern_init(&pattern, "foo", &error));
+  MatchIndex index;
+  match_index_init(&index, false);
+  TEST_CHECK(!match_index_is_complete(&index));
+
+  match_index_reset(&index, buffer->head);
+  // two rows at a time as the idle loop does
+  TEST_CHECK(!match_index_update(&index, &pattern, 2));
+  TEST_CHECK(match_index_get_number_of_matches(&index) == 2);
+  TEST_CHECK(!match_index_is_complete(&index));
+  TEST_CHECK(!match_index_update(&index, &pattern, 2));
+  TEST_CHECK(match_index_update(&index, &pattern, 2));
+  TEST_CHECK(match_index_is_complete(&index));
+
+  const MatchPosition expected[] = {
+    {0, 0, NULL}, {0, 8, NULL}, {2, 0, NULL}, {2, 3, NULL}, {4, 8, NULL},
+  };
+  TEST_CHECK(match_index_get_number_of_matches(&index) == 5);
+  for (int i = 0; i < 5; ++i) {
+    TEST_CHECK(match_index_get(&index, i)->line == expected[i].line);
+    TEST_CHECK(match_index_get(&index, i)->column == expected[i].column);
+  }
+
+  // starting over drops the old matches
+  match_index_reset(&index, buffer->head->next);
+  TEST_CHECK(match_index_update(&index, &pattern, 100));
+  TEST_CHECK(match_index_get_number_of_matches(&index) == 3);
+  TEST_CHECK(match_index_get(&index, 0)->line == 1);
+
+  match_index_reset(&index, NULL);
+  TEST_CHECK(!match_index_update(&index, &pattern, 100));
+  TEST_CHECK(!match_index_is_complete(&index));
+
+  match_index_deinit(&index);
+  search_pattern_deinit(&pattern);
+  buffer_free(buffer);
+}
+
+void test_match_index_find(void) {
+  Buffer* buffer = create_buffer();
+  SearchPattern pattern;
+  const char* error = NULL;
+  TEST_CHECK(search_pattern_init(&pattern, "foo", &error));
+  MatchIndex index;
+  match_index_init(&index, false);
+  match_index_reset(&index, buffer->head);
+  TEST_CHECK(match_index_update(&index, &pattern, 100));
+
+  TEST_CHECK(match_index_find(&index, 0, 0, false) == 1);
+  TEST_CHECK(match_index_find(&index, 0, 8, false) == 2);
+  TEST_CHECK(match_index_find(&index, 1, 3, false) == 2);
+  TEST_CHECK(match_index_find(&index, 4, 8, false) == -1);
+  TEST_CHECK(match_index_find(&index, 2, 3, true) == 2);
+  TEST_CHECK(match_index_find(&index, 2, 0, true) == 1);
+  TEST_CHECK(match_index_find(&index, 0, 0, true) == -1);
+  TEST_CHECK(match_index_find(&index, 9, 0, true) == 4);
+
+  TEST_CHECK(match_index_locate(&index, 2, 3) == 3);
+  TEST_CHECK(match_index_locate(&index, 2, 2) == -1);
+
+  match_index_deinit(&index);
+  search_pattern_deinit(&pattern);
+  buffer_free(buffer);
+}
+
+// the index kept up to date by edits has to match a fresh scan
+static void check_against_rescan(const MatchIndex* index,
+                                 const SearchPattern* pattern,
+                                 Buffer* buffer) {
+  MatchIndex fresh;
+  match_index_init(&fresh, index->rows_only);
+  match_index_reset(&fresh, buffer->head);
+  match_index_update(&fresh, pattern, buffer->number_of_rows);
+  TEST_CHECK(index->next_line <= buffer->number_of_rows);
+  // only the scanned part is compared
+  int count = 0;
+  while (count < fresh.number_of_matches &&
+         fresh.matches[count].line < index->next_line) {
+    ++count;
+  }
+  TEST_CHECK(index->number_of_matches == count);
+  TEST_MSG("expected %d matches, got %d", count, index->number_of_matches);
+  for (int i = 0; i < count && i < index->number_of_matches; ++i) {
+    TEST_CHECK(index->matches[i].line == fresh.matches[i].line);
+    TEST_CHECK(index->matches[i].column == fresh.matches[i].column);
+    TEST_CHECK(index->matches[i].row == fresh.matches[i].row);
+  }
+  match_index_deinit(&fresh);
+}
+
+void test_match_index_edits(void) {
+  SearchPattern pattern;
+  const char* error = NULL;
+  TEST_CHECK(search_pattern_init(&pattern, "ab", &error));
+  unsigned int seed = 7;
+
+  for (int rows_only = 0; rows_only < 2; ++rows_only) {
+    Buffer* buffer = buffer_alloc();
+    for (int i = 0; i < 40; ++i) {
+      buffer_append_line(buffer, i % 3 ? "xx ab ab" : "nothing");
+    }
+    MatchIndex index;
+    match_index_init(&index, rows_only);
+    match_index_reset(&index, buffer->head);
+    // a partial index has to stay valid as well
+    match_index_update(&index, &pattern, 20);
+
+    for (int step = 0; step < 200; ++step) {
+      seed = seed * 1103515245 + 12345;
+      const int line = (seed >> 8) % buffer->number_of_rows;
+      buffer->current_row = buffer_get_row(buffer, line);
+      switch ((seed >> 4) % 4) {
+        case 0: {
+          buffer_row_replace_line(buffer->current_row, step % 2 ? "ab" : "a b");
+          match_index_update_row(&index, &pattern, buffer->current_row, line);
+        } break;
+        case 1: {
+          buffer_break_current_line(buffer, 3);
+          match_index_update_row(&index, &pattern, buffer->current_row, line);
+          match_index_insert_rows(&index, &pattern, buffer->current_row->next,
+                                  line + 1, 1);
+        } break;
+        case 2: {
+          if (buffer->number_of_rows > 2) {
+            const int removed = buffer_remove_current_rows(buffer, 2);
+            BufferRow* next =
+              line < buffer->number_of_rows ? buffer->current_row : NULL;
+            match_index_remove_rows(&index, next, line, removed);
+          }
+        } break;
+        default: {
+          match_index_update(&index, &pattern, 3);
+        } break;
+      }
+      check_against_rescan(&index, &pattern, buffer);
+    }
+    match_index_update(&index, &pattern, buffer->number_of_rows);
+    TEST_CHECK(match_index_is_complete(&index));
+    check_against_rescan(&index, &pattern, buffer);
+
+    match_index_deinit(&index);
+    buffer_free(buffer);
+  }
+  search_pattern_deinit(&pattern);
+}
+
+TEST_LIST = {
+  {"test_match_index_update", test_match_index_update},
+  {"test_match_index_find", test_match_index_find},
+  {"test_match_index_edits", test_match_index_edits},
+  {NULL, NULL}  // zeroed record marking the end of the list
+};
@@ -0,0 +1,132 @@
+/*
+ Copyright (c) 2025 Mateusz Stadnik
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "acutest.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "path_index.h"
+
+#define PATH_INDEX_TEST_DIRECTORY "build/path_index_test"
+
+static int score(const char* path, const char* query) {
+  return path_index_score(path, (int)strlen(path), query, (int)strlen(query));
+}
+
+void test_path_index_score(void) {
+  TEST_CHECK(score("src/editor.c", "xyz") < 0);
+  TEST_CHECK(score("editor.c", "ce") < 0);
+  TEST_CHECK(score("src/editor.c", "") == 0);
+  TEST_CHECK(score("src/editor.c", "EDIT") > 0);
+  // file name over directories, word starts over the middle of words
+  TEST_CHECK(score("src/editor.c", "e") > score("editor/src.c", "e"));
+  TEST_CHECK(score("buffer_row.c", "br") > score("abracadabra.c", "br"));
+  TEST_CHECK(score("buffer_row.c", "row") > score("buffer_arrow.c", "row"));
+  // consecutive characters and the matching case
+  TEST_CHECK(score("editor.c", "dit") > score("xdxixt.c", "dit"));
+  TEST_CHECK(score("Makefile", "Make") > score("Makefile", "make"));
+  // the shortest occurrence is scored, not the first character found
+  TEST_CHECK(score("a_x/abc.c", "abc") == score("abc.c", "abc"));
+}
+
+static void create_file(const char* filename) {
+  FILE* file = fopen(filename, "w");
+  TEST_ASSERT(file != NULL);
+  fclose(file);
+}
+
+// relative to the test directory as the editor indexes its working directory
+static const char* test_files[] = {
+  "buffer.c",
+  "buffer_row.c",
+  "editor.c",
+  "tests/buffer_tests.c",
+  "tests/Makefile",
+};
+
+#define NUMBER_OF_TEST_FILES (int)(sizeof(test_files) / sizeof(test_files[0]))
+
+static void check_results(PathIndex* index,
+                          const char* query,
+                          const char** expected,
+                          int count) {
+  int results[3];
+  const int number_of_results = path_index_find(index, query, results, 3);
+  TEST_CHECK(number_of_results == count);
+  TEST_MSG("%s: %d results", query, number_of_results);
+  for (int i = 0; i < number_of_results && i < count; ++i) {
+    TEST_CHECK(strcmp(index->paths[results[i]], expected[i]) == 0);
+    TEST_MSG("%s %d: %s", query, i, index->paths[results[i]]);
+  }
+}
+
+void test_path_index_find(void) {
+  mkdir(PATH_INDEX_TEST_DIRECTORY, 0755);
+  TEST_ASSERT(chdir(PATH_INDEX_TEST_DIRECTORY) == 0);
+  mkdir("tests", 0755);
+  for (int i = 0; i < NUMBER_OF_TEST_FILES; ++i) {
+    create_file(test_files[i]);
+  }
+  PathIndex index;
+  path_index_init(&index);
+  TEST_ASSERT(path_index_build(&index, "."));
+  TEST_CHECK(index.number_of_paths == NUMBER_OF_TEST_FILES);
+
+  const char* buf[] = {test_files[0], test_files[1], test_files[3]};
+  check_results(&index, "buf", buf, 3);
+  TEST_CHECK(index.number_of_matches == 3);
+  // narrowed down from the matches of "buf"
+  const char* bufw[] = {test_files[1]};
+  check_results(&index, "bufw", bufw, 1);
+  TEST_CHECK(index.number_of_matches == 1);
+  // a query not extending the previous one searches all paths again
+  const char* bufs[] = {test_files[3]};
+  check_results(&index, "bufs", bufs, 1);
+  check_results(&index, "buf", buf, 3);
+  const char* make[] = {test_files[4]};
+  check_results(&index, "tmake", make, 1);
+  check_results(&index, "qqq", NULL, 0);
+  // only the best results are returned, all matches are counted
+  int results[1];
+  TEST_CHECK(path_index_find(&index, "c", results, 1) == 1);
+  TEST_CHECK(index.number_of_matches == 4);
+
+  // a new file shows up after the next build
+  create_file("tags.c");
+  check_results(&index, "tags", NULL, 0);
+  TEST_ASSERT(path_index_build(&index, "."));
+  const char* tags[] = {"tags.c"};
+  check_results(&index, "tags", tags, 1);
+  path_index_deinit(&index);
+
+  remove("tags.c");
+  for (int i = 0; i < NUMBER_OF_TEST_FILES; ++i) {
+    remove(test_files[i]);
+  }
+  rmdir("tests");
+  TEST_CHECK(chdir("../..") == 0);
+  rmdir(PATH_INDEX_TEST_DIRECTORY);
+}
+
+TEST_LIST = {
+  {"test_path_index_score", test_path_index_score},
+  {"test_path_index_find", test_path_index_find},
+  {NULL, NULL}  // zeroed record marking the end of the list
+};
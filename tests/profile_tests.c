@@ -0,0 +1,124 @@
+/*
+ Copyright (c) 2025 Mateusz Stadnik
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "acutest.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "buffer.h"
+#include "profile.h"
+
+void test_profile_timers(void) {
+  profile_reset();
+  profile_begin(ProfileTimer_Dispatch);
+  // nested, e.g. a macro replayed from a key, ends with the outer one
+  profile_begin(ProfileTimer_Dispatch);
+  profile_end(ProfileTimer_Dispatch);
+  ProfileSummary summary;
+  profile_begin(ProfileTimer_Input);
+  profile_cancel(ProfileTimer_Input);
+  profile_end(ProfileTimer_Render);
+  profile_end_frame();
+  profile_summarize(&summary);
+  TEST_CHECK(summary.average_nanoseconds[ProfileTimer_Dispatch] == 0);
+  TEST_CHECK(summary.average_nanoseconds[ProfileTimer_Input] == 0);
+  TEST_CHECK(summary.average_nanoseconds[ProfileTimer_Render] == 0);
+
+  volatile long sum = 0;
+  for (long i = 0; i < 1000000; ++i) {
+    sum += i;
+  }
+  profile_end(ProfileTimer_Dispatch);
+  profile_end_frame();
+  profile_summarize(&summary);
+  TEST_CHECK(summary.number_of_frames == 2);
+  TEST_CHECK(summary.maximum.nanoseconds[ProfileTimer_Dispatch] > 0);
+  TEST_CHECK(summary.average_nanoseconds[ProfileTimer_Dispatch] ==
+             summary.maximum.nanoseconds[ProfileTimer_Dispatch] / 2.0);
+}
+
+void test_profile_rolling_frames(void) {
+  profile_reset();
+  ProfileSummary summary;
+  profile_summarize(&summary);
+  TEST_CHECK(summary.number_of_frames == 0 && summary.total_frames == 0);
+
+  const int count = PROFILE_NUMBER_OF_FRAMES + 10;
+  for (int i = 0; i < count; ++i) {
+    profile_count(ProfileCounter_RowsRedrawn, i);
+    profile_count(ProfileCounter_BytesWritten, 100);
+    profile_end_frame();
+  }
+  profile_summarize(&summary);
+  TEST_CHECK(summary.total_frames == count);
+  TEST_CHECK(summary.number_of_frames == PROFILE_NUMBER_OF_FRAMES);
+  TEST_CHECK(summary.maximum.counters[ProfileCounter_RowsRedrawn] == count - 1);
+  // frames 10 to count - 1 are kept
+  TEST_CHECK(summary.average_counters[ProfileCounter_RowsRedrawn] ==
+             (10 + count - 1) / 2.0);
+  TEST_CHECK(summary.average_counters[ProfileCounter_BytesWritten] == 100);
+  TEST_CHECK(summary.maximum.counters[ProfileCounter_BytesWritten] == 100);
+}
+
+void test_profile_counters(void) {
+  profile_reset();
+  void* volatile pointer = malloc(16);
+  pointer = realloc(pointer, 32);
+  free(pointer);
+  pointer = calloc(4, 4);
+  free(pointer);
+
+  Buffer* buffer = buffer_alloc();
+  buffer_append_line(buffer, "int a;");
+  buffer_append_line(buffer, "int b;");
+  buffer_row_highlight_line(buffer_get_first_row(buffer));
+  profile_end_frame();
+  ProfileSummary summary;
+  profile_summarize(&summary);
+  TEST_CHECK(summary.maximum.counters[ProfileCounter_Allocations] > 3);
+  TEST_CHECK(summary.maximum.counters[ProfileCounter_RowsHighlighted] >= 1);
+  buffer_free(buffer);
+}
+
+void test_profile_format(void) {
+  profile_reset();
+  profile_count(ProfileCounter_RowsHighlighted, 7);
+  profile_end_frame();
+  char text[2048];
+  const int length = profile_format(text, sizeof(text));
+  TEST_CHECK(length == (int)strlen(text));
+  TEST_CHECK(strncmp(text, "1 frames", 8) == 0);
+  TEST_CHECK(strstr(text, "key dispatch (us)") != NULL);
+  TEST_CHECK(strstr(text, "terminal flush (us)") != NULL);
+  TEST_CHECK(strstr(text, "rows highlighted              7.0          7\n") != NULL);
+  TEST_MSG("%s", text);
+
+  // cut as snprintf does
+  char short_text[32];
+  TEST_CHECK(profile_format(short_text, sizeof(short_text)) == length);
+  TEST_CHECK(strncmp(short_text, text, sizeof(short_text) - 1) == 0);
+  TEST_CHECK(short_text[sizeof(short_text) - 1] == '\0');
+}
+
+TEST_LIST = {
+  {"test_profile_timers", test_profile_timers},
+  {"test_profile_rolling_frames", test_profile_rolling_frames},
+  {"test_profile_counters", test_profile_counters},
+  {"test_profile_format", test_profile_format},
+  {NULL, NULL}  // zeroed record marking the end of the list
+};
@@ -0,0 +1,209 @@
+/*
+ Copyright (c) 2025 Mateusz Stadnik
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "acutest.h"
+
+#include "regexp.h"
+
+static bool search(const char* pattern,
+                   const char* text,
+                   int start,
+                   RegexpMatch* match) {
+  const char* error = NULL;
+  Regexp* regexp = regexp_compile(pattern, &error);
+  TEST_CHECK(regexp != NULL);
+  TEST_MSG("pattern %s: %s", pattern, error ? error : "");
+  if (regexp == NULL) {
+    return false;
+  }
+  const bool found = regexp_search(regexp, text, strlen(text), start, match);
+  regexp_free(regexp);
+  return found;
+}
+
+static void check_match(const char* pattern,
+                        const char* text,
+                        int start,
+                        int length) {
+  RegexpMatch match = {-1, -1};
+  TEST_CHECK(search(pattern, text, 0, &match));
+  TEST_CHECK(match.start == start && match.length == length);
+  TEST_MSG("/%s/ on '%s': expected (%d, %d), got (%d, %d)", pattern, text, start,
+           length, match.start, match.length);
+}
+
+static void check_no_match(const char* pattern, const char* text) {
+  RegexpMatch match;
+  TEST_CHECK(!search(pattern, text, 0, &match));
+  TEST_MSG("/%s/ should not match '%s'", pattern, text);
+}
+
+void test_regexp_literals_and_sets(void) {
+  check_match("b.d", "abcde", 1, 3);
+  check_match("[0-9]\\+", "abc 1234 x", 4, 4);
+  check_match("[^a-z ]", "ab cD", 4, 1);
+  check_match("[[:upper:]][[:digit:]]", "aB3", 1, 2);
+  check_match("\\d\\s\\w", "x 1 y", 2, 3);
+  check_match("a\\.b", "axb a.b", 4, 3);
+  check_match("*x", "a*x", 1, 2);
+  check_no_match("[xyz]", "abc");
+}
+
+void test_regexp_repeats_are_longest(void) {
+  check_match("a*", "aaab", 0, 3);
+  check_match("ba*", "xbaaa", 1, 4);
+  check_match("colou\\=r", "color colour", 0, 5);
+  check_match("x\\(ab\\)\\+", "xababa", 0, 5);
+  // leftmost wins over shorter matches further right
+  check_match("a.*z\\|b", "a b z", 0, 5);
+  check_match("foo\\|foobar", "foobar", 0, 6);
+}
+
+void test_regexp_anchors(void) {
+  check_match("^int", "int main", 0, 3);
+  check_no_match("^main", "int main");
+  check_match("main$", "int main", 4, 4);
+  check_no_match("int$", "int main");
+  check_match("^$", "", 0, 0);
+  check_match("\\(^a\\|b$\\)", "cab", 2, 1);
+  check_match("a$b", "a$b", 0, 3);
+
+  RegexpMatch match;
+  // ^ does not match at a search start inside the text
+  TEST_CHECK(!search("^b", "ab", 1, &match));
+  TEST_CHECK(search("b$", "ab", 1, &match));
+  TEST_CHECK(match.start == 1 && match.length == 1);
+}
+
+void test_regexp_no_catastrophic_backtracking(void) {
+  // (a*)*b on a long run of a's is exponential for backtracking engines
+  static char text[20001];
+  memset(text, 'a', sizeof(text) - 1);
+  text[sizeof(text) - 1] = '\0';
+  check_no_match("\\(a*\\)*b", text);
+  check_match("\\(a\\|aa\\)*$", text, 0, sizeof(text) - 1);
+}
+
+void test_regexp_dfa_cache_flush(void) {
+  // the reversed scan has to remember the last 8 characters, which needs more
+  // states than the cache holds
+  const char* pattern = "[ab][ab][ab][ab][ab][ab][ab]a";
+  static char text[4097];
+  unsigned seed = 12345;
+  for (int i = 0; i < 4096; ++i) {
+    seed = seed * 1103515245u + 12345u;
+    text[i] = (seed >> 16) & 1 ? 'a' : 'b';
+  }
+  text[4096] = '\0';
+
+  const char* error = NULL;
+  Regexp* regexp = regexp_compile(pattern, &error);
+  TEST_CHECK(regexp != NULL);
+  for (int start = 0; start < 4096; start += 97) {
+    int expected = -1;
+    for (int i = start; i + 7 < 4096; ++i) {
+      if (text[i + 7] == 'a') {
+        expected = i;
+        break;
+      }
+    }
+    RegexpMatch match = {-1, -1};
+    const bool found = regexp_search(regexp, text, 4096, start, &match);
+    TEST_CHECK(found == (expected >= 0));
+    if (found) {
+      TEST_CHECK(match.start == expected && match.length == 8);
+    }
+  }
+  regexp_free(regexp);
+}
+
+void test_regexp_search_next(void) {
+  const char* patterns[] = {"a\\+", "^ab", "b*$", "x*", "[0-9]\\+\\|foo", "a.*b"};
+  const char* text = "ab aab 12 foo aaab xb";
+  const int len = strlen(text);
+  for (size_t p = 0; p < sizeof(patterns) / sizeof(patterns[0]); ++p) {
+    const char* error = NULL;
+    Regexp* regexp = regexp_compile(patterns[p], &error);
+    Regexp* fresh = regexp_compile(patterns[p], &error);
+    TEST_ASSERT(regexp != NULL && fresh != NULL);
+    RegexpMatch match;
+    bool found = regexp_search(regexp, text, len, 0, &match);
+    // every later start reuses the first scan and agrees with a new search
+    for (int start = 1; start <= len; ++start) {
+      RegexpMatch expected;
+      const bool expected_found = regexp_search(fresh, text, len, start, &expected);
+      found = regexp_search_next(regexp, text, len, start, &match);
+      TEST_CHECK(found == expected_found);
+      TEST_CHECK(!found ||
+                 (match.start == expected.start && match.length == expected.length));
+      TEST_MSG("/%s/ from %d", patterns[p], start);
+    }
+    regexp_free(regexp);
+    regexp_free(fresh);
+  }
+
+  // a text longer than the start window is scanned again past its end
+  const char* error = NULL;
+  Regexp* regexp = regexp_compile("ab", &error);
+  TEST_ASSERT(regexp != NULL);
+  static char long_text[REGEXP_STARTS_WINDOW * 3];
+  const int long_len = sizeof(long_text);
+  memset(long_text, 'x', long_len);
+  for (int i = 0; i + 1 < long_len; i += 100) {
+    long_text[i] = 'a';
+    long_text[i + 1] = 'b';
+  }
+  RegexpMatch match;
+  int found = 0;
+  for (bool more = regexp_search(regexp, long_text, long_len, 0, &match); more;
+       more = regexp_search_next(regexp, long_text, long_len, match.start + 1,
+                                 &match)) {
+    TEST_CHECK(match.start == found * 100 && match.length == 2);
+    ++found;
+  }
+  TEST_CHECK(found == (long_len + 98) / 100);
+  regexp_free(regexp);
+}
+
+void test_regexp_compile_errors(void) {
+  const char* error = NULL;
+  TEST_CHECK(regexp_compile("\\(abc", &error) == NULL);
+  TEST_CHECK(error != NULL);
+  TEST_CHECK(regexp_compile("abc\\)", &error) == NULL);
+  TEST_CHECK(regexp_compile("[z-a]", &error) == NULL);
+  TEST_CHECK(regexp_compile("abc\\", &error) == NULL);
+}
+
+void test_regexp_is_literal(void) {
+  TEST_CHECK(regexp_is_literal("hello world"));
+  TEST_CHECK(!regexp_is_literal("hel.o"));
+  TEST_CHECK(!regexp_is_literal("^hello"));
+  TEST_CHECK(!regexp_is_literal("a\\+"));
+}
+
+TEST_LIST = {
+  {"test_regexp_literals_and_sets", test_regexp_literals_and_sets},
+  {"test_regexp_repeats_are_longest", test_regexp_repeats_are_longest},
+  {"test_regexp_anchors", test_regexp_anchors},
+  {"test_regexp_no_catastrophic_backtracking",
+   test_regexp_no_catastrophic_backtracking},
+  {"test_regexp_dfa_cache_flush", test_regexp_dfa_cache_flush},
+  {"test_regexp_search_next", test_regexp_search_next},
+  {"test_regexp_compile_errors", test_regexp_compile_errors},
+  {"test_regexp_is_literal", test_regexp_is_literal},
+  {NULL, NULL}  // zeroed record marking the end of the list
+};
@@ -0,0 +1,109 @@
+/*
+ Copyright (c) 2025 Mateusz Stadnik
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "acutest.h"
+
+#include "buffer.h"
+#include "search.h"
+
+void test_search_find_forward(void) {
+  SearchPattern pattern;
+  const char* error = NULL;
+  // 'q' is rare, memchr prefilter is used
+  TEST_CHECK(search_pattern_init(&pattern, "quux", &error));
+  TEST_CHECK(pattern.use_prefilter);
+
+  const char* text = "qu quu quux quux";
+  SearchMatch match;
+  TEST_CHECK(search_find_forward(&pattern, text, strlen(text), 0, &match));
+  TEST_CHECK(match.start == 7);
+  TEST_CHECK(match.length == 4);
+
+  TEST_CHECK(search_find_forward(&pattern, text, strlen(text), 8, &match));
+  TEST_CHECK(match.start == 12);
+
+  TEST_CHECK(!search_find_forward(&pattern, text, strlen(text), 13, &match));
+  search_pattern_deinit(&pattern);
+
+  // common letters only, horspool is used
+  TEST_CHECK(search_pattern_init(&pattern, "eats", &error));
+  TEST_CHECK(!pattern.use_prefilter);
+  text = "eat seat eats tea";
+  TEST_CHECK(search_find_forward(&pattern, text, strlen(text), 0, &match));
+  TEST_CHECK(match.start == 9);
+  TEST_CHECK(!search_find_forward(&pattern, text, strlen(text), 10, &match));
+  search_pattern_deinit(&pattern);
+}
+
+void test_search_find_backward(void) {
+  SearchPattern pattern;
+  const char* error = NULL;
+  TEST_CHECK(search_pattern_init(&pattern, "ab", &error));
+
+  const char* text = "ab ab ab";
+  SearchMatch match;
+  TEST_CHECK(search_find_backward(&pattern, text, strlen(text), 8, &match));
+  TEST_CHECK(match.start == 6);
+  TEST_CHECK(search_find_backward(&pattern, text, strlen(text), 6, &match));
+  TEST_CHECK(match.start == 3);
+  TEST_CHECK(!search_find_backward(&pattern, text, strlen(text), 0, &match));
+
+  search_pattern_deinit(&pattern);
+}
+
+void test_buffer_find_wraps_around(void) {
+  Buffer* buffer = buffer_alloc();
+  buffer_append_line(buffer, "int main() {");
+  buffer_append_line(buffer, "  return 0;");
+  buffer_append_line(buffer, "}");
+
+  SearchPattern pattern;
+  const char* error = NULL;
+  TEST_CHECK(search_pattern_init(&pattern, "main", &error));
+
+  BufferPosition position;
+  BufferRow* last = buffer_get_row(buffer, 2);
+  TEST_CHECK(buffer_find(buffer, &pattern, last, 2, 0, false, &position));
+  TEST_CHECK(position.line == 0);
+  TEST_CHECK(position.column == 4);
+  TEST_CHECK(position.row == buffer->head);
+  TEST_CHECK(position.wrapped);
+
+  // the only match is found again from its own position
+  TEST_CHECK(buffer_find(buffer, &pattern, buffer->head, 0, 4, false, &position));
+  TEST_CHECK(position.line == 0);
+  TEST_CHECK(position.column == 4);
+
+  TEST_CHECK(buffer_find(buffer, &pattern, buffer->head, 0, 0, true, &position));
+  TEST_CHECK(position.line == 0);
+  TEST_CHECK(position.column == 4);
+  TEST_CHECK(position.wrapped);
+
+  search_pattern_deinit(&pattern);
+  TEST_CHECK(search_pattern_init(&pattern, "missing", &error));
+  TEST_CHECK(!buffer_find(buffer, &pattern, buffer->head, 0, 0, false, &position));
+  search_pattern_deinit(&pattern);
+
+  buffer_free(buffer);
+}
+
+TEST_LIST = {
+  {"test_search_find_forward", test_search_find_forward},
+  {"test_search_find_backward", test_search_find_backward},
+  {"test_buffer_find_wraps_around", test_buffer_find_wraps_around},
+  {NULL, NULL}  // zeroed record marking the end of the list
+};
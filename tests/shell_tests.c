@@ -0,0 +1,213 @@
+/*
+ Copyright (c) 2025 Mateusz Stadnik
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "acutest.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "buffer.h"
+#include "line_splitter.h"
+#include "shell.h"
+
+static void check_rows(const BufferRow* row, const char* const* lines, int count) {
+  for (int i = 0; i < count; ++i, row = row->next) {
+    TEST_ASSERT(row != NULL);
+    TEST_CHECK(strcmp(row->data, lines[i]) == 0);
+    TEST_MSG("row %d: '%s'", i, row->data);
+    TEST_CHECK(row->len == (int)strlen(lines[i]));
+  }
+  TEST_CHECK(row == NULL);
+}
+
+static Buffer* create_buffer(const char* const* lines, int count) {
+  Buffer* buffer = buffer_alloc();
+  for (int i = 0; i < count; ++i) {
+    buffer_append_line(buffer, lines[i]);
+  }
+  return buffer;
+}
+
+void test_line_splitter(void) {
+  LineSplitter splitter;
+  line_splitter_init(&splitter);
+  const char* blocks[] = {"first\nsec", "ond\r\n", "\n", "a long", " line ", "split",
+                          "\nlast"};
+  for (size_t i = 0; i < sizeof(blocks) / sizeof(blocks[0]); ++i) {
+    TEST_CHECK(line_splitter_feed(&splitter, blocks[i], strlen(blocks[i])));
+  }
+  TEST_CHECK(splitter.number_of_rows == 4);
+  TEST_CHECK(line_splitter_finish(&splitter));
+  const char* lines[] = {"first", "second", "", "a long line split", "last"};
+  TEST_CHECK(splitter.number_of_rows == 5);
+  check_rows(splitter.head, lines, 5);
+  TEST_CHECK(splitter.tail->next == NULL);
+  TEST_CHECK(splitter.tail->prev->next == splitter.tail);
+
+  BufferRow* head = NULL;
+  BufferRow* tail = NULL;
+  int number_of_rows = 0;
+  line_splitter_take_rows(&splitter, &head, &tail, &number_of_rows);
+  TEST_CHECK(number_of_rows == 5 && splitter.head == NULL);
+  line_splitter_deinit(&splitter);
+
+  Buffer* buffer = buffer_alloc();
+  buffer_replace_rows(buffer, NULL, 0, head, tail, number_of_rows);
+  TEST_CHECK(buffer_get_number_of_lines(buffer) == 5);
+  TEST_CHECK(buffer_get_row_index(buffer, tail) == 4);
+  check_rows(buffer_get_first_row(buffer), lines, 5);
+  buffer_free(buffer);
+}
+
+void test_line_splitter_read_file(void) {
+  FILE* file = fopen("build/line_splitter_test", "w");
+  TEST_ASSERT(file != NULL);
+  fputs("/* comment\nstill comment */\n", file);
+  for (int i = 0; i < 10000; ++i) {
+    fprintf(file, "row %d\n", i);
+  }
+  fputs("no newline", file);
+  fclose(file);
+
+  LineSplitter splitter;
+  line_splitter_init(&splitter);
+  TEST_CHECK(line_splitter_read_file(&splitter, "build/line_splitter_test"));
+  TEST_CHECK(splitter.number_of_rows == 10003);
+  TEST_CHECK(strcmp(splitter.tail->data, "no newline") == 0);
+  BufferRow* head = NULL;
+  BufferRow* tail = NULL;
+  int number_of_rows = 0;
+  line_splitter_take_rows(&splitter, &head, &tail, &number_of_rows);
+  line_splitter_deinit(&splitter);
+
+  // inserted between two rows, highlighted only when a row is needed
+  const char* lines[] = {"int a;", "int b;"};
+  Buffer* buffer = create_buffer(lines, 2);
+  BufferRow* last = buffer_get_row(buffer, 1);
+  buffer_replace_rows(buffer, last, 0, head, tail, number_of_rows);
+  TEST_CHECK(buffer_get_number_of_lines(buffer) == 10005);
+  TEST_CHECK(buffer_get_row_index(buffer, last) == 10004);
+  TEST_CHECK(head->prev == buffer_get_first_row(buffer) && tail->next == last);
+  TEST_CHECK(head->highlight_pending && head->next->highlight_pending);
+  buffer_row_highlight_pending(head->next);
+  TEST_CHECK(!head->highlight_pending && !head->next->highlight_pending);
+  TEST_CHECK(head->next->highlight_data[0] == (char)EHighlightToken_Comment);
+  TEST_CHECK(head->next->next->highlight_pending);
+  buffer_row_highlight_pending(tail);
+  TEST_CHECK(!head->next->next->highlight_pending);
+  buffer_free(buffer);
+
+  line_splitter_init(&splitter);
+  TEST_CHECK(!line_splitter_read_file(&splitter, "build/no_such_file"));
+  TEST_CHECK(splitter.number_of_rows == 0);
+  remove("build/line_splitter_test");
+}
+
+static void filter(Buffer* buffer,
+                   int first,
+                   int count,
+                   const char* command,
+                   int expected_status) {
+  LineSplitter output;
+  line_splitter_init(&output);
+  int status = -1;
+  const char* error = NULL;
+  BufferRow* row = buffer_get_row(buffer, first);
+  TEST_CHECK(shell_filter_rows(command, row, count, &output, NULL, NULL, &status,
+                               &error));
+  TEST_MSG("%s: %s", command, error != NULL ? error : "");
+  TEST_CHECK(status == expected_status);
+  TEST_MSG("%s: status %d", command, status);
+  BufferRow* head = NULL;
+  BufferRow* tail = NULL;
+  int number_of_rows = 0;
+  line_splitter_take_rows(&output, &head, &tail, &number_of_rows);
+  line_splitter_deinit(&output);
+  buffer_replace_rows(buffer, row, count, head, tail, number_of_rows);
+}
+
+void test_shell_filter_rows(void) {
+  const char* lines[] = {"keep", "pear", "apple", "fig", "end"};
+  Buffer* buffer = create_buffer(lines, 5);
+  buffer_scroll_rows(buffer, 2);
+  filter(buffer, 1, 3, "sort", 0);
+  const char* sorted[] = {"keep", "apple", "fig", "pear", "end"};
+  check_rows(buffer_get_first_row(buffer), sorted, 5);
+  TEST_CHECK(buffer_get_row_index(buffer, buffer_get_current_line(buffer)) == 1);
+
+  // more or fewer rows come back, the output of a failed command is kept
+  filter(buffer, 1, 2, "echo one; echo two; echo three", 0);
+  filter(buffer, 0, 1, "cat >/dev/null; exit 3", 3);
+  const char* replaced[] = {"one", "two", "three", "pear", "end"};
+  check_rows(buffer_get_first_row(buffer), replaced, 5);
+  filter(buffer, 4, 1, "echo error >&2", 0);
+  const char* last[] = {"one", "two", "three", "pear", "error"};
+  check_rows(buffer_get_first_row(buffer), last, 5);
+  filter(buffer, 0, 5, "true", 0);
+  TEST_CHECK(buffer_get_number_of_lines(buffer) == 1);
+  TEST_CHECK(buffer_get_first_row(buffer)->len == 0);
+  buffer_free(buffer);
+}
+
+void test_shell_filter_rows_large(void) {
+  // far more than a pipe holds in both directions, a filter writing while it
+  // reads would block if the output was read only after the input was written
+  Buffer* buffer = buffer_alloc();
+  char line[32];
+  for (int i = 0; i < 200000; ++i) {
+    snprintf(line, sizeof(line), "line %d", i);
+    buffer_append_line(buffer, line);
+  }
+  filter(buffer, 0, 200000, "cat", 0);
+  TEST_CHECK(buffer_get_number_of_lines(buffer) == 200000);
+  TEST_CHECK(strcmp(buffer_get_row(buffer, 123456)->data, "line 123456") == 0);
+  // the command stops reading early
+  filter(buffer, 0, 200000, "head -n 2", 0);
+  TEST_CHECK(buffer_get_number_of_lines(buffer) == 2);
+  TEST_CHECK(strcmp(buffer_get_row(buffer, 1)->data, "line 1") == 0);
+  buffer_free(buffer);
+}
+
+static bool interrupt(void* context) {
+  (void)context;
+  return false;
+}
+
+void test_shell_filter_rows_interrupted(void) {
+  // a command ignoring SIGTERM is killed instead of waited for
+  LineSplitter output;
+  line_splitter_init(&output);
+  int status = 0;
+  const char* error = NULL;
+  const time_t start = time(NULL);
+  TEST_CHECK(!shell_filter_rows("trap '' TERM; exec sleep 30", NULL, 0, &output,
+                                interrupt, NULL, &status, &error));
+  TEST_CHECK(time(NULL) - start < 10);
+  TEST_CHECK(error != NULL && strcmp(error, "Interrupted") == 0);
+  TEST_CHECK(status == -1);
+  line_splitter_deinit(&output);
+}
+
+TEST_LIST = {
+  {"test_line_splitter", test_line_splitter},
+  {"test_line_splitter_read_file", test_line_splitter_read_file},
+  {"test_shell_filter_rows", test_shell_filter_rows},
+  {"test_shell_filter_rows_large", test_shell_filter_rows_large},
+  {"test_shell_filter_rows_interrupted", test_shell_filter_rows_interrupted},
+  {NULL, NULL}  // zeroed record marking the end of the list
+};
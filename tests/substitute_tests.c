@@ -0,0 +1,157 @@
+/*
+ Copyright (c) 2025 Mateusz Stadnik
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "acutest.h"
+
+#include "buffer.h"
+#include "substitute.h"
+
+static void check_substitution(const char* pattern,
+                               const char* replacement,
+                               const char* flags,
+                               const char* text,
+                               const char* expected) {
+  Substitution substitution;
+  const char* error = NULL;
+  TEST_CHECK(substitution_init(&substitution, pattern, replacement, flags, &error));
+  char* result = NULL;
+  int length = 0;
+  substitution_build_row(&substitution, text, strlen(text), &result, &length);
+  if (expected == NULL) {
+    TEST_CHECK(result == NULL);
+  } else {
+    TEST_CHECK(result != NULL && strcmp(result, expected) == 0);
+    TEST_CHECK(length == (int)strlen(expected));
+    TEST_MSG("s/%s/%s/%s on '%s': expected '%s', got '%s'", pattern, replacement,
+             flags, text, expected, result ? result : "(null)");
+  }
+  free(result);
+  substitution_deinit(&substitution);
+}
+
+void test_substitution_build_row(void) {
+  check_substitution("foo", "bar", "", "foo foo", "bar foo");
+  check_substitution("foo", "bar", "g", "foo foo", "bar bar");
+  check_substitution("o\\+", "0", "g", "foo boo", "f0 b0");
+  check_substitution("[a-z]\\+", "<&>", "g", "ab 12 cd", "<ab> 12 <cd>");
+  check_substitution("x", "\\&", "", "axb", "a&b");
+  check_substitution("b*", "-", "g", "abc", "-a-c-");
+  check_substitution("^", "// ", "", "code", "// code");
+  check_substitution("missing", "x", "g", "text", NULL);
+}
+
+void test_substitution_flags(void) {
+  Substitution substitution;
+  const char* error = NULL;
+  TEST_CHECK(!substitution_init(&substitution, "a", "b", "gx", &error));
+  TEST_CHECK(error != NULL);
+
+  TEST_CHECK(substitution_init(&substitution, "a", "b", "gn", &error));
+  char* result = NULL;
+  int length = 0;
+  TEST_CHECK(substitution_build_row(&substitution, "banana", 6, &result, &length) ==
+             3);
+  TEST_CHECK(result == NULL);
+  substitution_deinit(&substitution);
+}
+
+void test_substitution_rejected_replacements(void) {
+  Substitution substitution;
+  const char* error = NULL;
+  TEST_CHECK(!substitution_init(&substitution, "\\(a\\)b", "\\1", "", &error));
+  TEST_CHECK(error != NULL && strcmp(error, "No capture groups") == 0);
+  error = NULL;
+  TEST_CHECK(!substitution_init(&substitution, "a", "x\\9", "g", &error));
+  TEST_CHECK(error != NULL && strcmp(error, "No capture groups") == 0);
+  error = NULL;
+  TEST_CHECK(!substitution_init(&substitution, ",", "\\n", "g", &error));
+  TEST_CHECK(error != NULL && strstr(error, "Line breaks") != NULL);
+  error = NULL;
+  TEST_CHECK(!substitution_init(&substitution, ",", "\\r", "g", &error));
+  TEST_CHECK(error != NULL && strstr(error, "Line breaks") != NULL);
+
+  // the whole match and escaped characters are still allowed
+  check_substitution("a", "\\0\\t\\\\", "", "bab", "ba\t\\b");
+}
+
+void test_substitute_rows(void) {
+  Buffer* buffer = buffer_alloc();
+  buffer_append_line(buffer, "int a = 1;");
+  buffer_append_line(buffer, "float b = 2;");
+  buffer_append_line(buffer, "int c = 3;");
+
+  Substitution substitution;
+  const char* error = NULL;
+  TEST_CHECK(substitution_init(&substitution, "int", "long", "g", &error));
+  SubstituteResult result;
+  substitute_rows(&substitution, buffer->head, 3, &result);
+  substitution_deinit(&substitution);
+
+  TEST_CHECK(result.substitutions == 2);
+  TEST_CHECK(result.changed_rows == 2);
+  TEST_CHECK(result.last_changed_row == 2);
+  TEST_CHECK(strcmp(buffer_get_row(buffer, 0)->data, "long a = 1;") == 0);
+  TEST_CHECK(strcmp(buffer_get_row(buffer, 1)->data, "float b = 2;") == 0);
+  TEST_CHECK(strcmp(buffer_get_row(buffer, 2)->data, "long c = 3;") == 0);
+  TEST_CHECK(buffer_get_row(buffer, 2)->len == 11);
+
+  buffer_free(buffer);
+}
+
+void test_substitute_rows_parallel(void) {
+  // enough rows for several chunks
+  const int number_of_rows = 20000;
+  Buffer* buffer = buffer_alloc();
+  char line[32];
+  for (int i = 0; i < number_of_rows; ++i) {
+    snprintf(line, sizeof(line), i % 3 == 0 ? "value %d" : "other %d", i);
+    buffer_append_line(buffer, line);
+  }
+  WorkerPool pool;
+  TEST_CHECK(worker_pool_init(&pool, 4));
+
+  Substitution substitution;
+  const char* error = NULL;
+  TEST_CHECK(substitution_init(&substitution, "val\\(ue\\)", "number", "", &error));
+  SubstituteResult result;
+  TEST_CHECK(substitute_rows_parallel(&substitution, &pool, buffer->head,
+                                      number_of_rows, NULL, NULL, &result));
+  substitution_deinit(&substitution);
+  worker_pool_deinit(&pool);
+
+  TEST_CHECK(result.substitutions == (number_of_rows + 2) / 3);
+  TEST_CHECK(result.changed_rows == (number_of_rows + 2) / 3);
+  TEST_CHECK(result.last_changed_row == 19998);
+  int index = 0;
+  for (BufferRow* row = buffer->head; row != NULL; row = row->next, ++index) {
+    snprintf(line, sizeof(line), index % 3 == 0 ? "number %d" : "other %d", index);
+    TEST_CHECK(strcmp(row->data, line) == 0);
+  }
+  TEST_CHECK(index == number_of_rows);
+
+  buffer_free(buffer);
+}
+
+TEST_LIST = {
+  {"test_substitution_build_row", test_substitution_build_row},
+  {"test_substitution_flags", test_substitution_flags},
+  {"test_substitution_rejected_replacements",
+   test_substitution_rejected_replacements},
+  {"test_substitute_rows", test_substitute_rows},
+  {"test_substitute_rows_parallel", test_substitute_rows_parallel},
+  {NULL, NULL}  // zeroed record marking the end of the list
+};
@@ -0,0 +1,164 @@
+/*
+ Copyright (c) 2025 Mateusz Stadnik
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "acutest.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "buffer.h"
+#include "tags.h"
+
+#define TAGS_TEST_FILE "build/tags_test"
+
+static void write_file(const char* text) {
+  FILE* file = fopen(TAGS_TEST_FILE, "w");
+  TEST_ASSERT(file != NULL);
+  fputs(text, file);
+  fclose(file);
+}
+
+static void check_tag(TagFile* file,
+                      const char* name,
+                      const char* filename,
+                      const char* address) {
+  Tag tag;
+  const bool found = tag_file_find(file, name, (int)strlen(name), &tag);
+  TEST_CHECK(found == (filename != NULL));
+  TEST_MSG("tag %s", name);
+  if (found && filename != NULL) {
+    TEST_CHECK(strcmp(tag.filename, filename) == 0);
+    TEST_CHECK(strcmp(tag.address, address) == 0);
+    TEST_MSG("%s: %s %s", name, tag.filename, tag.address);
+  }
+  tag_deinit(&tag);
+}
+
+void test_tag_file_find(void) {
+  write_file("!_TAG_FILE_FORMAT\t2\t/extended format/\n"
+             "!_TAG_FILE_SORTED\t1\t/0=unsorted, 1=sorted, 2=foldcase/\n"
+             "Buffer\tbuffer.h\t/^typedef struct Buffer {$/;\"\ts\n"
+             "buffer\tbuffer.c\t12\n"
+             "buffer_alloc\tbuffer.c\t/^Buffer* buffer_alloc() {$/;\"\tf\n"
+             "main\tmain.c\t/^int main(int argc, char* argv[]) {$/;\"\tf\n"
+             "path\tdir/a b.c\t/^static const char* path = \"a\\/b\";$/\n");
+  TagFile file;
+  TEST_ASSERT(tag_file_open(&file, TAGS_TEST_FILE));
+  TEST_CHECK(file.sorted == 1);
+  check_tag(&file, "Buffer", "buffer.h", "/^typedef struct Buffer {$/");
+  check_tag(&file, "buffer", "buffer.c", "12");
+  check_tag(&file, "buffer_alloc", "buffer.c", "/^Buffer* buffer_alloc() {$/");
+  check_tag(&file, "main", "main.c", "/^int main(int argc, char* argv[]) {$/");
+  check_tag(&file, "path", "dir/a b.c", "/^static const char* path = \"a\\/b\";$/");
+  check_tag(&file, "buf", NULL, NULL);
+  check_tag(&file, "buffer_free", NULL, NULL);
+  check_tag(&file, "A", NULL, NULL);
+  check_tag(&file, "zzz", NULL, NULL);
+  tag_file_close(&file);
+
+  // ctags writes unsorted files on request and sorts ignoring case with
+  // --sort=foldcase
+  write_file("!_TAG_FILE_SORTED\t0\t/0=unsorted, 1=sorted, 2=foldcase/\n"
+             "main\tmain.c\t3\n"
+             "buffer\tbuffer.c\t12\n");
+  TEST_ASSERT(tag_file_open(&file, TAGS_TEST_FILE));
+  check_tag(&file, "buffer", "buffer.c", "12");
+  check_tag(&file, "main", "main.c", "3");
+  tag_file_close(&file);
+  write_file("!_TAG_FILE_SORTED\t2\t/0=unsorted, 1=sorted, 2=foldcase/\n"
+             "buffer\tbuffer.c\t12\n"
+             "Buffer\tbuffer.h\t20\n"
+             "main\tmain.c\t3\n");
+  TEST_ASSERT(tag_file_open(&file, TAGS_TEST_FILE));
+  check_tag(&file, "Buffer", "buffer.h", "20");
+  check_tag(&file, "buffer", "buffer.c", "12");
+  check_tag(&file, "MAIN", NULL, NULL);
+  tag_file_close(&file);
+
+  TEST_CHECK(!tag_file_open(&file, "build/no_such_tags"));
+  remove(TAGS_TEST_FILE);
+}
+
+void test_tag_file_find_large(void) {
+  // a few MB with lines longer than a block of the cache
+  FILE* output = fopen(TAGS_TEST_FILE, "w");
+  TEST_ASSERT(output != NULL);
+  fputs("!_TAG_FILE_SORTED\t1\t/0=unsorted, 1=sorted, 2=foldcase/\n", output);
+  char padding[6000];
+  memset(padding, 'x', sizeof(padding) - 1);
+  padding[sizeof(padding) - 1] = '\0';
+  for (int i = 0; i < 100000; ++i) {
+    fprintf(output, "name%06d\tfile%d.c\t%d;\"\tf\t%s\n", i, i % 7, i + 1,
+            i % 1000 == 0 ? padding : "");
+  }
+  fclose(output);
+
+  TagFile file;
+  TEST_ASSERT(tag_file_open(&file, TAGS_TEST_FILE));
+  const int names[] = {0, 1, 999, 1000, 1001, 54321, 99999};
+  for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); ++i) {
+    char name[16];
+    char filename[16];
+    char address[16];
+    snprintf(name, sizeof(name), "name%06d", names[i]);
+    snprintf(filename, sizeof(filename), "file%d.c", names[i] % 7);
+    snprintf(address, sizeof(address), "%d", names[i] + 1);
+    check_tag(&file, name, filename, address);
+  }
+  check_tag(&file, "name100000", NULL, NULL);
+  check_tag(&file, "name", NULL, NULL);
+  tag_file_close(&file);
+  remove(TAGS_TEST_FILE);
+}
+
+void test_tag_find_row(void) {
+  Buffer* buffer = buffer_alloc();
+  buffer_append_line(buffer, "#include \"buffer.h\"");
+  buffer_append_line(buffer, "Buffer* buffer_alloc_all() {");
+  buffer_append_line(buffer, "Buffer* buffer_alloc() {");
+  buffer_append_line(buffer, "const char* path = \"a/b\";");
+  int line = -1;
+  int column = -1;
+
+  Tag tag = {"buffer.c", "/^Buffer* buffer_alloc() {$/"};
+  TEST_CHECK(tag_find_row(&tag, buffer, "buffer_alloc", 12, &line, &column) ==
+             buffer_get_row(buffer, 2));
+  TEST_CHECK(line == 2 && column == 8);
+
+  tag.address = "/^const char* path = \"a\\/b\";$/";
+  TEST_CHECK(tag_find_row(&tag, buffer, "path", 4, &line, &column) ==
+             buffer_get_row(buffer, 3));
+  TEST_CHECK(line == 3 && column == 12);
+
+  tag.address = "2";
+  TEST_CHECK(tag_find_row(&tag, buffer, "missing", 7, &line, &column) ==
+             buffer_get_row(buffer, 1));
+  TEST_CHECK(line == 1 && column == 0);
+
+  tag.address = "/^int main() {$/";
+  TEST_CHECK(tag_find_row(&tag, buffer, "main", 4, &line, &column) == NULL);
+  tag.address = "100";
+  TEST_CHECK(tag_find_row(&tag, buffer, "main", 4, &line, &column) == NULL);
+  buffer_free(buffer);
+}
+
+TEST_LIST = {
+  {"test_tag_file_find", test_tag_file_find},
+  {"test_tag_file_find_large", test_tag_file_find_large},
+  {"test_tag_find_row", test_tag_find_row},
+  {NULL, NULL}  // zeroed record marking the end of the list
+};
@@ -0,0 +1,159 @@
+/*
+ Copyright (c) 2025 Mateusz Stadnik
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "acutest.h"
+
+#include <string.h>
+
+#include "terminal.h"
+
+void test_virtual_terminal_draw(void) {
+  VirtualTerminal virtual_terminal;
+  terminal_virtual_setup(&virtual_terminal, 10, 3);
+  Terminal* terminal = &virtual_terminal.terminal;
+  TEST_ASSERT(terminal_init(terminal));
+  TEST_CHECK(strcmp(terminal_virtual_get_row(&virtual_terminal, 0), "          ") ==
+             0);
+
+  terminal_draw_text(terminal, 0, 1, "int x;");
+  terminal_draw_char(terminal, 1, 0, '~');
+  terminal_draw_format(terminal, 2, 0, "%d lines", 42);
+  TEST_CHECK(strcmp(terminal_virtual_get_row(&virtual_terminal, 0), " int x;   ") ==
+             0);
+  TEST_CHECK(strcmp(terminal_virtual_get_row(&virtual_terminal, 1), "~         ") ==
+             0);
+  TEST_CHECK(strcmp(terminal_virtual_get_row(&virtual_terminal, 2), "42 lines  ") ==
+             0);
+
+  // text past the right edge is cut
+  terminal_draw_text(terminal, 1, 8, "abcdef");
+  TEST_CHECK(strcmp(terminal_virtual_get_row(&virtual_terminal, 1), "~       ab") ==
+             0);
+
+  // clearing starts at the end of the last drawn text or the cursor
+  terminal_draw_text(terminal, 0, 0, "ab");
+  terminal_clear_to_end_of_line(terminal);
+  TEST_CHECK(strcmp(terminal_virtual_get_row(&virtual_terminal, 0), "ab        ") ==
+             0);
+  terminal_move(terminal, 2, 2);
+  terminal_clear_to_end_of_line(terminal);
+  TEST_CHECK(strcmp(terminal_virtual_get_row(&virtual_terminal, 2), "42        ") ==
+             0);
+  TEST_CHECK(virtual_terminal.cursor_y == 2 && virtual_terminal.cursor_x == 2);
+  terminal_show_cursor(terminal, false);
+  TEST_CHECK(!virtual_terminal.cursor_visible);
+  terminal_deinit(terminal);
+}
+
+void test_virtual_terminal_colors(void) {
+  VirtualTerminal virtual_terminal;
+  terminal_virtual_setup(&virtual_terminal, 20, 1);
+  Terminal* terminal = &virtual_terminal.terminal;
+  TEST_ASSERT(terminal_init(terminal));
+  // escape sequences take no cells
+  terminal_draw_text(terminal, 0, 0, "\e[0;31;40mif\e[0;39;49m (\e[1m\e[0;96;40mx");
+  TEST_CHECK(strcmp(terminal_virtual_get_row(&virtual_terminal, 0),
+                    "if (x               ") == 0);
+  TEST_CHECK(terminal_virtual_get_color(&virtual_terminal, 0, 0) == 31);
+  TEST_CHECK(terminal_virtual_get_color(&virtual_terminal, 0, 1) == 31);
+  TEST_CHECK(terminal_virtual_get_color(&virtual_terminal, 0, 2) == 39);
+  TEST_CHECK(terminal_virtual_get_color(&virtual_terminal, 0, 3) == 39);
+  TEST_CHECK(terminal_virtual_get_color(&virtual_terminal, 0, 4) == 96);
+  TEST_CHECK(terminal_virtual_get_color(&virtual_terminal, 0, 5) == 39);
+  // the color stays until the next sequence
+  terminal_draw_text(terminal, 0, 5, "y");
+  TEST_CHECK(terminal_virtual_get_color(&virtual_terminal, 0, 5) == 96);
+  terminal_move(terminal, 0, 0);
+  terminal_clear_to_end_of_line(terminal);
+  TEST_CHECK(terminal_virtual_get_color(&virtual_terminal, 0, 0) == 39);
+  terminal_deinit(terminal);
+}
+
+void test_virtual_terminal_statistics(void) {
+  VirtualTerminal virtual_terminal;
+  terminal_virtual_setup(&virtual_terminal, 80, 24);
+  Terminal* terminal = &virtual_terminal.terminal;
+  TEST_ASSERT(terminal_init(terminal));
+  char move[16];
+  TEST_CHECK(terminal_format_move(move, 9, 19) == 8);
+  TEST_CHECK(strcmp(move, "\x1b[10;20H") == 0);
+
+  // what an ANSI terminal would write, a move before every text
+  terminal_draw_text(terminal, 0, 0, "hello");
+  terminal_clear_to_end_of_line(terminal);
+  terminal_move(terminal, 9, 19);
+  terminal_flush(terminal);
+  TEST_CHECK(terminal->statistics.draws == 1);
+  TEST_CHECK(terminal->statistics.clears == 1);
+  TEST_CHECK(terminal->statistics.moves == 1);
+  TEST_CHECK(terminal->statistics.flushes == 1);
+  TEST_CHECK(terminal->statistics.bytes == 6 + 5 + 3 + 8);
+  TEST_MSG("bytes %ld", (long)terminal->statistics.bytes);
+  terminal_deinit(terminal);
+}
+
+void test_virtual_terminal_keys(void) {
+  VirtualTerminal virtual_terminal;
+  terminal_virtual_setup(&virtual_terminal, 10, 2);
+  Terminal* terminal = &virtual_terminal.terminal;
+  TEST_ASSERT(terminal_init(terminal));
+  TEST_CHECK(terminal_read_key(terminal) == TERMINAL_NO_KEY);
+  const int keys[] = {'i', 'a', TERMINAL_KEY_DOWN};
+  TEST_ASSERT(terminal_virtual_push_keys(&virtual_terminal, keys, 3));
+  TEST_CHECK(terminal_read_key(terminal) == 'i');
+  // keys are queued after the ones not read yet
+  TEST_ASSERT(terminal_virtual_push_keys(&virtual_terminal, keys, 1));
+  TEST_CHECK(terminal_read_key(terminal) == 'a');
+  TEST_CHECK(terminal_read_key(terminal) == TERMINAL_KEY_DOWN);
+  TEST_CHECK(terminal_read_key(terminal) == 'i');
+  TEST_CHECK(terminal_read_key(terminal) == TERMINAL_NO_KEY);
+
+  // more than the initial capacity
+  int many[1000];
+  for (int i = 0; i < 1000; ++i) {
+    many[i] = 'a' + i % 26;
+  }
+  TEST_ASSERT(terminal_virtual_push_keys(&virtual_terminal, many, 1000));
+  for (int i = 0; i < 1000; ++i) {
+    TEST_CHECK(terminal_read_key(terminal) == 'a' + i % 26);
+  }
+  TEST_CHECK(terminal_read_key(terminal) == TERMINAL_NO_KEY);
+  terminal_deinit(terminal);
+}
+
+void test_null_terminal(void) {
+  Terminal terminal = {.operations = &terminal_null_operations,
+                       .width = 80,
+                       .height = 24};
+  TEST_ASSERT(terminal_init(&terminal));
+  terminal_draw_text(&terminal, 0, 0, "text");
+  terminal_clear_to_end_of_line(&terminal);
+  terminal_flush(&terminal);
+  TEST_CHECK(terminal_read_key(&terminal) == TERMINAL_NO_KEY);
+  TEST_CHECK(terminal.statistics.draws == 1);
+  TEST_CHECK(terminal.statistics.bytes == 0);
+  terminal_deinit(&terminal);
+}
+
+TEST_LIST = {
+  {"test_virtual_terminal_draw", test_virtual_terminal_draw},
+  {"test_virtual_terminal_colors", test_virtual_terminal_colors},
+  {"test_virtual_terminal_statistics", test_virtual_terminal_statistics},
+  {"test_virtual_terminal_keys", test_virtual_terminal_keys},
+  {"test_null_terminal", test_null_terminal},
+  {NULL, NULL}  // zeroed record marking the end of the list
+};
@@ -0,0 +1,79 @@
+/*
+ Copyright (c) 2025 Mateusz Stadnik
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "acutest.h"
+
+#include "worker_pool.h"
+
+#define NUMBER_OF_TASKS 100
+
+typedef struct {
+  int done[NUMBER_OF_TASKS];
+  WorkerPool* pool;
+} Context;
+
+static void mark_task(void* context, int index, int worker) {
+  Context* c = context;
+  TEST_CHECK(worker >= 0 && worker < worker_pool_get_number_of_threads(c->pool));
+  c->done[index]++;
+}
+
+// finishes only when the run is cancelled
+static void wait_for_cancel(void* context, int index, int worker) {
+  (void)index;
+  (void)worker;
+  Context* c = context;
+  while (!worker_pool_is_cancelled(c->pool)) {
+  }
+}
+
+static bool cancel_run(void* context) {
+  (void)context;
+  return false;
+}
+
+void test_worker_pool_run(void) {
+  WorkerPool pool;
+  TEST_CHECK(worker_pool_init(&pool, 4));
+  Context context = {.pool = &pool};
+  // the pool is reused between runs
+  for (int run = 1; run <= 3; ++run) {
+    TEST_CHECK(worker_pool_run(&pool, mark_task, &context, NUMBER_OF_TASKS, NULL,
+                               NULL));
+    for (int i = 0; i < NUMBER_OF_TASKS; ++i) {
+      TEST_CHECK(context.done[i] == run);
+    }
+  }
+  worker_pool_deinit(&pool);
+}
+
+void test_worker_pool_cancel(void) {
+  WorkerPool pool;
+  TEST_CHECK(worker_pool_init(&pool, 2));
+  Context context = {.pool = &pool};
+  TEST_CHECK(!worker_pool_run(&pool, wait_for_cancel, &context, NUMBER_OF_TASKS,
+                              cancel_run, NULL));
+  TEST_CHECK(worker_pool_is_cancelled(&pool));
+  TEST_CHECK(worker_pool_run(&pool, mark_task, &context, NUMBER_OF_TASKS, NULL, NULL));
+  worker_pool_deinit(&pool);
+}
+
+TEST_LIST = {
+  {"test_worker_pool_run", test_worker_pool_run},
+  {"test_worker_pool_cancel", test_worker_pool_cancel},
+  {NULL, NULL}  // zeroed record marking the end of the list
+};
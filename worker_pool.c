@@ -0,0 +1,231 @@
+/*
+ Copyright (c) 2025 Mateusz Stadnik
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "worker_pool.h"
+
+#include <stdlib.h>
+
+#ifdef YASVI_THREADS
+#include <time.h>
+#include <unistd.h>
+#endif
+
+#define WORKER_POOL_MAX_THREADS 8
+// how often the calling thread polls while waiting
+#define WORKER_POOL_POLL_INTERVAL_NS 10000000
+
+#ifdef YASVI_THREADS
+
+typedef struct WorkerPoolThread {
+  WorkerPool* pool;
+  int index;
+} WorkerPoolThread;
+
+static void* worker_pool_thread(void* argument) {
+  WorkerPoolThread* thread = argument;
+  WorkerPool* pool = thread->pool;
+  const int worker = thread->index;
+  free(thread);
+
+  pthread_mutex_lock(&pool->mutex);
+  while (true) {
+    while (!pool->stopping &&
+           (pool->task == NULL || pool->next_task >= pool->number_of_tasks)) {
+      pthread_cond_wait(&pool->work_available, &pool->mutex);
+    }
+    if (pool->stopping) {
+      break;
+    }
+    const int index = pool->next_task++;
+    WorkerPoolTask task = pool->task;
+    void* context = pool->context;
+    const bool cancelled = pool->cancelled;
+    pthread_mutex_unlock(&pool->mutex);
+
+    if (!cancelled) {
+      task(context, index, worker);
+    }
+
+    pthread_mutex_lock(&pool->mutex);
+    if (++pool->finished_tasks == pool->number_of_tasks) {
+      pthread_cond_signal(&pool->work_done);
+    }
+  }
+  pthread_mutex_unlock(&pool->mutex);
+  return NULL;
+}
+
+int worker_pool_default_number_of_threads(void) {
+  const long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+  if (cpus < 1) {
+    return 1;
+  }
+  return cpus > WORKER_POOL_MAX_THREADS ? WORKER_POOL_MAX_THREADS : (int)cpus;
+}
+
+bool worker_pool_init(WorkerPool* pool, int number_of_threads) {
+  pool->task = NULL;
+  pool->context = NULL;
+  pool->number_of_tasks = 0;
+  pool->next_task = 0;
+  pool->finished_tasks = 0;
+  pool->cancelled = false;
+  pool->stopping = false;
+  pool->number_of_threads = 0;
+  pool->threads = malloc(sizeof(pthread_t) * number_of_threads);
+  if (pool->threads == NULL) {
+    return false;
+  }
+  pthread_mutex_init(&pool->mutex, NULL);
+  pthread_cond_init(&pool->work_available, NULL);
+  pthread_cond_init(&pool->work_done, NULL);
+
+  for (int i = 0; i < number_of_threads; ++i) {
+    WorkerPoolThread* thread = malloc(sizeof(WorkerPoolThread));
+    if (thread == NULL) {
+      break;
+    }
+    thread->pool = pool;
+    thread->index = i;
+    if (pthread_create(&pool->threads[i], NULL, worker_pool_thread, thread) != 0) {
+      free(thread);
+      break;
+    }
+    ++pool->number_of_threads;
+  }
+  if (pool->number_of_threads == 0) {
+    worker_pool_deinit(pool);
+    return false;
+  }
+  return true;
+}
+
+void worker_pool_deinit(WorkerPool* pool) {
+  if (pool->threads == NULL) {
+    return;
+  }
+  pthread_mutex_lock(&pool->mutex);
+  pool->stopping = true;
+  pthread_cond_broadcast(&pool->work_available);
+  pthread_mutex_unlock(&pool->mutex);
+  for (int i = 0; i < pool->number_of_threads; ++i) {
+    pthread_join(pool->threads[i], NULL);
+  }
+  pthread_cond_destroy(&pool->work_done);
+  pthread_cond_destroy(&pool->work_available);
+  pthread_mutex_destroy(&pool->mutex);
+  free(pool->threads);
+  pool->threads = NULL;
+  pool->number_of_threads = 0;
+}
+
+bool worker_pool_run(WorkerPool* pool,
+                     WorkerPoolTask task,
+                     void* context,
+                     int count,
+                     WorkerPoolPoll poll,
+                     void* poll_context) {
+  if (count <= 0) {
+    return true;
+  }
+  pthread_mutex_lock(&pool->mutex);
+  pool->task = task;
+  pool->context = context;
+  pool->number_of_tasks = count;
+  pool->next_task = 0;
+  pool->finished_tasks = 0;
+  pool->cancelled = false;
+  pthread_cond_broadcast(&pool->work_available);
+
+  while (pool->finished_tasks < pool->number_of_tasks) {
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_nsec += WORKER_POOL_POLL_INTERVAL_NS;
+    if (deadline.tv_nsec >= 1000000000) {
+      deadline.tv_sec += 1;
+      deadline.tv_nsec -= 1000000000;
+    }
+    pthread_cond_timedwait(&pool->work_done, &pool->mutex, &deadline);
+    if (poll != NULL && !pool->cancelled &&
+        pool->finished_tasks < pool->number_of_tasks) {
+      // poll without the lock, it may block on the terminal
+      pthread_mutex_unlock(&pool->mutex);
+      const bool keep_going = poll(poll_context);
+      pthread_mutex_lock(&pool->mutex);
+      if (!keep_going) {
+        pool->cancelled = true;
+      }
+    }
+  }
+  const bool cancelled = pool->cancelled;
+  pool->task = NULL;
+  pthread_mutex_unlock(&pool->mutex);
+  return !cancelled;
+}
+
+bool worker_pool_is_cancelled(WorkerPool* pool) {
+  pthread_mutex_lock(&pool->mutex);
+  const bool cancelled = pool->cancelled;
+  pthread_mutex_unlock(&pool->mutex);
+  return cancelled;
+}
+
+#else
+
+int worker_pool_default_number_of_threads(void) {
+  return 1;
+}
+
+bool worker_pool_init(WorkerPool* pool, int number_of_threads) {
+  (void)number_of_threads;
+  pool->number_of_threads = 1;
+  pool->cancelled = false;
+  return true;
+}
+
+void worker_pool_deinit(WorkerPool* pool) {
+  pool->number_of_threads = 0;
+}
+
+bool worker_pool_run(WorkerPool* pool,
+                     WorkerPoolTask task,
+                     void* context,
+                     int count,
+                     WorkerPoolPoll poll,
+                     void* poll_context) {
+  pool->cancelled = false;
+  for (int i = 0; i < count; ++i) {
+    if (poll != NULL && !poll(poll_context)) {
+      pool->cancelled = true;
+      return false;
+    }
+    task(context, i, 0);
+  }
+  return true;
+}
+
+bool worker_pool_is_cancelled(WorkerPool* pool) {
+  return pool->cancelled;
+}
+
+#endif
+
+int worker_pool_get_number_of_threads(const WorkerPool* pool) {
+  return pool->number_of_threads;
+}
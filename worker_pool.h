@@ -0,0 +1,64 @@
+/*
+ Copyright (c) 2025 Mateusz Stadnik
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+
+#ifdef YASVI_THREADS
+#include <pthread.h>
+#endif
+
+// worker is the index of the thread running the task, use it for scratch space
+typedef void (*WorkerPoolTask)(void* context, int index, int worker);
+// called on the calling thread while tasks run, returning false cancels
+typedef bool (*WorkerPoolPoll)(void* context);
+
+typedef struct WorkerPool {
+  int number_of_threads;
+  // state of the current run
+  WorkerPoolTask task;
+  void* context;
+  int number_of_tasks;
+  int next_task;
+  int finished_tasks;
+  bool cancelled;
+  bool stopping;
+#ifdef YASVI_THREADS
+  pthread_t* threads;
+  pthread_mutex_t mutex;
+  pthread_cond_t work_available;
+  pthread_cond_t work_done;
+#endif
+} WorkerPool;
+
+// without thread support the pool runs everything on the calling thread
+bool worker_pool_init(WorkerPool* pool, int number_of_threads);
+void worker_pool_deinit(WorkerPool* pool);
+int worker_pool_get_number_of_threads(const WorkerPool* pool);
+// number of threads worth using on this machine
+int worker_pool_default_number_of_threads(void);
+
+// runs task for every index in [0, count), returns false when cancelled
+bool worker_pool_run(WorkerPool* pool,
+                     WorkerPoolTask task,
+                     void* context,
+                     int count,
+                     WorkerPoolPoll poll,
+                     void* poll_context);
+// long tasks may check it to stop early
+bool worker_pool_is_cancelled(WorkerPool* pool);